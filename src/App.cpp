@@ -11,11 +11,13 @@
 #include "DeviceOptionsObserver.hpp"
 #include "DeviceSelector.hpp"
 #include "DeviceSelectorObserver.hpp"
+#include "OptionRewriter.hpp"
 #include "OutputOptionsState.hpp"
 #include "PreferencesView.hpp"
 #include "PresetPanel.hpp"
 #include "PreviewPanel.hpp"
 #include "PreviewScanProcess.hpp"
+#include "ProfilerOverlay.hpp"
 #include "ScanListPanel.hpp"
 #include "ScanOptionsPanel.hpp"
 #include "SingleScanProcess.hpp"
@@ -27,6 +29,7 @@
 #include "ZooLib/ErrorDialog.hpp"
 #include "ZooLib/Gettext.hpp"
 #include "ZooLib/PathUtils.hpp"
+#include "ZooLib/Profiler.hpp"
 #include "ZooLib/SignalSupport.hpp"
 
 Gorfector::App::App(int argc, char **argv, bool testMode)
@@ -43,6 +46,8 @@ Gorfector::App::App(int argc, char **argv, bool testMode)
     auto prefDir = GetUserConfigDirectoryPath();
     auto prefFilePath = prefDir / "preferences.json";
     m_State.SetPreferencesFilePath(prefFilePath);
+    m_DeviceOptionCache = new DeviceOptionCache(prefDir / "option-cache.bin");
+    m_ScannerDescriptionIndex = new ScannerDescriptionIndex(GetSystemConfigDirectoryPath(), prefDir);
 
     bool devMode{};
     for (int i = 1; i < argc; ++i)
@@ -53,13 +58,19 @@ Gorfector::App::App(int argc, char **argv, bool testMode)
         }
     }
 
+    // In developer mode, the scan pipeline timings are recorded, shown above the window and saved on exit.
+    ZooLib::Profiler::SetEnabled(devMode);
+
     m_AppState = new AppState(&m_State, devMode);
     m_State.LoadFromPreferencesFile(m_AppState);
 
-    m_ViewUpdateObserver = new ViewUpdateObserver(this, m_AppState);
+    // Devices are discovered in the background; the last known devices are listed until the discovery completes.
+    m_DeviceSelectorState = new DeviceSelectorState(&m_State);
+    m_State.LoadFromPreferencesFile(m_DeviceSelectorState);
+
+    m_ViewUpdateObserver = new ViewUpdateObserver(this, m_AppState, m_DeviceSelectorState);
     m_ObserverManager.AddObserver(m_ViewUpdateObserver);
 
-    m_DeviceSelectorState = new DeviceSelectorState(&m_State);
     m_DeviceSelectorObserver = new DeviceSelectorObserver(m_DeviceSelectorState, m_AppState);
     m_ObserverManager.AddObserver(m_DeviceSelectorObserver);
 
@@ -70,6 +81,19 @@ Gorfector::App::App(int argc, char **argv, bool testMode)
 
 Gorfector::App::~App()
 {
+    delete m_ProfilerOverlay;
+    m_ProfilerOverlay = nullptr;
+
+    if (ZooLib::Profiler::IsEnabled())
+    {
+        auto profileFilePath = GetUserConfigDirectoryPath() / "profile.json";
+        if (ZooLib::Profiler::WriteJsonFile(profileFilePath))
+        {
+            g_print("Profile written to %s\n", profileFilePath.c_str());
+        }
+        ZooLib::Profiler::SetEnabled(false);
+    }
+
     if (m_RightPaned != nullptr)
     {
         g_object_unref(m_RightPaned);
@@ -94,6 +118,8 @@ Gorfector::App::~App()
 
     delete m_AppState;
     delete m_DeviceSelectorState;
+    delete m_DeviceOptionCache;
+    delete m_ScannerDescriptionIndex;
 
     sane_exit();
 
@@ -104,7 +130,11 @@ void Gorfector::App::OnActivate(GtkApplication *app)
 {
     Application::OnActivate(app);
 
-    if (GetSelectorDeviceName().empty())
+    if (m_DeviceSelectorState->IsDiscovering())
+    {
+        m_SelectDeviceAfterDiscovery = true;
+    }
+    else if (GetSelectorDeviceName().empty())
     {
         auto action = g_action_map_lookup_action(G_ACTION_MAP(app), "select_device");
         g_action_activate(action, nullptr);
@@ -243,6 +273,12 @@ GtkWidget *Gorfector::App::BuildUI()
         gtk_paned_set_end_child(GTK_PANED(m_LeftPaned), previewBox);
     }
 
+    if (m_AppState->IsDeveloperMode())
+    {
+        m_ProfilerOverlay = new ProfilerOverlay(m_LeftPaned);
+        return m_ProfilerOverlay->GetRootWidget();
+    }
+
     return m_LeftPaned;
 }
 
@@ -401,8 +437,22 @@ int Gorfector::App::GetSelectorSaneInitId() const
 
 void Gorfector::App::Update(const std::vector<uint64_t> &lastSeenVersions)
 {
-    auto changeset = m_AppState->GetAggregatedChangeset(lastSeenVersions[0]);
-    if (changeset == nullptr || !changeset->HasAnyChange())
+    m_DeviceSelectorState->AggregateChangesets(lastSeenVersions[1], m_DeviceSelectorStateChangeset);
+    if (m_SelectDeviceAfterDiscovery &&
+        m_DeviceSelectorStateChangeset.IsChanged(DeviceSelectorStateChangeset::ChangeTypeFlag::e_Discovery) &&
+        !m_DeviceSelectorState->IsDiscovering())
+    {
+        m_SelectDeviceAfterDiscovery = false;
+        if (GetSelectorDeviceName().empty())
+        {
+            auto action = g_action_map_lookup_action(G_ACTION_MAP(m_GtkApp), "select_device");
+            g_action_activate(action, nullptr);
+        }
+    }
+
+    m_AppState->AggregateChangesets(lastSeenVersions[0], m_AppStateChangeset);
+    const auto *changeset = &m_AppStateChangeset;
+    if (!changeset->HasAnyChange())
     {
         return;
     }
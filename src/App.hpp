@@ -19,6 +19,8 @@ namespace Gorfector
     class ScanOptionsPanel;
     class DeviceSelectorObserver;
     class PreviewPanel;
+    class ProfilerOverlay;
+    class ScannerDescriptionIndex;
 
     /**
      * \class App
@@ -37,15 +39,25 @@ namespace Gorfector
 
     private:
         AppState *m_AppState{};
+        // Receives the changes of m_AppState, reused on every update.
+        AppStateChangeset m_AppStateChangeset{0};
         DeviceSelectorState *m_DeviceSelectorState{};
-
-        ViewUpdateObserver<App, AppState> *m_ViewUpdateObserver{};
+        // Receives the changes of m_DeviceSelectorState, reused on every update.
+        DeviceSelectorStateChangeset m_DeviceSelectorStateChangeset{0};
+        // Whether to show the device selection dialog if no device is selected when the device discovery completes.
+        bool m_SelectDeviceAfterDiscovery{};
+        DeviceOptionCache *m_DeviceOptionCache{};
+        ScannerDescriptionIndex *m_ScannerDescriptionIndex{};
+
+        ViewUpdateObserver<App, AppState, DeviceSelectorState> *m_ViewUpdateObserver{};
         DeviceSelectorObserver *m_DeviceSelectorObserver{};
         DeviceOptionsObserver *m_DeviceOptionsObserver{};
 
         ScanOptionsPanel *m_ScanOptionsPanel{};
         PreviewPanel *m_PreviewPanel{};
         PresetPanel *m_PresetPanel{};
+        // Shows the profiler metrics above the main window content, in developer mode.
+        ProfilerOverlay *m_ProfilerOverlay{};
 
         GtkWidget *m_LeftPaned{};
         GtkWidget *m_RightPaned{};
@@ -156,6 +168,24 @@ namespace Gorfector
             return m_DeviceSelectorState;
         }
 
+        /**
+         * \brief Retrieves the cache of the option values of the devices.
+         * \return A pointer to the DeviceOptionCache object.
+         */
+        [[nodiscard]] DeviceOptionCache *GetDeviceOptionCache() const
+        {
+            return m_DeviceOptionCache;
+        }
+
+        /**
+         * \brief Retrieves the index of the scanner description files.
+         * \return A pointer to the ScannerDescriptionIndex object.
+         */
+        [[nodiscard]] ScannerDescriptionIndex *GetScannerDescriptionIndex() const
+        {
+            return m_ScannerDescriptionIndex;
+        }
+
         /**
          * \brief Starts the preview scan of the current device.
          */
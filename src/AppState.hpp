@@ -25,6 +25,12 @@ namespace Gorfector
         {
         }
 
+        void Reset(uint64_t stateInitialVersion)
+        {
+            ChangesetBase::Reset(stateInitialVersion);
+            m_ChangeType = 0;
+        }
+
         void AddChangeType(ChangeTypeFlag changeType)
         {
             m_ChangeType |= static_cast<int>(changeType);
@@ -133,9 +139,9 @@ namespace Gorfector
             return &m_ChangesetManager;
         }
 
-        [[nodiscard]] AppStateChangeset *GetAggregatedChangeset(uint64_t stateComponentVersion) const
+        void AggregateChangesets(uint64_t stateComponentVersion, AppStateChangeset &accumulator) const
         {
-            return m_ChangesetManager.GetAggregatedChangeset(stateComponentVersion);
+            m_ChangesetManager.AggregateChangesets(stateComponentVersion, accumulator);
         }
 
         class Updater final : public StateComponent::Updater<AppState>
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <nlohmann/json.hpp>
+#include <ostream>
+
+#include "MultiScanProcess.hpp"
+
+namespace Gorfector
+{
+    /**
+     * \class BatchScanProcess
+     * \brief Scans the items of a scan list without a main window, and reports the progress on an output stream.
+     *
+     * Each event is written as one JSON object per line:
+     *
+     *     {"event":"scan_started","item":1,"page":1,"count":3,"file":"/path/to/scan.tiff"}
+     *     {"event":"progress","item":1,"page":1,"percent":42,"bytes":1234567,"total":2939328}
+     *     {"event":"scan_finished","item":1,"page":1,"file":"/path/to/scan.tiff"}
+     *     {"event":"error","item":2,"page":1,"message":"..."}
+     *
+     * Items and pages are numbered from 1. Items using the document feeder have one page per sheet, each in its own
+     * file; the other items have a single page. A progress event is written each time the percentage of the page
+     * changes. Since the next page starts while the file of the previous one is being closed, the `scan_finished`
+     * event of a page may come after the `scan_started` event of the next one. Only file destinations are supported:
+     * items sending the image by email or to a printer stop the batch with an error.
+     */
+    class BatchScanProcess final : public MultiScanProcess
+    {
+        std::ostream &m_Output;
+        size_t m_ItemCount;
+        size_t m_ScannedCount{};
+        size_t m_PageCount{};
+
+        size_t m_PageBytes{};
+        int m_LastPercent{-1};
+
+        void WriteEvent(nlohmann::json event)
+        {
+            WriteEvent(GetCurrentScanIndex(), m_PageIndex, std::move(event));
+        }
+
+        void WriteEvent(size_t itemIndex, size_t pageIndex, nlohmann::json event)
+        {
+            event["item"] = itemIndex + 1;
+            event["page"] = pageIndex + 1;
+            m_Output << event.dump() << std::endl;
+        }
+
+        [[nodiscard]] size_t GetPageSize() const
+        {
+            if (m_ScanParameters.bytes_per_line <= 0 || m_ScanParameters.lines <= 0)
+            {
+                // The number of lines is unknown (e.g. hand-held scanners).
+                return 0;
+            }
+
+            return static_cast<size_t>(m_ScanParameters.bytes_per_line) * m_ScanParameters.lines;
+        }
+
+    protected:
+        void ShowError(const std::string &message) override
+        {
+            WriteEvent({{"event", "error"}, {"message", message}});
+        }
+
+        void IncreaseProgress(size_t length) override
+        {
+            m_PageBytes += length;
+
+            auto pageSize = GetPageSize();
+            if (pageSize == 0 || length == 0)
+            {
+                return;
+            }
+
+            auto percent = static_cast<int>(std::min(m_PageBytes, pageSize) * 100 / pageSize);
+            if (percent != m_LastPercent)
+            {
+                m_LastPercent = percent;
+                WriteEvent({{"event", "progress"}, {"percent", percent}, {"bytes", m_PageBytes}, {"total", pageSize}});
+            }
+        }
+
+        bool LoadSettings() override
+        {
+            try
+            {
+                if (!MultiScanProcess::LoadSettings())
+                {
+                    return false;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                // Malformed items in a scan list file.
+                ShowError(std::string(_("Invalid scan list item: ")) + e.what());
+                return false;
+            }
+
+            if (m_OutputOptions->GetOutputDestination() != OutputOptionsState::OutputDestination::e_File)
+            {
+                ShowError(_("Only file destinations are supported in batch mode."));
+                return false;
+            }
+
+            return true;
+        }
+
+        void OnPageStarted() override
+        {
+            m_PageBytes = 0;
+            m_LastPercent = -1;
+            WriteEvent({{"event", "scan_started"}, {"count", m_ItemCount}, {"file", m_ImageFilePath.string()}});
+        }
+
+        void OnPageStopped(
+                size_t itemIndex, size_t pageIndex, const std::filesystem::path &imageFilePath, bool canceled) override
+        {
+            if (canceled)
+            {
+                // An item is scanned when all its pages are.
+                m_ScannedCount = std::min(m_ScannedCount, itemIndex);
+                return;
+            }
+
+            ++m_PageCount;
+            m_ScannedCount = std::max(m_ScannedCount, itemIndex + 1);
+            WriteEvent(itemIndex, pageIndex, {{"event", "scan_finished"}, {"file", imageFilePath.string()}});
+        }
+
+    public:
+        /**
+         * \brief Constructs a process scanning all the items of the current scan list of `scanListState`.
+         * \param output The stream receiving the progress events.
+         */
+        BatchScanProcess(
+                ScanDevice *device, ScanListState *scanListState, AppState *appState, DeviceOptionsState *scanOptions,
+                OutputOptionsState *outputOptions, std::ostream &output, const std::function<void()> *finishCallback)
+            : MultiScanProcess(
+                      device, scanListState, nullptr, appState, scanOptions, outputOptions, nullptr, finishCallback)
+            , m_Output(output)
+            , m_ItemCount(scanListState->GetScanListSize())
+        {
+        }
+
+        /**
+         * \brief Gets the number of items scanned successfully.
+         */
+        [[nodiscard]] size_t GetScannedCount() const
+        {
+            return m_ScannedCount;
+        }
+
+        /**
+         * \brief Gets the number of pages scanned successfully, which is greater than the number of items when the
+         * document feeder is used.
+         */
+        [[nodiscard]] size_t GetPageCount() const
+        {
+            return m_PageCount;
+        }
+
+        /**
+         * \brief Gets the number of items in the scan list.
+         */
+        [[nodiscard]] size_t GetItemCount() const
+        {
+            return m_ItemCount;
+        }
+    };
+}
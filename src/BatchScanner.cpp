@@ -0,0 +1,323 @@
+#include "BatchScanner.hpp"
+
+#include <csignal>
+#include <format>
+#include <fstream>
+#include <glib-unix.h>
+#include <sane/sane.h>
+
+#include "App.hpp"
+#include "AppState.hpp"
+#include "BatchScanProcess.hpp"
+#include "DeviceOptionCache.hpp"
+#include "DeviceOptionsState.hpp"
+#include "DeviceSelectorState.hpp"
+#include "OutputOptionsState.hpp"
+#include "PresetPanelState.hpp"
+#include "ScanListState.hpp"
+#include "Writers/FileWriter.hpp"
+#include "Writers/JpegWriter.hpp"
+#include "Writers/PngWriter.hpp"
+#include "Writers/TiffWriter.hpp"
+#include "ZooLib/Gettext.hpp"
+
+namespace
+{
+    struct CancelRequest
+    {
+        Gorfector::BatchScanProcess *Process{};
+        bool IsCanceled{};
+    };
+
+    gboolean OnTerminationSignal(gpointer data)
+    {
+        auto *cancelRequest = static_cast<CancelRequest *>(data);
+        if (!cancelRequest->IsCanceled && cancelRequest->Process != nullptr)
+        {
+            cancelRequest->IsCanceled = true;
+            cancelRequest->Process->Cancel();
+        }
+
+        return G_SOURCE_CONTINUE;
+    }
+}
+
+Gorfector::BatchScanner::BatchScanner(const std::filesystem::path &userConfigDirectoryPath, std::ostream &output)
+    : m_Output(output)
+{
+    SANE_Int saneVersion;
+    m_IsSaneInitialized = sane_init(&saneVersion, nullptr) == SANE_STATUS_GOOD;
+
+    // Use the settings of the application, but never save the scan list or the settings of its items to them.
+    m_State.SetPreferencesFilePath(userConfigDirectoryPath / "preferences.json");
+    m_State.SetPreferencesFileReadOnly(true);
+    m_DeviceOptionCache = new DeviceOptionCache(userConfigDirectoryPath / "option-cache.bin");
+
+    m_AppState = new AppState(&m_State, false);
+
+    m_DeviceSelectorState = new DeviceSelectorState(&m_State);
+    m_State.LoadFromPreferencesFile(m_DeviceSelectorState);
+
+    m_OutputOptions = new OutputOptionsState(&m_State);
+    m_State.LoadFromPreferencesFile(m_OutputOptions);
+
+    FileWriter::Register<TiffWriter>(&m_State, App::k_ApplicationName);
+    FileWriter::Register<JpegWriter>(&m_State, App::k_ApplicationName);
+    FileWriter::Register<PngWriter>(&m_State, App::k_ApplicationName);
+}
+
+Gorfector::BatchScanner::~BatchScanner()
+{
+    delete m_OutputOptions;
+    delete m_DeviceSelectorState;
+    delete m_AppState;
+    delete m_DeviceOptionCache;
+
+    sane_exit();
+
+    FileWriter::Clear();
+}
+
+void Gorfector::BatchScanner::WriteError(const std::string &message) const
+{
+    m_Output << nlohmann::json{{"event", "error"}, {"message", message}}.dump() << std::endl;
+}
+
+bool Gorfector::BatchScanner::LoadScanItems(const std::string &scanListOrPreset, nlohmann::json &items)
+{
+    if (std::filesystem::path(scanListOrPreset).extension() != ".json")
+    {
+        return LoadPresetItem(scanListOrPreset, items);
+    }
+
+    std::ifstream file(scanListOrPreset);
+    if (!file.good())
+    {
+        WriteError(std::vformat(_("Cannot read the scan list {}."), std::make_format_args(scanListOrPreset)));
+        return false;
+    }
+
+    items = nlohmann::json::parse(file, nullptr, false);
+    if (!items.is_array() || items.empty())
+    {
+        WriteError(std::vformat(
+                _("The scan list {} is not an array of scan items."), std::make_format_args(scanListOrPreset)));
+        return false;
+    }
+
+    // Items written by hand may not have an id; the scan list needs one for each item.
+    for (auto i = 0UZ; i < items.size(); ++i)
+    {
+        if (!items[i].is_object())
+        {
+            WriteError(std::vformat(
+                    _("The scan list {} is not an array of scan items."), std::make_format_args(scanListOrPreset)));
+            return false;
+        }
+        if (!items[i].contains(ScanListState::k_ItemIdKey))
+        {
+            items[i][ScanListState::k_ItemIdKey] = static_cast<int>(i) + 1;
+        }
+    }
+
+    return true;
+}
+
+bool Gorfector::BatchScanner::LoadPresetItem(const std::string &presetName, nlohmann::json &items)
+{
+    PresetPanelState presets(&m_State);
+    m_State.LoadFromPreferencesFile(&presets);
+
+    auto preset = presets.GetPreset(presetName);
+    if (preset == nullptr)
+    {
+        WriteError(std::vformat(_("No preset named {}."), std::make_format_args(presetName)));
+        return false;
+    }
+    if (!preset->contains(PresetPanelState::k_ScannerSettingsKey))
+    {
+        WriteError(std::vformat(_("The preset {} has no scanner settings."), std::make_format_args(presetName)));
+        return false;
+    }
+
+    auto item = nlohmann::json{
+            {ScanListState::k_ItemIdKey, 1},
+            {ScanListState::k_ItemScannerSettingsKey, preset->at(PresetPanelState::k_ScannerSettingsKey)},
+    };
+    if (preset->contains(PresetPanelState::k_ScanAreaKey))
+    {
+        item[ScanListState::k_ItemScannerSettingsKey][DeviceOptionsState::k_OptionsKey].update(
+                preset->at(PresetPanelState::k_ScanAreaKey));
+    }
+    if (preset->contains(PresetPanelState::k_OutputSettingsKey))
+    {
+        item[ScanListState::k_ItemOutputSettingsKey] = preset->at(PresetPanelState::k_OutputSettingsKey);
+    }
+    else
+    {
+        to_json(item[ScanListState::k_ItemOutputSettingsKey], *m_OutputOptions);
+    }
+
+    items = nlohmann::json::array({std::move(item)});
+    return true;
+}
+
+void Gorfector::BatchScanner::WaitForDiscovery() const
+{
+    while (m_DeviceSelectorState->IsDiscovering())
+    {
+        g_main_context_iteration(nullptr, TRUE);
+    }
+}
+
+Gorfector::SaneDevice *Gorfector::BatchScanner::FindDevice(const nlohmann::json &device) const
+{
+    auto name = device.value(DeviceOptionsState::k_DeviceNameKey, std::string{});
+    auto vendor = device.value(DeviceOptionsState::k_DeviceVendorKey, std::string{});
+    auto model = device.value(DeviceOptionsState::k_DeviceModelKey, std::string{});
+
+    WaitForDiscovery();
+
+    if (auto saneDevice = m_DeviceSelectorState->GetDeviceByName(name); saneDevice != nullptr)
+    {
+        return saneDevice;
+    }
+
+    // The device name may change, e.g. when a USB scanner is plugged in another port.
+    for (auto saneDevice: m_DeviceSelectorState->GetDeviceList())
+    {
+        if (vendor == saneDevice->GetVendor() && model == saneDevice->GetModel())
+        {
+            return saneDevice;
+        }
+    }
+
+    return nullptr;
+}
+
+Gorfector::BatchScanner::ExitCode Gorfector::BatchScanner::RunScanList(const std::string &scanListOrPreset)
+{
+    if (!m_IsSaneInitialized)
+    {
+        WriteError(_("Failed to initialize SANE."));
+        return ExitCode::e_DeviceNotFound;
+    }
+
+    nlohmann::json items;
+    if (!LoadScanItems(scanListOrPreset, items))
+    {
+        return ExitCode::e_InvalidArguments;
+    }
+
+    // A scan list holds the items of a single scanner: the one of the first item with scanner settings.
+    const nlohmann::json *device{};
+    for (const auto &item: items)
+    {
+        if (item.contains(ScanListState::k_ItemScannerSettingsKey) &&
+            item[ScanListState::k_ItemScannerSettingsKey].contains(DeviceOptionsState::k_DeviceKey))
+        {
+            device = &item[ScanListState::k_ItemScannerSettingsKey][DeviceOptionsState::k_DeviceKey];
+            break;
+        }
+    }
+    if (device == nullptr || !device->is_object())
+    {
+        WriteError(_("The scan list does not specify a scanner."));
+        return ExitCode::e_InvalidArguments;
+    }
+
+    auto saneDevice = FindDevice(*device);
+    if (saneDevice == nullptr && !m_DeviceSelectorState->IsNetworkLookUpEnabled())
+    {
+        auto updater = DeviceSelectorState::Updater(m_DeviceSelectorState);
+        updater.SetLookUpNetwork(true);
+        updater.UpdateDeviceList();
+        saneDevice = FindDevice(*device);
+    }
+    if (saneDevice == nullptr)
+    {
+        auto deviceName = device->value(DeviceOptionsState::k_DeviceNameKey, std::string{});
+        WriteError(std::vformat(_("Scanner {} not found."), std::make_format_args(deviceName)));
+        return ExitCode::e_DeviceNotFound;
+    }
+
+    const std::string deviceName = saneDevice->GetName();
+    DeviceSelectorState::Updater(m_DeviceSelectorState).SelectDevice(deviceName);
+    if (m_DeviceSelectorState->GetSelectedDeviceName() != deviceName)
+    {
+        WriteError(std::vformat(_("Failed to open scanner {}."), std::make_format_args(deviceName)));
+        return ExitCode::e_DeviceNotFound;
+    }
+
+    return Scan(saneDevice, items);
+}
+
+Gorfector::BatchScanner::ExitCode Gorfector::BatchScanner::Scan(SaneDevice *device, const nlohmann::json &items)
+{
+    DeviceOptionsState deviceOptions(&m_State, device->GetName(), m_DeviceOptionCache);
+
+    ScanListState scanList(&m_State);
+    {
+        auto scanListName = std::string(device->GetVendor()) + "::" + device->GetModel();
+        auto updater = ScanListState::Updater(&scanList);
+        updater.LoadFromJson({
+                {ScanListState::k_AddAllParamsKey, false},
+                {ScanListState::k_ScanListsKey, {{scanListName, items}}},
+        });
+        updater.SetCurrentDeviceName(device->GetVendor(), device->GetModel());
+    }
+
+    m_ItemCount = scanList.GetScanListSize();
+    auto finished = false;
+    CancelRequest cancelRequest{};
+
+    auto process = new BatchScanProcess(
+            device, &scanList, m_AppState, &deviceOptions, m_OutputOptions, m_Output,
+            new std::function<void()>([&]() {
+                m_ScannedCount = cancelRequest.Process->GetScannedCount();
+                m_PageCount = cancelRequest.Process->GetPageCount();
+                finished = true;
+            }));
+    cancelRequest.Process = process;
+
+    if (!process->Start())
+    {
+        // finishCallback is deleted in the destructor of ScanProcess
+        delete process;
+        finished = true;
+    }
+
+    auto sigintSourceId = g_unix_signal_add(SIGINT, OnTerminationSignal, &cancelRequest);
+    auto sigtermSourceId = g_unix_signal_add(SIGTERM, OnTerminationSignal, &cancelRequest);
+
+    while (!finished)
+    {
+        g_main_context_iteration(nullptr, TRUE);
+    }
+
+    g_source_remove(sigintSourceId);
+    g_source_remove(sigtermSourceId);
+
+    if (cancelRequest.IsCanceled)
+    {
+        return ExitCode::e_Canceled;
+    }
+
+    return m_ScannedCount == m_ItemCount ? ExitCode::e_Success : ExitCode::e_ScanFailed;
+}
+
+Gorfector::BatchScanner::ExitCode Gorfector::BatchScanner::Run(const std::string &scanListOrPreset)
+{
+    auto exitCode = RunScanList(scanListOrPreset);
+
+    auto event = nlohmann::json{
+            {"event", "batch_finished"},
+            {"scanned", m_ScannedCount},
+            {"count", m_ItemCount},
+            {"pages", m_PageCount},
+            {"exit_code", static_cast<int>(exitCode)},
+    };
+    m_Output << event.dump() << std::endl;
+
+    return exitCode;
+}
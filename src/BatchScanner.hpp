@@ -0,0 +1,83 @@
+#pragma once
+
+#include <filesystem>
+#include <nlohmann/json.hpp>
+#include <ostream>
+#include <string>
+
+#include "ZooLib/State.hpp"
+
+namespace Gorfector
+{
+    class AppState;
+    class DeviceOptionCache;
+    class DeviceSelectorState;
+    class OutputOptionsState;
+    class SaneDevice;
+
+    /**
+     * \class BatchScanner
+     * \brief Runs a scan list without user interface, for `gorfector --batch`.
+     *
+     * The scan list is either a JSON file holding an array of scan list items, as saved in the preferences by the scan
+     * list panel, or the name of a preset, which is scanned once. The scanner and output settings come from the items;
+     * the other settings (device list, file format settings) come from the user preferences, which are never
+     * modified. The progress is written on the output stream as JSON lines (see `BatchScanProcess`).
+     */
+    class BatchScanner
+    {
+    public:
+        /**
+         * \brief The process exit codes of the batch mode.
+         */
+        enum class ExitCode
+        {
+            e_Success = 0, ///< All items were scanned.
+            e_ScanFailed = 1, ///< An item could not be scanned; the following items were not scanned.
+            e_InvalidArguments = 2, ///< The scan list or the preset could not be loaded.
+            e_DeviceNotFound = 3, ///< The scanner of the scan list is not available.
+            e_Canceled = 4, ///< The batch was interrupted by SIGINT or SIGTERM.
+        };
+
+    private:
+        std::ostream &m_Output;
+        ZooLib::State m_State{};
+        AppState *m_AppState{};
+        DeviceSelectorState *m_DeviceSelectorState{};
+        OutputOptionsState *m_OutputOptions{};
+        DeviceOptionCache *m_DeviceOptionCache{};
+        bool m_IsSaneInitialized{};
+
+        size_t m_ItemCount{};
+        size_t m_ScannedCount{};
+        size_t m_PageCount{};
+
+        void WriteError(const std::string &message) const;
+        bool LoadScanItems(const std::string &scanListOrPreset, nlohmann::json &items);
+        bool LoadPresetItem(const std::string &presetName, nlohmann::json &items);
+        SaneDevice *FindDevice(const nlohmann::json &device) const;
+        void WaitForDiscovery() const;
+        ExitCode RunScanList(const std::string &scanListOrPreset);
+        ExitCode Scan(SaneDevice *device, const nlohmann::json &items);
+
+    public:
+        /**
+         * \brief Initializes SANE and starts the device discovery.
+         * \param userConfigDirectoryPath The directory holding the user preferences and the option cache.
+         * \param output The stream receiving the progress events.
+         */
+        BatchScanner(const std::filesystem::path &userConfigDirectoryPath, std::ostream &output);
+        ~BatchScanner();
+
+        BatchScanner(const BatchScanner &) = delete;
+        BatchScanner &operator=(const BatchScanner &) = delete;
+
+        /**
+         * \brief Scans all the items of a scan list, running the main loop until they are scanned. The last event
+         * written is `{"event":"batch_finished","scanned":...,"count":...,"pages":...,"exit_code":...}`.
+         * \param scanListOrPreset The path of a scan list JSON file (with the `.json` extension) or a preset name.
+         * \return The exit code of the process.
+         */
+        ExitCode Run(const std::string &scanListOrPreset);
+    };
+}
@@ -13,7 +13,8 @@ namespace Gorfector
      *
      * This class is responsible for applying scanner settings, scan area settings,
      * and output settings from a given preset (in JSON format) to the respective
-     * `DeviceOptionsState` and `OutputOptionsState` objects.
+     * `DeviceOptionsState` and `OutputOptionsState` objects. The scanner settings and
+     * scan area are applied from their compiled snapshots.
      *
      * \note The preset is expected to follow a specific structure with keys defined
      *       in `PresetPanelState`.
@@ -25,13 +26,28 @@ namespace Gorfector
          */
         const nlohmann::json *m_Preset;
 
+        /**
+         * \brief Pointer to the compiled scanner settings of the preset.
+         */
+        const OptionSnapshot *m_ScannerSettings;
+
+        /**
+         * \brief Pointer to the compiled scan area of the preset.
+         */
+        const OptionSnapshot *m_ScanArea;
+
     public:
         /**
          * \brief Constructor for the ApplyPresetCommand.
          * \param preset Pointer to the JSON object containing the preset configuration.
+         * \param scannerSettings Pointer to the compiled scanner settings of the preset, or nullptr.
+         * \param scanArea Pointer to the compiled scan area of the preset, or nullptr.
          */
-        explicit ApplyPresetCommand(const nlohmann::json *preset)
+        explicit ApplyPresetCommand(
+                const nlohmann::json *preset, const OptionSnapshot *scannerSettings, const OptionSnapshot *scanArea)
             : m_Preset(preset)
+            , m_ScannerSettings(scannerSettings)
+            , m_ScanArea(scanArea)
         {
         }
 
@@ -54,17 +70,19 @@ namespace Gorfector
                 return;
             }
 
-            if (command.m_Preset->contains(PresetPanelState::k_ScannerSettingsKey))
-            {
-                auto scannerSettings = command.m_Preset->at(PresetPanelState::k_ScannerSettingsKey);
-                auto deviceOptionsUpdater = DeviceOptionsState::Updater(deviceOptions);
-                deviceOptionsUpdater.ApplySettings(scannerSettings);
-            }
-            if (command.m_Preset->contains(PresetPanelState::k_ScanAreaKey))
+            if (command.m_ScannerSettings != nullptr || command.m_ScanArea != nullptr)
             {
-                auto scanAreaSettings = command.m_Preset->at(PresetPanelState::k_ScanAreaKey);
+                // Send the scanner settings and the scan area to the device together.
                 auto deviceOptionsUpdater = DeviceOptionsState::Updater(deviceOptions);
-                deviceOptionsUpdater.ApplyScanArea(scanAreaSettings);
+                deviceOptionsUpdater.BeginBatch();
+                if (command.m_ScannerSettings != nullptr)
+                {
+                    deviceOptionsUpdater.ApplySettings(*command.m_ScannerSettings);
+                }
+                if (command.m_ScanArea != nullptr)
+                {
+                    deviceOptionsUpdater.ApplyScanArea(*command.m_ScanArea);
+                }
             }
             if (command.m_Preset->contains(PresetPanelState::k_OutputSettingsKey))
             {
@@ -15,9 +15,9 @@ namespace Gorfector
     class LoadScanItemCommand : public ZooLib::Command
     {
         /**
-         * \brief Pointer to the JSON object containing scanner settings.
+         * \brief Pointer to the compiled scanner settings.
          */
-        const nlohmann::json *m_ScannerSettings;
+        const OptionSnapshot *m_ScannerSettings;
 
         /**
          * \brief Pointer to the JSON object containing output settings.
@@ -25,20 +25,20 @@ namespace Gorfector
         const nlohmann::json *m_OutputSettings;
 
         /**
-         * \brief Pointer to the JSON object containing scan area settings.
+         * \brief Pointer to the compiled scan area settings.
          */
-        const nlohmann::json *m_ScanAreaSettings;
+        const OptionSnapshot *m_ScanAreaSettings;
 
     public:
         /**
          * \brief Constructor for the LoadScanItemCommand.
-         * \param scannerSettings Pointer to the JSON object with scanner settings.
+         * \param scannerSettings Pointer to the compiled scanner settings.
          * \param outputSettings Pointer to the JSON object with output settings.
-         * \param scanAreaSettings Pointer to the JSON object with scan area settings.
+         * \param scanAreaSettings Pointer to the compiled scan area settings.
          */
         explicit LoadScanItemCommand(
-                const nlohmann::json *scannerSettings, const nlohmann::json *outputSettings,
-                const nlohmann::json *scanAreaSettings)
+                const OptionSnapshot *scannerSettings, const nlohmann::json *outputSettings,
+                const OptionSnapshot *scanAreaSettings)
             : m_ScannerSettings(scannerSettings)
             , m_OutputSettings(outputSettings)
             , m_ScanAreaSettings(scanAreaSettings)
@@ -55,21 +55,29 @@ namespace Gorfector
         Execute(const LoadScanItemCommand &command, DeviceOptionsState *deviceOptions,
                 OutputOptionsState *outputOptions)
         {
-            if (command.m_ScannerSettings != nullptr && !command.m_ScannerSettings->empty())
+            auto hasScannerSettings =
+                    command.m_ScannerSettings != nullptr && command.m_ScannerSettings->GetOptionCount() > 0;
+            auto hasScanArea =
+                    command.m_ScanAreaSettings != nullptr && command.m_ScanAreaSettings->GetOptionCount() > 0;
+            if (hasScannerSettings || hasScanArea)
             {
+                // Send the scanner settings and the scan area to the device together.
                 auto deviceOptionsUpdater = DeviceOptionsState::Updater(deviceOptions);
-                deviceOptionsUpdater.ApplySettings(*command.m_ScannerSettings);
+                deviceOptionsUpdater.BeginBatch();
+                if (hasScannerSettings)
+                {
+                    deviceOptionsUpdater.ApplySettings(*command.m_ScannerSettings);
+                }
+                if (hasScanArea)
+                {
+                    deviceOptionsUpdater.ApplyScanArea(*command.m_ScanAreaSettings);
+                }
             }
             if (command.m_OutputSettings != nullptr && !command.m_OutputSettings->empty())
             {
                 auto outputOptionsUpdater = OutputOptionsState::Updater(outputOptions);
                 outputOptionsUpdater.ApplySettings(*command.m_OutputSettings);
             }
-            if (command.m_ScanAreaSettings != nullptr && !command.m_ScanAreaSettings->empty())
-            {
-                auto deviceOptionsUpdater = DeviceOptionsState::Updater(deviceOptions);
-                deviceOptionsUpdater.ApplyScanArea(*command.m_ScanAreaSettings);
-            }
         }
     };
 }
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Writers/JpegWriterState.hpp"
+#include "ZooLib/Command.hpp"
+
+namespace Gorfector
+{
+    /**
+     * \class SetJpegWorkerCount
+     * \brief Command class to set the number of threads compressing bands of the image in the `JpegWriterState`.
+     */
+    class SetJpegWorkerCount : public ZooLib::Command
+    {
+        /**
+         * \brief The desired number of threads compressing bands of the image for the JPEG writer.
+         */
+        const int m_WorkerCount{};
+
+    public:
+        /**
+         * \brief Constructor for the SetJpegWorkerCount command.
+         * \param workerCount The desired number of threads compressing bands of the image.
+         */
+        explicit SetJpegWorkerCount(int workerCount)
+            : m_WorkerCount(workerCount)
+        {
+        }
+
+        /**
+         * \brief Executes the command to set the number of threads compressing bands of the image.
+         * \param command The `SetJpegWorkerCount` instance containing the desired value.
+         * \param jpegWriterState Pointer to the `JpegWriterState` to update.
+         */
+        static void Execute(const SetJpegWorkerCount &command, JpegWriterState *jpegWriterState)
+        {
+            auto updater = JpegWriterState::Updater(jpegWriterState);
+            updater.SetWorkerCount(command.m_WorkerCount);
+        }
+    };
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Writers/PngWriterState.hpp"
+#include "ZooLib/Command.hpp"
+
+namespace Gorfector
+{
+    /**
+     * \class SetPngWorkerCount
+     * \brief Command class to set the number of threads compressing the image data in the `PngWriterState`.
+     */
+    class SetPngWorkerCount : public ZooLib::Command
+    {
+        /**
+         * \brief The desired number of threads compressing the image data for the PNG writer.
+         */
+        const int m_WorkerCount{};
+
+    public:
+        /**
+         * \brief Constructor for the SetPngWorkerCount command.
+         * \param workerCount The desired number of threads compressing the image data.
+         */
+        explicit SetPngWorkerCount(int workerCount)
+            : m_WorkerCount(workerCount)
+        {
+        }
+
+        /**
+         * \brief Executes the command to set the number of threads compressing the image data.
+         * \param command The `SetPngWorkerCount` instance containing the desired value.
+         * \param pngWriterState Pointer to the `PngWriterState` to update.
+         */
+        static void Execute(const SetPngWorkerCount &command, PngWriterState *pngWriterState)
+        {
+            auto updater = PngWriterState::Updater(pngWriterState);
+            updater.SetWorkerCount(command.m_WorkerCount);
+        }
+    };
+}
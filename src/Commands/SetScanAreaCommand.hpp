@@ -40,6 +40,7 @@ namespace Gorfector
         static void Execute(const SetScanAreaCommand &command, DeviceOptionsState *deviceOptionState)
         {
             auto updater = DeviceOptionsState::Updater(deviceOptionState);
+            updater.BeginBatch();
             updater.SetOptionValue(deviceOptionState->GetTLXIndex(), 0, command.m_ScanArea.x);
             updater.SetOptionValue(deviceOptionState->GetTLYIndex(), 0, command.m_ScanArea.y);
             updater.SetOptionValue(
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Writers/TiffWriterState.hpp"
+#include "ZooLib/Command.hpp"
+
+namespace Gorfector
+{
+    /**
+     * \class SetTiffStripHeight
+     * \brief Command class to set the number of lines per strip in the `TiffWriterState`.
+     */
+    class SetTiffStripHeight : public ZooLib::Command
+    {
+        /**
+         * \brief The desired number of lines per strip for the TIFF writer.
+         */
+        const int m_StripHeight{};
+
+    public:
+        /**
+         * \brief Constructor for the SetTiffStripHeight command.
+         * \param stripHeight The desired number of lines per strip.
+         */
+        explicit SetTiffStripHeight(int stripHeight)
+            : m_StripHeight(stripHeight)
+        {
+        }
+
+        /**
+         * \brief Executes the command to set the number of lines per strip.
+         * \param command The `SetTiffStripHeight` instance containing the desired value.
+         * \param tiffWriterState Pointer to the `TiffWriterState` to update.
+         */
+        static void Execute(const SetTiffStripHeight &command, TiffWriterState *tiffWriterState)
+        {
+            auto updater = TiffWriterState::Updater(tiffWriterState);
+            updater.SetStripHeight(command.m_StripHeight);
+        }
+    };
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Writers/TiffWriterState.hpp"
+#include "ZooLib/Command.hpp"
+
+namespace Gorfector
+{
+    /**
+     * \class SetTiffTiledPyramid
+     * \brief Command class to set the tiled pyramid option in the `TiffWriterState`.
+     */
+    class SetTiffTiledPyramid : public ZooLib::Command
+    {
+        /**
+         * \brief The desired tiled pyramid option for the TIFF writer.
+         */
+        const bool m_TiledPyramid{};
+
+    public:
+        /**
+         * \brief Constructor for the SetTiffTiledPyramid command.
+         * \param tiledPyramid The desired tiled pyramid option.
+         */
+        explicit SetTiffTiledPyramid(bool tiledPyramid)
+            : m_TiledPyramid(tiledPyramid)
+        {
+        }
+
+        /**
+         * \brief Executes the command to set the tiled pyramid option.
+         * \param command The `SetTiffTiledPyramid` instance containing the desired value.
+         * \param tiffWriterState Pointer to the `TiffWriterState` to update.
+         */
+        static void Execute(const SetTiffTiledPyramid &command, TiffWriterState *tiffWriterState)
+        {
+            auto updater = TiffWriterState::Updater(tiffWriterState);
+            updater.SetTiledPyramid(command.m_TiledPyramid);
+        }
+    };
+}
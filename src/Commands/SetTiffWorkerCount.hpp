@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Writers/TiffWriterState.hpp"
+#include "ZooLib/Command.hpp"
+
+namespace Gorfector
+{
+    /**
+     * \class SetTiffWorkerCount
+     * \brief Command class to set the number of threads compressing strips in the `TiffWriterState`.
+     */
+    class SetTiffWorkerCount : public ZooLib::Command
+    {
+        /**
+         * \brief The desired number of threads compressing strips for the TIFF writer.
+         */
+        const int m_WorkerCount{};
+
+    public:
+        /**
+         * \brief Constructor for the SetTiffWorkerCount command.
+         * \param workerCount The desired number of threads compressing strips.
+         */
+        explicit SetTiffWorkerCount(int workerCount)
+            : m_WorkerCount(workerCount)
+        {
+        }
+
+        /**
+         * \brief Executes the command to set the number of threads compressing strips.
+         * \param command The `SetTiffWorkerCount` instance containing the desired value.
+         * \param tiffWriterState Pointer to the `TiffWriterState` to update.
+         */
+        static void Execute(const SetTiffWorkerCount &command, TiffWriterState *tiffWriterState)
+        {
+            auto updater = TiffWriterState::Updater(tiffWriterState);
+            updater.SetWorkerCount(command.m_WorkerCount);
+        }
+    };
+}
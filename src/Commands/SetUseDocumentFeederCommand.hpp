@@ -0,0 +1,41 @@
+#pragma once
+
+#include "OutputOptionsState.hpp"
+#include "ZooLib/Command.hpp"
+
+namespace Gorfector
+{
+    /**
+     * \class SetUseDocumentFeederCommand
+     * \brief Command class to set the option for scanning pages until the document feeder is empty in the
+     * `OutputOptionsState`.
+     */
+    class SetUseDocumentFeederCommand : public ZooLib::Command
+    {
+        /**
+         * \brief Indicates whether pages should be scanned until the document feeder is empty.
+         */
+        bool m_UseDocumentFeeder{};
+
+    public:
+        /**
+         * \brief Constructor for the SetUseDocumentFeederCommand.
+         * \param useDocumentFeeder A boolean indicating whether to scan pages until the document feeder is empty.
+         */
+        explicit SetUseDocumentFeederCommand(bool useDocumentFeeder)
+            : m_UseDocumentFeeder(useDocumentFeeder)
+        {
+        }
+
+        /**
+         * \brief Executes the command to set the document feeder option.
+         * \param command The `SetUseDocumentFeederCommand` instance containing the desired option.
+         * \param outputOptionsState Pointer to the `OutputOptionsState` where the option will be updated.
+         */
+        static void Execute(const SetUseDocumentFeederCommand &command, OutputOptionsState *outputOptionsState)
+        {
+            auto updater = OutputOptionsState::Updater(outputOptionsState);
+            updater.SetUseDocumentFeeder(command.m_UseDocumentFeeder);
+        }
+    };
+}
@@ -31,6 +31,11 @@ namespace Gorfector
          */
         TModifiedState *m_ModifiedState;
 
+        /**
+         * \brief Receives the changes of the application state, reused on every update.
+         */
+        AppStateChangeset m_AppStateChangeset{0};
+
     protected:
         /**
          * \brief Updates the modified state when the current device changes.
@@ -40,8 +45,9 @@ namespace Gorfector
          */
         void UpdateImplementation() override
         {
-            auto changeset = m_AppState->GetAggregatedChangeset(m_ObservedComponentVersions[0]);
-            if (changeset != nullptr && changeset->IsChanged(AppStateChangeset::ChangeTypeFlag::e_CurrentDevice))
+            m_AppState->AggregateChangesets(m_ObservedComponentVersions[0], m_AppStateChangeset);
+            const auto *changeset = &m_AppStateChangeset;
+            if (changeset->IsChanged(AppStateChangeset::ChangeTypeFlag::e_CurrentDevice))
             {
                 auto currentDeviceName = m_AppState->GetCurrentDeviceName();
                 auto device = m_DeviceSelectorState->GetDeviceByName(currentDeviceName);
@@ -50,7 +56,7 @@ namespace Gorfector
                 auto updater = typename TModifiedState::Updater(m_ModifiedState);
                 updater.SetCurrentDeviceName(vendorName, modelName);
             }
-            if (changeset != nullptr && changeset->IsChanged(AppStateChangeset::ChangeTypeFlag::e_ScanActivity))
+            if (changeset->IsChanged(AppStateChangeset::ChangeTypeFlag::e_ScanActivity))
             {
                 auto scanActivity = m_AppState->IsPreviewing() || m_AppState->IsScanning();
                 auto updater = typename TModifiedState::Updater(m_ModifiedState);
@@ -0,0 +1,116 @@
+#include "DeviceDiscovery.hpp"
+
+Gorfector::DeviceDiscovery::DeviceDiscovery(std::function<void()> onCompleted)
+    : m_OnCompleted(std::move(onCompleted))
+{
+    m_Thread = std::thread(&DeviceDiscovery::Run, this);
+}
+
+Gorfector::DeviceDiscovery::~DeviceDiscovery()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Stopping = true;
+        // A discovery that did not start yet is not needed anymore.
+        m_Requested = false;
+    }
+    m_Condition.notify_all();
+
+    // SANE cannot be interrupted: wait for the running discovery.
+    m_Thread.join();
+}
+
+Gorfector::DeviceDiscovery::Result Gorfector::DeviceDiscovery::Discover(bool networkLookUp)
+{
+    Result result;
+
+    // Although the SANE documentation states that sane_get_devices() can pick up newly available devices,
+    // it does not seem to be the case. Re-init SANE to get the latest devices (this invalidates all previous
+    // SANE data).
+    SANE_Int saneVersion;
+    sane_exit();
+    if (SANE_STATUS_GOOD != sane_init(&saneVersion, nullptr))
+    {
+        sane_exit();
+        return result;
+    }
+
+    result.Succeeded = true;
+
+    const SANE_Device **deviceList;
+    SANE_Status status = sane_get_devices(&deviceList, networkLookUp ? SANE_FALSE : SANE_TRUE);
+    if (status == SANE_STATUS_GOOD)
+    {
+        for (auto i = 0; deviceList[i] != nullptr; i++)
+        {
+            result.Devices.emplace_back(deviceList[i]);
+        }
+    }
+
+    return result;
+}
+
+void Gorfector::DeviceDiscovery::Start(bool networkLookUp)
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Requested = true;
+        m_NetworkLookUp = networkLookUp;
+    }
+    m_Condition.notify_all();
+}
+
+bool Gorfector::DeviceDiscovery::IsRunning()
+{
+    std::lock_guard lock(m_Mutex);
+    return m_Requested || m_Running;
+}
+
+std::optional<Gorfector::DeviceDiscovery::Result> Gorfector::DeviceDiscovery::TakeResult()
+{
+    std::lock_guard lock(m_Mutex);
+    return std::exchange(m_Result, std::nullopt);
+}
+
+std::optional<Gorfector::DeviceDiscovery::Result> Gorfector::DeviceDiscovery::WaitForResult()
+{
+    std::unique_lock lock(m_Mutex);
+    m_Condition.wait(lock, [this]() { return !m_Requested && !m_Running; });
+    return std::exchange(m_Result, std::nullopt);
+}
+
+void Gorfector::DeviceDiscovery::Run()
+{
+    std::unique_lock lock(m_Mutex);
+    while (true)
+    {
+        m_Condition.wait(lock, [this]() { return m_Stopping || m_Requested; });
+        if (!m_Requested)
+        {
+            // Stopping, and nothing left to do.
+            return;
+        }
+
+        auto networkLookUp = m_NetworkLookUp;
+        m_Requested = false;
+        m_Running = true;
+
+        lock.unlock();
+        auto result = Discover(networkLookUp);
+        lock.lock();
+
+        m_Result = std::move(result);
+        // Report the completion only when no other discovery is pending, so that the result is the latest one.
+        m_Running = false;
+        if (!m_Requested)
+        {
+            m_Condition.notify_all();
+            if (m_OnCompleted)
+            {
+                lock.unlock();
+                m_OnCompleted();
+                lock.lock();
+            }
+        }
+    }
+}
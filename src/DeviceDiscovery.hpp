@@ -0,0 +1,99 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "SaneDevice.hpp"
+
+namespace Gorfector
+{
+    /**
+     * \class DeviceDiscovery
+     * \brief Lists the available SANE devices on a worker thread.
+     *
+     * Listing the devices reinitializes SANE (see `Discover()`) and can take several seconds when network look up is
+     * enabled. A discovery started with `Start()` runs on the worker thread; when it completes, the completion
+     * callback is called on the worker thread and the result can be taken with `TakeResult()`.
+     *
+     * Since SANE is reinitialized, no other thread may call SANE while a discovery is running, and all the handles
+     * opened before the discovery are invalidated.
+     */
+    class DeviceDiscovery
+    {
+    public:
+        /**
+         * \brief The outcome of a discovery.
+         */
+        struct Result
+        {
+            bool Succeeded{}; ///< False if SANE could not be initialized.
+            std::vector<SaneDeviceInfo> Devices{}; ///< The devices found, in the order returned by SANE.
+        };
+
+    private:
+        std::function<void()> m_OnCompleted{};
+
+        std::mutex m_Mutex{};
+        std::condition_variable m_Condition{};
+        bool m_Requested{};
+        bool m_NetworkLookUp{};
+        bool m_Running{};
+        bool m_Stopping{};
+        std::optional<Result> m_Result{};
+
+        std::thread m_Thread{};
+
+        void Run();
+
+    public:
+        /**
+         * \brief Constructs a device discovery and starts its worker thread.
+         * \param onCompleted Called on the worker thread each time a discovery completes. May be empty.
+         */
+        explicit DeviceDiscovery(std::function<void()> onCompleted);
+
+        DeviceDiscovery(const DeviceDiscovery &) = delete;
+        DeviceDiscovery &operator=(const DeviceDiscovery &) = delete;
+
+        /**
+         * \brief Waits for the running discovery, if any, and stops the worker thread.
+         */
+        ~DeviceDiscovery();
+
+        /**
+         * \brief Reinitializes SANE and lists the available devices. This blocks the calling thread.
+         * \param networkLookUp Whether to look for network devices.
+         * \return The devices found.
+         */
+        static Result Discover(bool networkLookUp);
+
+        /**
+         * \brief Requests a discovery. If a discovery is already running, another one is started once it completes.
+         * \param networkLookUp Whether to look for network devices.
+         */
+        void Start(bool networkLookUp);
+
+        /**
+         * \brief Checks whether a discovery is requested or running.
+         * \return True if a discovery is requested or running.
+         */
+        [[nodiscard]] bool IsRunning();
+
+        /**
+         * \brief Takes the result of the last completed discovery.
+         * \return The result, or no value if no discovery completed since the last call.
+         */
+        std::optional<Result> TakeResult();
+
+        /**
+         * \brief Waits until no discovery is requested or running, then takes the result of the last one.
+         * \return The result, or no value if no discovery completed since the last call to `TakeResult()`.
+         */
+        std::optional<Result> WaitForResult();
+    };
+}
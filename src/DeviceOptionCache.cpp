@@ -0,0 +1,153 @@
+#include "DeviceOptionCache.hpp"
+
+#include <format>
+
+Gorfector::DeviceOptionCache::DeviceOptionCache(std::filesystem::path filePath)
+    : m_FilePath(std::move(filePath))
+{
+}
+
+std::string Gorfector::DeviceOptionCache::GetModelKey(std::string_view vendor, std::string_view model)
+{
+    // Vendor and model names do not contain control characters.
+    return std::format("{}\x1f{}\x1f", vendor, model);
+}
+
+void Gorfector::DeviceOptionCache::Load()
+{
+    if (m_Loaded)
+    {
+        return;
+    }
+    m_Loaded = true;
+
+    if (auto snapshots = OptionSnapshotFile::Read(m_FilePath); snapshots.has_value())
+    {
+        m_Snapshots = std::move(*snapshots);
+    }
+}
+
+nlohmann::json Gorfector::DeviceOptionCache::DescribeOptions(const SaneDevice *device, int optionCount)
+{
+    auto options = nlohmann::json::array();
+
+    for (auto i = 1; i < optionCount; i++)
+    {
+        auto option = device->GetOptionDescriptor(i);
+        if (option == nullptr)
+        {
+            continue;
+        }
+
+        std::string description{};
+        if (option->desc != nullptr)
+        {
+            auto descLen = std::strlen(option->desc);
+            description.reserve(descLen);
+            auto n = 0UZ;
+            while (n < descLen)
+            {
+                if (option->desc[n] == '"')
+                {
+                    description += "\\\"";
+                }
+                else
+                {
+                    description += option->desc[n];
+                }
+                n++;
+            }
+        }
+
+        auto stringListJson = nlohmann::json::array();
+        if (option->type == SANE_TYPE_STRING && option->constraint_type == SANE_CONSTRAINT_STRING_LIST)
+        {
+            auto stringList = option->constraint.string_list;
+            if (stringList != nullptr && stringList[0] != nullptr)
+            {
+                for (auto j = 0; stringList[j] != nullptr; j++)
+                {
+                    stringListJson.push_back(stringList[j]);
+                }
+            }
+        }
+
+        auto title = option->title == nullptr ? "" : option->title;
+
+        auto name = option->name == nullptr ? "<no name>" : option->name;
+
+        auto flags = std::vector<std::string>{};
+        if (SaneDevice::IsAdvanced(*option))
+        {
+            flags.emplace_back("advanced");
+        }
+        if (SaneDevice::IsDisplayOnly(*option))
+        {
+            flags.emplace_back("display only");
+        }
+
+        auto flagsStr = std::string{};
+        if (!flags.empty())
+        {
+            flagsStr = flags[0];
+            for (auto j = 1UZ; j < flags.size(); j++)
+            {
+                flagsStr += ", ";
+                flagsStr += flags[j];
+            }
+        }
+        std::string comment{};
+        comment += name;
+        comment += " (";
+        comment += flagsStr;
+        comment += ")";
+
+        auto jsonOption = nlohmann::json();
+        jsonOption["id"] = i;
+        jsonOption["title"] = title;
+        jsonOption["description"] = description;
+        jsonOption["string_list"] = stringListJson;
+        jsonOption["flags"] = nlohmann::json::array();
+        jsonOption["comment"] = comment;
+
+        options.push_back(jsonOption);
+    }
+
+    return options;
+}
+
+std::string Gorfector::DeviceOptionCache::GetOptionHash(const nlohmann::json &options)
+{
+    auto optionDump = options.dump();
+    auto hash = std::hash<std::string>{}(optionDump);
+    return std::format("{:x}", hash);
+}
+
+const Gorfector::OptionSnapshot *
+Gorfector::DeviceOptionCache::Find(std::string_view vendor, std::string_view model, std::string_view optionHash)
+{
+    Load();
+
+    auto key = GetModelKey(vendor, model);
+    key += optionHash;
+    auto it = m_Snapshots.find(key);
+    return it == m_Snapshots.end() ? nullptr : &it->second;
+}
+
+void Gorfector::DeviceOptionCache::Store(
+        std::string_view vendor, std::string_view model, std::string_view optionHash, OptionSnapshot values)
+{
+    Load();
+
+    auto modelKey = GetModelKey(vendor, model);
+    std::erase_if(m_Snapshots, [&modelKey](const auto &entry) { return entry.first.starts_with(modelKey); });
+
+    auto key = modelKey;
+    key += optionHash;
+    m_Snapshots.insert_or_assign(std::move(key), std::move(values));
+
+    if (!OptionSnapshotFile::Write(m_FilePath, m_Snapshots))
+    {
+        g_warning("Failed to write the option cache %s", m_FilePath.c_str());
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+
+#include "OptionSnapshot.hpp"
+#include "SaneDevice.hpp"
+
+namespace Gorfector
+{
+    /**
+     * \class DeviceOptionCache
+     * \brief Remembers the option values a device reports when it is opened, by vendor, model and option hash.
+     *
+     * Reading the value of an option is a round trip to the device, which takes a long time for network scanners.
+     * When a device with the same options as a cached one is opened, the options are built from the cached values
+     * and the values are read from the device later.
+     *
+     * The option hash is the one written by `OptionRewriter::Dump()`. The cache is stored in a file using the
+     * `OptionSnapshotFile` format, and only the latest option hash of each device model is kept.
+     */
+    class DeviceOptionCache
+    {
+        std::filesystem::path m_FilePath{};
+        std::map<std::string, OptionSnapshot> m_Snapshots{};
+        bool m_Loaded{};
+
+        static std::string GetModelKey(std::string_view vendor, std::string_view model);
+
+        void Load();
+
+    public:
+        /**
+         * \brief Constructs a cache stored in a file. The file is read on first use.
+         * \param filePath The path of the file.
+         */
+        explicit DeviceOptionCache(std::filesystem::path filePath);
+
+        /**
+         * \brief Describes the options of a device, as `OptionRewriter::Dump()` writes them.
+         * \param device The device, which must be opened.
+         * \param optionCount The number of options of the device, including option 0.
+         * \return An array with the description of each option.
+         */
+        static nlohmann::json DescribeOptions(const SaneDevice *device, int optionCount);
+
+        /**
+         * \brief Computes the hash of option descriptions.
+         * \param options The option descriptions, as returned by `DescribeOptions()`.
+         * \return The hash, as an hexadecimal string.
+         */
+        static std::string GetOptionHash(const nlohmann::json &options);
+
+        /**
+         * \brief Finds the cached option values of a device.
+         * \param vendor The vendor of the device.
+         * \param model The model of the device.
+         * \param optionHash The hash of the option descriptions of the device.
+         * \return The option values, or nullptr if they are not in the cache.
+         */
+        const OptionSnapshot *Find(std::string_view vendor, std::string_view model, std::string_view optionHash);
+
+        /**
+         * \brief Stores the option values of a device and writes the cache file. The values previously stored for
+         * the same model are replaced.
+         * \param vendor The vendor of the device.
+         * \param model The model of the device.
+         * \param optionHash The hash of the option descriptions of the device.
+         * \param values The option values.
+         */
+        void Store(std::string_view vendor, std::string_view model, std::string_view optionHash, OptionSnapshot values);
+    };
+}
@@ -1,9 +1,14 @@
+#include <algorithm>
 #include <cstring>
 #include <glib.h>
 #include <memory>
 
 #include "DeviceOptionsState.hpp"
 #include "SaneDevice.hpp"
+#include "ZooLib/Profiler.hpp"
+
+static const ZooLib::Profiler::Metric s_BatchRoundTrips{"options.batch.round_trips", ZooLib::Profiler::Unit::e_Count};
+static const ZooLib::Profiler::Metric s_BatchReloads{"options.batch.reloads", ZooLib::Profiler::Unit::e_Count};
 
 static int EnsureBufferSize(std::unique_ptr<char8_t[]> &buffer, int currentSize, int requestedSize)
 {
@@ -21,7 +26,63 @@ static int EnsureBufferSize(std::unique_ptr<char8_t[]> &buffer, int currentSize,
     return currentSize;
 }
 
-void Gorfector::DeviceOptionsState::ReloadOptions() const
+// Copies a cached value to a SANE value buffer, if it matches the option descriptor.
+static bool ReadCachedValue(
+        const Gorfector::OptionSnapshot::Option &cachedValue, const SANE_Option_Descriptor &optionDescriptor,
+        char8_t *value)
+{
+    using ValueType = Gorfector::OptionSnapshot::ValueType;
+
+    switch (optionDescriptor.type)
+    {
+        case SANE_TYPE_BOOL:
+        {
+            if (cachedValue.GetType() != ValueType::e_Bool || cachedValue.GetValueCount() != 1)
+            {
+                return false;
+            }
+            *reinterpret_cast<SANE_Bool *>(value) = cachedValue.GetBool(0) ? SANE_TRUE : SANE_FALSE;
+            return true;
+        }
+
+        case SANE_TYPE_INT:
+        case SANE_TYPE_FIXED:
+        {
+            auto numberOfElements = optionDescriptor.size / static_cast<SANE_Int>(sizeof(SANE_Word));
+            if (cachedValue.GetType() != ValueType::e_Int ||
+                cachedValue.GetValueCount() != static_cast<uint32_t>(numberOfElements))
+            {
+                return false;
+            }
+            for (auto i = 0; i < numberOfElements; i++)
+            {
+                reinterpret_cast<SANE_Word *>(value)[i] = cachedValue.GetInt(i);
+            }
+            return true;
+        }
+
+        case SANE_TYPE_STRING:
+        {
+            if (cachedValue.GetType() != ValueType::e_String || cachedValue.GetValueCount() != 1)
+            {
+                return false;
+            }
+            auto string = cachedValue.GetString(0);
+            if (string.size() >= static_cast<size_t>(optionDescriptor.size))
+            {
+                return false;
+            }
+            std::memcpy(value, string.data(), string.size());
+            value[string.size()] = 0;
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+void Gorfector::DeviceOptionsState::ReloadOptions(bool updateRequestedValues) const
 {
     auto device = GetDevice();
     if (device == nullptr)
@@ -29,45 +90,71 @@ void Gorfector::DeviceOptionsState::ReloadOptions() const
         return;
     }
 
+    ApplyOptionValues(ReadOptionValues(device), updateRequestedValues);
+}
+
+Gorfector::DeviceOptionsState::OptionValueBuffers
+Gorfector::DeviceOptionsState::ReadOptionValues(const SaneDevice *device)
+{
+    OptionValueBuffers values;
+
     int optionCount;
-    if (!device->GetOptionValue(0, &optionCount))
+    if (!device->GetOptionValue(0, &optionCount) || optionCount < 1)
     {
-        return;
+        return values;
     }
 
-    int valueBufferSize = sizeof(SANE_Word) * 512;
-    std::unique_ptr<char8_t[]> value(new char8_t[valueBufferSize]);
-
+    values.resize(optionCount);
     for (auto optionIndex = 1; optionIndex < optionCount; optionIndex++)
     {
         const SANE_Option_Descriptor *optionDescriptor = device->GetOptionDescriptor(optionIndex);
-        if (optionDescriptor == nullptr)
+        if (optionDescriptor == nullptr || optionDescriptor->type == SANE_TYPE_GROUP ||
+            optionDescriptor->type == SANE_TYPE_BUTTON || optionDescriptor->size <= 0 ||
+            optionDescriptor->size > (1 << 24))
         {
             continue;
         }
 
-        if (optionDescriptor->type != SANE_TYPE_GROUP && optionDescriptor->type != SANE_TYPE_BUTTON)
+        auto &value = values[optionIndex];
+        value.resize(optionDescriptor->size);
+        if (!device->GetOptionValue(optionIndex, value.data()))
         {
-            valueBufferSize = EnsureBufferSize(value, valueBufferSize, optionDescriptor->size);
-            if (valueBufferSize < optionDescriptor->size)
-            {
-                continue;
-            }
+            value.clear();
+        }
+    }
 
-            if (!device->GetOptionValue(optionIndex, value.get()))
-            {
-                continue;
-            }
+    return values;
+}
+
+void Gorfector::DeviceOptionsState::ApplyOptionValues(
+        const OptionValueBuffers &values, bool updateRequestedValues) const
+{
+    auto optionCount = std::min(values.size(), m_OptionValues.size());
+    for (auto optionIndex = 1UZ; optionIndex < optionCount; optionIndex++)
+    {
+        const auto &value = values[optionIndex];
+        auto optionValue = m_OptionValues[optionIndex];
+        if (value.empty() || optionValue == nullptr)
+        {
+            continue;
         }
 
-        switch (optionDescriptor->type)
+        switch (optionValue->GetValueType())
         {
             case SANE_TYPE_BOOL:
             {
-                auto *settingValue = dynamic_cast<DeviceOptionValue<bool> *>(m_OptionValues[optionIndex]);
-                if (settingValue != nullptr)
+                auto *settingValue = dynamic_cast<DeviceOptionValue<bool> *>(optionValue);
+                if (settingValue != nullptr && value.size() >= sizeof(SANE_Bool))
                 {
-                    settingValue->SetDeviceValue(0, (*reinterpret_cast<SANE_Bool *>(value.get())));
+                    bool deviceValue = *reinterpret_cast<const SANE_Bool *>(value.data());
+                    if (updateRequestedValues)
+                    {
+                        settingValue->SetValues(0, deviceValue, deviceValue);
+                    }
+                    else
+                    {
+                        settingValue->SetDeviceValue(0, deviceValue);
+                    }
                 }
                 break;
             }
@@ -75,16 +162,24 @@ void Gorfector::DeviceOptionsState::ReloadOptions() const
             case SANE_TYPE_INT:
             case SANE_TYPE_FIXED:
             {
-                int numberOfElements = static_cast<int>(optionDescriptor->size / sizeof(SANE_Word));
+                int numberOfElements = static_cast<int>(value.size() / sizeof(SANE_Word));
                 if (numberOfElements > 4)
                     break;
 
-                auto *intValue = dynamic_cast<DeviceOptionValue<int> *>(m_OptionValues[optionIndex]);
+                auto *intValue = dynamic_cast<DeviceOptionValue<int> *>(optionValue);
                 if (intValue != nullptr)
                 {
                     for (auto i = 0; i < numberOfElements; i++)
                     {
-                        intValue->SetDeviceValue(i, reinterpret_cast<SANE_Int *>(value.get())[i]);
+                        auto deviceValue = reinterpret_cast<const SANE_Int *>(value.data())[i];
+                        if (updateRequestedValues)
+                        {
+                            intValue->SetValues(i, deviceValue, deviceValue);
+                        }
+                        else
+                        {
+                            intValue->SetDeviceValue(i, deviceValue);
+                        }
                     }
                 }
                 break;
@@ -92,10 +187,20 @@ void Gorfector::DeviceOptionsState::ReloadOptions() const
 
             case SANE_TYPE_STRING:
             {
-                auto *strValue = dynamic_cast<DeviceOptionValue<std::string> *>(m_OptionValues[optionIndex]);
+                auto *strValue = dynamic_cast<DeviceOptionValue<std::string> *>(optionValue);
                 if (strValue != nullptr)
                 {
-                    strValue->SetDeviceValue(0, std::string(reinterpret_cast<SANE_String>(value.get())));
+                    // The device may fill the whole buffer, without a terminating null.
+                    auto *chars = reinterpret_cast<const char *>(value.data());
+                    auto deviceValue = std::string(chars, strnlen(chars, value.size()));
+                    if (updateRequestedValues)
+                    {
+                        strValue->SetValues(0, deviceValue, deviceValue);
+                    }
+                    else
+                    {
+                        strValue->SetDeviceValue(0, deviceValue);
+                    }
                 }
                 break;
             }
@@ -106,6 +211,59 @@ void Gorfector::DeviceOptionsState::ReloadOptions() const
     }
 }
 
+static gboolean DispatchRefreshCompletedSource(GSource *source, GSourceFunc callback, gpointer data)
+{
+    g_source_set_ready_time(source, -1);
+    return callback(data);
+}
+
+void Gorfector::DeviceOptionsState::StartRefresh(SaneDevice *device)
+{
+    static GSourceFuncs s_RefreshCompletedSourceFuncs = []() {
+        GSourceFuncs funcs{};
+        funcs.dispatch = DispatchRefreshCompletedSource;
+        return funcs;
+    }();
+
+    m_RefreshCompletedSource = g_source_new(&s_RefreshCompletedSourceFuncs, sizeof(GSource));
+    g_source_set_name(m_RefreshCompletedSource, "Gorfector option values refresh");
+    g_source_set_callback(
+            m_RefreshCompletedSource,
+            [](gpointer data) -> gboolean {
+                Updater(static_cast<DeviceOptionsState *>(data)).RefreshCachedValues();
+                return G_SOURCE_REMOVE;
+            },
+            this, nullptr);
+    g_source_attach(m_RefreshCompletedSource, nullptr);
+
+    // The other uses of the device wait for the task, and closing or deleting the device too. The task does not
+    // use this object, which can be deleted first: it keeps a reference on the source.
+    std::promise<OptionValueBuffers> refreshedValues;
+    m_RefreshedValues = refreshedValues.get_future();
+    device->RunInBackground([device, source = g_source_ref(m_RefreshCompletedSource),
+                             refreshedValues = std::move(refreshedValues)]() mutable {
+        refreshedValues.set_value(ReadOptionValues(device));
+        g_source_set_ready_time(source, 0);
+        g_source_unref(source);
+    });
+}
+
+Gorfector::DeviceOptionsState::OptionValueBuffers Gorfector::DeviceOptionsState::WaitForRefresh()
+{
+    DestroyRefreshSource();
+    return m_RefreshedValues.valid() ? m_RefreshedValues.get() : OptionValueBuffers{};
+}
+
+void Gorfector::DeviceOptionsState::DestroyRefreshSource()
+{
+    if (m_RefreshCompletedSource != nullptr)
+    {
+        g_source_destroy(m_RefreshCompletedSource);
+        g_source_unref(m_RefreshCompletedSource);
+        m_RefreshCompletedSource = nullptr;
+    }
+}
+
 void Gorfector::DeviceOptionsState::BuildOptions()
 {
     Clear();
@@ -122,6 +280,22 @@ void Gorfector::DeviceOptionsState::BuildOptions()
         return;
     }
 
+    // Reading the option descriptors does not need a round trip to the device for each option, but reading the
+    // values does. If the device has the same options as when its values were cached, use the cached values.
+    const OptionSnapshot *cachedSnapshot = nullptr;
+    std::unordered_map<std::string_view, OptionSnapshot::Option> cachedValues;
+    if (m_OptionCache != nullptr)
+    {
+        m_OptionHash = DeviceOptionCache::GetOptionHash(DeviceOptionCache::DescribeOptions(device, optionCount));
+        cachedSnapshot = m_OptionCache->Find(device->GetVendor(), device->GetModel(), m_OptionHash);
+    }
+    if (cachedSnapshot != nullptr)
+    {
+        cachedSnapshot->ForEachOption([&cachedValues](const OptionSnapshot::Option &option) {
+            cachedValues.emplace(option.GetName(), option);
+        });
+    }
+
     int valueBufferSize = sizeof(SANE_Word) * 512;
     std::unique_ptr<char8_t[]> value(new char8_t[valueBufferSize]);
 
@@ -141,7 +315,14 @@ void Gorfector::DeviceOptionsState::BuildOptions()
                 continue;
             }
 
-            if (!device->GetOptionValue(optionIndex, value.get()))
+            auto cachedValue =
+                    optionDescriptor->name == nullptr ? cachedValues.end() : cachedValues.find(optionDescriptor->name);
+            if (cachedValue != cachedValues.end() &&
+                ReadCachedValue(cachedValue->second, *optionDescriptor, value.get()))
+            {
+                m_ValuesFromCache = true;
+            }
+            else if (!device->GetOptionValue(optionIndex, value.get()))
             {
                 continue;
             }
@@ -191,10 +372,83 @@ void Gorfector::DeviceOptionsState::BuildOptions()
                 break;
         }
     }
+
+    if (m_ValuesFromCache)
+    {
+        // Read the actual values without blocking the display of the options.
+        StartRefresh(device);
+    }
+    else if (m_OptionCache != nullptr)
+    {
+        if (auto snapshot = OptionSnapshot::FromJson(SerializeValues()); snapshot.has_value())
+        {
+            m_OptionCache->Store(device->GetVendor(), device->GetModel(), m_OptionHash, std::move(*snapshot));
+        }
+    }
+}
+
+nlohmann::json Gorfector::DeviceOptionsState::SerializeValues() const
+{
+    auto values = nlohmann::json::object();
+    for (auto optionValue: m_OptionValues)
+    {
+        if (optionValue != nullptr)
+        {
+            optionValue->Serialize(values);
+        }
+    }
+    return values;
+}
+
+void Gorfector::DeviceOptionsState::Updater::RefreshCachedValues()
+{
+    if (!m_StateComponent->m_ValuesFromCache)
+    {
+        return;
+    }
+
+    m_StateComponent->m_ValuesFromCache = false;
+
+    // Nothing was requested yet: the requested values are the device values.
+    m_StateComponent->ApplyOptionValues(m_StateComponent->WaitForRefresh(), true);
+
+    for (auto optionIndex = 0U; optionIndex < m_StateComponent->m_OptionValues.size(); optionIndex++)
+    {
+        auto optionValue = m_StateComponent->m_OptionValues[optionIndex];
+        if (optionValue == nullptr)
+        {
+            continue;
+        }
+
+        for (auto valueIndex = 0U; valueIndex < optionValue->GetValueCount(); valueIndex++)
+        {
+            m_StateComponent->GetCurrentChangeset()->AddChangedIndex(
+                    WidgetIndex{.OptionValueIndices = {optionIndex, valueIndex}});
+        }
+    }
+
+    // Keep the cache up to date if the device reports other values than the cached ones.
+    auto device = m_StateComponent->GetDevice();
+    auto optionCache = m_StateComponent->m_OptionCache;
+    if (device == nullptr || optionCache == nullptr)
+    {
+        return;
+    }
+
+    auto values = m_StateComponent->SerializeValues();
+    auto cachedSnapshot = optionCache->Find(device->GetVendor(), device->GetModel(), m_StateComponent->m_OptionHash);
+    if (cachedSnapshot == nullptr || cachedSnapshot->ToJson() != values)
+    {
+        if (auto snapshot = OptionSnapshot::FromJson(values); snapshot.has_value())
+        {
+            optionCache->Store(
+                    device->GetVendor(), device->GetModel(), m_StateComponent->m_OptionHash, std::move(*snapshot));
+        }
+    }
 }
 
 void Gorfector::DeviceOptionsState::Updater::SetOptionValue(
-        uint32_t optionIndex, uint32_t valueIndex, bool requestedValue) const
+        uint32_t optionIndex, uint32_t valueIndex, bool requestedValue)
 {
     auto *option = dynamic_cast<DeviceOptionValue<bool> *>(m_StateComponent->m_OptionValues[optionIndex]);
     if (option == nullptr)
@@ -202,6 +456,13 @@ void Gorfector::DeviceOptionsState::Updater::SetOptionValue(
         return;
     }
 
+    if (m_Batching)
+    {
+        option->SetRequestedValue(valueIndex, requestedValue);
+        m_StagedIndices.push_back(optionIndex);
+        return;
+    }
+
     if (option->GetValue(valueIndex) == requestedValue)
     {
         option->SetRequestedValue(valueIndex, requestedValue);
@@ -239,7 +500,7 @@ void Gorfector::DeviceOptionsState::Updater::SetOptionValue(
 }
 
 void Gorfector::DeviceOptionsState::Updater::SetOptionValue(
-        uint32_t optionIndex, uint32_t valueIndex, double requestedValue) const
+        uint32_t optionIndex, uint32_t valueIndex, double requestedValue)
 {
     auto *option = dynamic_cast<DeviceOptionValue<int> *>(m_StateComponent->m_OptionValues[optionIndex]);
     if (option == nullptr)
@@ -261,7 +522,7 @@ void Gorfector::DeviceOptionsState::Updater::SetOptionValue(
 }
 
 void Gorfector::DeviceOptionsState::Updater::SetOptionValue(
-        uint32_t optionIndex, uint32_t valueIndex, int requestedValue) const
+        uint32_t optionIndex, uint32_t valueIndex, int requestedValue)
 {
     auto *option = dynamic_cast<DeviceOptionValue<int> *>(m_StateComponent->m_OptionValues[optionIndex]);
     if (option == nullptr)
@@ -269,6 +530,13 @@ void Gorfector::DeviceOptionsState::Updater::SetOptionValue(
         return;
     }
 
+    if (m_Batching)
+    {
+        option->SetRequestedValue(valueIndex, requestedValue);
+        m_StagedIndices.push_back(optionIndex);
+        return;
+    }
+
     if (option->GetValue(valueIndex) == requestedValue)
     {
         option->SetRequestedValue(valueIndex, requestedValue);
@@ -327,7 +595,7 @@ void Gorfector::DeviceOptionsState::Updater::SetOptionValue(
 }
 
 void Gorfector::DeviceOptionsState::Updater::SetOptionValue(
-        uint32_t optionIndex, uint32_t valueIndex, const std::string &requestedValue) const
+        uint32_t optionIndex, uint32_t valueIndex, const std::string &requestedValue)
 {
     auto *option = dynamic_cast<DeviceOptionValue<std::string> *>(m_StateComponent->m_OptionValues[optionIndex]);
     if (option == nullptr)
@@ -335,6 +603,13 @@ void Gorfector::DeviceOptionsState::Updater::SetOptionValue(
         return;
     }
 
+    if (m_Batching)
+    {
+        option->SetRequestedValue(valueIndex, requestedValue);
+        m_StagedIndices.push_back(optionIndex);
+        return;
+    }
+
     if (option->GetValue(valueIndex) == requestedValue)
     {
         option->SetRequestedValue(valueIndex, requestedValue);
@@ -386,11 +661,10 @@ bool Gorfector::DeviceOptionsState::Updater::ApplyRequestedValuesToDevice(const
         return false;
     }
 
+    bool needReload = false;
     for (unsigned long changedIndex: changedIndices)
     {
-        bool needReload = false;
-
-        int optionInfo;
+        int optionInfo = 0;
         auto optionValue = m_StateComponent->m_OptionValues[changedIndex];
         if (optionValue == nullptr)
         {
@@ -402,6 +676,19 @@ bool Gorfector::DeviceOptionsState::Updater::ApplyRequestedValuesToDevice(const
             continue;
         }
 
+        if (needReload)
+        {
+            // The options were changed by a previous write and are not reloaded yet: the option may have become
+            // inactive or changed size. It is written in the next pass if it still needs to be.
+            auto optionDescriptor = saneDevice->GetOptionDescriptor(changedIndex);
+            if (optionDescriptor == nullptr || (optionDescriptor->cap & SANE_CAP_INACTIVE) != 0 ||
+                optionDescriptor->type != optionValue->GetValueType() ||
+                static_cast<unsigned long>(optionDescriptor->size) != optionValue->GetValueSize())
+            {
+                continue;
+            }
+        }
+
         switch (optionValue->GetValueType())
         {
             case SANE_TYPE_BOOL:
@@ -412,7 +699,6 @@ bool Gorfector::DeviceOptionsState::Updater::ApplyRequestedValuesToDevice(const
                     SANE_Bool saneValue = option->GetRequestedValue(0) ? SANE_TRUE : SANE_FALSE;
                     if (saneDevice->SetOptionValue(changedIndex, &saneValue, &optionInfo))
                     {
-                        needReload = (optionInfo & SANE_INFO_RELOAD_OPTIONS) != 0;
                         option->SetDeviceValue(0, saneValue == SANE_TRUE);
                     }
                 }
@@ -434,8 +720,6 @@ bool Gorfector::DeviceOptionsState::Updater::ApplyRequestedValuesToDevice(const
 
                     if (saneDevice->SetOptionValue(changedIndex, saneValue.get(), &optionInfo))
                     {
-                        needReload = (optionInfo & SANE_INFO_RELOAD_OPTIONS) != 0;
-
                         for (auto valueIndex = 0U; valueIndex < valueCount; valueIndex++)
                         {
                             option->SetDeviceValue(valueIndex, saneValue[valueIndex]);
@@ -454,7 +738,6 @@ bool Gorfector::DeviceOptionsState::Updater::ApplyRequestedValuesToDevice(const
                     strcpy(saneValue.get(), option->GetRequestedValue(0).c_str());
                     if (saneDevice->SetOptionValue(changedIndex, saneValue.get(), &optionInfo))
                     {
-                        needReload = (optionInfo & SANE_INFO_RELOAD_OPTIONS) != 0;
                         option->SetDeviceValue(0, std::string(saneValue.get()));
                     }
                 }
@@ -465,14 +748,27 @@ bool Gorfector::DeviceOptionsState::Updater::ApplyRequestedValuesToDevice(const
                 break;
         }
 
-        if (needReload)
+        for (auto valueIndex = 0U; valueIndex < optionValue->GetValueCount(); valueIndex++)
         {
-            ReloadOptions();
-            return false;
+            m_StateComponent->GetCurrentChangeset()->AddChangedIndex(
+                    WidgetIndex{.OptionValueIndices = {static_cast<uint32_t>(changedIndex), valueIndex}});
+        }
+
+        // Do not reload the options now: the values of the other options in the batch are still to be written.
+        if ((optionInfo & SANE_INFO_RELOAD_OPTIONS) != 0)
+        {
+            needReload = true;
+
+            auto &reloadTriggers = m_StateComponent->m_ReloadTriggers;
+            if (reloadTriggers.size() <= changedIndex)
+            {
+                reloadTriggers.resize(m_StateComponent->m_OptionValues.size());
+            }
+            reloadTriggers[changedIndex] = true;
         }
     }
 
-    return true;
+    return needReload;
 }
 
 void Gorfector::DeviceOptionsState::Updater::FindRequestMismatches(
@@ -575,28 +871,193 @@ void Gorfector::DeviceOptionsState::Updater::ApplyPreset(const nlohmann::json &j
         }
     }
 
+    ApplyRequestedValues(indicesToApply);
+}
+
+void Gorfector::DeviceOptionsState::Updater::ApplyPreset(const OptionSnapshot &snapshot)
+{
+    // Walk the snapshot table and load it in m_OptionValues requested values.
+    std::vector<size_t> indicesToApply;
+    snapshot.ForEachOption([this, &indicesToApply](const OptionSnapshot::Option &snapshotOption) {
+        auto optionIndex = m_StateComponent->FindOptionIndex(snapshotOption.GetName());
+        if (optionIndex == k_InvalidIndex)
+        {
+            return;
+        }
+
+        auto optionValue = m_StateComponent->m_OptionValues[optionIndex];
+        if (optionValue == nullptr)
+        {
+            return;
+        }
+
+        auto valueCount = static_cast<uint32_t>(
+                std::min<unsigned long>(snapshotOption.GetValueCount(), optionValue->GetValueCount()));
+        switch (optionValue->GetValueType())
+        {
+            case SANE_TYPE_BOOL:
+            {
+                auto *option = dynamic_cast<DeviceOptionValue<bool> *>(optionValue);
+                if (option == nullptr || snapshotOption.GetType() == OptionSnapshot::ValueType::e_String)
+                {
+                    return;
+                }
+
+                for (auto valueIndex = 0U; valueIndex < valueCount; valueIndex++)
+                {
+                    auto value = snapshotOption.GetType() == OptionSnapshot::ValueType::e_Bool
+                                         ? snapshotOption.GetBool(valueIndex)
+                                         : snapshotOption.GetInt(valueIndex) != 0;
+                    option->SetRequestedValue(valueIndex, value);
+                }
+                break;
+            }
+
+            case SANE_TYPE_INT:
+            case SANE_TYPE_FIXED:
+            {
+                auto *option = dynamic_cast<DeviceOptionValue<int> *>(optionValue);
+                if (option == nullptr || snapshotOption.GetType() != OptionSnapshot::ValueType::e_Int)
+                {
+                    return;
+                }
+
+                for (auto valueIndex = 0U; valueIndex < valueCount; valueIndex++)
+                {
+                    option->SetRequestedValue(valueIndex, snapshotOption.GetInt(valueIndex));
+                }
+                break;
+            }
+
+            case SANE_TYPE_STRING:
+            {
+                auto *option = dynamic_cast<DeviceOptionValue<std::string> *>(optionValue);
+                if (option == nullptr || snapshotOption.GetType() != OptionSnapshot::ValueType::e_String)
+                {
+                    return;
+                }
+
+                for (auto valueIndex = 0U; valueIndex < valueCount; valueIndex++)
+                {
+                    option->SetRequestedValue(valueIndex, std::string(snapshotOption.GetString(valueIndex)));
+                }
+                break;
+            }
+
+            default:
+                return;
+        }
+
+        indicesToApply.push_back(optionIndex);
+        for (auto valueIndex = 0U; valueIndex < optionValue->GetValueCount(); valueIndex++)
+        {
+            m_StateComponent->GetCurrentChangeset()->AddChangedIndex(
+                    WidgetIndex{.OptionValueIndices = {optionIndex, valueIndex}});
+        }
+    });
+
+    ApplyRequestedValues(indicesToApply);
+}
+
+void Gorfector::DeviceOptionsState::Updater::SortForWrite(std::vector<size_t> &indices) const
+{
+    auto writeRank = [this](size_t index) {
+        const auto &reloadTriggers = m_StateComponent->m_ReloadTriggers;
+        if (index < reloadTriggers.size() && reloadTriggers[index])
+        {
+            return 0;
+        }
+
+        auto optionValue = m_StateComponent->m_OptionValues[index];
+        if (index == m_StateComponent->m_ModeIndex ||
+            (optionValue != nullptr && strcmp(optionValue->GetName(), "source") == 0))
+        {
+            return 0;
+        }
+
+        // The range of the scan area depends on the source and the resolution.
+        if (index == m_StateComponent->m_TLXIndex || index == m_StateComponent->m_TLYIndex ||
+            index == m_StateComponent->m_BRXIndex || index == m_StateComponent->m_BRYIndex)
+        {
+            return 2;
+        }
+
+        return 1;
+    };
+
+    // Within a rank, keep the order of the device, which usually lists an option before the ones depending on it.
+    std::ranges::sort(indices);
+    auto duplicates = std::ranges::unique(indices);
+    indices.erase(duplicates.begin(), duplicates.end());
+    std::ranges::stable_sort(indices, std::less{}, writeRank);
+}
+
+void Gorfector::DeviceOptionsState::Updater::ApplyRequestedValues(const std::vector<size_t> &indicesToApply)
+{
+    m_StagedIndices.insert(m_StagedIndices.end(), indicesToApply.begin(), indicesToApply.end());
+    if (!m_Batching)
+    {
+        CommitBatch();
+    }
+}
+
+Gorfector::DeviceOptionsState::BatchResult Gorfector::DeviceOptionsState::Updater::CommitBatch()
+{
+    BatchResult result;
+
+    m_Batching = false;
+    auto indices = std::exchange(m_StagedIndices, {});
+
+    auto saneDevice = m_StateComponent->GetDevice();
+    if (saneDevice == nullptr || indices.empty())
+    {
+        return result;
+    }
+
+    SortForWrite(indices);
+    auto controlOptionCount = saneDevice->GetControlOptionCount();
+
     // When applying the requested values to the device, the device may decide to change the value
     // of some other options (for example, setting the source to transparent may change the resolution).
-    // In this case, we need to check if the requested values are still valid and reapply them if necessary.
-    // This is done until all requested values are set or until we reach a maximum number of iterations.
+    // In this case, the options are reloaded and the values that do not match the requested values anymore
+    // are written again.
     std::vector<size_t> mismatchIndices;
-    bool applyCompleted = false;
-    int maxRepeatCount = 20;
-    while (!applyCompleted && maxRepeatCount > 0)
+    FindRequestMismatches(indices, mismatchIndices);
+    auto passCount = 0;
+    while (!mismatchIndices.empty() && passCount < k_MaxBatchPassCount)
     {
-        maxRepeatCount--;
+        passCount++;
+
+        if (!ApplyRequestedValuesToDevice(mismatchIndices))
+        {
+            // The device values are up to date: the values that still differ were adjusted by the device.
+            mismatchIndices.clear();
+            FindRequestMismatches(indices, mismatchIndices);
+            break;
+        }
+
+        ReloadOptions();
+        result.ReloadCount++;
 
         mismatchIndices.clear();
-        FindRequestMismatches(indicesToApply, mismatchIndices);
-        applyCompleted = ApplyRequestedValuesToDevice(mismatchIndices);
+        FindRequestMismatches(indices, mismatchIndices);
     }
 
-    mismatchIndices.clear();
-    FindRequestMismatches(indicesToApply, mismatchIndices);
-    if (!mismatchIndices.empty())
+    result.RoundTripCount = saneDevice->GetControlOptionCount() - controlOptionCount;
+    result.Succeeded = mismatchIndices.empty();
+
+    m_StateComponent->m_LastBatchResult = result;
+    s_BatchRoundTrips.Record(result.RoundTripCount);
+    s_BatchReloads.Record(result.ReloadCount);
+
+    g_debug("Wrote %zu options in %lu round trips and %u reloads", indices.size(),
+            static_cast<unsigned long>(result.RoundTripCount), result.ReloadCount);
+    if (!result.Succeeded)
     {
-        g_print("Failed to set all requested values on the device after %d iterations.", 20 - maxRepeatCount);
+        g_warning("Failed to set all requested values on the device after %d passes", passCount);
     }
+
+    return result;
 }
 
 void Gorfector::DeviceOptionsState::Updater::LoadFromJson(const nlohmann::json &json)
@@ -640,6 +1101,27 @@ void Gorfector::DeviceOptionsState::Updater::LoadFromJson(const nlohmann::json &
     ApplyPreset(json[k_OptionsKey]);
 }
 
+void Gorfector::DeviceOptionsState::Updater::ApplySettings(const OptionSnapshot &snapshot)
+{
+    if (m_StateComponent->m_State == nullptr)
+    {
+        return;
+    }
+
+    auto saneDevice = m_StateComponent->GetDevice();
+    if (saneDevice == nullptr || !snapshot.HasDevice())
+    {
+        return;
+    }
+
+    if (snapshot.GetDeviceVendor() != saneDevice->GetVendor() || snapshot.GetDeviceModel() != saneDevice->GetModel())
+    {
+        return;
+    }
+
+    ApplyPreset(snapshot);
+}
+
 bool Gorfector::DeviceOptionsState::IsPreview() const
 {
     if (m_PreviewIndex != std::numeric_limits<uint32_t>::max())
@@ -1,12 +1,19 @@
 #pragma once
 
 #include <cstring>
+#include <future>
+#include <limits>
 #include <nlohmann/json.hpp>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "DeviceOptionValue.hpp"
+#include "DeviceOptionCache.hpp"
 #include "DeviceOptionValueBase.hpp"
 #include "DeviceSelectorState.hpp"
+#include "OptionSnapshot.hpp"
 #include "Rect.hpp"
 #include "ZooLib/ChangesetBase.hpp"
 #include "ZooLib/ChangesetManager.hpp"
@@ -36,25 +43,87 @@ namespace Gorfector
      */
     class DeviceOptionsStateChangeset : public ZooLib::ChangesetBase
     {
+        static constexpr uint64_t k_NoIndex = std::numeric_limits<uint64_t>::max();
+
         std::vector<WidgetIndex> m_ChangedIndices;
+        // Open addressing hash set of the composite indices in m_ChangedIndices, used to skip duplicates in constant
+        // time. Its size is a power of two, at least twice the number of indices.
+        std::vector<uint64_t> m_IndexSet;
         bool m_ReloadOptions{};
 
+        static size_t HashIndex(uint64_t compositeIndex)
+        {
+            return static_cast<size_t>((compositeIndex * 0x9E3779B97F4A7C15ull) >> 32);
+        }
+
+        /**
+         * \brief Inserts a composite index in the index set.
+         * \return False if the index was already in the set.
+         */
+        bool InsertInIndexSet(uint64_t compositeIndex)
+        {
+            const auto mask = m_IndexSet.size() - 1;
+            for (auto slot = HashIndex(compositeIndex) & mask;; slot = (slot + 1) & mask)
+            {
+                if (m_IndexSet[slot] == compositeIndex)
+                {
+                    return false;
+                }
+                if (m_IndexSet[slot] == k_NoIndex)
+                {
+                    m_IndexSet[slot] = compositeIndex;
+                    return true;
+                }
+            }
+        }
+
+        void GrowIndexSet()
+        {
+            m_IndexSet.assign(std::max<size_t>(64, 2 * m_IndexSet.size()), k_NoIndex);
+            for (auto index: m_ChangedIndices)
+            {
+                InsertInIndexSet(index.CompositeIndex);
+            }
+        }
+
     public:
         explicit DeviceOptionsStateChangeset(uint64_t stateInitialVersion)
             : ChangesetBase(stateInitialVersion)
         {
         }
 
+        /**
+         * \brief Resets the changeset to an empty changeset, keeping its memory for reuse.
+         *
+         * \param stateInitialVersion The initial version of the state.
+         */
+        void Reset(uint64_t stateInitialVersion)
+        {
+            ChangesetBase::Reset(stateInitialVersion);
+            m_ChangedIndices.clear();
+            std::ranges::fill(m_IndexSet, k_NoIndex);
+            m_ReloadOptions = false;
+        }
+
         /**
          * \brief Adds a changed index to the changeset.
          *
-         * This method records an index that has been modified in the device options state.
+         * This method records an index that has been modified in the device options state. Indices already in the
+         * changeset are ignored.
          *
          * \param index The `WidgetIndex` representing the changed index.
          */
         void AddChangedIndex(WidgetIndex index)
         {
-            m_ChangedIndices.push_back(index);
+            if (2 * (m_ChangedIndices.size() + 1) > m_IndexSet.size())
+            {
+                GrowIndexSet();
+            }
+
+            if (InsertInIndexSet(index.CompositeIndex))
+            {
+                m_ChangedIndices.push_back(index);
+            }
         }
 
         /**
@@ -111,12 +180,7 @@ namespace Gorfector
 
             for (auto changedIndex: changeset.m_ChangedIndices)
             {
-                if (std::ranges::find_if(m_ChangedIndices, [changedIndex](const WidgetIndex &a) {
-                        return a.CompositeIndex == changedIndex.CompositeIndex;
-                    }) == m_ChangedIndices.end())
-                {
-                    m_ChangedIndices.push_back(changedIndex);
-                }
+                AddChangedIndex(changedIndex);
             }
         }
     };
@@ -144,9 +208,47 @@ namespace Gorfector
         static constexpr const char *k_BrxKey = "br-x"; ///< Key for the bottom-right x-coordinate option.
         static constexpr const char *k_BryKey = "br-y"; ///< Key for the bottom-right y-coordinate option.
 
+        /**
+         * \brief The outcome of a batch of option writes.
+         */
+        struct BatchResult
+        {
+            uint64_t RoundTripCount{}; ///< The number of option values read from or written to the device.
+            uint32_t ReloadCount{}; ///< The number of times all the options were reloaded from the device.
+            bool Succeeded{true}; ///< False if the device did not accept all the requested values.
+        };
+
     private:
+        // Hashes option names given as any string type, so that looking up a name does not copy it.
+        struct OptionNameHash
+        {
+            using is_transparent = void;
+
+            size_t operator()(std::string_view name) const
+            {
+                return std::hash<std::string_view>{}(name);
+            }
+        };
+
+        // The raw values of the options read from a device, by option index. Empty for the options without a value.
+        using OptionValueBuffers = std::vector<std::vector<char8_t>>;
+
         const std::string m_DeviceName;
         std::vector<DeviceOptionValueBase *> m_OptionValues;
+        std::unordered_map<std::string, uint32_t, OptionNameHash, std::equal_to<>> m_OptionIndicesByName;
+        // Options that made the device reload the options when set. They are written first in a batch.
+        std::vector<bool> m_ReloadTriggers;
+
+        BatchResult m_LastBatchResult{};
+
+        DeviceOptionCache *m_OptionCache;
+        std::string m_OptionHash;
+        // True if the option values come from m_OptionCache and were not read from the device yet.
+        bool m_ValuesFromCache{};
+        // Reads the values of the options with a background task of the device when they come from the cache. The
+        // task fills m_RefreshedValues and wakes up the main thread with m_RefreshCompletedSource.
+        GSource *m_RefreshCompletedSource{};
+        std::future<OptionValueBuffers> m_RefreshedValues{};
 
         uint32_t m_PreviewIndex;
         uint32_t m_ModeIndex;
@@ -181,8 +283,14 @@ namespace Gorfector
             return deviceSelectorState->GetDeviceByName(m_DeviceName);
         }
 
-        void ReloadOptions() const;
+        void ReloadOptions(bool updateRequestedValues = false) const;
+        static OptionValueBuffers ReadOptionValues(const SaneDevice *device);
+        void ApplyOptionValues(const OptionValueBuffers &values, bool updateRequestedValues) const;
+        void StartRefresh(SaneDevice *device);
+        OptionValueBuffers WaitForRefresh();
+        void DestroyRefreshSource();
         void BuildOptions();
+        [[nodiscard]] nlohmann::json SerializeValues() const;
 
         void AddOptionValue(uint32_t index, DeviceOptionValueBase *optionValue)
         {
@@ -191,6 +299,7 @@ namespace Gorfector
                 m_OptionValues.resize(index + 1);
             }
             m_OptionValues[index] = optionValue;
+            m_OptionIndicesByName[optionValue->GetName()] = index;
 
             /* Save special indices */
 
@@ -246,14 +355,26 @@ namespace Gorfector
                 delete optionValue;
             }
             m_OptionValues.clear();
+            m_OptionIndicesByName.clear();
+            m_ReloadTriggers.clear();
         }
 
         friend void to_json(nlohmann::json &j, const DeviceOptionsState &p);
 
     public:
-        DeviceOptionsState(ZooLib::State *state, std::string deviceName)
+        /**
+         * \brief Constructs the options of a device, reading them from the device.
+         *
+         * \param state Pointer to the parent `ZooLib::State` instance.
+         * \param deviceName The name of the device, which must be opened.
+         * \param optionCache If not null, the option values are taken from this cache when the device has the same
+         * options as a cached one, and read from the device on a worker thread. The values read are applied on the
+         * main thread; an `Updater` created before waits for them, as do the other uses of the device.
+         */
+        DeviceOptionsState(ZooLib::State *state, std::string deviceName, DeviceOptionCache *optionCache = nullptr)
             : StateComponent(state)
             , m_DeviceName(std::move(deviceName))
+            , m_OptionCache(optionCache)
             , m_PreviewIndex(k_InvalidIndex)
             , m_ModeIndex(k_InvalidIndex)
             , m_TLXIndex(k_InvalidIndex)
@@ -270,9 +391,32 @@ namespace Gorfector
 
         ~DeviceOptionsState() override
         {
+            DestroyRefreshSource();
             Clear();
         }
 
+        /**
+         * \brief Finds the index of an option from its name.
+         *
+         * \param name The name of the option.
+         * \return The index of the option, or `k_InvalidIndex` if the device has no such option.
+         */
+        [[nodiscard]] uint32_t FindOptionIndex(std::string_view name) const
+        {
+            auto it = m_OptionIndicesByName.find(name);
+            return it == m_OptionIndicesByName.end() ? k_InvalidIndex : it->second;
+        }
+
+        /**
+         * \brief Gets the outcome of the last batch of option writes sent to the device.
+         *
+         * \return The outcome of the last batch.
+         */
+        [[nodiscard]] const BatchResult &GetLastBatchResult() const
+        {
+            return m_LastBatchResult;
+        }
+
         [[nodiscard]] uint64_t FirstChangesetVersion() const
         {
             return m_ChangesetManager.FirstChangesetVersion();
@@ -283,9 +427,9 @@ namespace Gorfector
             return &m_ChangesetManager;
         }
 
-        [[nodiscard]] DeviceOptionsStateChangeset *GetAggregatedChangeset(uint64_t stateComponentVersion) const
+        void AggregateChangesets(uint64_t stateComponentVersion, DeviceOptionsStateChangeset &accumulator) const
         {
-            return m_ChangesetManager.GetAggregatedChangeset(stateComponentVersion);
+            m_ChangesetManager.AggregateChangesets(stateComponentVersion, accumulator);
         }
 
         /**
@@ -299,9 +443,22 @@ namespace Gorfector
          */
         class Updater : public StateComponent::Updater<DeviceOptionsState>
         {
+        public:
+            /**
+             * \brief The maximum number of times a batch writes the values the device did not accept.
+             */
+            static constexpr int k_MaxBatchPassCount = 4;
+
+        private:
+            bool m_Batching{};
+            std::vector<size_t> m_StagedIndices{};
+
             bool ApplyRequestedValuesToDevice(const std::vector<size_t> &changedIndices);
             void FindRequestMismatches(const std::vector<size_t> &indicesToCheck, std::vector<size_t> &mismatches);
+            void SortForWrite(std::vector<size_t> &indices) const;
+            void ApplyRequestedValues(const std::vector<size_t> &indicesToApply);
             void ApplyPreset(const nlohmann::json &json);
+            void ApplyPreset(const OptionSnapshot &snapshot);
 
         public:
             /**
@@ -312,16 +469,48 @@ namespace Gorfector
             explicit Updater(DeviceOptionsState *state)
                 : StateComponent::Updater<DeviceOptionsState>(state)
             {
+                // The values are compared with the requested values: they need to be the device values.
+                RefreshCachedValues();
             }
 
             /**
-             * \brief Destructor. Pushes the current changeset to the stack.
+             * \brief Destructor. Commits the open batch, if any, and pushes the current changeset to the stack.
              */
             ~Updater() override
             {
+                if (m_Batching)
+                {
+                    CommitBatch();
+                }
                 m_StateComponent->m_ChangesetManager.PushCurrentChangeset();
             }
 
+            /**
+             * \brief Starts a batch of option writes.
+             *
+             * Until `CommitBatch()` is called, the values set with `SetOptionValue()`, `ApplySettings()` and
+             * `ApplyScanArea()` are only recorded as requested values; nothing is sent to the device.
+             */
+            void BeginBatch()
+            {
+                m_Batching = true;
+            }
+
+            /**
+             * \brief Sends the values recorded since `BeginBatch()` to the device and ends the batch.
+             *
+             * Only the values that differ from the device values are written. The options that change the other
+             * options (the ones that made the device reload the options before, the scan source and the scan mode)
+             * are written first and the scan area is written last. When the device asks for the options to be
+             * reloaded, the reload is deferred until all the values are written; meanwhile, the options that the
+             * device made inactive or resized are skipped. Another pass is made only if the device did not accept some
+             * values until the options were reloaded, up to `k_MaxBatchPassCount` passes.
+             *
+             * \return The number of round trips and reloads the batch needed. It is also kept by the state component,
+             * see `GetLastBatchResult()`, and recorded by the profiler.
+             */
+            BatchResult CommitBatch();
+
             /**
              * \brief Loads settings from a JSON object into the `DeviceOptionsState`.
              *
@@ -349,6 +538,33 @@ namespace Gorfector
                 ApplyPreset(json);
             }
 
+            /**
+             * \brief Applies settings from a compiled snapshot to the `DeviceOptionsState`.
+             *
+             * The settings are applied only if the snapshot was taken for the same device model.
+             *
+             * \param snapshot The snapshot of the settings to apply.
+             */
+            void ApplySettings(const OptionSnapshot &snapshot);
+
+            /**
+             * \brief Applies a scan area configuration from a compiled snapshot.
+             *
+             * \param snapshot The snapshot of the scan area options.
+             */
+            void ApplyScanArea(const OptionSnapshot &snapshot)
+            {
+                ApplyPreset(snapshot);
+            }
+
+            /**
+             * \brief Replaces the option values taken from the option cache by the values read from the device.
+             *
+             * Waits for the task reading the values, if it is still running. The widgets of all the options
+             * are updated.
+             */
+            void RefreshCachedValues();
+
             /**
              * \brief Reloads the options of the `DeviceOptionsState` from the device.
              *
@@ -365,45 +581,49 @@ namespace Gorfector
              * \brief Sets the value of a boolean option in the `DeviceOptionsState`.
              *
              * This method sets the value of a boolean option at the specified index.
+             * During a batch, the value is recorded and sent to the device by `CommitBatch()`.
              *
              * \param optionIndex The index of the option to set.
              * \param valueIndex The index of the value to set for the option.
              * \param requestedValue The boolean value to set for the option.
              */
-            void SetOptionValue(uint32_t optionIndex, uint32_t valueIndex, bool requestedValue) const;
+            void SetOptionValue(uint32_t optionIndex, uint32_t valueIndex, bool requestedValue);
 
             /**
              * \brief Sets the value of a double option in the `DeviceOptionsState`.
              *
              * This method sets the value of a double option at the specified index.
+             * During a batch, the value is recorded and sent to the device by `CommitBatch()`.
              *
              * \param optionIndex The index of the option to set.
              * \param valueIndex The index of the value to set for the option.
              * \param requestedValue The double value to set for the option.
              */
-            void SetOptionValue(uint32_t optionIndex, uint32_t valueIndex, double requestedValue) const;
+            void SetOptionValue(uint32_t optionIndex, uint32_t valueIndex, double requestedValue);
 
             /**
              * \brief Sets the value of an integer option in the `DeviceOptionsState`.
              *
              * This method sets the value of an integer option at the specified index.
+             * During a batch, the value is recorded and sent to the device by `CommitBatch()`.
              *
              * \param optionIndex The index of the option to set.
              * \param valueIndex The index of the value to set for the option.
              * \param requestedValue The integer value to set for the option.
              */
-            void SetOptionValue(uint32_t optionIndex, uint32_t valueIndex, int requestedValue) const;
+            void SetOptionValue(uint32_t optionIndex, uint32_t valueIndex, int requestedValue);
 
             /**
              * \brief Sets the value of a string option in the `DeviceOptionsState`.
              *
              * This method sets the value of a string option at the specified index.
+             * During a batch, the value is recorded and sent to the device by `CommitBatch()`.
              *
              * \param optionIndex The index of the option to set.
              * \param valueIndex The index of the value to set for the option.
              * \param requestedValue The string value to set for the option.
              */
-            void SetOptionValue(uint32_t optionIndex, uint32_t valueIndex, const std::string &requestedValue) const;
+            void SetOptionValue(uint32_t optionIndex, uint32_t valueIndex, const std::string &requestedValue);
         };
 
         /**
@@ -45,10 +45,10 @@ Gorfector::DeviceSelector::DeviceSelector(
     ConnectGtkSignalWithParamSpecs(this, &DeviceSelector::OnActivateNetwork, networkScan, "notify::active");
     gtk_list_box_append(GTK_LIST_BOX(m_DeviceSelectorRoot), networkScan);
 
-    auto refreshButton = gtk_button_new_with_label(_("Refresh Scanner List"));
-    gtk_widget_set_css_classes(GTK_WIDGET(refreshButton), buttonClasses);
-    ConnectGtkSignal(this, &DeviceSelector::OnRefreshDevicesClicked, refreshButton, "clicked");
-    gtk_list_box_append(GTK_LIST_BOX(m_DeviceSelectorRoot), refreshButton);
+    m_RefreshButton = gtk_button_new_with_label(_("Refresh Scanner List"));
+    gtk_widget_set_css_classes(GTK_WIDGET(m_RefreshButton), buttonClasses);
+    ConnectGtkSignal(this, &DeviceSelector::OnRefreshDevicesClicked, m_RefreshButton, "clicked");
+    gtk_list_box_append(GTK_LIST_BOX(m_DeviceSelectorRoot), m_RefreshButton);
 
     m_Dispatcher.RegisterHandler(SelectDeviceCommand::Execute, m_State);
     m_Dispatcher.RegisterHandler(RefreshDeviceList::Execute, m_State);
@@ -99,8 +99,22 @@ void Gorfector::DeviceSelector::OnDeviceSelected(GtkWidget *)
 
 void Gorfector::DeviceSelector::Update(const std::vector<uint64_t> &lastSeenVersion)
 {
+    bool forceUpdate = lastSeenVersion[0] == 0;
+
+    m_State->AggregateChangesets(lastSeenVersion[0], m_StateChangeset);
+    if (!forceUpdate && !m_StateChangeset.HasAnyChange())
+    {
+        return;
+    }
+
     g_signal_handler_block(m_DeviceSelectorList, m_DropdownSelectedSignalId);
 
+    // The devices cannot be opened until the discovery completes.
+    const auto isDiscovering = m_State->IsDiscovering();
+    adw_action_row_set_subtitle(
+            ADW_ACTION_ROW(m_DeviceSelectorList), isDiscovering ? _("Searching for scanners...") : "");
+    gtk_widget_set_sensitive(m_RefreshButton, !isDiscovering);
+
     if (const auto deviceList = m_State->GetDeviceList(); !deviceList.empty())
     {
         const auto deviceCount = m_State->GetDeviceList().size();
@@ -146,7 +160,18 @@ void Gorfector::DeviceSelector::Update(const std::vector<uint64_t> &lastSeenVers
             auto *deviceGList = gtk_string_list_new(deviceNamesCStr.get());
             adw_combo_row_set_model(ADW_COMBO_ROW(m_DeviceSelectorList), G_LIST_MODEL(deviceGList));
             adw_combo_row_set_selected(ADW_COMBO_ROW(m_DeviceSelectorList), selectedItemIndex);
-            gtk_widget_set_sensitive(m_DeviceSelectorList, true);
+            gtk_widget_set_sensitive(m_DeviceSelectorList, !isDiscovering);
+        }
+    }
+    else if (isDiscovering)
+    {
+        if (m_DeviceSelectorList != nullptr)
+        {
+            const char *deviceListNames[] = {_("None"), nullptr};
+            auto *deviceGList = gtk_string_list_new(deviceListNames);
+            adw_combo_row_set_model(ADW_COMBO_ROW(m_DeviceSelectorList), G_LIST_MODEL(deviceGList));
+            adw_combo_row_set_selected(ADW_COMBO_ROW(m_DeviceSelectorList), 0);
+            gtk_widget_set_sensitive(m_DeviceSelectorList, false);
         }
     }
     else
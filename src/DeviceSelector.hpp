@@ -21,12 +21,14 @@ namespace Gorfector
     {
         DeviceSelectorState *m_State; ///< Pointer to the state of the device selector.
         ViewUpdateObserver<DeviceSelector, DeviceSelectorState> *m_Observer; ///< Observer for view updates.
+        DeviceSelectorStateChangeset m_StateChangeset{0}; ///< Receives the changes of m_State on every update.
 
         ZooLib::Application *m_App; ///< Pointer to the application instance.
         ZooLib::CommandDispatcher m_Dispatcher{}; ///< Command dispatcher for handling commands.
 
         GtkWidget *m_DeviceSelectorRoot{}; ///< Root widget for the device selector UI.
         GtkWidget *m_DeviceSelectorList{}; ///< Widget for the list of devices.
+        GtkWidget *m_RefreshButton{}; ///< Button to refresh the list of devices.
 
         gulong m_DropdownSelectedSignalId; ///< Signal ID for dropdown selection events.
 
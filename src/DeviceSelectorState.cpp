@@ -1,3 +1,183 @@
 #include "DeviceSelectorState.hpp"
 
+#include "DeviceOptionsState.hpp"
+
 const std::string Gorfector::DeviceSelectorState::k_NullDeviceName{};
+
+static gboolean DispatchDiscoveryCompletedSource(GSource *source, GSourceFunc callback, gpointer data)
+{
+    // Disarm the source before applying the result, so that a discovery completing meanwhile is not lost.
+    g_source_set_ready_time(source, -1);
+    return callback(data);
+}
+
+Gorfector::DeviceSelectorState::DeviceSelectorState(ZooLib::State *state)
+    : StateComponent(state)
+    , m_SelectFirstDevice(true)
+{
+    static GSourceFuncs s_DiscoveryCompletedSourceFuncs = []() {
+        GSourceFuncs funcs{};
+        funcs.dispatch = DispatchDiscoveryCompletedSource;
+        return funcs;
+    }();
+
+    m_DiscoveryCompletedSource = g_source_new(&s_DiscoveryCompletedSourceFuncs, sizeof(GSource));
+    g_source_set_name(m_DiscoveryCompletedSource, "Gorfector device discovery");
+    g_source_set_callback(
+            m_DiscoveryCompletedSource,
+            [](gpointer data) -> gboolean {
+                auto *deviceSelectorState = static_cast<DeviceSelectorState *>(data);
+                DeviceSelectorState::Updater(deviceSelectorState).ApplyDiscoveryResult();
+                return G_SOURCE_CONTINUE;
+            },
+            this, nullptr);
+    g_source_attach(m_DiscoveryCompletedSource, nullptr);
+
+    m_DeviceDiscovery = std::make_unique<DeviceDiscovery>([this]() {
+        // Called on the discovery thread: wake up the main thread.
+        g_source_set_ready_time(m_DiscoveryCompletedSource, 0);
+    });
+
+    StartDiscovery();
+}
+
+void Gorfector::DeviceSelectorState::SetDeviceList(const std::vector<SaneDeviceInfo> &devices)
+{
+    for (const SaneDevice *const device: m_DeviceList)
+    {
+        delete device;
+    }
+    m_DeviceList.clear();
+
+    m_DeviceList.reserve(devices.size());
+    for (const auto &device: devices)
+    {
+        m_DeviceList.push_back(new SaneDevice(device));
+    }
+
+    GetCurrentChangeset()->AddChangeType(DeviceSelectorStateChangeset::ChangeTypeFlag::e_DeviceList);
+}
+
+void Gorfector::DeviceSelectorState::StartDiscovery()
+{
+    if (!m_IsDiscovering)
+    {
+        // Discovering reinitializes SANE, which invalidates the handle of the selected device. Close it, and
+        // select it again when the discovery completes.
+        m_PendingDeviceName = m_SelectedDeviceName;
+        SelectDevice(k_NullDeviceName);
+    }
+
+    m_IsDiscovering = true;
+    GetCurrentChangeset()->AddChangeType(DeviceSelectorStateChangeset::ChangeTypeFlag::e_Discovery);
+
+    m_DeviceDiscovery->Start(m_NetworkLookUp);
+}
+
+void Gorfector::DeviceSelectorState::ApplyDiscoveryResult()
+{
+    auto result = m_DeviceDiscovery->TakeResult();
+    if (!result.has_value())
+    {
+        return;
+    }
+
+    m_IsDiscovering = false;
+    GetCurrentChangeset()->AddChangeType(DeviceSelectorStateChangeset::ChangeTypeFlag::e_Discovery);
+
+    if (!result->Succeeded)
+    {
+        SetDeviceList({});
+        return;
+    }
+
+    ++m_SANEInitId;
+    SetDeviceList(result->Devices);
+
+    auto deviceName = std::exchange(m_PendingDeviceName, k_NullDeviceName);
+    if (GetDeviceByName(deviceName) == nullptr && m_SelectFirstDevice && !m_DeviceList.empty())
+    {
+        deviceName = m_DeviceList[0]->GetName();
+    }
+    m_SelectFirstDevice = false;
+
+    SelectDevice(deviceName);
+
+    // Update the cache of the device list.
+    m_State->SaveToFile(this);
+}
+
+void Gorfector::DeviceSelectorState::SelectDevice(const std::string &deviceName)
+{
+    if (m_IsDiscovering)
+    {
+        // The device cannot be opened until SANE is initialized again.
+        m_PendingDeviceName = deviceName;
+        return;
+    }
+
+    if (m_SelectedDeviceName == deviceName)
+        return;
+
+    auto device = GetDeviceByName(m_SelectedDeviceName);
+    if (device != nullptr)
+        device->Close();
+
+    device = GetDeviceByName(deviceName);
+
+    m_SelectedDeviceName = k_NullDeviceName;
+    if (device != nullptr)
+    {
+        if (device->Open())
+        {
+            m_SelectedDeviceName = deviceName;
+        }
+    }
+
+    GetCurrentChangeset()->AddChangeType(DeviceSelectorStateChangeset::ChangeTypeFlag::e_SelectedDevice);
+
+    if (m_DumpSane && (m_SelectedDeviceName != k_NullDeviceName))
+    {
+        OptionRewriter::Dump(GetDeviceByName(m_SelectedDeviceName));
+    }
+}
+
+void Gorfector::to_json(nlohmann::json &j, const DeviceSelectorState &state)
+{
+    auto devices = nlohmann::json::array();
+    for (const auto device: state.m_DeviceList)
+    {
+        devices.push_back({
+                {DeviceOptionsState::k_DeviceNameKey, device->GetName()},
+                {DeviceOptionsState::k_DeviceVendorKey, device->GetVendor()},
+                {DeviceOptionsState::k_DeviceModelKey, device->GetModel()},
+                {DeviceOptionsState::k_DeviceTypeKey, device->GetType()},
+        });
+    }
+
+    // While discovering, the selected device is the one that will be selected when the discovery completes.
+    const auto &selectedDeviceName = state.m_IsDiscovering ? state.m_PendingDeviceName : state.m_SelectedDeviceName;
+    j = nlohmann::json{
+            {DeviceSelectorState::k_DevicesKey, devices},
+            {DeviceSelectorState::k_SelectedDeviceKey, selectedDeviceName},
+    };
+}
+
+void Gorfector::from_json(const nlohmann::json &j, DeviceSelectorState &state)
+{
+    std::vector<SaneDeviceInfo> devices;
+    for (const auto &device: j.at(DeviceSelectorState::k_DevicesKey))
+    {
+        devices.emplace_back(
+                device.at(DeviceOptionsState::k_DeviceNameKey).get<std::string>(),
+                device.at(DeviceOptionsState::k_DeviceVendorKey).get<std::string>(),
+                device.at(DeviceOptionsState::k_DeviceModelKey).get<std::string>(),
+                device.at(DeviceOptionsState::k_DeviceTypeKey).get<std::string>());
+    }
+    state.SetDeviceList(devices);
+
+    if (state.m_PendingDeviceName.empty())
+    {
+        j.at(DeviceSelectorState::k_SelectedDeviceKey).get_to(state.m_PendingDeviceName);
+    }
+}
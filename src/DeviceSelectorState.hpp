@@ -1,13 +1,69 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "DeviceDiscovery.hpp"
 #include "OptionRewriter.hpp"
 #include "SaneDevice.hpp"
+#include "ZooLib/ChangesetBase.hpp"
+#include "ZooLib/ChangesetManager.hpp"
 #include "ZooLib/StateComponent.hpp"
 
 namespace Gorfector
 {
+    /**
+     * \class DeviceSelectorStateChangeset
+     * \brief Represents the changes made to the `DeviceSelectorState`.
+     */
+    class DeviceSelectorStateChangeset : public ZooLib::ChangesetBase
+    {
+    public:
+        enum class ChangeTypeFlag
+        {
+            e_DeviceList = 1 << 0,
+            e_SelectedDevice = 1 << 1,
+            e_Discovery = 1 << 2,
+        };
+
+    private:
+        int m_ChangeType{};
+
+    public:
+        explicit DeviceSelectorStateChangeset(uint64_t stateInitialVersion)
+            : ChangesetBase(stateInitialVersion)
+        {
+        }
+
+        void Reset(uint64_t stateInitialVersion)
+        {
+            ChangesetBase::Reset(stateInitialVersion);
+            m_ChangeType = 0;
+        }
+
+        void AddChangeType(ChangeTypeFlag changeType)
+        {
+            m_ChangeType |= static_cast<int>(changeType);
+        }
+
+        [[nodiscard]] bool IsChanged(ChangeTypeFlag changeType) const
+        {
+            return (m_ChangeType & static_cast<int>(changeType)) != 0;
+        }
+
+        [[nodiscard]] bool HasAnyChange() const
+        {
+            return m_ChangeType != 0;
+        }
+
+        void Aggregate(const DeviceSelectorStateChangeset &changeset)
+        {
+            ChangesetBase::Aggregate(changeset);
+
+            m_ChangeType |= changeset.m_ChangeType;
+        }
+    };
+
     /**
      * \class DeviceSelectorState
      * \brief Manages the state of the device selector, including the list of devices and the selected device.
@@ -15,11 +71,18 @@ namespace Gorfector
      * The `DeviceSelectorState` class is responsible for maintaining the list of available devices,
      * tracking the currently selected device, and interacting with the SANE library to retrieve and manage devices.
      * It provides methods to update the device list, select a device, and configure network lookup settings.
+     *
+     * Devices are discovered on a worker thread (see `DeviceDiscovery`), and the result is applied on the main thread.
+     * The last known device list is saved to the preferences file, so that it can be displayed at startup while the
+     * devices are being discovered. Devices cannot be opened during a discovery; a device selected during a discovery
+     * is opened when the discovery completes, if it is still available.
      */
     class DeviceSelectorState final : public ZooLib::StateComponent
     {
     public:
         static const std::string k_NullDeviceName;
+        static constexpr const char *k_DevicesKey = "Devices";
+        static constexpr const char *k_SelectedDeviceKey = "SelectedDevice";
 
     private:
         std::vector<SaneDevice *> m_DeviceList{};
@@ -28,92 +91,53 @@ namespace Gorfector
         int m_SANEInitId{};
         bool m_DumpSane{};
 
-        /**
-         * \brief Retrieves the list of devices from the SANE library.
-         *
-         * This method clears the current device list, reinitializes the SANE library, and fetches the latest
-         * list of devices. It also ensures that the previously selected device is reselected if it is still available.
-         */
-        void GetDevicesFromSANE()
-        {
-            const auto currentlySelectedDeviceName = m_SelectedDeviceName;
+        bool m_IsDiscovering{};
+        // The device to select when the discovery completes.
+        std::string m_PendingDeviceName{};
+        // Whether to select the first device if the pending device is not found.
+        bool m_SelectFirstDevice{};
+        std::unique_ptr<DeviceDiscovery> m_DeviceDiscovery{};
+        GSource *m_DiscoveryCompletedSource{};
 
-            SelectDevice(k_NullDeviceName);
-            for (const SaneDevice *const device: m_DeviceList)
-            {
-                delete device;
-            }
-            m_DeviceList.clear();
-
-            // Although the SANE documentation states that sane_get_devices() can pick up newly available devices,
-            // it does not seem to be the case. Re-init SANE to get the latest devices (this invalidates all previous
-            // SANE data).
-            SANE_Int saneVersion;
-            sane_exit();
-            if (SANE_STATUS_GOOD != sane_init(&saneVersion, nullptr))
-            {
-                sane_exit();
-                return;
-            }
-            ++m_SANEInitId;
-
-            const SANE_Device **deviceList;
-            SANE_Status status = sane_get_devices(&deviceList, IsNetworkLookUpEnabled() ? SANE_FALSE : SANE_TRUE);
-            if (status == SANE_STATUS_GOOD)
-            {
-                auto deviceCount = 0;
-                while (deviceList[deviceCount] != nullptr)
-                {
-                    deviceCount++;
-                }
+        ZooLib::ChangesetManager<DeviceSelectorStateChangeset> m_ChangesetManager{};
 
-                m_DeviceList.reserve(deviceCount);
-                for (int i = 0; i < deviceCount; i++)
-                {
-                    if (deviceList[i] != nullptr)
-                        m_DeviceList.push_back(new SaneDevice(deviceList[i]));
+        friend void to_json(nlohmann::json &j, const DeviceSelectorState &state);
+        friend void from_json(const nlohmann::json &j, DeviceSelectorState &state);
 
-                    if (deviceList[i]->name == currentlySelectedDeviceName)
-                    {
-                        SelectDevice(currentlySelectedDeviceName);
-                    }
-                }
-            }
+        [[nodiscard]] DeviceSelectorStateChangeset *GetCurrentChangeset()
+        {
+            return m_ChangesetManager.GetCurrentChangeset(GetVersion());
         }
 
+        /**
+         * \brief Replaces the device list. The devices are not opened.
+         * \param devices The new list of devices.
+         */
+        void SetDeviceList(const std::vector<SaneDeviceInfo> &devices);
+
+        /**
+         * \brief Starts the discovery of the devices on the worker thread.
+         *
+         * The selected device is closed, and it is selected again when the discovery completes, if it is still
+         * available.
+         */
+        void StartDiscovery();
+
+        /**
+         * \brief Applies the result of the discovery to the device list. Called on the main thread.
+         */
+        void ApplyDiscoveryResult();
+
         /**
          * \brief Selects a device by its name.
          *
          * This method updates the currently selected device, closes the previously selected device (if any),
          * and opens the new device. If the specified device name is invalid, it resets the selection to a null device.
+         * During a discovery, the device is only recorded, and it is selected when the discovery completes.
          *
          * \param deviceName The name of the device to select.
          */
-        void SelectDevice(const std::string &deviceName)
-        {
-            if (m_SelectedDeviceName == deviceName)
-                return;
-
-            auto device = GetDeviceByName(m_SelectedDeviceName);
-            if (device != nullptr)
-                device->Close();
-
-            device = GetDeviceByName(deviceName);
-
-            m_SelectedDeviceName = k_NullDeviceName;
-            if (device != nullptr)
-            {
-                if (device->Open())
-                {
-                    m_SelectedDeviceName = deviceName;
-                }
-            }
-
-            if (m_DumpSane && (m_SelectedDeviceName != k_NullDeviceName))
-            {
-                OptionRewriter::Dump(GetDeviceByName(m_SelectedDeviceName));
-            }
-        }
+        void SelectDevice(const std::string &deviceName);
 
     public:
         /**
@@ -182,34 +206,58 @@ namespace Gorfector
         }
 
         /**
-         * \brief Constructs a `DeviceSelectorState` instance and initializes the device list.
+         * \brief Checks if the devices are being discovered. The device list is the last known one until the
+         * discovery completes.
+         * \return True if a discovery is running.
+         */
+        [[nodiscard]] bool IsDiscovering() const
+        {
+            return m_IsDiscovering;
+        }
+
+        /**
+         * \brief Constructs a `DeviceSelectorState` instance and starts the discovery of the devices.
          *
-         * This constructor initializes the `DeviceSelectorState` by fetching the list of devices
-         * from the SANE library and selecting the first available device if the list is not empty.
+         * The first available device is selected when the discovery completes, unless the device that was selected
+         * the last time the application ran is available.
          *
          * \param state Pointer to the parent `ZooLib::State` instance.
          */
-        explicit DeviceSelectorState(ZooLib::State *state)
-            : StateComponent(state)
-        {
-            GetDevicesFromSANE();
-            if (!m_DeviceList.empty())
-            {
-                SelectDevice(m_DeviceList[0]->GetName());
-            }
-        }
+        explicit DeviceSelectorState(ZooLib::State *state);
 
         /**
-         * \brief Destructor for the `DeviceSelectorState` class.
+         * \brief Destructor for the `DeviceSelectorState` class. Waits for the running discovery, if any.
          */
         ~DeviceSelectorState() override
         {
+            // Stop the discovery thread before destroying the source it wakes up.
+            m_DeviceDiscovery.reset();
+            g_source_destroy(m_DiscoveryCompletedSource);
+            g_source_unref(m_DiscoveryCompletedSource);
+
+            m_State->SaveToFile(this);
+
             for (const auto device: m_DeviceList)
             {
                 delete device;
             }
         }
 
+        [[nodiscard]] std::string GetSerializationKey() const override
+        {
+            return "DeviceSelectorState";
+        }
+
+        [[nodiscard]] ZooLib::ChangesetManagerBase *GetChangesetManager() override
+        {
+            return &m_ChangesetManager;
+        }
+
+        void AggregateChangesets(uint64_t stateComponentVersion, DeviceSelectorStateChangeset &accumulator) const
+        {
+            m_ChangesetManager.AggregateChangesets(stateComponentVersion, accumulator);
+        }
+
         /**
          * \class Updater
          * \brief Provides an interface to update the state of the `DeviceSelectorState`.
@@ -230,20 +278,41 @@ namespace Gorfector
             {
             }
 
+            ~Updater() override
+            {
+                m_StateComponent->m_ChangesetManager.PushCurrentChangeset();
+            }
+
             /**
-             * \brief Loads the state from a JSON object (unimplemented).
+             * \brief Loads the last known device list from a JSON object. Ignored once a discovery has completed.
              * \param json The JSON object containing the state data.
              */
             void LoadFromJson(const nlohmann::json &json) override
             {
+                if (!m_StateComponent->m_IsDiscovering)
+                {
+                    return;
+                }
+
+                from_json(json, *m_StateComponent);
             }
 
             /**
-             * \brief Updates the device list by fetching the latest devices from the SANE library.
+             * \brief Starts the discovery of the devices on a worker thread. The device list is updated when the
+             * discovery completes.
              */
             void UpdateDeviceList() const
             {
-                m_StateComponent->GetDevicesFromSANE();
+                m_StateComponent->StartDiscovery();
+            }
+
+            /**
+             * \brief Applies the result of the last discovery, if any. Called on the main thread when a discovery
+             * completes.
+             */
+            void ApplyDiscoveryResult() const
+            {
+                m_StateComponent->ApplyDiscoveryResult();
             }
 
             /**
@@ -274,4 +343,7 @@ namespace Gorfector
             }
         };
     };
+
+    void to_json(nlohmann::json &j, const DeviceSelectorState &state);
+    void from_json(const nlohmann::json &j, DeviceSelectorState &state);
 }
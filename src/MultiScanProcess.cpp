@@ -13,9 +13,8 @@ static void DestroyProcess(gpointer data)
 
 void Gorfector::MultiScanProcess::InstallGtkCallback()
 {
-    m_ScanCallbackId = gtk_widget_add_tick_callback(
-            m_MainWindow,
-            [](GtkWidget *widget, GdkFrameClock *frameClock, gpointer data) -> gboolean {
+    InstallUpdateSource(
+            [](gpointer data) -> gboolean {
                 auto *scanProcess = static_cast<MultiScanProcess *>(data);
                 if (scanProcess->Update())
                 {
@@ -25,5 +24,5 @@ void Gorfector::MultiScanProcess::InstallGtkCallback()
                 scanProcess->Stop(false);
                 return G_SOURCE_REMOVE;
             },
-            this, DestroyProcess);
+            DestroyProcess);
 }
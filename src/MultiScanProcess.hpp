@@ -1,5 +1,7 @@
 #pragma once
 
+#include <format>
+
 #include "ScanProcess.hpp"
 #include "SingleScanProcess.hpp"
 #include "Writers/FileWriter.hpp"
@@ -19,6 +21,7 @@ namespace Gorfector
                    ": " + SingleScanProcess::GetProgressString();
         }
 
+    protected:
         bool ComputeFileName()
         {
             const auto &dirPath = m_OutputOptions->GetOutputDirectory();
@@ -31,6 +34,8 @@ namespace Gorfector
 
             if (!std::filesystem::exists(dirPath))
             {
+                auto dirPathStr = dirPath.string();
+                ShowError(std::vformat(_("Directory does not exists: {}."), std::make_format_args(dirPathStr)));
                 return false;
             }
 
@@ -41,6 +46,9 @@ namespace Gorfector
                 {
                     case OutputOptionsState::FileExistsAction::e_Cancel:
                     {
+                        auto imageFilePathStr = m_ImageFilePath.string();
+                        ShowError(std::vformat(
+                                _("File '{}' already exists."), std::make_format_args(imageFilePathStr)));
                         return false;
                     }
                     case OutputOptionsState::FileExistsAction::e_IncrementCounter:
@@ -48,6 +56,10 @@ namespace Gorfector
                         ZooLib::IncrementPath(m_ImageFilePath);
                         if (std::filesystem::exists(m_ImageFilePath))
                         {
+                            auto imageFilePathStr = m_ImageFilePath.string();
+                            ShowError(std::vformat(
+                                    _("Incrementing file name '{}' failed to produce a unique name."),
+                                    std::make_format_args(imageFilePathStr)));
                             return false;
                         }
                         break;
@@ -71,9 +83,9 @@ namespace Gorfector
 
             if (m_ScanListState->IsScanAreaItem(m_CurrentScanIndex))
             {
-                auto scanAreaSettings = m_ScanListState->GetScanAreaSettings(m_CurrentScanIndex);
+                auto scanAreaSettings = m_ScanListState->GetScanAreaSnapshot(m_CurrentScanIndex);
 
-                if (scanAreaSettings == nullptr || scanAreaSettings->empty())
+                if (scanAreaSettings == nullptr || scanAreaSettings->GetOptionCount() == 0)
                 {
                     return false;
                 }
@@ -83,10 +95,10 @@ namespace Gorfector
             }
             else
             {
-                auto scannerSettings = m_ScanListState->GetScannerSettings(m_CurrentScanIndex);
+                auto scannerSettings = m_ScanListState->GetScannerSettingsSnapshot(m_CurrentScanIndex);
                 auto outputSettings = m_ScanListState->GetOutputSettings(m_CurrentScanIndex);
 
-                if (scannerSettings == nullptr || outputSettings == nullptr || scannerSettings->empty() ||
+                if (scannerSettings == nullptr || outputSettings == nullptr || !scannerSettings->HasDevice() ||
                     outputSettings->empty())
                 {
                     return false;
@@ -99,36 +111,74 @@ namespace Gorfector
                 outputOptionsUpdater.ApplySettings(*outputSettings);
             }
 
-            if (ComputeFileName())
+            if (!ComputeFileName())
             {
-                m_FileWriter = FileWriter::GetFileWriterForPath(m_ImageFilePath);
-                return m_FileWriter != nullptr;
+                return false;
             }
 
-            return false;
+            m_FileWriter = FileWriter::GetFileWriterForPath(m_ImageFilePath);
+            if (m_FileWriter == nullptr)
+            {
+                ShowError(_("Unsupported file format."));
+                return false;
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] size_t GetItemIndex() const override
+        {
+            return m_CurrentScanIndex;
+        }
+
+        [[nodiscard]] bool HasNextFrame() const override
+        {
+            return SingleScanProcess::HasNextFrame() || m_CurrentScanIndex + 1 < m_ScanListState->GetScanListSize();
+        }
+
+        bool StartNextItem() override
+        {
+            if (m_CurrentScanIndex + 1 >= m_ScanListState->GetScanListSize())
+            {
+                return false;
+            }
+
+            ++m_CurrentScanIndex;
+            m_PageIndex = 0;
+            if (!LoadSettings() || !StartFrame())
+            {
+                m_HasFailed = true;
+                return false;
+            }
+
+            BeginFrame();
+            return true;
         }
 
-    protected:
         void InstallGtkCallback() override;
 
         void Stop(bool canceled) override
         {
             SingleScanProcess::Stop(canceled);
 
+            // The next frame could not be started by StartNextFrame(), or a file could not be saved.
+            canceled = canceled || m_HasFailed;
+
             ++m_CurrentScanIndex;
             if (canceled || m_CurrentScanIndex >= m_ScanListState->GetScanListSize())
             {
                 m_IsFinished = true;
             }
-            else
+            else if (!Start())
             {
-                Start();
+                // The next item could not be started: the scan list stops there.
+                m_IsFinished = true;
             }
         }
 
     public:
         MultiScanProcess(
-                SaneDevice *device, ScanListState *scanListState, PreviewState *previewState, AppState *appState,
+                ScanDevice *device, ScanListState *scanListState, PreviewState *previewState, AppState *appState,
                 DeviceOptionsState *scanOptions, OutputOptionsState *outputOptions, GtkWidget *mainWindow,
                 const std::function<void()> *finishCallback)
             : SingleScanProcess(
@@ -142,5 +192,13 @@ namespace Gorfector
         {
             return m_IsFinished;
         }
+
+        /**
+         * \brief Gets the index of the item being scanned in the scan list.
+         */
+        [[nodiscard]] size_t GetCurrentScanIndex() const
+        {
+            return m_CurrentScanIndex;
+        }
     };
 }
@@ -1,9 +1,11 @@
 #include "OptionRewriter.hpp"
 
 #include <format>
+#include <fstream>
 #include <glib.h>
 
-#include "App.hpp"
+#include "DeviceOptionCache.hpp"
+#include "ZooLib/PathUtils.hpp"
 
 void Gorfector::OptionRewriter::Dump(SaneDevice *device)
 {
@@ -20,264 +22,293 @@ void Gorfector::OptionRewriter::Dump(SaneDevice *device)
         return;
     }
 
-    for (auto i = 1; i < optionCount; i++)
+    auto options = DeviceOptionCache::DescribeOptions(device, optionCount);
+    if (!options.empty())
     {
-        auto option = device->GetOptionDescriptor(i);
-        if (option == nullptr)
-        {
-            continue;
-        }
+        deviceInfo["options"] = options;
+        deviceInfo["option_hash"] = DeviceOptionCache::GetOptionHash(options);
+    }
 
-        std::string description{};
-        if (option->desc != nullptr)
-        {
-            auto descLen = std::strlen(option->desc);
-            description.reserve(descLen);
-            auto n = 0UZ;
-            while (n < descLen)
-            {
-                if (option->desc[n] == '"')
-                {
-                    description += "\\\"";
-                }
-                else
-                {
-                    description += option->desc[n];
-                }
-                n++;
-            }
-        }
+    g_print("%s", deviceInfo.dump(4).c_str());
+}
 
-        auto stringListJson = nlohmann::json::array();
-        if (option->type == SANE_TYPE_STRING && option->constraint_type == SANE_CONSTRAINT_STRING_LIST)
-        {
-            auto stringList = option->constraint.string_list;
-            if (stringList != nullptr && stringList[0] != nullptr)
-            {
-                for (auto j = 0; stringList[j] != nullptr; j++)
-                {
-                    stringListJson.push_back(stringList[j]);
-                }
-            }
-        }
+static nlohmann::json ReadJsonFile(const std::filesystem::path &filePath)
+{
+    std::ifstream file(filePath);
+    if (!file)
+    {
+        return nlohmann::json::value_t::discarded;
+    }
 
-        auto title = option->title == nullptr ? "" : option->title;
+    return nlohmann::json::parse(file, nullptr, false);
+}
 
-        auto name = option->name == nullptr ? "<no name>" : option->name;
+Gorfector::ScannerDescriptionIndex::ScannerDescriptionIndex(
+        const std::filesystem::path &systemConfigPath, const std::filesystem::path &userConfigPath)
+{
+    auto baseDirectory = systemConfigPath / "scanners";
+    auto prefDirectory = userConfigPath / "scanners";
 
-        auto flags = std::vector<std::string>{};
-        if (SaneDevice::IsAdvanced(*option))
-        {
-            flags.emplace_back("advanced");
-        }
-        if (SaneDevice::IsDisplayOnly(*option))
-        {
-            flags.emplace_back("display only");
-        }
+    std::error_code error;
+    std::filesystem::create_directories(prefDirectory, error);
 
-        auto flagsStr = std::string{};
-        if (!flags.empty())
-        {
-            flagsStr = flags[0];
-            for (auto j = 1UZ; j < flags.size(); j++)
-            {
-                flagsStr += ", ";
-                flagsStr += flags[j];
-            }
-        }
-        std::string comment{};
-        comment += name;
-        comment += " (";
-        comment += flagsStr;
-        comment += ")";
-
-        auto jsonOption = nlohmann::json();
-        jsonOption["id"] = i;
-        jsonOption["title"] = title;
-        jsonOption["description"] = description;
-        jsonOption["string_list"] = stringListJson;
-        jsonOption["flags"] = nlohmann::json::array();
-        jsonOption["comment"] = comment;
-
-        deviceInfo["options"].push_back(jsonOption);
-
-        auto optionDump = deviceInfo["options"].dump();
-        auto hash = std::hash<std::string>{}(optionDump);
-        deviceInfo["option_hash"] = std::format("{:x}", hash);
+    m_IndexFilePath = prefDirectory / "index.json";
+
+    ScanContext context{};
+    if (std::filesystem::exists(m_IndexFilePath))
+    {
+        context.IndexModifiedTime = std::filesystem::last_write_time(m_IndexFilePath, error);
+        ReadIndexFile(context);
+    }
+    else
+    {
+        context.IndexModifiedTime = std::filesystem::file_time_type::min();
+        // Create the index file before reading the modification time of its directory: rewriting it later does not
+        // change the modification time of the directory.
+        std::ofstream(m_IndexFilePath).close();
+        m_Changed = true;
     }
 
-    g_print("%s", deviceInfo.dump(4).c_str());
-}
+    ScanDirectory(baseDirectory, context);
+    ScanDirectory(prefDirectory, context);
+    RemoveMissingFiles(context);
 
-void AddToIndex(
-        nlohmann::json &index, const std::string &vendorName, const std::string &modelName, const std::string &filePath)
-{
-    for (auto vendor: index["contents"])
+    if (m_Changed || m_Directories != context.PreviousDirectories)
     {
-        if (vendor["vendor"] == vendorName)
-        {
-            for (auto model: vendor["models"])
-            {
-                if (model["name"] == modelName)
-                {
-                    model["filepath"] = filePath;
-                }
-            }
-
-            auto newModel = nlohmann::json({{"name", modelName}, {"filepath", filePath}});
-            vendor["models"].push_back(newModel);
-            return;
-        }
+        WriteIndexFile();
     }
+}
 
-    auto newVendor = nlohmann::json({{"vendor", vendorName}, {"models", nlohmann::json::array()}});
-    auto newModel = nlohmann::json({{"name", modelName}, {"filepath", filePath}});
-    newVendor["models"].push_back(newModel);
-    index["contents"].push_back(newVendor);
+std::string Gorfector::ScannerDescriptionIndex::GetModelKey(std::string_view vendor, std::string_view model)
+{
+    // Vendor and model names do not contain control characters.
+    return std::format("{}\x1f{}", vendor, model);
 }
 
-void UpdateIndexRecursively(
-        const std::filesystem::path &scannersPath, const std::filesystem::file_time_type &indexModifiedTime,
-        nlohmann::json &index)
+void Gorfector::ScannerDescriptionIndex::ReadIndexFile(ScanContext &context)
 {
-    if (!std::filesystem::exists(scannersPath))
+    auto index = ReadJsonFile(m_IndexFilePath);
+    if (!index.is_object())
     {
+        m_Changed = true;
         return;
     }
 
-    for (const auto &entry: std::filesystem::directory_iterator(scannersPath))
+    if (auto contents = index.find("contents"); contents != index.end() && contents->is_array())
     {
-        if (entry.is_directory())
-        {
-            UpdateIndexRecursively(entry.path(), indexModifiedTime, index);
-        }
-        else if (entry.path().extension() == ".json")
+        for (const auto &vendor: *contents)
         {
-            const auto &scannerFilePath = entry.path();
-            if (std::filesystem::exists(scannerFilePath) &&
-                std::filesystem::last_write_time(scannerFilePath) > indexModifiedTime)
+            if (!vendor.is_object() || !vendor.contains("models") || !vendor["models"].is_array())
             {
-                std::ifstream scannerFile(scannerFilePath);
-                auto scannerData = nlohmann::json::parse(scannerFile);
-                scannerFile.close();
+                continue;
+            }
 
-                if (scannerData.is_null() || !scannerData.contains("devices") || !scannerData["devices"].is_array())
+            auto vendorName = vendor.value("vendor", std::string{});
+            for (const auto &model: vendor["models"])
+            {
+                if (!model.is_object())
                 {
                     continue;
                 }
 
-                for (auto device: scannerData["devices"])
+                auto modelName = model.value("name", std::string{});
+                auto filePath = model.value("filepath", std::string{});
+                if (!filePath.empty())
                 {
-                    auto vendor = device["vendor"].get<std::string>();
-                    auto model = device["model"].get<std::string>();
-                    auto path = canonical(scannerFilePath);
-                    path = ZooLib::UnrelocatePath(scannerFilePath);
-                    AddToIndex(index, vendor, model, path.string());
+                    m_DescriptionFiles.insert_or_assign(GetModelKey(vendorName, modelName), filePath);
+                    m_IndexedFiles.insert(filePath);
                 }
             }
         }
     }
+
+    if (auto directories = index.find("directories"); directories != index.end() && directories->is_object())
+    {
+        for (const auto &[path, directory]: directories->items())
+        {
+            if (!directory.is_object() || !directory.contains("subdirectories") ||
+                !directory["subdirectories"].is_array())
+            {
+                continue;
+            }
+
+            DirectoryState state{directory.value("modified_time", int64_t{}), {}};
+            for (const auto &subdirectory: directory["subdirectories"])
+            {
+                if (subdirectory.is_string())
+                {
+                    state.Subdirectories.push_back(subdirectory.get<std::string>());
+                }
+            }
+            context.PreviousDirectories.insert_or_assign(path, std::move(state));
+        }
+    }
 }
 
-Gorfector::OptionRewriter::OptionRewriter(
-        const std::filesystem::path &systemConfigPath, const std::filesystem::path &userConfigPath)
+void Gorfector::ScannerDescriptionIndex::WriteIndexFile() const
 {
-    auto baseDirectory = systemConfigPath / "scanners";
-    auto prefDirectory = userConfigPath / "scanners";
-
-    if (!std::filesystem::exists(prefDirectory))
+    std::map<std::string, nlohmann::json> vendors;
+    for (const auto &[key, filePath]: m_DescriptionFiles)
     {
-        std::filesystem::create_directories(prefDirectory);
+        auto separator = key.find('\x1f');
+        auto vendorName = key.substr(0, separator);
+        auto &vendor = vendors[vendorName];
+        if (vendor.is_null())
+        {
+            vendor = nlohmann::json({{"vendor", vendorName}, {"models", nlohmann::json::array()}});
+        }
+        vendor["models"].push_back(nlohmann::json({{"name", key.substr(separator + 1)}, {"filepath", filePath}}));
     }
 
-    auto indexFilePath = prefDirectory / "index.json";
-    std::filesystem::file_time_type indexModifiedTime;
-    nlohmann::json index;
-
-    if (!std::filesystem::exists(indexFilePath))
+    auto index = nlohmann::json::object();
+    index["contents"] = nlohmann::json::array();
+    for (auto &[vendorName, vendor]: vendors)
     {
-        indexModifiedTime = std::filesystem::file_time_type::min();
+        index["contents"].push_back(std::move(vendor));
     }
-    else
+
+    index["directories"] = nlohmann::json::object();
+    for (const auto &[path, directory]: m_Directories)
     {
-        indexModifiedTime = std::filesystem::last_write_time(indexFilePath);
-        auto indexFile = std::ifstream(indexFilePath);
-        index = nlohmann::json::parse(indexFile);
-        indexFile.close();
+        index["directories"][path] = nlohmann::json(
+                {{"modified_time", directory.ModifiedTime}, {"subdirectories", directory.Subdirectories}});
     }
 
-    if (index.empty() || !index.contains("contents") || !index["contents"].is_array())
+    // Overwrite the file in place, to keep the modification time of its directory.
+    auto indexFile = std::ofstream(m_IndexFilePath, std::ios::trunc);
+    indexFile << index.dump(4);
+    indexFile.close();
+    if (indexFile.fail())
     {
-        index = nlohmann::json::object();
-        index["contents"] = nlohmann::json::array();
+        g_warning("Failed to write the scanner description index %s", m_IndexFilePath.c_str());
     }
-
-    UpdateIndexRecursively(baseDirectory, indexModifiedTime, index);
-    UpdateIndexRecursively(prefDirectory, indexModifiedTime, index);
-
-    auto newIndexFile = std::ofstream(indexFilePath);
-    newIndexFile << index.dump(4);
-    newIndexFile.close();
 }
 
-void Gorfector::OptionRewriter::LoadOptionDescriptionFile(
-        const std::filesystem::path &userConfigPath, const char *deviceVendor, const char *deviceModel)
+void Gorfector::ScannerDescriptionIndex::ScanDirectory(const std::filesystem::path &directory, ScanContext &context)
 {
-    m_OptionInfos.clear();
-
-    auto prefDirectory = userConfigPath / "scanners";
-    auto indexFilePath = prefDirectory / "index.json";
-
-    nlohmann::json index;
-    if (std::filesystem::exists(indexFilePath))
+    std::error_code error;
+    auto modifiedTime = std::filesystem::last_write_time(directory, error);
+    if (error)
     {
-        std::ifstream indexFile(indexFilePath);
-        index = nlohmann::json::parse(indexFile);
-        indexFile.close();
+        return;
     }
 
-    if (index.empty() || !index.contains("contents") || !index["contents"].is_array())
+    auto directoryKey = ZooLib::UnrelocatePath(directory).string();
+    auto state = DirectoryState{modifiedTime.time_since_epoch().count(), {}};
+
+    if (auto it = context.PreviousDirectories.find(directoryKey);
+        it != context.PreviousDirectories.end() && it->second.ModifiedTime == state.ModifiedTime)
     {
-        return;
+        // No file was added, removed or renamed in this directory since it was indexed.
+        state.Subdirectories = it->second.Subdirectories;
     }
-
-    auto optionFilePath = std::filesystem::path();
-    for (auto vendor: index["contents"])
+    else
     {
-        if (vendor["vendor"] == deviceVendor)
+        ++m_ListedDirectoryCount;
+        context.ListedDirectories.insert(directoryKey);
+
+        for (const auto &entry: std::filesystem::directory_iterator(directory, error))
         {
-            for (auto model: vendor["models"])
+            const auto &path = entry.path();
+            if (entry.is_directory(error))
+            {
+                state.Subdirectories.push_back(path.filename().string());
+            }
+            else if (path.extension() == ".json" && path != m_IndexFilePath)
             {
-                if (model["name"] == deviceModel)
+                auto filePath = ZooLib::UnrelocatePath(path).string();
+                context.ListedFiles.insert(filePath);
+
+                if (!m_IndexedFiles.contains(filePath) ||
+                    entry.last_write_time(error) > context.IndexModifiedTime)
                 {
-                    auto filepath = model["filepath"].get<std::string>();
-                    optionFilePath = ZooLib::RelocatePath(filepath);
-                    break;
+                    AddDescriptionFile(filePath);
                 }
             }
         }
 
-        if (!optionFilePath.empty())
-        {
-            break;
-        }
+        std::ranges::sort(state.Subdirectories);
     }
 
-    if (std::filesystem::exists(optionFilePath))
+    m_Directories.insert_or_assign(directoryKey, state);
+
+    for (const auto &subdirectory: state.Subdirectories)
     {
-        std::ifstream optionFile(optionFilePath);
-        auto optionFileData = nlohmann::json::parse(optionFile);
-        optionFile.close();
+        ScanDirectory(directory / subdirectory, context);
+    }
+}
+
+void Gorfector::ScannerDescriptionIndex::AddDescriptionFile(const std::string &filePath)
+{
+    std::erase_if(m_DescriptionFiles, [&filePath](const auto &entry) { return entry.second == filePath; });
+    m_IndexedFiles.insert(filePath);
+    m_Changed = true;
+
+    auto scannerData = ReadJsonFile(ZooLib::RelocatePath(filePath));
+    if (!scannerData.is_object() || !scannerData.contains("devices") || !scannerData["devices"].is_array())
+    {
+        return;
+    }
 
-        if (optionFileData.is_null() || !optionFileData.contains("options") || !optionFileData["options"].is_array())
+    for (const auto &device: scannerData["devices"])
+    {
+        if (!device.is_object())
         {
-            return;
+            continue;
         }
 
-        for (auto option: optionFileData["options"])
+        auto vendor = device.value("vendor", std::string{});
+        auto model = device.value("model", std::string{});
+        m_DescriptionFiles.insert_or_assign(GetModelKey(vendor, model), filePath);
+    }
+}
+
+void Gorfector::ScannerDescriptionIndex::RemoveMissingFiles(const ScanContext &context)
+{
+    auto removedCount = std::erase_if(m_DescriptionFiles, [this, &context](const auto &entry) {
+        auto directoryKey = std::filesystem::path(entry.second).parent_path().string();
+        if (!m_Directories.contains(directoryKey))
         {
-            auto id = option["id"].get<uint32_t>();
-            m_OptionInfos[id] = option.get<OptionInfos>();
+            return true;
         }
+
+        return context.ListedDirectories.contains(directoryKey) && !context.ListedFiles.contains(entry.second);
+    });
+
+    if (removedCount > 0)
+    {
+        m_Changed = true;
     }
 }
+
+const std::map<uint32_t, Gorfector::OptionInfos> *
+Gorfector::ScannerDescriptionIndex::Find(std::string_view deviceVendor, std::string_view deviceModel)
+{
+    auto key = GetModelKey(deviceVendor, deviceModel);
+    if (auto it = m_OptionInfos.find(key); it != m_OptionInfos.end())
+    {
+        return &it->second;
+    }
+
+    auto fileIt = m_DescriptionFiles.find(key);
+    if (fileIt == m_DescriptionFiles.end())
+    {
+        return nullptr;
+    }
+
+    auto optionFileData = ReadJsonFile(ZooLib::RelocatePath(fileIt->second));
+    if (!optionFileData.is_object() || !optionFileData.contains("options") || !optionFileData["options"].is_array())
+    {
+        g_warning("Invalid scanner description file %s", fileIt->second.c_str());
+        return nullptr;
+    }
+
+    auto &optionInfos = m_OptionInfos[key];
+    for (const auto &option: optionFileData["options"])
+    {
+        auto id = option.at("id").get<uint32_t>();
+        optionInfos[id] = option.get<OptionInfos>();
+    }
+
+    return &optionInfos;
+}
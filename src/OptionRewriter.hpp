@@ -5,9 +5,13 @@
 #include <nlohmann/json.hpp>
 #include <sane/sane.h>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "SaneDevice.hpp"
+#include "ZooLib/Gettext.hpp"
 
 namespace Gorfector
 {
@@ -62,12 +66,99 @@ namespace Gorfector
         p.Flags = flags;
     }
 
+    /**
+     * \class ScannerDescriptionIndex
+     * \brief Finds the scanner description files, which rewrite the options of device models, by vendor and model.
+     *
+     * The `scanners` directories of the system and user configuration paths are indexed in `scanners/index.json`,
+     * in the user configuration path. The index records the modification time of each directory: a directory whose
+     * modification time did not change is not listed again, and the index file is rewritten only if something
+     * changed. The description files are parsed when a device of their model is first looked up.
+     */
+    class ScannerDescriptionIndex final
+    {
+        struct DirectoryState
+        {
+            int64_t ModifiedTime{};
+            std::vector<std::string> Subdirectories{};
+
+            bool operator==(const DirectoryState &other) const = default;
+        };
+
+        std::filesystem::path m_IndexFilePath{};
+
+        // Unrelocated path of the description file of each model, by model key.
+        std::unordered_map<std::string, std::string> m_DescriptionFiles{};
+        std::unordered_set<std::string> m_IndexedFiles{};
+        // Parsed description files, by model key.
+        std::unordered_map<std::string, std::map<uint32_t, OptionInfos>> m_OptionInfos{};
+
+        // State of each indexed directory, by unrelocated path.
+        std::map<std::string, DirectoryState> m_Directories{};
+        size_t m_ListedDirectoryCount{};
+        bool m_Changed{};
+
+        struct ScanContext
+        {
+            std::map<std::string, DirectoryState> PreviousDirectories{};
+            std::filesystem::file_time_type IndexModifiedTime{};
+            std::unordered_set<std::string> ListedDirectories{};
+            std::unordered_set<std::string> ListedFiles{};
+        };
+
+        static std::string GetModelKey(std::string_view vendor, std::string_view model);
+
+        void ReadIndexFile(ScanContext &context);
+        void WriteIndexFile() const;
+        void ScanDirectory(const std::filesystem::path &directory, ScanContext &context);
+        void AddDescriptionFile(const std::string &filePath);
+        void RemoveMissingFiles(const ScanContext &context);
+
+    public:
+        /**
+         * \brief Builds the index, updating the index file if needed.
+         * \param systemConfigPath Path to system config files.
+         * \param userConfigPath Path to user config files.
+         */
+        ScannerDescriptionIndex(
+                const std::filesystem::path &systemConfigPath, const std::filesystem::path &userConfigPath);
+
+        /**
+         * \brief Finds the option descriptions of a device model.
+         * \param deviceVendor The vendor name of the device.
+         * \param deviceModel The model name of the device.
+         * \return The option descriptions, indexed by option index, or nullptr if there is no description file for the
+         * model.
+         */
+        const std::map<uint32_t, OptionInfos> *Find(std::string_view deviceVendor, std::string_view deviceModel);
+
+        /**
+         * \brief Gets the number of directories that were listed when the index was built. The other directories did
+         * not change since the index file was written.
+         */
+        [[nodiscard]] size_t GetListedDirectoryCount() const
+        {
+            return m_ListedDirectoryCount;
+        }
+    };
+
     class OptionRewriter final
     {
         /**
-         * \brief Stores information about options, indexed by their option index.
+         * \brief Stores information about options, indexed by their option index. Owned by the index.
          */
-        std::map<uint32_t, OptionInfos> m_OptionInfos;
+        const std::map<uint32_t, OptionInfos> *m_OptionInfos{};
+
+        [[nodiscard]] const OptionInfos *FindOptionInfos(int optionIndex) const
+        {
+            if (m_OptionInfos == nullptr)
+            {
+                return nullptr;
+            }
+
+            auto it = m_OptionInfos->find(optionIndex);
+            return it == m_OptionInfos->end() ? nullptr : &it->second;
+        }
 
     public:
         /**
@@ -77,11 +168,9 @@ namespace Gorfector
         static void Dump(SaneDevice *device);
 
         /**
-         * \brief Constructs an `OptionRewriter` instance.
-         * \param systemConfigPath Path to system config files.
-         * \param userConfigPath Path to user config files.
+         * \brief Constructs an `OptionRewriter` instance, which does not rewrite any option.
          */
-        OptionRewriter(const std::filesystem::path &systemConfigPath, const std::filesystem::path &userConfigPath);
+        OptionRewriter() = default;
 
         /**
          * \brief Default destructor for the `OptionRewriter` class.
@@ -90,12 +179,15 @@ namespace Gorfector
 
         /**
          * \brief Loads option descriptions for a specific device based on its vendor and model.
-         * \param userConfigPath Path to user configuration files.
+         * \param index The index of the scanner description files.
          * \param deviceVendor The vendor name of the device.
          * \param deviceModel The model name of the device.
          */
-        void LoadOptionDescriptionFile(
-                const std::filesystem::path &userConfigPath, const char *deviceVendor, const char *deviceModel);
+        void
+        LoadOptionDescriptionFile(ScannerDescriptionIndex &index, const char *deviceVendor, const char *deviceModel)
+        {
+            m_OptionInfos = index.Find(deviceVendor, deviceModel);
+        }
 
         /**
          * \brief Retrieves the title of an option.
@@ -106,9 +198,9 @@ namespace Gorfector
         const char *GetTitle(int optionIndex, const char *defaultText)
         {
             const char *text = defaultText;
-            if (auto it = m_OptionInfos.find(optionIndex); it != m_OptionInfos.end())
+            if (auto optionInfos = FindOptionInfos(optionIndex); optionInfos != nullptr)
             {
-                text = it->second.Title.c_str();
+                text = optionInfos->Title.c_str();
             }
 
             if (text == nullptr || *text == '\0')
@@ -127,9 +219,9 @@ namespace Gorfector
         const char *GetDescription(int optionIndex, const char *defaultText)
         {
             const char *text = defaultText;
-            if (auto it = m_OptionInfos.find(optionIndex); it != m_OptionInfos.end())
+            if (auto optionInfos = FindOptionInfos(optionIndex); optionInfos != nullptr)
             {
-                text = it->second.Description.c_str();
+                text = optionInfos->Description.c_str();
             }
 
             if (text == nullptr || *text == '\0')
@@ -148,12 +240,12 @@ namespace Gorfector
         void
         GetStringList(int optionIndex, const SANE_String_Const *defaultList, SANE_String_Const *rewrittenStringList)
         {
-            if (auto it = m_OptionInfos.find(optionIndex); it != m_OptionInfos.end())
+            if (auto optionInfos = FindOptionInfos(optionIndex); optionInfos != nullptr)
             {
                 auto i = 0UZ;
-                for (; i < it->second.StringStringList.size(); ++i)
+                for (; i < optionInfos->StringStringList.size(); ++i)
                 {
-                    auto &text = it->second.StringStringList[i];
+                    auto &text = optionInfos->StringStringList[i];
                     if (text.empty())
                     {
                         rewrittenStringList[i] = text.c_str();
@@ -191,9 +283,9 @@ namespace Gorfector
          */
         bool IsDisplayOnly(int optionIndex, bool defaultValue)
         {
-            if (auto it = m_OptionInfos.find(optionIndex); it != m_OptionInfos.end())
+            if (auto optionInfos = FindOptionInfos(optionIndex); optionInfos != nullptr)
             {
-                return it->second.Flags & static_cast<uint32_t>(OptionFlags::e_ForceReadOnly);
+                return optionInfos->Flags & static_cast<uint32_t>(OptionFlags::e_ForceReadOnly);
             }
 
             return defaultValue;
@@ -207,14 +299,14 @@ namespace Gorfector
          */
         bool ShouldHide(int optionIndex, bool defaultValue)
         {
-            if (auto it = m_OptionInfos.find(optionIndex); it != m_OptionInfos.end())
+            if (auto optionInfos = FindOptionInfos(optionIndex); optionInfos != nullptr)
             {
-                if (it->second.Flags & static_cast<uint32_t>(OptionFlags::e_ForceHidden))
+                if (optionInfos->Flags & static_cast<uint32_t>(OptionFlags::e_ForceHidden))
                 {
                     return true;
                 }
 
-                if (it->second.Flags & static_cast<uint32_t>(OptionFlags::e_ForceShown))
+                if (optionInfos->Flags & static_cast<uint32_t>(OptionFlags::e_ForceShown))
                 {
                     return false;
                 }
@@ -231,14 +323,14 @@ namespace Gorfector
          */
         bool IsAdvanced(int optionIndex, bool defaultValue)
         {
-            if (auto it = m_OptionInfos.find(optionIndex); it != m_OptionInfos.end())
+            if (auto optionInfos = FindOptionInfos(optionIndex); optionInfos != nullptr)
             {
-                if (it->second.Flags & static_cast<uint32_t>(OptionFlags::e_ForceAdvanced))
+                if (optionInfos->Flags & static_cast<uint32_t>(OptionFlags::e_ForceAdvanced))
                 {
                     return true;
                 }
 
-                if (it->second.Flags & static_cast<uint32_t>(OptionFlags::e_ForceBasic))
+                if (optionInfos->Flags & static_cast<uint32_t>(OptionFlags::e_ForceBasic))
                 {
                     return false;
                 }
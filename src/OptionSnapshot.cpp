@@ -0,0 +1,345 @@
+#include "OptionSnapshot.hpp"
+
+#include <fstream>
+#include <glib.h>
+#include <vector>
+
+#include "DeviceOptionsState.hpp"
+
+static constexpr std::string_view k_FileMagic = "GOSF";
+
+static void WriteUint8(std::vector<uint8_t> &bytes, uint8_t value)
+{
+    bytes.push_back(value);
+}
+
+static void WriteUint32(std::vector<uint8_t> &bytes, uint32_t value)
+{
+    bytes.push_back(static_cast<uint8_t>(value));
+    bytes.push_back(static_cast<uint8_t>(value >> 8));
+    bytes.push_back(static_cast<uint8_t>(value >> 16));
+    bytes.push_back(static_cast<uint8_t>(value >> 24));
+}
+
+static void WriteString(std::vector<uint8_t> &bytes, std::string_view value)
+{
+    WriteUint32(bytes, static_cast<uint32_t>(value.size()));
+    bytes.insert(bytes.end(), value.begin(), value.end());
+}
+
+static std::string_view GetString(const nlohmann::json &object, const char *key)
+{
+    auto it = object.find(key);
+    if (it == object.end() || !it->is_string())
+    {
+        return {};
+    }
+
+    return it->get_ref<const std::string &>();
+}
+
+static bool WriteOption(std::vector<uint8_t> &bytes, const std::string &name, const nlohmann::json &values)
+{
+    if (!values.is_array() || values.empty())
+    {
+        return false;
+    }
+
+    Gorfector::OptionSnapshot::ValueType type;
+    if (values[0].is_boolean())
+    {
+        type = Gorfector::OptionSnapshot::ValueType::e_Bool;
+    }
+    else if (values[0].is_number())
+    {
+        type = Gorfector::OptionSnapshot::ValueType::e_Int;
+    }
+    else if (values[0].is_string())
+    {
+        type = Gorfector::OptionSnapshot::ValueType::e_String;
+    }
+    else
+    {
+        return false;
+    }
+
+    // Convert the values first, so that nothing is written for an option with invalid values.
+    std::vector<uint8_t> valueBytes;
+    try
+    {
+        for (const auto &value: values)
+        {
+            switch (type)
+            {
+                case Gorfector::OptionSnapshot::ValueType::e_Bool:
+                    WriteUint8(valueBytes, value.get<bool>() ? 1 : 0);
+                    break;
+                case Gorfector::OptionSnapshot::ValueType::e_Int:
+                    WriteUint32(valueBytes, static_cast<uint32_t>(value.get<int32_t>()));
+                    break;
+                case Gorfector::OptionSnapshot::ValueType::e_String:
+                    WriteString(valueBytes, value.get_ref<const std::string &>());
+                    break;
+            }
+        }
+    }
+    catch (const nlohmann::json::exception &)
+    {
+        return false;
+    }
+
+    WriteString(bytes, name);
+    WriteUint8(bytes, static_cast<uint8_t>(type));
+    WriteUint32(bytes, static_cast<uint32_t>(values.size()));
+    bytes.insert(bytes.end(), valueBytes.begin(), valueBytes.end());
+    return true;
+}
+
+bool Gorfector::OptionSnapshot::ReadOption(Reader &reader, Option &option)
+{
+    option.m_Name = reader.ReadString();
+    auto type = reader.ReadUint8();
+    option.m_ValueCount = reader.ReadUint32();
+    if (reader.Failed() || type > static_cast<uint8_t>(ValueType::e_String))
+    {
+        return false;
+    }
+
+    option.m_Type = static_cast<ValueType>(type);
+    auto valuesStart = reader.GetPosition();
+    switch (option.m_Type)
+    {
+        case ValueType::e_Bool:
+            reader.Skip(option.m_ValueCount);
+            break;
+        case ValueType::e_Int:
+            reader.Skip(4 * static_cast<size_t>(option.m_ValueCount));
+            break;
+        case ValueType::e_String:
+            for (auto i = 0U; i < option.m_ValueCount && !reader.Failed(); ++i)
+            {
+                reader.ReadString();
+            }
+            break;
+    }
+
+    if (reader.Failed())
+    {
+        return false;
+    }
+
+    option.m_Values = reader.GetRange(valuesStart);
+    return true;
+}
+
+std::optional<Gorfector::OptionSnapshot> Gorfector::OptionSnapshot::FromJson(const nlohmann::json &settings)
+{
+    if (!settings.is_object())
+    {
+        return std::nullopt;
+    }
+
+    auto bytes = std::make_shared<std::vector<uint8_t>>(k_Magic.begin(), k_Magic.end());
+
+    const nlohmann::json *options = &settings;
+    auto device = settings.find(DeviceOptionsState::k_DeviceKey);
+    if (device != settings.end() && device->is_object())
+    {
+        WriteString(*bytes, GetString(*device, DeviceOptionsState::k_DeviceNameKey));
+        WriteString(*bytes, GetString(*device, DeviceOptionsState::k_DeviceVendorKey));
+        WriteString(*bytes, GetString(*device, DeviceOptionsState::k_DeviceModelKey));
+        WriteString(*bytes, GetString(*device, DeviceOptionsState::k_DeviceTypeKey));
+
+        auto optionsIt = settings.find(DeviceOptionsState::k_OptionsKey);
+        static const auto k_NoOptions = nlohmann::json::object();
+        options = optionsIt != settings.end() && optionsIt->is_object() ? &*optionsIt : &k_NoOptions;
+    }
+    else
+    {
+        for (auto i = 0; i < 4; ++i)
+        {
+            WriteString(*bytes, {});
+        }
+    }
+
+    auto optionCountPosition = bytes->size();
+    WriteUint32(*bytes, 0);
+
+    uint32_t optionCount = 0;
+    for (const auto &[name, values]: options->items())
+    {
+        if (WriteOption(*bytes, name, values))
+        {
+            ++optionCount;
+        }
+    }
+
+    std::vector<uint8_t> optionCountBytes;
+    WriteUint32(optionCountBytes, optionCount);
+    std::ranges::copy(optionCountBytes, bytes->begin() + static_cast<ptrdiff_t>(optionCountPosition));
+
+    auto span = std::span<const uint8_t>(*bytes);
+    return FromBytes(span, std::move(bytes));
+}
+
+std::optional<Gorfector::OptionSnapshot>
+Gorfector::OptionSnapshot::FromBytes(std::span<const uint8_t> bytes, std::shared_ptr<const void> storage)
+{
+    auto reader = Reader(bytes, 0);
+    auto magic = reader.Skip(k_Magic.size());
+    if (magic == nullptr || std::string_view(reinterpret_cast<const char *>(magic), k_Magic.size()) != k_Magic)
+    {
+        return std::nullopt;
+    }
+
+    OptionSnapshot snapshot;
+    snapshot.m_DeviceName = reader.ReadString();
+    snapshot.m_DeviceVendor = reader.ReadString();
+    snapshot.m_DeviceModel = reader.ReadString();
+    snapshot.m_DeviceType = reader.ReadString();
+    snapshot.m_OptionCount = reader.ReadUint32();
+    snapshot.m_FirstOptionPosition = reader.GetPosition();
+
+    Option option;
+    for (auto i = 0U; i < snapshot.m_OptionCount; ++i)
+    {
+        if (!ReadOption(reader, option))
+        {
+            return std::nullopt;
+        }
+    }
+
+    if (reader.Failed() || reader.GetPosition() != bytes.size())
+    {
+        return std::nullopt;
+    }
+
+    snapshot.m_Storage = std::move(storage);
+    snapshot.m_Bytes = bytes;
+    return snapshot;
+}
+
+nlohmann::json Gorfector::OptionSnapshot::ToJson() const
+{
+    auto options = nlohmann::json::object();
+    ForEachOption([&options](const Option &option) {
+        auto values = nlohmann::json::array();
+        for (auto i = 0U; i < option.GetValueCount(); ++i)
+        {
+            switch (option.GetType())
+            {
+                case ValueType::e_Bool:
+                    values.push_back(option.GetBool(i));
+                    break;
+                case ValueType::e_Int:
+                    values.push_back(option.GetInt(i));
+                    break;
+                case ValueType::e_String:
+                    values.push_back(std::string(option.GetString(i)));
+                    break;
+            }
+        }
+        options[std::string(option.GetName())] = std::move(values);
+    });
+
+    if (!HasDevice())
+    {
+        return options;
+    }
+
+    auto settings = nlohmann::json::object();
+    settings[DeviceOptionsState::k_DeviceKey] = {
+            {DeviceOptionsState::k_DeviceNameKey, m_DeviceName},
+            {DeviceOptionsState::k_DeviceVendorKey, m_DeviceVendor},
+            {DeviceOptionsState::k_DeviceModelKey, m_DeviceModel},
+            {DeviceOptionsState::k_DeviceTypeKey, m_DeviceType},
+    };
+    settings[DeviceOptionsState::k_OptionsKey] = std::move(options);
+    return settings;
+}
+
+bool Gorfector::OptionSnapshotFile::Write(
+        const std::filesystem::path &filePath, const std::map<std::string, OptionSnapshot> &snapshots)
+{
+    std::vector<uint8_t> bytes;
+    bytes.insert(bytes.end(), k_FileMagic.begin(), k_FileMagic.end());
+    WriteUint32(bytes, static_cast<uint32_t>(snapshots.size()));
+    for (const auto &[name, snapshot]: snapshots)
+    {
+        WriteString(bytes, name);
+        auto snapshotBytes = snapshot.GetBytes();
+        WriteUint32(bytes, static_cast<uint32_t>(snapshotBytes.size()));
+        bytes.insert(bytes.end(), snapshotBytes.begin(), snapshotBytes.end());
+    }
+
+    auto temporaryFilePath = filePath;
+    temporaryFilePath += ".tmp";
+
+    std::error_code error;
+    {
+        std::ofstream outFile(temporaryFilePath, std::ios::binary | std::ios::trunc);
+        outFile.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        outFile.close();
+        if (outFile.fail())
+        {
+            std::filesystem::remove(temporaryFilePath, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporaryFilePath, filePath, error);
+    if (error)
+    {
+        std::filesystem::remove(temporaryFilePath, error);
+        return false;
+    }
+
+    return true;
+}
+
+std::optional<std::map<std::string, Gorfector::OptionSnapshot>>
+Gorfector::OptionSnapshotFile::Read(const std::filesystem::path &filePath)
+{
+    auto mappedFile = g_mapped_file_new(filePath.c_str(), FALSE, nullptr);
+    if (mappedFile == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    // The snapshots keep the file mapped as long as one of them is alive.
+    auto storage = std::shared_ptr<const void>(mappedFile, [](const void *file) {
+        g_mapped_file_unref(static_cast<GMappedFile *>(const_cast<void *>(file)));
+    });
+    auto bytes = std::span(
+            reinterpret_cast<const uint8_t *>(g_mapped_file_get_contents(mappedFile)),
+            g_mapped_file_get_length(mappedFile));
+
+    auto reader = OptionSnapshot::Reader(bytes, 0);
+    auto magic = reader.Skip(k_FileMagic.size());
+    if (magic == nullptr || std::string_view(reinterpret_cast<const char *>(magic), k_FileMagic.size()) != k_FileMagic)
+    {
+        return std::nullopt;
+    }
+
+    std::map<std::string, OptionSnapshot> snapshots;
+    auto count = reader.ReadUint32();
+    for (auto i = 0U; i < count; ++i)
+    {
+        auto name = reader.ReadString();
+        auto size = reader.ReadUint32();
+        auto data = reader.Skip(size);
+        if (reader.Failed())
+        {
+            return std::nullopt;
+        }
+
+        auto snapshot = OptionSnapshot::FromBytes(std::span(data, size), storage);
+        if (!snapshot.has_value())
+        {
+            return std::nullopt;
+        }
+        snapshots.emplace(name, std::move(*snapshot));
+    }
+
+    return snapshots;
+}
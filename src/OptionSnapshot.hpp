@@ -0,0 +1,323 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Gorfector
+{
+    /**
+     * \class OptionSnapshot
+     * \brief A packed, read-only table of device option values, applied to a device without parsing JSON.
+     *
+     * A snapshot holds the same information as the scanner settings of a preset or scan list item: the device
+     * identification and the requested values of the options. It is compiled once from the JSON settings, and
+     * applying it walks the table, looking options up by name.
+     *
+     * The binary layout, in little endian order, is:
+     *
+     *     "GOS1"
+     *     string DeviceName, string DeviceVendor, string DeviceModel, string DeviceType
+     *     uint32 OptionCount
+     *     OptionCount times: string Name, uint8 ValueType, uint32 ValueCount, ValueCount values
+     *
+     * where strings are a uint32 length followed by the characters, and values are a uint8 for booleans, an int32 for
+     * integers and a string for strings. The bytes can be owned by the snapshot or by a memory mapped file.
+     */
+    class OptionSnapshot
+    {
+    public:
+        enum class ValueType : uint8_t
+        {
+            e_Bool = 0,
+            e_Int = 1,
+            e_String = 2,
+        };
+
+        /**
+         * \brief Reads little endian values from a byte range, checking that they are in the range.
+         */
+        class Reader
+        {
+            std::span<const uint8_t> m_Bytes{};
+            size_t m_Position{};
+            bool m_Failed{};
+
+        public:
+            Reader(std::span<const uint8_t> bytes, size_t position)
+                : m_Bytes(bytes)
+                , m_Position(position)
+            {
+            }
+
+            [[nodiscard]] bool Failed() const
+            {
+                return m_Failed;
+            }
+
+            [[nodiscard]] size_t GetPosition() const
+            {
+                return m_Position;
+            }
+
+            [[nodiscard]] std::span<const uint8_t> GetRange(size_t start) const
+            {
+                return m_Bytes.subspan(start, m_Position - start);
+            }
+
+            const uint8_t *Skip(size_t size)
+            {
+                if (m_Failed || m_Bytes.size() - m_Position < size)
+                {
+                    m_Failed = true;
+                    return nullptr;
+                }
+
+                auto data = m_Bytes.data() + m_Position;
+                m_Position += size;
+                return data;
+            }
+
+            uint8_t ReadUint8()
+            {
+                auto data = Skip(1);
+                return data == nullptr ? 0 : data[0];
+            }
+
+            uint32_t ReadUint32()
+            {
+                auto data = Skip(4);
+                if (data == nullptr)
+                {
+                    return 0;
+                }
+
+                return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+                       static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+            }
+
+            std::string_view ReadString()
+            {
+                auto size = ReadUint32();
+                auto data = Skip(size);
+                if (data == nullptr)
+                {
+                    return {};
+                }
+
+                return {reinterpret_cast<const char *>(data), size};
+            }
+        };
+
+        /**
+         * \brief The requested values of one option of a snapshot.
+         */
+        class Option
+        {
+            friend class OptionSnapshot;
+
+            std::string_view m_Name{};
+            ValueType m_Type{};
+            uint32_t m_ValueCount{};
+            std::span<const uint8_t> m_Values{};
+
+        public:
+            [[nodiscard]] std::string_view GetName() const
+            {
+                return m_Name;
+            }
+
+            [[nodiscard]] ValueType GetType() const
+            {
+                return m_Type;
+            }
+
+            [[nodiscard]] uint32_t GetValueCount() const
+            {
+                return m_ValueCount;
+            }
+
+            [[nodiscard]] bool GetBool(uint32_t valueIndex) const
+            {
+                return m_Values[valueIndex] != 0;
+            }
+
+            [[nodiscard]] int32_t GetInt(uint32_t valueIndex) const
+            {
+                return static_cast<int32_t>(Reader(m_Values, 4 * static_cast<size_t>(valueIndex)).ReadUint32());
+            }
+
+            [[nodiscard]] std::string_view GetString(uint32_t valueIndex) const
+            {
+                auto reader = Reader(m_Values, 0);
+                auto value = reader.ReadString();
+                for (auto i = 0U; i < valueIndex; ++i)
+                {
+                    value = reader.ReadString();
+                }
+                return value;
+            }
+        };
+
+    private:
+        static constexpr std::string_view k_Magic = "GOS1";
+
+        std::shared_ptr<const void> m_Storage{};
+        std::span<const uint8_t> m_Bytes{};
+
+        std::string_view m_DeviceName{};
+        std::string_view m_DeviceVendor{};
+        std::string_view m_DeviceModel{};
+        std::string_view m_DeviceType{};
+        uint32_t m_OptionCount{};
+        size_t m_FirstOptionPosition{};
+
+        static bool ReadOption(Reader &reader, Option &option);
+
+    public:
+        /**
+         * \brief Compiles scanner settings to a snapshot.
+         * \param settings The settings, as serialized by `to_json(nlohmann::json &, const DeviceOptionsState &)`, or
+         * an object mapping option names to arrays of values, like the scan area of a preset.
+         * \return The snapshot, or no value if the settings are not valid.
+         */
+        static std::optional<OptionSnapshot> FromJson(const nlohmann::json &settings);
+
+        /**
+         * \brief Creates a snapshot from its binary representation. The bytes are validated but not copied.
+         * \param bytes The binary representation of the snapshot.
+         * \param storage An object that owns the bytes; it is kept alive as long as the snapshot or its copies.
+         * \return The snapshot, or no value if the bytes are not a valid snapshot.
+         */
+        static std::optional<OptionSnapshot>
+        FromBytes(std::span<const uint8_t> bytes, std::shared_ptr<const void> storage);
+
+        /**
+         * \brief Converts the snapshot back to JSON settings, for example to edit it.
+         * \return The settings, in the format accepted by `FromJson()`.
+         */
+        [[nodiscard]] nlohmann::json ToJson() const;
+
+        [[nodiscard]] std::span<const uint8_t> GetBytes() const
+        {
+            return m_Bytes;
+        }
+
+        [[nodiscard]] bool HasDevice() const
+        {
+            return !m_DeviceVendor.empty() || !m_DeviceModel.empty();
+        }
+
+        [[nodiscard]] std::string_view GetDeviceVendor() const
+        {
+            return m_DeviceVendor;
+        }
+
+        [[nodiscard]] std::string_view GetDeviceModel() const
+        {
+            return m_DeviceModel;
+        }
+
+        [[nodiscard]] uint32_t GetOptionCount() const
+        {
+            return m_OptionCount;
+        }
+
+        /**
+         * \brief Calls a function for each option of the snapshot, in order.
+         * \param func The function to call, with a `const Option &`.
+         */
+        template<typename TFunc>
+        void ForEachOption(TFunc &&func) const
+        {
+            auto reader = Reader(m_Bytes, m_FirstOptionPosition);
+            Option option;
+            for (auto i = 0U; i < m_OptionCount; ++i)
+            {
+                // The bytes were validated on creation.
+                ReadOption(reader, option);
+                func(option);
+            }
+        }
+    };
+
+    /**
+     * \class OptionSnapshotCache
+     * \brief Compiles JSON settings to snapshots on first use and keeps them until they are invalidated.
+     *
+     * \tparam TKey The type of the key identifying the settings, for example a preset name.
+     */
+    template<typename TKey>
+    class OptionSnapshotCache
+    {
+        std::unordered_map<TKey, std::optional<OptionSnapshot>> m_Snapshots{};
+
+    public:
+        /**
+         * \brief Gets the snapshot of some settings, compiling it if it is not in the cache.
+         * \param key The key identifying the settings.
+         * \param settings The settings. Only used if the snapshot is not in the cache.
+         * \return The snapshot, or nullptr if there are no settings or they are not valid.
+         */
+        const OptionSnapshot *Get(const TKey &key, const nlohmann::json *settings)
+        {
+            if (settings == nullptr)
+            {
+                return nullptr;
+            }
+
+            auto it = m_Snapshots.find(key);
+            if (it == m_Snapshots.end())
+            {
+                it = m_Snapshots.emplace(key, OptionSnapshot::FromJson(*settings)).first;
+            }
+
+            return it->second.has_value() ? &*it->second : nullptr;
+        }
+
+        void Erase(const TKey &key)
+        {
+            m_Snapshots.erase(key);
+        }
+
+        void Clear()
+        {
+            m_Snapshots.clear();
+        }
+    };
+
+    /**
+     * \class OptionSnapshotFile
+     * \brief Stores named option snapshots in a binary file, which is memory mapped when read.
+     *
+     * The file starts with "GOSF" and a uint32 count, followed by, for each snapshot, its name as a string and its
+     * bytes as a string, using the conventions of `OptionSnapshot`. `DeviceOptionCache` keeps the option values of
+     * the devices between runs in such a file.
+     */
+    class OptionSnapshotFile
+    {
+    public:
+        /**
+         * \brief Writes snapshots to a file. The file is replaced atomically.
+         * \param filePath The path of the file.
+         * \param snapshots The snapshots, by name.
+         * \return True on success.
+         */
+        static bool
+        Write(const std::filesystem::path &filePath, const std::map<std::string, OptionSnapshot> &snapshots);
+
+        /**
+         * \brief Reads snapshots from a file. The file is memory mapped, and the snapshots refer to the mapped bytes.
+         * \param filePath The path of the file.
+         * \return The snapshots, by name, or no value if the file cannot be read or is not valid.
+         */
+        static std::optional<std::map<std::string, OptionSnapshot>> Read(const std::filesystem::path &filePath);
+    };
+}
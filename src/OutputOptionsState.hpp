@@ -25,6 +25,8 @@ namespace Gorfector
                 "CreateMissingDirectories"; ///< Key for directory creation flag.
         static constexpr const char *k_OutputFileNameKey = "OutputFileName"; ///< Key for output file name.
         static constexpr const char *k_FileExistsActionKey = "FileExistsAction"; ///< Key for file exists action.
+        static constexpr const char *k_UseDocumentFeederKey =
+                "UseDocumentFeeder"; ///< Key for document feeder flag.
 
         /**
          * \brief Enum representing the possible output destinations.
@@ -57,6 +59,7 @@ namespace Gorfector
         bool m_CreateMissingDirectories{true}; ///< Whether to create missing directories.
         std::string m_OutputFileName{}; ///< The name of the output file.
         FileExistsAction m_FileExistsAction{}; ///< The action to take if the file already exists.
+        bool m_UseDocumentFeeder{}; ///< Whether to scan pages until the document feeder is empty.
 
         friend void to_json(nlohmann::json &j, const OutputOptionsState &p);
         friend void from_json(const nlohmann::json &j, OutputOptionsState &p);
@@ -140,6 +143,17 @@ namespace Gorfector
             return m_FileExistsAction;
         }
 
+        /**
+         * \brief Checks if pages should be scanned until the document feeder is empty. Each page is saved in its own
+         * file, named by incrementing the counter of the file name.
+         *
+         * \return True if the document feeder should be emptied, false to scan a single page.
+         */
+        [[nodiscard]] bool GetUseDocumentFeeder() const
+        {
+            return m_UseDocumentFeeder;
+        }
+
         /**
          * \brief Updater class for modifying the state.
          */
@@ -225,6 +239,16 @@ namespace Gorfector
             {
                 m_StateComponent->m_FileExistsAction = action;
             }
+
+            /**
+             * \brief Sets whether to scan pages until the document feeder is empty.
+             *
+             * \param useDocumentFeeder True to empty the document feeder, false to scan a single page.
+             */
+            void SetUseDocumentFeeder(bool useDocumentFeeder)
+            {
+                m_StateComponent->m_UseDocumentFeeder = useDocumentFeeder;
+            }
         };
     };
 
@@ -245,7 +269,8 @@ namespace Gorfector
                 {OutputOptionsState::k_OutputDirectoryKey, outputDir},
                 {OutputOptionsState::k_CreateMissingDirectoriesKey, p.m_CreateMissingDirectories},
                 {OutputOptionsState::k_OutputFileNameKey, p.m_OutputFileName},
-                {OutputOptionsState::k_FileExistsActionKey, p.m_FileExistsAction}};
+                {OutputOptionsState::k_FileExistsActionKey, p.m_FileExistsAction},
+                {OutputOptionsState::k_UseDocumentFeederKey, p.m_UseDocumentFeeder}};
     }
 
     /**
@@ -264,5 +289,7 @@ namespace Gorfector
         j.at(OutputOptionsState::k_CreateMissingDirectoriesKey).get_to(p.m_CreateMissingDirectories);
         j.at(OutputOptionsState::k_OutputFileNameKey).get_to(p.m_OutputFileName);
         j.at(OutputOptionsState::k_FileExistsActionKey).get_to(p.m_FileExistsAction);
+        // Not in the settings saved by older versions.
+        p.m_UseDocumentFeeder = j.value(OutputOptionsState::k_UseDocumentFeederKey, false);
     }
 }
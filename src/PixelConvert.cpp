@@ -0,0 +1,330 @@
+#include "PixelConvert.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GORFECTOR_PIXEL_CONVERT_X86
+#elif defined(__aarch64__) || (defined(__ARM_NEON) && defined(__ARM_ARCH) && __ARM_ARCH >= 8)
+#include <arm_neon.h>
+#define GORFECTOR_PIXEL_CONVERT_NEON
+#endif
+
+// ReSharper disable once CppDFAUnreachableCode
+static constexpr size_t k_HighByteOffset = std::endian::native == std::endian::little ? 1 : 0;
+
+static void Depth16To8Scalar(const uint8_t *source, uint8_t *destination, size_t sampleCount)
+{
+    for (auto i = 0UZ; i < sampleCount; ++i)
+    {
+        destination[i] = source[2 * i + k_HighByteOffset];
+    }
+}
+
+static void Expand1BitTo8Scalar(const uint8_t *source, uint8_t *destination, size_t pixelCount)
+{
+    for (auto i = 0UZ; i < pixelCount; ++i)
+    {
+        destination[i] = source[i / 8] & (1 << (7 - (i % 8))) ? 0 : 255;
+    }
+}
+
+static void GrayToRgbScalar(const uint8_t *source, uint8_t *destination, size_t pixelCount)
+{
+    for (auto i = 0UZ; i < pixelCount; ++i)
+    {
+        destination[3 * i] = source[i];
+        destination[3 * i + 1] = source[i];
+        destination[3 * i + 2] = source[i];
+    }
+}
+
+static constexpr Gorfector::PixelConvert::Kernels k_ScalarKernels{
+        "Scalar",
+        Depth16To8Scalar,
+        Expand1BitTo8Scalar,
+        GrayToRgbScalar,
+};
+
+#ifdef GORFECTOR_PIXEL_CONVERT_X86
+
+__attribute__((target("sse2"))) static void
+Depth16To8Sse2(const uint8_t *source, uint8_t *destination, size_t sampleCount)
+{
+    auto i = 0UZ;
+    for (; i + 16 <= sampleCount; i += 16)
+    {
+        auto low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 2 * i));
+        auto high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 2 * i + 16));
+        auto packed = _mm_packus_epi16(_mm_srli_epi16(low, 8), _mm_srli_epi16(high, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), packed);
+    }
+
+    Depth16To8Scalar(source + 2 * i, destination + i, sampleCount - i);
+}
+
+__attribute__((target("sse2"))) static void
+Expand1BitTo8Sse2(const uint8_t *source, uint8_t *destination, size_t pixelCount)
+{
+    const auto bitMask = _mm_set1_epi64x(static_cast<int64_t>(0x0102040810204080ULL));
+    const auto zero = _mm_setzero_si128();
+
+    auto i = 0UZ;
+    for (; i + 16 <= pixelCount; i += 16)
+    {
+        // Repeat each of the two source bytes 8 times.
+        auto bytes = _mm_cvtsi32_si128(source[i / 8] | source[i / 8 + 1] << 8);
+        bytes = _mm_unpacklo_epi8(bytes, bytes);
+        bytes = _mm_unpacklo_epi16(bytes, bytes);
+        bytes = _mm_unpacklo_epi32(bytes, bytes);
+
+        auto white = _mm_cmpeq_epi8(_mm_and_si128(bytes, bitMask), zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), white);
+    }
+
+    Expand1BitTo8Scalar(source + i / 8, destination + i, pixelCount - i);
+}
+
+__attribute__((target("avx2"))) static void
+Depth16To8Avx2(const uint8_t *source, uint8_t *destination, size_t sampleCount)
+{
+    auto i = 0UZ;
+    for (; i + 32 <= sampleCount; i += 32)
+    {
+        auto low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + 2 * i));
+        auto high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + 2 * i + 32));
+        auto packed = _mm256_packus_epi16(_mm256_srli_epi16(low, 8), _mm256_srli_epi16(high, 8));
+        // The pack instruction works on each 128 bit lane: put the 64 bit quarters back in order.
+        packed = _mm256_permute4x64_epi64(packed, 0b11011000);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i), packed);
+    }
+
+    Depth16To8Sse2(source + 2 * i, destination + i, sampleCount - i);
+}
+
+__attribute__((target("avx2"))) static void
+Expand1BitTo8Avx2(const uint8_t *source, uint8_t *destination, size_t pixelCount)
+{
+    const auto bitMask = _mm256_set1_epi64x(static_cast<int64_t>(0x0102040810204080ULL));
+    const auto repeatBytes = _mm256_setr_epi8(
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const auto zero = _mm256_setzero_si256();
+
+    auto i = 0UZ;
+    for (; i + 32 <= pixelCount; i += 32)
+    {
+        int32_t fourBytes;
+        std::memcpy(&fourBytes, source + i / 8, sizeof(fourBytes));
+
+        // Repeat each of the four source bytes 8 times.
+        auto bytes = _mm256_shuffle_epi8(_mm256_set1_epi32(fourBytes), repeatBytes);
+        auto white = _mm256_cmpeq_epi8(_mm256_and_si256(bytes, bitMask), zero);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i), white);
+    }
+
+    Expand1BitTo8Sse2(source + i / 8, destination + i, pixelCount - i);
+}
+
+__attribute__((target("avx2"))) static void
+GrayToRgbAvx2(const uint8_t *source, uint8_t *destination, size_t pixelCount)
+{
+    const auto shuffle0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+    const auto shuffle1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+    const auto shuffle2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+
+    auto i = 0UZ;
+    for (; i + 16 <= pixelCount; i += 16)
+    {
+        auto gray = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+        auto *output = reinterpret_cast<__m128i *>(destination + 3 * i);
+        _mm_storeu_si128(output, _mm_shuffle_epi8(gray, shuffle0));
+        _mm_storeu_si128(output + 1, _mm_shuffle_epi8(gray, shuffle1));
+        _mm_storeu_si128(output + 2, _mm_shuffle_epi8(gray, shuffle2));
+    }
+
+    GrayToRgbScalar(source + i, destination + 3 * i, pixelCount - i);
+}
+
+static constexpr Gorfector::PixelConvert::Kernels k_Sse2Kernels{
+        "SSE2",
+        Depth16To8Sse2,
+        Expand1BitTo8Sse2,
+        // SSE2 has no byte shuffle instruction.
+        GrayToRgbScalar,
+};
+
+static constexpr Gorfector::PixelConvert::Kernels k_Avx2Kernels{
+        "AVX2",
+        Depth16To8Avx2,
+        Expand1BitTo8Avx2,
+        GrayToRgbAvx2,
+};
+
+#endif
+
+#ifdef GORFECTOR_PIXEL_CONVERT_NEON
+
+static void Depth16To8Neon(const uint8_t *source, uint8_t *destination, size_t sampleCount)
+{
+    auto i = 0UZ;
+    for (; i + 16 <= sampleCount; i += 16)
+    {
+        // Deinterleave the low and high bytes of the samples.
+        auto bytes = vld2q_u8(source + 2 * i);
+        vst1q_u8(destination + i, bytes.val[k_HighByteOffset]);
+    }
+
+    Depth16To8Scalar(source + 2 * i, destination + i, sampleCount - i);
+}
+
+static void Expand1BitTo8Neon(const uint8_t *source, uint8_t *destination, size_t pixelCount)
+{
+    static constexpr uint8_t k_BitMask[16] = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                              0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
+    const auto bitMask = vld1q_u8(k_BitMask);
+
+    auto i = 0UZ;
+    for (; i + 16 <= pixelCount; i += 16)
+    {
+        auto bytes = vcombine_u8(vdup_n_u8(source[i / 8]), vdup_n_u8(source[i / 8 + 1]));
+        auto black = vtstq_u8(bytes, bitMask);
+        vst1q_u8(destination + i, vmvnq_u8(black));
+    }
+
+    Expand1BitTo8Scalar(source + i / 8, destination + i, pixelCount - i);
+}
+
+static void GrayToRgbNeon(const uint8_t *source, uint8_t *destination, size_t pixelCount)
+{
+    auto i = 0UZ;
+    for (; i + 16 <= pixelCount; i += 16)
+    {
+        auto gray = vld1q_u8(source + i);
+        vst3q_u8(destination + 3 * i, (uint8x16x3_t{{gray, gray, gray}}));
+    }
+
+    GrayToRgbScalar(source + i, destination + 3 * i, pixelCount - i);
+}
+
+static constexpr Gorfector::PixelConvert::Kernels k_NeonKernels{
+        "NEON",
+        Depth16To8Neon,
+        Expand1BitTo8Neon,
+        GrayToRgbNeon,
+};
+
+#endif
+
+std::vector<const Gorfector::PixelConvert::Kernels *> Gorfector::PixelConvert::GetAvailableKernels()
+{
+    std::vector<const Kernels *> kernels{&k_ScalarKernels};
+
+#ifdef GORFECTOR_PIXEL_CONVERT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+    {
+        kernels.push_back(&k_Sse2Kernels);
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        kernels.push_back(&k_Avx2Kernels);
+    }
+#endif
+
+#ifdef GORFECTOR_PIXEL_CONVERT_NEON
+    kernels.push_back(&k_NeonKernels);
+#endif
+
+    return kernels;
+}
+
+const Gorfector::PixelConvert::Kernels &Gorfector::PixelConvert::GetKernels()
+{
+    static const Kernels *s_Kernels = GetAvailableKernels().back();
+    return *s_Kernels;
+}
+
+void Gorfector::PixelConvert::ConvertLineTo8Bit(
+        const uint8_t *source, uint8_t *destination, int pixelsPerLine, int depth, SANE_Frame format)
+{
+    auto samples = static_cast<size_t>(pixelsPerLine) * (format == SANE_FRAME_RGB ? 3 : 1);
+
+    if (depth == 1)
+    {
+        GetKernels().m_Expand1BitTo8(source, destination, pixelsPerLine);
+    }
+    else if (depth == 8)
+    {
+        std::memcpy(destination, source, samples);
+    }
+    else if (depth == 16)
+    {
+        GetKernels().m_Depth16To8(source, destination, samples);
+    }
+}
+
+void Gorfector::PixelConvert::ConvertLineToRgb8(
+        const uint8_t *source, uint8_t *destination, int pixelsPerLine, int depth, SANE_Frame format)
+{
+    if (format == SANE_FRAME_RGB)
+    {
+        ConvertLineTo8Bit(source, destination, pixelsPerLine, depth, format);
+        return;
+    }
+
+    const auto &kernels = GetKernels();
+    if (depth == 8)
+    {
+        kernels.m_GrayToRgb(source, destination, pixelsPerLine);
+        return;
+    }
+
+    // Convert to 8 bit gray in chunks small enough to fit on the stack, then to RGB. The chunk size is a multiple
+    // of 8, so each chunk of a 1 bit line starts on a byte boundary.
+    constexpr auto chunkSize = 1024UZ;
+    uint8_t gray[chunkSize];
+    const auto pixelCount = static_cast<size_t>(pixelsPerLine);
+    for (auto x = 0UZ; x < pixelCount; x += chunkSize)
+    {
+        auto count = std::min(chunkSize, pixelCount - x);
+        if (depth == 1)
+        {
+            kernels.m_Expand1BitTo8(source + x / 8, gray, count);
+        }
+        else if (depth == 16)
+        {
+            kernels.m_Depth16To8(source + 2 * x, gray, count);
+        }
+        else
+        {
+            return;
+        }
+
+        kernels.m_GrayToRgb(gray, destination + 3 * x, count);
+    }
+}
+
+void Gorfector::PixelConvert::DownsampleRgb8(
+        const uint8_t *line0, const uint8_t *line1, uint8_t *destination, int pixelsPerLine)
+{
+    const auto pairCount = static_cast<size_t>(pixelsPerLine) / 2;
+    for (auto x = 0UZ; x < pairCount; ++x)
+    {
+        for (auto c = 0UZ; c < 3; ++c)
+        {
+            auto sum = line0[6 * x + c] + line0[6 * x + 3 + c] + line1[6 * x + c] + line1[6 * x + 3 + c];
+            destination[3 * x + c] = static_cast<uint8_t>((sum + 2) / 4);
+        }
+    }
+
+    if (pixelsPerLine % 2 != 0)
+    {
+        for (auto c = 0UZ; c < 3; ++c)
+        {
+            auto sum = line0[6 * pairCount + c] + line1[6 * pairCount + c];
+            destination[3 * pairCount + c] = static_cast<uint8_t>((sum + 1) / 2);
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <sane/sane.h>
+
+namespace Gorfector
+{
+    /**
+     * \class PixelConvert
+     * \brief Converts SANE image lines to 8 bit samples, using the vector instructions available on the CPU.
+     *
+     * Each conversion is implemented by a set of kernels: a scalar one, and SSE2, AVX2 or NEON ones depending on
+     * the architecture. The best set supported by the CPU is selected the first time `GetKernels()` is called. All
+     * kernel sets produce the same output.
+     */
+    class PixelConvert
+    {
+    public:
+        /**
+         * \brief A set of conversion kernels.
+         */
+        struct Kernels
+        {
+            /**
+             * \brief Name of the instruction set used by the kernels.
+             */
+            const char *m_Name;
+
+            /**
+             * \brief Reduces 16 bit samples, in the native byte order, to 8 bit samples by keeping their most
+             * significant byte.
+             */
+            void (*m_Depth16To8)(const uint8_t *source, uint8_t *destination, size_t sampleCount);
+
+            /**
+             * \brief Expands 1 bit pixels, most significant bit first, to 8 bit gray pixels. A set bit is black (0),
+             * a cleared bit is white (255), as in SANE 1 bit frames.
+             */
+            void (*m_Expand1BitTo8)(const uint8_t *source, uint8_t *destination, size_t pixelCount);
+
+            /**
+             * \brief Converts 8 bit gray pixels to 8 bit RGB pixels.
+             */
+            void (*m_GrayToRgb)(const uint8_t *source, uint8_t *destination, size_t pixelCount);
+        };
+
+        /**
+         * \brief Gets the best kernel set supported by the CPU.
+         * \return The kernel set.
+         */
+        static const Kernels &GetKernels();
+
+        /**
+         * \brief Gets all the kernel sets supported by the CPU, the scalar one first.
+         * \return The kernel sets.
+         */
+        static std::vector<const Kernels *> GetAvailableKernels();
+
+        /**
+         * \brief Converts a SANE line to 8 bit samples, keeping the number of samples per pixel.
+         * \param source The line to convert.
+         * \param destination Receives `pixelsPerLine` samples per color component.
+         * \param pixelsPerLine Number of pixels in the line.
+         * \param depth Number of bits per sample: 1, 8 or 16.
+         * \param format The frame format: SANE_FRAME_GRAY or SANE_FRAME_RGB.
+         */
+        static void ConvertLineTo8Bit(
+                const uint8_t *source, uint8_t *destination, int pixelsPerLine, int depth, SANE_Frame format);
+
+        /**
+         * \brief Converts a SANE line to 8 bit RGB pixels.
+         * \param source The line to convert.
+         * \param destination Receives `3 * pixelsPerLine` samples.
+         * \param pixelsPerLine Number of pixels in the line.
+         * \param depth Number of bits per sample: 1, 8 or 16.
+         * \param format The frame format: SANE_FRAME_GRAY or SANE_FRAME_RGB.
+         */
+        static void ConvertLineToRgb8(
+                const uint8_t *source, uint8_t *destination, int pixelsPerLine, int depth, SANE_Frame format);
+
+        /**
+         * \brief Halves the size of two lines of 8 bit RGB pixels by averaging each 2x2 block of pixels.
+         * \param line0 The first source line.
+         * \param line1 The second source line. It can be `line0` for the last line of an image with an odd height.
+         * \param destination Receives `3 * ((pixelsPerLine + 1) / 2)` samples. If `pixelsPerLine` is odd, the last
+         * pixel is the average of the last source column.
+         * \param pixelsPerLine Number of pixels in the source lines.
+         */
+        static void DownsampleRgb8(const uint8_t *line0, const uint8_t *line1, uint8_t *destination, int pixelsPerLine);
+    };
+}
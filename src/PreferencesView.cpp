@@ -28,6 +28,28 @@ void Gorfector::PreferencesView::BuildFileSettingsBox(GtkWidget *parent)
     adw_preferences_group_add(ADW_PREFERENCES_GROUP(prefGroup), m_TiffJpegQuality);
     ZooLib::ConnectGtkSignalWithParamSpecs(this, &PreferencesView::OnValueChanged, m_TiffJpegQuality, "notify::value");
 
+    m_TiffStripHeight = adw_spin_row_new_with_range(1, 4096, 16);
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_TiffStripHeight), _("Strip Height"));
+    adw_action_row_set_subtitle(ADW_ACTION_ROW(m_TiffStripHeight), _("Number of image lines in each TIFF strip."));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(prefGroup), m_TiffStripHeight);
+    ZooLib::ConnectGtkSignalWithParamSpecs(this, &PreferencesView::OnValueChanged, m_TiffStripHeight, "notify::value");
+
+    m_TiffWorkerCount = adw_spin_row_new_with_range(1, 64, 1);
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_TiffWorkerCount), _("Compression Threads"));
+    adw_action_row_set_subtitle(
+            ADW_ACTION_ROW(m_TiffWorkerCount), _("Deflate and Packbits strips are compressed in parallel."));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(prefGroup), m_TiffWorkerCount);
+    ZooLib::ConnectGtkSignalWithParamSpecs(this, &PreferencesView::OnValueChanged, m_TiffWorkerCount, "notify::value");
+
+    m_TiffTiledPyramid = adw_switch_row_new();
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_TiffTiledPyramid), _("Tiled Pyramid"));
+    adw_action_row_set_subtitle(
+            ADW_ACTION_ROW(m_TiffTiledPyramid),
+            _("Write tiles and reduced-resolution versions of the image, for fast display of large scans."));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(prefGroup), m_TiffTiledPyramid);
+    ZooLib::ConnectGtkSignalWithParamSpecs(
+            this, &PreferencesView::OnTiledPyramidChanged, m_TiffTiledPyramid, "notify::active");
+
     prefGroup = adw_preferences_group_new();
     adw_preferences_group_set_title(ADW_PREFERENCES_GROUP(prefGroup), _("PNG Settings"));
     adw_preferences_page_add(ADW_PREFERENCES_PAGE(parent), ADW_PREFERENCES_GROUP(prefGroup));
@@ -40,6 +62,13 @@ void Gorfector::PreferencesView::BuildFileSettingsBox(GtkWidget *parent)
     ZooLib::ConnectGtkSignalWithParamSpecs(
             this, &PreferencesView::OnValueChanged, m_PngCompressionLevel, "notify::value");
 
+    m_PngWorkerCount = adw_spin_row_new_with_range(1, 64, 1);
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_PngWorkerCount), _("Compression Threads"));
+    adw_action_row_set_subtitle(
+            ADW_ACTION_ROW(m_PngWorkerCount), _("Blocks of image data are filtered and compressed in parallel."));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(prefGroup), m_PngWorkerCount);
+    ZooLib::ConnectGtkSignalWithParamSpecs(this, &PreferencesView::OnValueChanged, m_PngWorkerCount, "notify::value");
+
     prefGroup = adw_preferences_group_new();
     adw_preferences_group_set_title(ADW_PREFERENCES_GROUP(prefGroup), _("JPEG Settings"));
     adw_preferences_page_add(ADW_PREFERENCES_PAGE(parent), ADW_PREFERENCES_GROUP(prefGroup));
@@ -50,9 +79,21 @@ void Gorfector::PreferencesView::BuildFileSettingsBox(GtkWidget *parent)
     adw_preferences_group_add(ADW_PREFERENCES_GROUP(prefGroup), m_JpegQuality);
     ZooLib::ConnectGtkSignalWithParamSpecs(this, &PreferencesView::OnValueChanged, m_JpegQuality, "notify::value");
 
+    m_JpegWorkerCount = adw_spin_row_new_with_range(1, 64, 1);
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_JpegWorkerCount), _("Compression Threads"));
+    adw_action_row_set_subtitle(
+            ADW_ACTION_ROW(m_JpegWorkerCount), _("Bands of the image are compressed in parallel."));
+    adw_preferences_group_add(ADW_PREFERENCES_GROUP(prefGroup), m_JpegWorkerCount);
+    ZooLib::ConnectGtkSignalWithParamSpecs(this, &PreferencesView::OnValueChanged, m_JpegWorkerCount, "notify::value");
+
     m_Dispatcher.RegisterHandler(SetTiffCompression::Execute, m_TiffWriterStateComponent);
     m_Dispatcher.RegisterHandler(SetTiffDeflateLevel::Execute, m_TiffWriterStateComponent);
     m_Dispatcher.RegisterHandler(SetTiffJpegQuality::Execute, m_TiffWriterStateComponent);
+    m_Dispatcher.RegisterHandler(SetTiffStripHeight::Execute, m_TiffWriterStateComponent);
+    m_Dispatcher.RegisterHandler(SetTiffWorkerCount::Execute, m_TiffWriterStateComponent);
+    m_Dispatcher.RegisterHandler(SetTiffTiledPyramid::Execute, m_TiffWriterStateComponent);
     m_Dispatcher.RegisterHandler(SetPngCompressionLevel::Execute, m_PngWriterStateComponent);
+    m_Dispatcher.RegisterHandler(SetPngWorkerCount::Execute, m_PngWriterStateComponent);
     m_Dispatcher.RegisterHandler(SetJpegQuality::Execute, m_JpegWriterStateComponent);
+    m_Dispatcher.RegisterHandler(SetJpegWorkerCount::Execute, m_JpegWriterStateComponent);
 }
@@ -6,10 +6,15 @@
 #include "App.hpp"
 #include "Commands/DevMode/SetDumpSaneOptions.hpp"
 #include "Commands/SetJpegQuality.hpp"
+#include "Commands/SetJpegWorkerCount.hpp"
 #include "Commands/SetPngCompressionLevel.hpp"
+#include "Commands/SetPngWorkerCount.hpp"
 #include "Commands/SetTiffCompression.hpp"
 #include "Commands/SetTiffDeflateLevel.hpp"
 #include "Commands/SetTiffJpegQuality.hpp"
+#include "Commands/SetTiffStripHeight.hpp"
+#include "Commands/SetTiffTiledPyramid.hpp"
+#include "Commands/SetTiffWorkerCount.hpp"
 #include "ViewUpdateObserver.hpp"
 #include "ZooLib/CommandDispatcher.hpp"
 #include "ZooLib/Gettext.hpp"
@@ -84,16 +89,41 @@ namespace Gorfector
          */
         GtkWidget *m_TiffJpegQuality{};
 
+        /**
+         * \brief UI element for setting the number of lines per TIFF strip.
+         */
+        GtkWidget *m_TiffStripHeight{};
+
+        /**
+         * \brief UI element for setting the number of threads compressing TIFF strips.
+         */
+        GtkWidget *m_TiffWorkerCount{};
+
+        /**
+         * \brief UI element for enabling tiled TIFF output with reduced-resolution levels.
+         */
+        GtkWidget *m_TiffTiledPyramid{};
+
         /**
          * \brief UI element for setting PNG compression level.
          */
         GtkWidget *m_PngCompressionLevel{};
 
+        /**
+         * \brief UI element for setting the number of threads compressing PNG image data.
+         */
+        GtkWidget *m_PngWorkerCount{};
+
         /**
          * \brief UI element for setting JPEG quality.
          */
         GtkWidget *m_JpegQuality{};
 
+        /**
+         * \brief UI element for setting the number of threads compressing JPEG images.
+         */
+        GtkWidget *m_JpegWorkerCount{};
+
         /**
          * \brief UI element for enabling dumping of SANE options to stdout.
          */
@@ -167,6 +197,16 @@ namespace Gorfector
             m_Dispatcher.Dispatch(SetTiffCompression(selectedIndex));
         }
 
+        /**
+         * \brief Handles the activation of tiled TIFF output.
+         *
+         * \param widget The widget triggering the event.
+         */
+        void OnTiledPyramidChanged(GtkWidget *widget)
+        {
+            m_Dispatcher.Dispatch(SetTiffTiledPyramid(adw_switch_row_get_active(ADW_SWITCH_ROW(widget))));
+        }
+
         /**
          * \brief Handles changes to spin row values in the preferences UI.
          *
@@ -184,14 +224,30 @@ namespace Gorfector
             {
                 m_Dispatcher.Dispatch(SetTiffJpegQuality(value));
             }
+            else if (widget == m_TiffStripHeight)
+            {
+                m_Dispatcher.Dispatch(SetTiffStripHeight(value));
+            }
+            else if (widget == m_TiffWorkerCount)
+            {
+                m_Dispatcher.Dispatch(SetTiffWorkerCount(value));
+            }
             else if (widget == m_PngCompressionLevel)
             {
                 m_Dispatcher.Dispatch(SetPngCompressionLevel(value));
             }
+            else if (widget == m_PngWorkerCount)
+            {
+                m_Dispatcher.Dispatch(SetPngWorkerCount(value));
+            }
             else if (widget == m_JpegQuality)
             {
                 m_Dispatcher.Dispatch(SetJpegQuality(value));
             }
+            else if (widget == m_JpegWorkerCount)
+            {
+                m_Dispatcher.Dispatch(SetJpegWorkerCount(value));
+            }
         }
 
         /**
@@ -263,8 +319,13 @@ namespace Gorfector
             m_Dispatcher.UnregisterHandler<SetTiffCompression>();
             m_Dispatcher.UnregisterHandler<SetTiffDeflateLevel>();
             m_Dispatcher.UnregisterHandler<SetTiffJpegQuality>();
+            m_Dispatcher.UnregisterHandler<SetTiffStripHeight>();
+            m_Dispatcher.UnregisterHandler<SetTiffWorkerCount>();
+            m_Dispatcher.UnregisterHandler<SetTiffTiledPyramid>();
             m_Dispatcher.UnregisterHandler<SetPngCompressionLevel>();
+            m_Dispatcher.UnregisterHandler<SetPngWorkerCount>();
             m_Dispatcher.UnregisterHandler<SetJpegQuality>();
+            m_Dispatcher.UnregisterHandler<SetJpegWorkerCount>();
             m_Dispatcher.UnregisterHandler<SetDumpSaneOptions>();
 
             m_App->GetObserverManager()->RemoveObserver(m_ViewUpdateObserver);
@@ -320,9 +381,14 @@ namespace Gorfector
                     ADW_SPIN_ROW(m_TiffDeflateCompressionLevel),
                     m_TiffWriterStateComponent->GetDeflateCompressionLevel());
             adw_spin_row_set_value(ADW_SPIN_ROW(m_TiffJpegQuality), m_TiffWriterStateComponent->GetJpegQuality());
+            adw_spin_row_set_value(ADW_SPIN_ROW(m_TiffStripHeight), m_TiffWriterStateComponent->GetStripHeight());
+            adw_spin_row_set_value(ADW_SPIN_ROW(m_TiffWorkerCount), m_TiffWriterStateComponent->GetWorkerCount());
+            adw_switch_row_set_active(ADW_SWITCH_ROW(m_TiffTiledPyramid), m_TiffWriterStateComponent->IsTiledPyramid());
             adw_spin_row_set_value(
                     ADW_SPIN_ROW(m_PngCompressionLevel), m_PngWriterStateComponent->GetCompressionLevel());
+            adw_spin_row_set_value(ADW_SPIN_ROW(m_PngWorkerCount), m_PngWriterStateComponent->GetWorkerCount());
             adw_spin_row_set_value(ADW_SPIN_ROW(m_JpegQuality), m_JpegWriterStateComponent->GetQuality());
+            adw_spin_row_set_value(ADW_SPIN_ROW(m_JpegWorkerCount), m_JpegWriterStateComponent->GetWorkerCount());
 
             if (m_DumpSaneOptions != nullptr)
             {
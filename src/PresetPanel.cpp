@@ -74,7 +74,9 @@ void Gorfector::PresetPanel::OnApplyPresetButtonPressed(GtkButton *button)
     auto rowId = gtk_list_box_row_get_index(GTK_LIST_BOX_ROW(listBoxRow));
     auto presetName = m_DisplayedPresetNames[rowId];
     auto preset = m_PresetPanelState->GetPreset(presetName);
-    m_Dispatcher.Dispatch(ApplyPresetCommand(preset));
+    auto scannerSettings = m_PresetPanelState->GetScannerSettingsSnapshot(presetName);
+    auto scanArea = m_PresetPanelState->GetScanAreaSnapshot(presetName);
+    m_Dispatcher.Dispatch(ApplyPresetCommand(preset, scannerSettings, scanArea));
 }
 
 void Gorfector::PresetPanel::OnDeletePresetButtonPressed(GtkButton *button)
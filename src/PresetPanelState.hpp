@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DeviceOptionsState.hpp"
+#include "OptionSnapshot.hpp"
 #include "ZooLib/StateComponent.hpp"
 
 namespace Gorfector
@@ -21,6 +22,10 @@ namespace Gorfector
         std::string m_CurrentDeviceVendor{};
         bool m_ScanActivity{};
 
+        // Compiled device settings of the presets, by preset name, so that applying a preset does not parse JSON.
+        mutable OptionSnapshotCache<std::string> m_ScannerSettingsSnapshots{};
+        mutable OptionSnapshotCache<std::string> m_ScanAreaSnapshots{};
+
         friend void to_json(nlohmann::json &j, const PresetPanelState &state);
         friend void from_json(const nlohmann::json &j, PresetPanelState &state);
 
@@ -111,8 +116,46 @@ namespace Gorfector
             return nullptr;
         }
 
+        /**
+         * \brief Gets the scanner settings of a preset, compiled to a snapshot.
+         * \param presetId The name of the preset.
+         * \return The snapshot, or nullptr if the preset does not exist or has no scanner settings.
+         */
+        [[nodiscard]] const OptionSnapshot *GetScannerSettingsSnapshot(const std::string &presetId) const
+        {
+            auto preset = GetPreset(presetId);
+            if (preset == nullptr || !preset->contains(k_ScannerSettingsKey))
+            {
+                return nullptr;
+            }
+
+            return m_ScannerSettingsSnapshots.Get(presetId, &preset->at(k_ScannerSettingsKey));
+        }
+
+        /**
+         * \brief Gets the scan area of a preset, compiled to a snapshot.
+         * \param presetId The name of the preset.
+         * \return The snapshot, or nullptr if the preset does not exist or has no scan area.
+         */
+        [[nodiscard]] const OptionSnapshot *GetScanAreaSnapshot(const std::string &presetId) const
+        {
+            auto preset = GetPreset(presetId);
+            if (preset == nullptr || !preset->contains(k_ScanAreaKey))
+            {
+                return nullptr;
+            }
+
+            return m_ScanAreaSnapshots.Get(presetId, &preset->at(k_ScanAreaKey));
+        }
+
         class Updater final : public StateComponent::Updater<PresetPanelState>
         {
+            void InvalidateSnapshots(const std::string &presetId)
+            {
+                m_StateComponent->m_ScannerSettingsSnapshots.Erase(presetId);
+                m_StateComponent->m_ScanAreaSnapshots.Erase(presetId);
+            }
+
         public:
             explicit Updater(PresetPanelState *state)
                 : StateComponent::Updater<PresetPanelState>(state)
@@ -133,6 +176,8 @@ namespace Gorfector
             void LoadFromJson(const nlohmann::json &json) override
             {
                 from_json(json, *m_StateComponent);
+                m_StateComponent->m_ScannerSettingsSnapshots.Clear();
+                m_StateComponent->m_ScanAreaSnapshots.Clear();
             }
 
             void SetExpanded(bool expanded)
@@ -148,6 +193,10 @@ namespace Gorfector
             void AddPreset(const nlohmann::json &preset)
             {
                 m_StateComponent->m_Presets.push_back(preset);
+                if (preset.contains(k_PresetNameKey))
+                {
+                    InvalidateSnapshots(preset[k_PresetNameKey].get<std::string>());
+                }
             }
 
             void RemovePreset(const std::string &uniqueId)
@@ -160,6 +209,7 @@ namespace Gorfector
                                 })
                                 .begin(),
                         m_StateComponent->m_Presets.end());
+                InvalidateSnapshots(uniqueId);
             }
 
             void RenamePreset(const std::string &presetId, const std::string &newName)
@@ -171,6 +221,8 @@ namespace Gorfector
                 {
                     (*it)[k_PresetNameKey] = newName;
                 }
+                InvalidateSnapshots(presetId);
+                InvalidateSnapshots(newName);
             }
 
             void UpdatePreset(const std::string &presetId, const nlohmann::json &newValues)
@@ -206,6 +258,7 @@ namespace Gorfector
                         preset.erase(k_OutputSettingsKey);
                     }
                 }
+                InvalidateSnapshots(presetId);
             }
         };
     };
@@ -0,0 +1,77 @@
+#include "PreviewCanvas.hpp"
+
+G_DECLARE_FINAL_TYPE(GorfectorPreviewCanvas, gorfector_preview_canvas, GORFECTOR, PREVIEW_CANVAS, GtkWidget)
+
+struct _GorfectorPreviewCanvas
+{
+    GtkWidget m_Parent;
+
+    Gorfector::PreviewCanvas::SnapshotFunc *m_SnapshotFunc;
+    int m_Width;
+    int m_Height;
+};
+
+G_DEFINE_FINAL_TYPE(GorfectorPreviewCanvas, gorfector_preview_canvas, GTK_TYPE_WIDGET)
+
+static guint s_ResizeSignal;
+
+static void PreviewCanvasFinalize(GObject *object)
+{
+    auto canvas = GORFECTOR_PREVIEW_CANVAS(object);
+    delete canvas->m_SnapshotFunc;
+    canvas->m_SnapshotFunc = nullptr;
+
+    G_OBJECT_CLASS(gorfector_preview_canvas_parent_class)->finalize(object);
+}
+
+static void PreviewCanvasSizeAllocate(GtkWidget *widget, int width, int height, int baseline)
+{
+    GTK_WIDGET_CLASS(gorfector_preview_canvas_parent_class)->size_allocate(widget, width, height, baseline);
+
+    auto canvas = GORFECTOR_PREVIEW_CANVAS(widget);
+    if (width != canvas->m_Width || height != canvas->m_Height)
+    {
+        canvas->m_Width = width;
+        canvas->m_Height = height;
+        g_signal_emit(widget, s_ResizeSignal, 0, width, height);
+    }
+}
+
+static void PreviewCanvasSnapshot(GtkWidget *widget, GtkSnapshot *snapshot)
+{
+    auto canvas = GORFECTOR_PREVIEW_CANVAS(widget);
+    auto width = gtk_widget_get_width(widget);
+    auto height = gtk_widget_get_height(widget);
+    if (canvas->m_SnapshotFunc != nullptr && width > 0 && height > 0)
+    {
+        (*canvas->m_SnapshotFunc)(snapshot, width, height);
+    }
+}
+
+static void gorfector_preview_canvas_class_init(GorfectorPreviewCanvasClass *klass)
+{
+    G_OBJECT_CLASS(klass)->finalize = PreviewCanvasFinalize;
+
+    auto widgetClass = GTK_WIDGET_CLASS(klass);
+    widgetClass->size_allocate = PreviewCanvasSizeAllocate;
+    widgetClass->snapshot = PreviewCanvasSnapshot;
+    gtk_widget_class_set_css_name(widgetClass, "previewcanvas");
+
+    s_ResizeSignal = g_signal_new(
+            "resize", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST, 0, nullptr, nullptr, nullptr, G_TYPE_NONE, 2,
+            G_TYPE_INT, G_TYPE_INT);
+}
+
+static void gorfector_preview_canvas_init(GorfectorPreviewCanvas *canvas)
+{
+    canvas->m_SnapshotFunc = nullptr;
+    canvas->m_Width = 0;
+    canvas->m_Height = 0;
+}
+
+GtkWidget *Gorfector::PreviewCanvas::Create(SnapshotFunc snapshotFunc)
+{
+    auto canvas = GORFECTOR_PREVIEW_CANVAS(g_object_new(gorfector_preview_canvas_get_type(), nullptr));
+    canvas->m_SnapshotFunc = new SnapshotFunc(std::move(snapshotFunc));
+    return GTK_WIDGET(canvas);
+}
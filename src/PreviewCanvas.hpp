@@ -0,0 +1,31 @@
+#pragma once
+
+#include <functional>
+#include <gtk/gtk.h>
+
+namespace Gorfector
+{
+    /**
+     * \class PreviewCanvas
+     * \brief Creates widgets that draw themselves by appending render nodes to a `GtkSnapshot`.
+     *
+     * Unlike a `GtkDrawingArea`, whose content is painted with cairo on every redraw, a canvas lets its owner append
+     * textures and transforms that GTK renders directly. Like a `GtkDrawingArea`, the canvas emits a `resize` signal,
+     * with the new width and height, when its size changes.
+     */
+    class PreviewCanvas
+    {
+    public:
+        /**
+         * \brief Function called to draw the canvas, with the snapshot to append to, and the canvas width and height.
+         */
+        using SnapshotFunc = std::function<void(GtkSnapshot *snapshot, int width, int height)>;
+
+        /**
+         * \brief Creates a new canvas widget.
+         * \param snapshotFunc The function called to draw the canvas.
+         * \return The new widget.
+         */
+        static GtkWidget *Create(SnapshotFunc snapshotFunc);
+    };
+}
@@ -3,10 +3,16 @@
 #include "Commands/SetPanCommand.hpp"
 #include "Commands/SetScanAreaCommand.hpp"
 #include "Commands/SetZoomCommand.hpp"
+#include "PixelConvert.hpp"
+#include "PreviewCanvas.hpp"
 #include "SetMouseBehaviorCommand.hpp"
 #include "ZooLib/Gettext.hpp"
+#include "ZooLib/Profiler.hpp"
 #include "ZooLib/SignalSupport.hpp"
 
+// Redraw() only queues a redraw; the preview is drawn when GTK takes a snapshot of it.
+static const ZooLib::Profiler::Metric s_RedrawTime{"preview.redraw.time", ZooLib::Profiler::Unit::e_Nanoseconds};
+
 enum class ScanAreaCursorRegions
 {
     Outside,
@@ -32,8 +38,8 @@ Gorfector::PreviewPanel::PreviewPanel(ZooLib::CommandDispatcher *parentDispatche
     auto box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
     gtk_grid_attach(GTK_GRID(m_RootWidget), box, 0, 0, 1, 1);
 
-    m_PreviewPixBuf = nullptr;
-    m_PreviewImage = gtk_drawing_area_new();
+    m_PreviewImage = PreviewCanvas::Create(
+            [this](GtkSnapshot *snapshot, int width, int height) { OnPreviewSnapshot(snapshot, width, height); });
     gtk_widget_add_css_class(GTK_WIDGET(m_PreviewImage), "preview-panel");
     gtk_widget_set_hexpand(m_PreviewImage, true);
     gtk_widget_set_vexpand(m_PreviewImage, true);
@@ -84,14 +90,6 @@ Gorfector::PreviewPanel::PreviewPanel(ZooLib::CommandDispatcher *parentDispatche
     gtk_widget_add_controller(m_PreviewImage, GTK_EVENT_CONTROLLER(mouseHandler));
     auto scrollHandler = gtk_event_controller_scroll_new(GTK_EVENT_CONTROLLER_SCROLL_BOTH_AXES);
     gtk_widget_add_controller(m_PreviewImage, GTK_EVENT_CONTROLLER(scrollHandler));
-    gtk_drawing_area_set_draw_func(
-            GTK_DRAWING_AREA(m_PreviewImage),
-            [](GtkDrawingArea *widget, cairo_t *cr, int width, int height, gpointer data) {
-                auto previewPanel = static_cast<PreviewPanel *>(data);
-                previewPanel->OnPreviewDraw(cr);
-            },
-            this, nullptr);
-
     ConnectGtkSignal(this, &PreviewPanel::OnResized, m_PreviewImage, "resize");
     ConnectGtkSignal(this, &PreviewPanel::OnZoomDropDownChanged, m_ZoomDropDown, "notify::selected");
     ConnectGtkSignal(this, &PreviewPanel::OnPreviewDragBegin, dragHandler, "drag-begin");
@@ -120,6 +118,12 @@ Gorfector::PreviewPanel::~PreviewPanel()
     delete m_ViewUpdateObserver;
     delete m_PreviewState;
 
+    if (m_EmptyPatternTexture != nullptr)
+    {
+        g_object_unref(m_EmptyPatternTexture);
+        m_EmptyPatternTexture = nullptr;
+    }
+
     m_ViewUpdateObserver = nullptr;
     m_PreviewState = nullptr;
 }
@@ -132,20 +136,6 @@ void Gorfector::PreviewPanel::OnResized(GtkWidget *widget, void *data, void *)
     auto width = gtk_widget_get_size(widget, GTK_ORIENTATION_HORIZONTAL);
     auto height = gtk_widget_get_size(widget, GTK_ORIENTATION_VERTICAL);
 
-    auto currentWidth = m_PreviewPixBuf != nullptr ? gdk_pixbuf_get_width(m_PreviewPixBuf) : 0;
-    auto currentHeight = m_PreviewPixBuf != nullptr ? gdk_pixbuf_get_height(m_PreviewPixBuf) : 0;
-
-    if (width == currentWidth && height == currentHeight)
-    {
-        return;
-    }
-
-    if (m_PreviewPixBuf != nullptr)
-    {
-        g_object_unref(m_PreviewPixBuf);
-        m_PreviewPixBuf = nullptr;
-    }
-
     Redraw();
 
     auto updater = PreviewState::Updater(m_PreviewState);
@@ -711,40 +701,63 @@ void Gorfector::PreviewPanel::OnMouseScroll(GtkEventControllerScroll *scrollCont
     }
 }
 
-void Gorfector::PreviewPanel::OnPreviewDraw(cairo_t *cr) const
+void Gorfector::PreviewPanel::OnPreviewSnapshot(GtkSnapshot *snapshot, int width, int height)
 {
-    gdk_cairo_set_source_pixbuf(cr, m_PreviewPixBuf, 0, 0);
-    cairo_paint(cr);
+    ZooLib::Profiler::ScopedTimer timer(s_RedrawTime);
 
-    if (m_App == nullptr || m_App->GetDeviceOptions() == nullptr)
+    graphene_rect_t bounds;
+    graphene_rect_init(&bounds, 0, 0, static_cast<float>(width), static_cast<float>(height));
+    gtk_snapshot_push_clip(snapshot, &bounds);
+
+    // The scan area outline is blended with the image below it, so it is visible on any background.
+    gtk_snapshot_push_blend(snapshot, GSK_BLEND_MODE_EXCLUSION);
+
+    AppendEmptyPattern(snapshot, bounds);
+    if (m_ScannedImage != nullptr)
     {
-        return;
+        m_TextureCache.Snapshot(snapshot, m_ZoomFactor, m_PreviewState->GetPreviewPanOffset(), bounds);
     }
+    gtk_snapshot_pop(snapshot);
 
-    Rect<double> scanArea = m_App->GetDeviceOptions()->GetScanArea();
     Rect<double> pixelArea;
-    if (!ScanAreaToPixels(scanArea, pixelArea))
+    if (m_App != nullptr && m_App->GetDeviceOptions() != nullptr &&
+        ScanAreaToPixels(m_App->GetDeviceOptions()->GetScanArea(), pixelArea))
     {
-        return;
+        auto cr = gtk_snapshot_append_cairo(snapshot, &bounds);
+        cairo_set_source_rgba(cr, 1.0, 1.0, 1.0, 1.0);
+        cairo_set_line_width(cr, .50);
+        cairo_rectangle(cr, pixelArea.x, pixelArea.y, pixelArea.width, pixelArea.height);
+        cairo_stroke(cr);
+        cairo_destroy(cr);
     }
+    gtk_snapshot_pop(snapshot);
 
-    cairo_set_operator(cr, CAIRO_OPERATOR_EXCLUSION);
-    cairo_set_source_rgba(cr, 1.0, 1.0, 1.0, 1.0);
-    cairo_set_line_width(cr, .50);
-    cairo_rectangle(cr, pixelArea.x, pixelArea.y, pixelArea.width, pixelArea.height);
-    cairo_stroke(cr);
+    gtk_snapshot_pop(snapshot);
 }
 
 void Gorfector::PreviewPanel::Update(const std::vector<uint64_t> &lastSeenVersions)
 {
-    auto changeset = m_PreviewState->GetAggregatedChangeset(lastSeenVersions[0]);
-    if (changeset == nullptr || !changeset->HasAnyChange())
+    m_PreviewState->AggregateChangesets(lastSeenVersions[0], m_PreviewStateChangeset);
+    const auto *changeset = &m_PreviewStateChangeset;
+    if (!changeset->HasAnyChange())
     {
         return;
     }
 
     if (changeset->IsChanged(PreviewStateChangeset::TypeFlag::Image))
     {
+        // Textures are only rebuilt for the lines received since the last update, unless this is a new image.
+        const auto lastLine = changeset->GetLastLine();
+        if (changeset->IsChanged(PreviewStateChangeset::TypeFlag::NewImage) || lastLine < m_LastLineReceived)
+        {
+            m_TextureCache.InvalidateAll();
+        }
+        else
+        {
+            m_TextureCache.InvalidateLines(m_LastLineReceived + 1, lastLine);
+        }
+        m_LastLineReceived = lastLine;
+
         if (const auto image = m_PreviewState->GetScannedImage(); image != nullptr)
         {
             const auto width = m_PreviewState->GetScannedPixelsPerLine();
@@ -771,6 +784,7 @@ void Gorfector::PreviewPanel::Update(const std::vector<uint64_t> &lastSeenVersio
                     m_ScannedImage = gdk_pixbuf_new_from_data(
                             m_UnderlyingBuffer, GDK_COLORSPACE_RGB, false, 8, width, height, bytesPerLine, nullptr,
                             nullptr);
+                    m_TextureCache.SetImage(m_UnderlyingBuffer, width, height, bytesPerLine);
                 }
 
                 delete[] m_ConvertedImage;
@@ -821,77 +835,16 @@ void Gorfector::PreviewPanel::Update(const std::vector<uint64_t> &lastSeenVersio
                     m_ScannedImage = gdk_pixbuf_new_from_data(
                             m_UnderlyingBuffer, GDK_COLORSPACE_RGB, false, 8, width, height, 3 * width, nullptr,
                             nullptr);
+                    m_TextureCache.SetImage(m_UnderlyingBuffer, width, height, 3 * width);
                 }
 
-                if (m_PreviewState->GetScannedImageBitDepth() == 1)
-                {
-                    // Convert 1-bit black and white (min is white) to 8-bit RGB
-                    for (int y = m_LastLineConverted + 1; y <= lastLineToConvert; ++y)
-                    {
-                        auto line = &image[y * bytesPerLine];
-                        for (int x = 0; x < width; ++x)
-                        {
-                            int dstPixelIndex = 3 * (y * width + x);
-                            unsigned char pixelValue = line[x / 8] & (1 << (7 - (x % 8)));
-                            m_ConvertedImage[dstPixelIndex] = pixelValue ? 0 : 255;
-                            m_ConvertedImage[dstPixelIndex + 1] = pixelValue ? 0 : 255;
-                            m_ConvertedImage[dstPixelIndex + 2] = pixelValue ? 0 : 255;
-                        }
-                    }
-                }
-                else if (
-                        m_PreviewState->GetScannedImageBitDepth() == 8 &&
-                        m_PreviewState->GetScannedImagePixelFormat() == SANE_FRAME_GRAY)
+                const auto bitDepth = m_PreviewState->GetScannedImageBitDepth();
+                const auto pixelFormat = m_PreviewState->GetScannedImagePixelFormat();
+                for (int y = m_LastLineConverted + 1; y <= lastLineToConvert; ++y)
                 {
-                    // Convert 8-bit grayscale to 8-bit RGB
-                    for (int y = m_LastLineConverted + 1; y <= lastLineToConvert; ++y)
-                    {
-                        for (int x = 0; x < width; ++x)
-                        {
-                            int dstPixelIndex = 3 * (y * width + x);
-                            int srcPixelIndex = y * bytesPerLine + x;
-                            unsigned char pixelValue = image[srcPixelIndex];
-                            m_ConvertedImage[dstPixelIndex] = pixelValue;
-                            m_ConvertedImage[dstPixelIndex + 1] = pixelValue;
-                            m_ConvertedImage[dstPixelIndex + 2] = pixelValue;
-                        }
-                    }
-                }
-                else if (m_PreviewState->GetScannedImageBitDepth() == 16)
-                {
-                    constexpr auto offset = std::endian::native == std::endian::little ? 1 : 0;
-
-                    if (m_PreviewState->GetScannedImagePixelFormat() == SANE_FRAME_GRAY)
-                    {
-                        // Convert 16-bit grayscale to 8-bit RGB
-                        for (int y = m_LastLineConverted + 1; y <= lastLineToConvert; ++y)
-                        {
-                            auto line = &image[y * bytesPerLine];
-                            for (int x = 0; x < width; ++x)
-                            {
-                                int dstPixelIndex = 3 * (y * width + x);
-                                unsigned char pixelValue = line[2 * x + offset];
-                                m_ConvertedImage[dstPixelIndex] = pixelValue;
-                                m_ConvertedImage[dstPixelIndex + 1] = pixelValue;
-                                m_ConvertedImage[dstPixelIndex + 2] = pixelValue;
-                            }
-                        }
-                    }
-                    else if (m_PreviewState->GetScannedImagePixelFormat() == SANE_FRAME_RGB)
-                    {
-                        // Convert 16-bit RGB to 8-bit RGB
-                        for (int y = m_LastLineConverted + 1; y <= lastLineToConvert; ++y)
-                        {
-                            auto line = &image[y * bytesPerLine];
-                            for (int x = 0; x < width; ++x)
-                            {
-                                int dstPixelIndex = 3 * (y * width + x);
-                                m_ConvertedImage[dstPixelIndex] = line[6 * x + offset];
-                                m_ConvertedImage[dstPixelIndex + 1] = line[6 * x + 2 + offset];
-                                m_ConvertedImage[dstPixelIndex + 2] = line[6 * x + 4 + offset];
-                            }
-                        }
-                    }
+                    auto line = &image[static_cast<size_t>(y) * bytesPerLine];
+                    auto convertedLine = &m_ConvertedImage[3 * static_cast<size_t>(y) * width];
+                    PixelConvert::ConvertLineToRgb8(line, convertedLine, width, bitDepth, pixelFormat);
                 }
 
                 m_LastLineConverted = lastLineToConvert;
@@ -985,86 +938,56 @@ void Gorfector::PreviewPanel::Update(const std::vector<uint64_t> &lastSeenVersio
 
 void Gorfector::PreviewPanel::Redraw()
 {
-    if (m_PreviewPixBuf == nullptr)
+    if (m_ScannedImage != nullptr && m_ZoomFactor == 0.0)
     {
-        auto width = gtk_widget_get_size(m_PreviewImage, GTK_ORIENTATION_HORIZONTAL);
-        auto height = gtk_widget_get_size(m_PreviewImage, GTK_ORIENTATION_VERTICAL);
-        if (width == 0 || height == 0)
+        auto displayWidth = gtk_widget_get_size(m_PreviewImage, GTK_ORIENTATION_HORIZONTAL);
+        auto displayHeight = gtk_widget_get_size(m_PreviewImage, GTK_ORIENTATION_VERTICAL);
+        if (displayWidth == 0 || displayHeight == 0)
         {
             return;
         }
 
-        m_PreviewPixBuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, false, 8, width, height);
-    }
-
-    if (m_ScannedImage != nullptr)
-    {
-        auto displayWidth = m_PreviewPixBuf != nullptr ? gdk_pixbuf_get_width(m_PreviewPixBuf) : 0.0;
-        auto displayHeight = m_PreviewPixBuf != nullptr ? gdk_pixbuf_get_height(m_PreviewPixBuf) : 0.0;
-        auto scannedWidth = gdk_pixbuf_get_width(m_ScannedImage);
-        auto scannedHeight = gdk_pixbuf_get_height(m_ScannedImage);
+        auto scaleW = static_cast<double>(displayWidth) / gdk_pixbuf_get_width(m_ScannedImage);
+        auto scaleH = static_cast<double>(displayHeight) / gdk_pixbuf_get_height(m_ScannedImage);
 
-        auto pan = m_PreviewState->GetPreviewPanOffset();
-        if (m_ZoomFactor == 0.0)
-        {
-            auto scaleW = displayWidth / scannedWidth;
-            auto scaleH = displayHeight / scannedHeight;
-
-            m_ZoomFactor = PreviewState::FloorZoomFactor(std::min(scaleW, scaleH));
-        }
-
-        auto previewWidth = std::min(scannedWidth * m_ZoomFactor, displayWidth - pan.x);
-        auto previewHeight = std::min(scannedHeight * m_ZoomFactor, displayHeight - pan.y);
-
-        auto destX = static_cast<int>(std::max(0.0, pan.x));
-        auto destY = static_cast<int>(std::max(0.0, pan.y));
-
-        previewWidth -= (destX - pan.x);
-        previewHeight -= (destY - pan.y);
-
-        FillWithEmptyPattern();
-        gdk_pixbuf_scale(
-                m_ScannedImage, m_PreviewPixBuf, destX, destY, static_cast<int>(previewWidth),
-                static_cast<int>(previewHeight), pan.x, pan.y, m_ZoomFactor, m_ZoomFactor, GDK_INTERP_NEAREST);
-    }
-    else
-    {
-        FillWithEmptyPattern();
+        m_ZoomFactor = PreviewState::FloorZoomFactor(std::min(scaleW, scaleH));
     }
+
+    // Zoom and pan only change where the textures are drawn.
+    gtk_widget_queue_draw(m_PreviewImage);
 }
 
-void Gorfector::PreviewPanel::FillWithEmptyPattern() const
+void Gorfector::PreviewPanel::AppendEmptyPattern(GtkSnapshot *snapshot, const graphene_rect_t &bounds)
 {
-    g_assert(gdk_pixbuf_get_colorspace(m_PreviewPixBuf) == GDK_COLORSPACE_RGB);
-    g_assert(gdk_pixbuf_get_bits_per_sample(m_PreviewPixBuf) == 8);
-    g_assert(gdk_pixbuf_get_has_alpha(m_PreviewPixBuf) == false);
-    g_assert(gdk_pixbuf_get_n_channels(m_PreviewPixBuf) == 3);
+    constexpr int k_PatternSize = 128;
 
-    auto *pixbuf = gdk_pixbuf_get_pixels(m_PreviewPixBuf);
-    int height = gdk_pixbuf_get_height(m_PreviewPixBuf);
-    int width = gdk_pixbuf_get_width(m_PreviewPixBuf);
-    int rowStride = gdk_pixbuf_get_rowstride(m_PreviewPixBuf);
-
-    constexpr guchar k_Light = 0xFF;
-    constexpr guchar k_Dark = 0xEE;
-
-    for (int y = 0; y < height; ++y)
+    if (m_EmptyPatternTexture == nullptr)
     {
-        auto *ptr = pixbuf + y * rowStride;
-        for (int x = 0; x < width; ++x)
+        constexpr guchar k_Light = 0xFF;
+        constexpr guchar k_Dark = 0xEE;
+
+        auto *pixels = static_cast<guchar *>(g_malloc(3 * k_PatternSize * k_PatternSize));
+        auto *ptr = pixels;
+        for (int y = 0; y < k_PatternSize; ++y)
         {
-            if (((x & 0x40) && !(y & 0x40)) || (!(x & 0x40) && (y & 0x40)))
-            {
-                *ptr++ = k_Dark;
-                *ptr++ = k_Dark;
-                *ptr++ = k_Dark;
-            }
-            else
+            for (int x = 0; x < k_PatternSize; ++x)
             {
-                *ptr++ = k_Light;
-                *ptr++ = k_Light;
-                *ptr++ = k_Light;
+                auto value = ((x & 0x40) != 0) != ((y & 0x40) != 0) ? k_Dark : k_Light;
+                *ptr++ = value;
+                *ptr++ = value;
+                *ptr++ = value;
             }
         }
+
+        auto bytes = g_bytes_new_take(pixels, 3 * k_PatternSize * k_PatternSize);
+        m_EmptyPatternTexture =
+                gdk_memory_texture_new(k_PatternSize, k_PatternSize, GDK_MEMORY_R8G8B8, bytes, 3 * k_PatternSize);
+        g_bytes_unref(bytes);
     }
+
+    graphene_rect_t patternBounds;
+    graphene_rect_init(&patternBounds, 0, 0, k_PatternSize, k_PatternSize);
+    gtk_snapshot_push_repeat(snapshot, &bounds, &patternBounds);
+    gtk_snapshot_append_texture(snapshot, m_EmptyPatternTexture, &patternBounds);
+    gtk_snapshot_pop(snapshot);
 }
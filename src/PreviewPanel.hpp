@@ -3,6 +3,7 @@
 #include <gtk/gtk.h>
 
 #include "PreviewState.hpp"
+#include "PreviewTextureCache.hpp"
 #include "Rect.hpp"
 #include "ViewUpdateObserver.hpp"
 #include "ZooLib/CommandDispatcher.hpp"
@@ -37,6 +38,8 @@ namespace Gorfector
         ZooLib::CommandDispatcher m_Dispatcher{};
 
         PreviewState *m_PreviewState{};
+        // Receives the changes of m_PreviewState, reused on every update.
+        PreviewStateChangeset m_PreviewStateChangeset{0};
         ViewUpdateObserver<PreviewPanel, PreviewState> *m_ViewUpdateObserver{};
 
         double m_ZoomFactor{};
@@ -47,21 +50,26 @@ namespace Gorfector
         GdkPixbuf *m_ScannedImage{};
         // The whole preview image, including the checkerboard.
         GtkWidget *m_PreviewImage{};
+        // The checkerboard tile drawn behind the scanned image.
+        GdkTexture *m_EmptyPatternTexture{};
         GtkWidget *m_PanToggleButton;
         GtkWidget *m_CropToggleButton;
 
         gulong m_PanToggleButtonSignalId;
         gulong m_CropToggleButtonSignalId;
 
-        // The scanned data
-        GdkPixbuf *m_PreviewPixBuf{};
-        // The source data for m_PreviewPixBuf
+        // The scanned data, as textures
+        PreviewTextureCache m_TextureCache{};
+        // The source data for m_ScannedImage and m_TextureCache
         const unsigned char *m_UnderlyingBuffer{};
         // Auxiliary buffer for the converted image, if scanned data is not in 8bit RGBA format.
         unsigned char *m_ConvertedImage{};
         size_t m_ConvertedImageSize{};
         int m_LastLineConverted{-1};
 
+        // The last line of the scanned image received so far.
+        int m_LastLineReceived{-1};
+
         bool m_IsDragging{};
         double m_DragStartX{};
         double m_DragStartY{};
@@ -79,7 +87,7 @@ namespace Gorfector
         void OnMouseMove(GtkEventControllerMotion *motionController, gdouble x, gdouble y);
         void OnMouseScroll(GtkEventControllerScroll *scrollController, gdouble deltaX, gdouble deltaY);
 
-        void OnPreviewDraw(cairo_t *cr) const;
+        void OnPreviewSnapshot(GtkSnapshot *snapshot, int width, int height);
 
         void OnResized(GtkWidget *widget, void *data, void *);
         void OnCropButtonToggled(GtkToggleButton *button, void *data);
@@ -89,7 +97,7 @@ namespace Gorfector
         void ComputeScanArea(double deltaX, double deltaY, Rect<double> &outScanArea) const;
         bool ScanAreaToPixels(const Rect<double> &scanArea, Rect<double> &outPixelArea) const;
 
-        void FillWithEmptyPattern() const;
+        void AppendEmptyPattern(GtkSnapshot *snapshot, const graphene_rect_t &bounds);
         void Redraw();
 
     public:
@@ -36,30 +36,36 @@ namespace Gorfector
         {
             if (m_ScanParameters.format != SANE_FRAME_GRAY && m_ScanParameters.format != SANE_FRAME_RGB)
             {
-                ZooLib::ShowUserError(ADW_APPLICATION_WINDOW(m_MainWindow), _("Unsupported format."));
+                ShowError(_("Unsupported format."));
                 return false;
             }
 
             return true;
         }
 
-        void GetBuffer(SANE_Byte *&outBuffer, size_t &outMaxReadLength) override
+        size_t ConsumeBytes(SANE_Byte *bytes, size_t length) override
         {
             auto previewPanelUpdater = PreviewState::Updater(m_PreviewState);
-            previewPanelUpdater.GetReadBuffer(outBuffer, outMaxReadLength);
-        }
 
-        void CommitBuffer(size_t readLength) override
-        {
-            auto previewPanelUpdater = PreviewState::Updater(m_PreviewState);
-            previewPanelUpdater.CommitReadBuffer(readLength);
+            SANE_Byte *previewBuffer = nullptr;
+            size_t maxLength = 0;
+            previewPanelUpdater.GetReadBuffer(previewBuffer, maxLength);
+
+            // Bytes beyond the size announced by the device parameters are discarded.
+            auto copyLength = std::min(length, maxLength);
+            if (copyLength > 0)
+            {
+                std::memcpy(previewBuffer, bytes, copyLength);
+                previewPanelUpdater.CommitReadBuffer(copyLength);
+            }
 
-            ScanProcess::CommitBuffer(readLength);
+            ScanProcess::ConsumeBytes(bytes, copyLength);
+            return length;
         }
 
     public:
         PreviewScanProcess(
-                SaneDevice *device, PreviewState *previewState, AppState *appState, DeviceOptionsState *scanOptions,
+                ScanDevice *device, PreviewState *previewState, AppState *appState, DeviceOptionsState *scanOptions,
                 OutputOptionsState *outputOptions, GtkWidget *mainWindow, const std::function<void()> *finishCallback)
             : ScanProcess(device, previewState, appState, scanOptions, outputOptions, mainWindow, finishCallback)
         {
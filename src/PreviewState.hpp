@@ -21,6 +21,7 @@ namespace Gorfector
             Image = 8,
             Progress = 16,
             MouseBehavior = 32,
+            NewImage = 64,
         };
 
     private:
@@ -39,6 +40,12 @@ namespace Gorfector
             m_LastLine = -1;
         }
 
+        void Reset(uint64_t stateInitialVersion)
+        {
+            ChangesetBase::Reset(stateInitialVersion);
+            Clear();
+        }
+
         void Set(TypeFlag typeFlag, int lastLine = -1)
         {
             m_ChangeType |= static_cast<std::underlying_type_t<TypeFlag>>(typeFlag);
@@ -283,9 +290,9 @@ namespace Gorfector
             return &m_ChangesetManager;
         }
 
-        [[nodiscard]] PreviewStateChangeset *GetAggregatedChangeset(uint64_t stateComponentVersion) const
+        void AggregateChangesets(uint64_t stateComponentVersion, PreviewStateChangeset &accumulator) const
         {
-            return m_ChangesetManager.GetAggregatedChangeset(stateComponentVersion);
+            m_ChangesetManager.AggregateChangesets(stateComponentVersion, accumulator);
         }
 
         class Updater final : public StateComponent::Updater<PreviewState>
@@ -415,6 +422,7 @@ namespace Gorfector
 
                 auto changeset = m_StateComponent->GetCurrentChangeset();
                 changeset->Set(PreviewStateChangeset::TypeFlag::Image, -1);
+                changeset->Set(PreviewStateChangeset::TypeFlag::NewImage);
             }
 
             void GetReadBuffer(SANE_Byte *&buffer, size_t &maxLength)
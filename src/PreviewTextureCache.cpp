@@ -0,0 +1,232 @@
+#include "PreviewTextureCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "PixelConvert.hpp"
+
+void Gorfector::PreviewTextureCache::SetImage(const uint8_t *pixels, int width, int height, int rowStride)
+{
+    Clear();
+
+    if (pixels == nullptr || width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    m_Source = pixels;
+    m_SourceRowStride = rowStride;
+
+    for (auto levelIndex = 0; levelIndex < k_LevelCount; ++levelIndex)
+    {
+        auto &level = m_Levels[levelIndex];
+        if (levelIndex == 0)
+        {
+            level.m_Width = width;
+            level.m_Height = height;
+        }
+        else
+        {
+            level.m_Width = (m_Levels[levelIndex - 1].m_Width + 1) / 2;
+            level.m_Height = (m_Levels[levelIndex - 1].m_Height + 1) / 2;
+            level.m_Pixels.resize(3 * static_cast<size_t>(level.m_Width) * level.m_Height);
+            level.m_FirstDirtyRow = 0;
+            level.m_LastDirtyRow = level.m_Height - 1;
+        }
+
+        level.m_TileColumns = (level.m_Width + k_TileSize - 1) / k_TileSize;
+        level.m_TileRows = (level.m_Height + k_TileSize - 1) / k_TileSize;
+        level.m_Tiles.assign(static_cast<size_t>(level.m_TileColumns) * level.m_TileRows, nullptr);
+        level.m_TileRowIsDirty.assign(level.m_TileRows, true);
+    }
+}
+
+void Gorfector::PreviewTextureCache::Clear()
+{
+    for (auto &level: m_Levels)
+    {
+        for (auto *tile: level.m_Tiles)
+        {
+            if (tile != nullptr)
+            {
+                g_object_unref(tile);
+            }
+        }
+
+        level = Level{};
+    }
+
+    m_Source = nullptr;
+    m_SourceRowStride = 0;
+}
+
+void Gorfector::PreviewTextureCache::InvalidateLines(int firstLine, int lastLine)
+{
+    if (m_Source == nullptr)
+    {
+        return;
+    }
+
+    firstLine = std::max(firstLine, 0);
+    lastLine = std::min(lastLine, m_Levels[0].m_Height - 1);
+    if (firstLine > lastLine)
+    {
+        return;
+    }
+
+    for (auto levelIndex = 0; levelIndex < k_LevelCount; ++levelIndex)
+    {
+        auto &level = m_Levels[levelIndex];
+        auto firstRow = firstLine >> levelIndex;
+        auto lastRow = lastLine >> levelIndex;
+
+        if (levelIndex > 0)
+        {
+            if (level.m_LastDirtyRow < level.m_FirstDirtyRow)
+            {
+                level.m_FirstDirtyRow = firstRow;
+                level.m_LastDirtyRow = lastRow;
+            }
+            else
+            {
+                level.m_FirstDirtyRow = std::min(level.m_FirstDirtyRow, firstRow);
+                level.m_LastDirtyRow = std::max(level.m_LastDirtyRow, lastRow);
+            }
+        }
+
+        for (auto tileRow = firstRow / k_TileSize; tileRow <= lastRow / k_TileSize; ++tileRow)
+        {
+            level.m_TileRowIsDirty[tileRow] = true;
+        }
+    }
+}
+
+void Gorfector::PreviewTextureCache::UpdateLevel(int levelIndex)
+{
+    auto &level = m_Levels[levelIndex];
+    if (levelIndex == 0 || level.m_LastDirtyRow < level.m_FirstDirtyRow)
+    {
+        return;
+    }
+
+    const auto &previousLevel = m_Levels[levelIndex - 1];
+    auto getPreviousRow = [this, levelIndex, &previousLevel](int row) {
+        if (levelIndex == 1)
+        {
+            return m_Source + static_cast<size_t>(row) * m_SourceRowStride;
+        }
+        return previousLevel.m_Pixels.data() + 3 * static_cast<size_t>(row) * previousLevel.m_Width;
+    };
+
+    for (auto row = level.m_FirstDirtyRow; row <= level.m_LastDirtyRow; ++row)
+    {
+        auto line0 = getPreviousRow(2 * row);
+        auto line1 = getPreviousRow(std::min(2 * row + 1, previousLevel.m_Height - 1));
+        auto destination = level.m_Pixels.data() + 3 * static_cast<size_t>(row) * level.m_Width;
+        PixelConvert::DownsampleRgb8(line0, line1, destination, previousLevel.m_Width);
+    }
+
+    level.m_FirstDirtyRow = 0;
+    level.m_LastDirtyRow = -1;
+}
+
+void Gorfector::PreviewTextureCache::UpdateTiles(int levelIndex)
+{
+    auto &level = m_Levels[levelIndex];
+    const auto *pixels = levelIndex == 0 ? m_Source : level.m_Pixels.data();
+    const auto rowStride =
+            levelIndex == 0 ? static_cast<size_t>(m_SourceRowStride) : 3 * static_cast<size_t>(level.m_Width);
+
+    for (auto tileRow = 0; tileRow < level.m_TileRows; ++tileRow)
+    {
+        if (!level.m_TileRowIsDirty[tileRow])
+        {
+            continue;
+        }
+
+        auto y = tileRow * k_TileSize;
+        auto tileHeight = std::min(k_TileSize, level.m_Height - y);
+        for (auto tileColumn = 0; tileColumn < level.m_TileColumns; ++tileColumn)
+        {
+            auto x = tileColumn * k_TileSize;
+            auto tileWidth = std::min(k_TileSize, level.m_Width - x);
+            auto tileRowStride = 3 * static_cast<size_t>(tileWidth);
+
+            auto *tilePixels = static_cast<uint8_t *>(g_malloc(tileRowStride * tileHeight));
+            for (auto row = 0; row < tileHeight; ++row)
+            {
+                std::memcpy(
+                        tilePixels + row * tileRowStride, pixels + (y + row) * rowStride + 3 * static_cast<size_t>(x),
+                        tileRowStride);
+            }
+
+            auto bytes = g_bytes_new_take(tilePixels, tileRowStride * tileHeight);
+            auto texture = gdk_memory_texture_new(tileWidth, tileHeight, GDK_MEMORY_R8G8B8, bytes, tileRowStride);
+            g_bytes_unref(bytes);
+
+            auto &tile = level.m_Tiles[static_cast<size_t>(tileRow) * level.m_TileColumns + tileColumn];
+            if (tile != nullptr)
+            {
+                g_object_unref(tile);
+            }
+            tile = texture;
+        }
+
+        level.m_TileRowIsDirty[tileRow] = false;
+    }
+}
+
+void Gorfector::PreviewTextureCache::Snapshot(
+        GtkSnapshot *snapshot, double zoomFactor, Point<double> origin, const graphene_rect_t &bounds)
+{
+    if (m_Source == nullptr || zoomFactor <= 0.0)
+    {
+        return;
+    }
+
+    // Use the smallest level that is not smaller than the zoomed image.
+    auto levelIndex = 0;
+    while (levelIndex + 1 < k_LevelCount && zoomFactor <= 1.0 / (1 << (levelIndex + 1)))
+    {
+        ++levelIndex;
+    }
+
+    for (auto i = 1; i <= levelIndex; ++i)
+    {
+        UpdateLevel(i);
+    }
+    UpdateTiles(levelIndex);
+
+    const auto &level = m_Levels[levelIndex];
+    const auto scale = zoomFactor * (1 << levelIndex);
+    const auto filter = scale >= 1.0 ? GSK_SCALING_FILTER_NEAREST : GSK_SCALING_FILTER_LINEAR;
+
+    // Keep the tiles on whole pixels, so that no seam shows between them.
+    const auto originX = std::round(origin.x);
+    const auto originY = std::round(origin.y);
+
+    for (auto tileRow = 0; tileRow < level.m_TileRows; ++tileRow)
+    {
+        auto y = tileRow * k_TileSize;
+        auto tileHeight = std::min(k_TileSize, level.m_Height - y);
+        for (auto tileColumn = 0; tileColumn < level.m_TileColumns; ++tileColumn)
+        {
+            auto x = tileColumn * k_TileSize;
+            auto tileWidth = std::min(k_TileSize, level.m_Width - x);
+
+            graphene_rect_t rect;
+            graphene_rect_init(
+                    &rect, static_cast<float>(originX + x * scale), static_cast<float>(originY + y * scale),
+                    static_cast<float>(tileWidth * scale), static_cast<float>(tileHeight * scale));
+            if (!graphene_rect_intersection(&rect, &bounds, nullptr))
+            {
+                continue;
+            }
+
+            gtk_snapshot_append_scaled_texture(
+                    snapshot, level.m_Tiles[static_cast<size_t>(tileRow) * level.m_TileColumns + tileColumn], filter,
+                    &rect);
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <gtk/gtk.h>
+#include <vector>
+
+#include "Point.hpp"
+
+namespace Gorfector
+{
+    /**
+     * \class PreviewTextureCache
+     * \brief Keeps the preview image as tiles of `GdkMemoryTexture`, along with downscaled copies of the image.
+     *
+     * Level 0 is the image itself; each following level halves the size of the previous one, down to the smallest
+     * zoom factor of `PreviewState::k_ZoomValues`. Zooming out draws the level matching the zoom factor at its natural
+     * size, and zooming in draws level 0 scaled up, so changing the zoom or pan only changes where the tiles are drawn.
+     *
+     * Textures are immutable: lines invalidated while the image is being scanned are downscaled, and the tiles
+     * containing them rebuilt, the next time the level is drawn.
+     */
+    class PreviewTextureCache
+    {
+        static constexpr int k_TileSize = 256;
+        static constexpr int k_LevelCount = 5;
+
+        struct Level
+        {
+            int m_Width{};
+            int m_Height{};
+            // The pixels of the level, in 8 bit RGB. Empty for level 0, which uses the source image.
+            std::vector<uint8_t> m_Pixels{};
+            // The range of rows that need to be recomputed from the previous level.
+            int m_FirstDirtyRow{};
+            int m_LastDirtyRow{-1};
+
+            int m_TileColumns{};
+            int m_TileRows{};
+            std::vector<GdkTexture *> m_Tiles{};
+            std::vector<bool> m_TileRowIsDirty{};
+        };
+
+        const uint8_t *m_Source{};
+        int m_SourceRowStride{};
+        std::array<Level, k_LevelCount> m_Levels{};
+
+        void UpdateLevel(int levelIndex);
+        void UpdateTiles(int levelIndex);
+
+    public:
+        PreviewTextureCache() = default;
+        PreviewTextureCache(const PreviewTextureCache &) = delete;
+        PreviewTextureCache &operator=(const PreviewTextureCache &) = delete;
+
+        ~PreviewTextureCache()
+        {
+            Clear();
+        }
+
+        /**
+         * \brief Sets the image to draw. All lines are invalidated.
+         * \param pixels The image, in 8 bit RGB. It is not copied and must outlive the cache or the next call to
+         * `SetImage()` or `Clear()`.
+         * \param width The width of the image, in pixels.
+         * \param height The height of the image, in pixels.
+         * \param rowStride The distance between two lines of the image, in bytes.
+         */
+        void SetImage(const uint8_t *pixels, int width, int height, int rowStride);
+
+        /**
+         * \brief Releases the textures and forgets the image.
+         */
+        void Clear();
+
+        /**
+         * \brief Notifies the cache that lines of the image changed.
+         * \param firstLine The first line that changed.
+         * \param lastLine The last line that changed, inclusively.
+         */
+        void InvalidateLines(int firstLine, int lastLine);
+
+        /**
+         * \brief Notifies the cache that all lines of the image changed.
+         */
+        void InvalidateAll()
+        {
+            InvalidateLines(0, m_Levels[0].m_Height - 1);
+        }
+
+        /**
+         * \brief Appends the image to a snapshot.
+         * \param snapshot The snapshot to append to.
+         * \param zoomFactor The zoom factor.
+         * \param origin Where the top left corner of the image is drawn.
+         * \param bounds The visible area. Tiles outside of it are not drawn.
+         */
+        void Snapshot(GtkSnapshot *snapshot, double zoomFactor, Point<double> origin, const graphene_rect_t &bounds);
+    };
+}
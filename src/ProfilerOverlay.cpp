@@ -0,0 +1,50 @@
+#include "ProfilerOverlay.hpp"
+
+#include "ZooLib/Profiler.hpp"
+
+Gorfector::ProfilerOverlay::ProfilerOverlay(GtkWidget *child)
+{
+    m_RootWidget = gtk_overlay_new();
+    gtk_overlay_set_child(GTK_OVERLAY(m_RootWidget), child);
+
+    m_Label = gtk_label_new(nullptr);
+    // Keep the label alive until the timeout is removed, even if the window is destroyed first.
+    g_object_ref(m_Label);
+    gtk_widget_add_css_class(m_Label, "dev-overlay");
+    gtk_widget_set_halign(m_Label, GTK_ALIGN_END);
+    gtk_widget_set_valign(m_Label, GTK_ALIGN_START);
+    gtk_widget_set_can_target(m_Label, false);
+    gtk_overlay_add_overlay(GTK_OVERLAY(m_RootWidget), m_Label);
+
+    Refresh();
+    m_RefreshSourceId = g_timeout_add(k_RefreshInterval, OnRefreshTimeout, this);
+}
+
+Gorfector::ProfilerOverlay::~ProfilerOverlay()
+{
+    if (m_RefreshSourceId != 0)
+    {
+        g_source_remove(m_RefreshSourceId);
+        m_RefreshSourceId = 0;
+    }
+
+    g_object_unref(m_Label);
+    m_Label = nullptr;
+}
+
+gboolean Gorfector::ProfilerOverlay::OnRefreshTimeout(gpointer data)
+{
+    static_cast<ProfilerOverlay *>(data)->Refresh();
+    return G_SOURCE_CONTINUE;
+}
+
+void Gorfector::ProfilerOverlay::Refresh()
+{
+    if (!gtk_widget_get_mapped(m_Label) && gtk_label_get_text(GTK_LABEL(m_Label))[0] != '\0')
+    {
+        return;
+    }
+
+    auto text = ZooLib::Profiler::FormatSummaries(ZooLib::Profiler::GetSummaries());
+    gtk_label_set_text(GTK_LABEL(m_Label), text.c_str());
+}
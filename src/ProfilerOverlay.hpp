@@ -0,0 +1,41 @@
+#pragma once
+
+#include <gtk/gtk.h>
+
+namespace Gorfector
+{
+    /**
+     * \class ProfilerOverlay
+     * \brief Shows the metrics recorded by `ZooLib::Profiler` above a widget, in developer mode.
+     *
+     * The metrics are refreshed periodically. The overlay does not receive input, so the widget below it stays usable.
+     */
+    class ProfilerOverlay
+    {
+        static constexpr guint k_RefreshInterval = 500;
+
+        GtkWidget *m_RootWidget{};
+        GtkWidget *m_Label{};
+        guint m_RefreshSourceId{};
+
+        static gboolean OnRefreshTimeout(gpointer data);
+
+    public:
+        /**
+         * \param child The widget shown below the metrics.
+         */
+        explicit ProfilerOverlay(GtkWidget *child);
+
+        ~ProfilerOverlay();
+
+        ProfilerOverlay(const ProfilerOverlay &) = delete;
+        ProfilerOverlay &operator=(const ProfilerOverlay &) = delete;
+
+        [[nodiscard]] GtkWidget *GetRootWidget() const
+        {
+            return m_RootWidget;
+        }
+
+        void Refresh();
+    };
+}
@@ -1,23 +1,108 @@
 #pragma once
 
+#include <cstdint>
 #include <cstring>
+#include <functional>
 #include <glib.h>
+#include <mutex>
 #include <sane/sane.h>
+#include <string>
+#include <thread>
+
+#include "ScanDevice.hpp"
+#include "ZooLib/Profiler.hpp"
 
 namespace Gorfector
 {
-    class SaneDevice
+    /**
+     * \brief The identification of a device, copied from a `SANE_Device` so that it stays valid when SANE is
+     * reinitialized.
+     */
+    struct SaneDeviceInfo
+    {
+        std::string Name{};
+        std::string Vendor{};
+        std::string Model{};
+        std::string Type{};
+
+        SaneDeviceInfo() = default;
+
+        SaneDeviceInfo(std::string name, std::string vendor, std::string model, std::string type)
+            : Name(std::move(name))
+            , Vendor(std::move(vendor))
+            , Model(std::move(model))
+            , Type(std::move(type))
+        {
+        }
+
+        explicit SaneDeviceInfo(const SANE_Device *device)
+            : Name(device->name == nullptr ? "" : device->name)
+            , Vendor(device->vendor == nullptr ? "" : device->vendor)
+            , Model(device->model == nullptr ? "" : device->model)
+            , Type(device->type == nullptr ? "" : device->type)
+        {
+        }
+
+        bool operator==(const SaneDeviceInfo &other) const = default;
+    };
+
+    class SaneDevice final : public ScanDevice
     {
-        const SANE_Device *m_Device{};
+        SaneDeviceInfo m_Device{};
         SANE_Handle m_Handle{};
+        mutable uint64_t m_ControlOptionCount{};
+
+        // A task using the handle on a worker thread. SANE handles are not reentrant: the other uses of the handle,
+        // from any thread, wait for the task to complete.
+        mutable std::mutex m_BackgroundTaskMutex{};
+        mutable std::thread m_BackgroundTask{};
+        static inline thread_local const SaneDevice *t_BackgroundTaskDevice{};
+
+        static inline const ZooLib::Profiler::Metric s_ReadTime{
+                "sane.read.time", ZooLib::Profiler::Unit::e_Nanoseconds};
+        static inline const ZooLib::Profiler::Metric s_ReadSize{"sane.read.bytes", ZooLib::Profiler::Unit::e_Bytes};
+        static inline const ZooLib::Profiler::Metric s_ControlOptionTime{
+                "sane.control_option.time", ZooLib::Profiler::Unit::e_Nanoseconds};
+
+        /**
+         * \brief Whether debug messages are shown. Option accesses are frequent, and `g_debug()` formats its message
+         * before discarding it, so the option accesses only log when debug messages are enabled.
+         */
+        [[nodiscard]] static bool IsDebugLogEnabled()
+        {
+            static const bool s_IsDebugLogEnabled = !g_log_writer_default_would_drop(G_LOG_LEVEL_DEBUG, G_LOG_DOMAIN);
+            return s_IsDebugLogEnabled;
+        }
+
+        void LogSetOptionValue(uint32_t optionIndex, const void *value) const
+        {
+            const auto *optionDescriptor = sane_get_option_descriptor(m_Handle, static_cast<int>(optionIndex));
+            if (optionDescriptor == nullptr || optionDescriptor->size == 0)
+            {
+                g_debug("Setting option %d", optionIndex);
+            }
+            else if (optionDescriptor->type == SANE_TYPE_STRING)
+            {
+                g_debug("Setting option %d (%s)", optionIndex, static_cast<const char *>(value));
+            }
+            else
+            {
+                g_debug("Setting option %d (%d)", optionIndex, *static_cast<const SANE_Word *>(value));
+            }
+        }
 
     public:
+        explicit SaneDevice(SaneDeviceInfo device)
+            : m_Device(std::move(device))
+        {
+        }
+
         explicit SaneDevice(const SANE_Device *device)
             : m_Device(device)
         {
         }
 
-        ~SaneDevice()
+        ~SaneDevice() override
         {
             Close();
         }
@@ -27,10 +112,10 @@ namespace Gorfector
         SaneDevice &operator=(const SaneDevice &) = delete;
 
         SaneDevice(SaneDevice &&other) noexcept
-            : m_Device(other.m_Device)
+            : m_Device((other.WaitForBackgroundTask(), std::move(other.m_Device)))
             , m_Handle(other.m_Handle)
+            , m_ControlOptionCount(other.m_ControlOptionCount)
         {
-            other.m_Device = nullptr;
             other.m_Handle = nullptr;
         }
 
@@ -38,22 +123,60 @@ namespace Gorfector
         {
             if (this != &other)
             {
-                m_Device = other.m_Device;
+                Close();
+                other.WaitForBackgroundTask();
+                m_Device = std::move(other.m_Device);
                 m_Handle = other.m_Handle;
-                other.m_Device = nullptr;
+                m_ControlOptionCount = other.m_ControlOptionCount;
                 other.m_Handle = nullptr;
             }
             return *this;
         }
 
+        /**
+         * \brief Runs a task using the device on a worker thread. Until the task completes, the other uses of the
+         * device wait for it.
+         * \param task The task. It can use the device.
+         */
+        void RunInBackground(std::move_only_function<void()> task)
+        {
+            WaitForBackgroundTask();
+
+            std::lock_guard lock(m_BackgroundTaskMutex);
+            m_BackgroundTask = std::thread([this, task = std::move(task)]() mutable {
+                t_BackgroundTaskDevice = this;
+                task();
+                t_BackgroundTaskDevice = nullptr;
+            });
+        }
+
+        /**
+         * \brief Waits for the task started by `RunInBackground()`, if any. Called by all the methods using the handle,
+         * except from the task itself.
+         */
+        void WaitForBackgroundTask() const
+        {
+            if (t_BackgroundTaskDevice == this)
+            {
+                return;
+            }
+
+            std::lock_guard lock(m_BackgroundTaskMutex);
+            if (m_BackgroundTask.joinable())
+            {
+                m_BackgroundTask.join();
+            }
+        }
+
         bool Open()
         {
-            g_debug("Opening device %s", m_Device->name);
+            WaitForBackgroundTask();
+            g_debug("Opening device %s", m_Device.Name.c_str());
 
-            SANE_Status status = sane_open(m_Device->name, &m_Handle);
+            SANE_Status status = sane_open(m_Device.Name.c_str(), &m_Handle);
             if (status != SANE_STATUS_GOOD)
             {
-                g_debug("Failed to open device %s: %s", m_Device->name, sane_strstatus(status));
+                g_debug("Failed to open device %s: %s", m_Device.Name.c_str(), sane_strstatus(status));
                 m_Handle = nullptr;
                 return false;
             }
@@ -62,9 +185,10 @@ namespace Gorfector
 
         void Close()
         {
+            WaitForBackgroundTask();
             if (m_Handle != nullptr)
             {
-                g_debug("Closing device %s", m_Device->name);
+                g_debug("Closing device %s", m_Device.Name.c_str());
 
                 sane_cancel(m_Handle);
                 sane_close(m_Handle);
@@ -74,49 +198,76 @@ namespace Gorfector
 
         [[nodiscard]] const char *GetName() const
         {
-            return m_Device->name;
+            return m_Device.Name.c_str();
         }
 
         [[nodiscard]] const char *GetVendor() const
         {
-            return m_Device->vendor;
+            return m_Device.Vendor.c_str();
         }
 
         [[nodiscard]] const char *GetModel() const
         {
-            return m_Device->model;
+            return m_Device.Model.c_str();
         }
 
         [[nodiscard]] const char *GetType() const
         {
-            return m_Device->type;
+            return m_Device.Type.c_str();
+        }
+
+        [[nodiscard]] const SaneDeviceInfo &GetInfo() const
+        {
+            return m_Device;
         }
 
-        [[nodiscard]] const SANE_Option_Descriptor *GetOptionDescriptor(uint32_t optionIndex) const
+        /**
+         * \brief Gets the number of option values read from or written to the device. With most backends, each of
+         * these is a round trip to the device.
+         */
+        [[nodiscard]] uint64_t GetControlOptionCount() const
         {
+            return m_ControlOptionCount;
+        }
+
+        [[nodiscard]] const SANE_Option_Descriptor *GetOptionDescriptor(uint32_t optionIndex) const override
+        {
+            WaitForBackgroundTask();
             if (m_Handle == nullptr)
             {
                 return nullptr;
             }
 
-            g_debug("Getting option descriptor for option %d", optionIndex);
+            if (IsDebugLogEnabled())
+            {
+                g_debug("Getting option descriptor for option %d", optionIndex);
+            }
 
             const SANE_Option_Descriptor *optionDescriptor =
                     sane_get_option_descriptor(m_Handle, static_cast<int>(optionIndex));
             return optionDescriptor;
         }
 
-        bool GetOptionValue(uint32_t optionIndex, void *value) const
+        bool GetOptionValue(uint32_t optionIndex, void *value) const override
         {
+            WaitForBackgroundTask();
             if (m_Handle == nullptr)
             {
                 return false;
             }
 
-            g_debug("Getting option %d value", optionIndex);
+            if (IsDebugLogEnabled())
+            {
+                g_debug("Getting option %d value", optionIndex);
+            }
+            ++m_ControlOptionCount;
 
-            auto status =
-                    sane_control_option(m_Handle, static_cast<int>(optionIndex), SANE_ACTION_GET_VALUE, value, nullptr);
+            SANE_Status status;
+            {
+                ZooLib::Profiler::ScopedTimer timer(s_ControlOptionTime);
+                status = sane_control_option(
+                        m_Handle, static_cast<int>(optionIndex), SANE_ACTION_GET_VALUE, value, nullptr);
+            }
             if (status != SANE_STATUS_GOOD)
             {
                 g_debug("Failed to get option value for option %d: %s", optionIndex, sane_strstatus(status));
@@ -126,20 +277,26 @@ namespace Gorfector
             return true;
         }
 
-        bool SetOptionValue(uint32_t optionIndex, void *value, int *optionInfo) const
+        bool SetOptionValue(uint32_t optionIndex, void *value, int *optionInfo) const override
         {
+            WaitForBackgroundTask();
             if (m_Handle == nullptr)
             {
                 return false;
             }
 
-            int *intValue = static_cast<int *>(value);
-            char *charValue = static_cast<char *>(value);
-            g_debug("Setting option %d (%d) (%c%c%c%c)", optionIndex, *intValue, charValue[0], charValue[1],
-                    charValue[2], charValue[3]);
+            if (IsDebugLogEnabled())
+            {
+                LogSetOptionValue(optionIndex, value);
+            }
+            ++m_ControlOptionCount;
 
-            auto status = sane_control_option(
-                    m_Handle, static_cast<int>(optionIndex), SANE_ACTION_SET_VALUE, value, optionInfo);
+            SANE_Status status;
+            {
+                ZooLib::Profiler::ScopedTimer timer(s_ControlOptionTime);
+                status = sane_control_option(
+                        m_Handle, static_cast<int>(optionIndex), SANE_ACTION_SET_VALUE, value, optionInfo);
+            }
             if (status != SANE_STATUS_GOOD)
             {
                 g_debug("Failed to set option value for option %d: %s", optionIndex, sane_strstatus(status));
@@ -149,74 +306,82 @@ namespace Gorfector
             return true;
         }
 
-        bool StartScan() const
+        SANE_Status StartScan() const override
         {
+            WaitForBackgroundTask();
             if (m_Handle == nullptr)
             {
-                return false;
+                return SANE_STATUS_INVAL;
             }
 
-            g_debug("Starting scan for device %s", m_Device->name);
+            g_debug("Starting scan for device %s", m_Device.Name.c_str());
 
             auto status = sane_start(m_Handle);
             if (status != SANE_STATUS_GOOD)
             {
                 g_debug("Failed to start scan: %s", sane_strstatus(status));
-                return false;
             }
 
-            return true;
+            return status;
         }
 
-        bool Read(SANE_Byte *buffer, SANE_Int maxLength, SANE_Int *length) const
+        SANE_Status Read(SANE_Byte *buffer, SANE_Int maxLength, SANE_Int *length) const override
         {
+            WaitForBackgroundTask();
             if (m_Handle == nullptr)
             {
-                return false;
+                *length = 0;
+                return SANE_STATUS_INVAL;
             }
 
-            auto status = sane_read(m_Handle, buffer, maxLength, length);
+            SANE_Status status;
+            {
+                ZooLib::Profiler::ScopedTimer timer(s_ReadTime);
+                status = sane_read(m_Handle, buffer, maxLength, length);
+            }
+            s_ReadSize.Record(*length);
+
             switch (status)
             {
                 case SANE_STATUS_GOOD:
                 case SANE_STATUS_DEVICE_BUSY:
-                    return true;
+                case SANE_STATUS_EOF:
+                    break;
 
                 default:
-                    g_debug("Failed to read from device %s: %s", m_Device->name, sane_strstatus(status));
-                    return false;
+                    g_debug("Failed to read from device %s: %s", m_Device.Name.c_str(), sane_strstatus(status));
+                    break;
             }
+
+            return status;
         }
 
-        void CancelScan() const
+        void CancelScan() const override
         {
+            WaitForBackgroundTask();
             if (m_Handle == nullptr)
             {
                 return;
             }
 
-            g_debug("Cancelling scan for device %s", m_Device->name);
+            g_debug("Cancelling scan for device %s", m_Device.Name.c_str());
             sane_cancel(m_Handle);
         }
 
-        /**
-         * Gets the parameters of the device. Must be called after StartScan().
-         * \param parameters A pointer to the parameter structure to be filled with the device parameters.
-         * \return True if the parameters were successfully retrieved, false otherwise.
-         */
-        bool GetParameters(SANE_Parameters *parameters) const
+        bool GetParameters(SANE_Parameters *parameters) const override
         {
+            WaitForBackgroundTask();
             if (m_Handle == nullptr)
             {
                 return false;
             }
 
-            g_debug("Getting parameters for device %s", m_Device->name);
+            g_debug("Getting parameters for device %s", m_Device.Name.c_str());
 
             auto status = sane_get_parameters(m_Handle, parameters);
             if (status != SANE_STATUS_GOOD)
             {
-                g_debug("Failed to get parameters for device %s: %s", m_Device->name, sane_strstatus(status));
+                g_debug("Failed to get parameters for device %s: %s", m_Device.Name.c_str(), sane_strstatus(status));
                 return false;
             }
 
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <sane/sane.h>
+
+namespace Gorfector
+{
+    /**
+     * \class ScanDevice
+     * \brief The operations of a device used by the scan processes.
+     *
+     * `SaneDevice` implements them with a SANE handle. Tests and benchmarks implement them with a fake device, to run
+     * the scan processes without a scanner. The methods follow the semantics of the corresponding SANE functions.
+     */
+    class ScanDevice
+    {
+    public:
+        virtual ~ScanDevice() = default;
+
+        [[nodiscard]] virtual const SANE_Option_Descriptor *GetOptionDescriptor(uint32_t optionIndex) const = 0;
+
+        virtual bool GetOptionValue(uint32_t optionIndex, void *value) const = 0;
+
+        virtual bool SetOptionValue(uint32_t optionIndex, void *value, int *optionInfo) const = 0;
+
+        /**
+         * \brief Starts the acquisition of a frame.
+         * \return `SANE_STATUS_GOOD` if the scan started, `SANE_STATUS_NO_DOCS` if the document feeder is empty, or
+         * another error status.
+         */
+        virtual SANE_Status StartScan() const = 0;
+
+        /**
+         * \brief Reads image data from the device.
+         * \param buffer The buffer receiving the data.
+         * \param maxLength The size of the buffer.
+         * \param length Receives the number of bytes read, which can be 0 if the device is busy.
+         * \return `SANE_STATUS_GOOD` or `SANE_STATUS_DEVICE_BUSY` if more data can be read, `SANE_STATUS_EOF` at the
+         * end of the frame, or the error that stopped the frame (e.g. `SANE_STATUS_JAMMED`).
+         */
+        virtual SANE_Status Read(SANE_Byte *buffer, SANE_Int maxLength, SANE_Int *length) const = 0;
+
+        virtual void CancelScan() const = 0;
+
+        /**
+         * Gets the parameters of the frame. Must be called after StartScan().
+         * \param parameters A pointer to the parameter structure to be filled with the device parameters.
+         * \return True if the parameters were successfully retrieved, false otherwise.
+         */
+        virtual bool GetParameters(SANE_Parameters *parameters) const = 0;
+    };
+}
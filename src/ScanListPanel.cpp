@@ -312,9 +312,9 @@ void Gorfector::ScanListPanel::OnLoadButtonPressed(GtkButton *button)
 {
     auto listBoxRow = ZooLib::GetParentOfType(GTK_WIDGET(button), GTK_TYPE_LIST_BOX_ROW);
     auto rowId = gtk_list_box_row_get_index(GTK_LIST_BOX_ROW(listBoxRow));
-    auto scannerSettings = m_PanelState->GetScannerSettings(rowId);
+    auto scannerSettings = m_PanelState->GetScannerSettingsSnapshot(rowId);
     auto outputSettings = m_PanelState->GetOutputSettings(rowId);
-    auto scanAreaSettings = m_PanelState->GetScanAreaSettings(rowId);
+    auto scanAreaSettings = m_PanelState->GetScanAreaSnapshot(rowId);
     m_Dispatcher.Dispatch(LoadScanItemCommand(scannerSettings, outputSettings, scanAreaSettings));
 }
 
@@ -352,8 +352,9 @@ void Gorfector::ScanListPanel::Update(const std::vector<uint64_t> &lastSeenVersi
 
     bool forceUpdate = lastSeenVersions[0] == 0;
 
-    auto changeset = m_PanelState->GetAggregatedChangeset(lastSeenVersions[0]);
-    if (!forceUpdate && (changeset == nullptr || !changeset->HasAnyChange()))
+    m_PanelState->AggregateChangesets(lastSeenVersions[0], m_PanelStateChangeset);
+    const auto *changeset = &m_PanelStateChangeset;
+    if (!forceUpdate && !changeset->HasAnyChange())
     {
         return;
     }
@@ -18,6 +18,8 @@ namespace Gorfector
         ZooLib::CommandDispatcher m_Dispatcher{};
 
         ScanListState *m_PanelState{};
+        // Receives the changes of m_PanelState, reused on every update.
+        ScanListStateChangeset m_PanelStateChangeset{0};
         ViewUpdateObserver<ScanListPanel, ScanListState> *m_ViewUpdateObserver{};
         CurrentDeviceObserver<ScanListState> *m_CurrentDeviceObserver;
 
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <algorithm>
 #include <nlohmann/json.hpp>
 #include <vector>
 
 #include "DeviceOptionsState.hpp"
+#include "OptionSnapshot.hpp"
 #include "OutputOptionsState.hpp"
 
 namespace Gorfector
@@ -42,6 +44,12 @@ namespace Gorfector
             m_ChangeType = static_cast<std::underlying_type_t<TypeFlag>>(TypeFlag::None);
         }
 
+        void Reset(uint64_t stateInitialVersion)
+        {
+            ChangesetBase::Reset(stateInitialVersion);
+            Clear();
+        }
+
         void Set(TypeFlag typeFlag, int lastLine = -1)
         {
             m_ChangeType |= static_cast<std::underlying_type_t<TypeFlag>>(typeFlag);
@@ -79,8 +87,6 @@ namespace Gorfector
     public:
         static constexpr const char *k_AddAllParamsKey = "AddAllParams";
         static constexpr const char *k_ScanListsKey = "ScanLists";
-
-    private:
         static constexpr const char *k_ItemIdKey = "Id";
         static constexpr const char *k_ItemScanAreaHumanKey = "ScanAreaHuman";
         static constexpr const char *k_ItemScanAreaUnitsKey = "ScanAreaUnits";
@@ -88,6 +94,8 @@ namespace Gorfector
         static constexpr const char *k_ItemOutputSettingsKey = "OutputSettings";
         static constexpr const char *k_ItemScanAreaSettingsKey = "ScanAreaSettings";
 
+    private:
+
         std::map<std::string, nlohmann::json> m_ScanLists{};
         bool m_AddToScanListButtonAddsAllParams{};
 
@@ -97,6 +105,10 @@ namespace Gorfector
 
         int m_SelectedIndex{-1};
 
+        // Compiled device settings of the items of the current scan list, by item id.
+        mutable OptionSnapshotCache<int> m_ScannerSettingsSnapshots{};
+        mutable OptionSnapshotCache<int> m_ScanAreaSnapshots{};
+
         ZooLib::ChangesetManager<ScanListStateChangeset> m_ChangesetManager{};
 
         friend void to_json(nlohmann::json &j, const ScanListState &state);
@@ -194,6 +206,26 @@ namespace Gorfector
             return nullptr;
         }
 
+        /**
+         * \brief Gets the scanner settings of a scan item, compiled to a snapshot.
+         * \param index The index of the item in the current scan list.
+         * \return The snapshot, or nullptr if the item has no scanner settings.
+         */
+        [[nodiscard]] const OptionSnapshot *GetScannerSettingsSnapshot(size_t index) const
+        {
+            return m_ScannerSettingsSnapshots.Get(GetScanItemId(index), GetScannerSettings(index));
+        }
+
+        /**
+         * \brief Gets the scan area settings of a scan item, compiled to a snapshot.
+         * \param index The index of the item in the current scan list.
+         * \return The snapshot, or nullptr if the item has no scan area settings.
+         */
+        [[nodiscard]] const OptionSnapshot *GetScanAreaSnapshot(size_t index) const
+        {
+            return m_ScanAreaSnapshots.Get(GetScanItemId(index), GetScanAreaSettings(index));
+        }
+
         [[nodiscard]] bool GetAddToScanListButtonAddsAllParams() const
         {
             return m_AddToScanListButtonAddsAllParams;
@@ -214,9 +246,9 @@ namespace Gorfector
             return &m_ChangesetManager;
         }
 
-        [[nodiscard]] ScanListStateChangeset *GetAggregatedChangeset(uint64_t stateComponentVersion) const
+        void AggregateChangesets(uint64_t stateComponentVersion, ScanListStateChangeset &accumulator) const
         {
-            return m_ChangesetManager.GetAggregatedChangeset(stateComponentVersion);
+            m_ChangesetManager.AggregateChangesets(stateComponentVersion, accumulator);
         }
 
         class Updater final : public StateComponent::Updater<ScanListState>
@@ -232,6 +264,41 @@ namespace Gorfector
                 {
                     m_StateComponent->m_CurrentScanList = {};
                 }
+                ClearSnapshots();
+            }
+
+            void ClearSnapshots()
+            {
+                m_StateComponent->m_ScannerSettingsSnapshots.Clear();
+                m_StateComponent->m_ScanAreaSnapshots.Clear();
+            }
+
+            void EraseSnapshots(int itemId)
+            {
+                m_StateComponent->m_ScannerSettingsSnapshots.Erase(itemId);
+                m_StateComponent->m_ScanAreaSnapshots.Erase(itemId);
+            }
+
+            // Items can be reordered, so the last item does not necessarily have the largest id.
+            [[nodiscard]] int GetNextItemId() const
+            {
+                auto itemId = 0;
+                for (const auto &item: m_StateComponent->m_CurrentScanList)
+                {
+                    itemId = std::max(itemId, item[k_ItemIdKey].get<int>());
+                }
+                return itemId + 1;
+            }
+
+            // Adds an item to the current scan list. Its id may have been used by a removed item, so its snapshots
+            // are discarded.
+            void AddItem(nlohmann::json &&scanItem)
+            {
+                EraseSnapshots(scanItem[k_ItemIdKey].get<int>());
+                m_StateComponent->m_CurrentScanList.emplace_back(std::move(scanItem));
+
+                auto changeset = m_StateComponent->GetCurrentChangeset();
+                changeset->Set(ScanListStateChangeset::TypeFlag::ListContent);
             }
 
         public:
@@ -302,44 +369,27 @@ namespace Gorfector
 
             void AddCompleteScanItem(const DeviceOptionsState *deviceOptions, const OutputOptionsState *outputOptions)
             {
-                auto itemId = 1;
-                if (!m_StateComponent->m_CurrentScanList.empty())
-                {
-                    auto lastItem = m_StateComponent->m_CurrentScanList.back();
-                    itemId = lastItem[k_ItemIdKey].get<int>() + 1;
-                }
-
                 std::string scanAreaUnits =
                         deviceOptions->GetScanAreaUnit() == ScanAreaUnit::e_Millimeters ? "mm" : "px";
                 auto scanAreaHuman = deviceOptions->GetScanArea();
                 auto scanItem = nlohmann::json{
-                        {k_ItemIdKey, itemId},
+                        {k_ItemIdKey, GetNextItemId()},
                         {k_ItemScanAreaUnitsKey, scanAreaUnits},
                         {k_ItemScanAreaHumanKey,
                          {scanAreaHuman.MinX(), scanAreaHuman.MinY(), scanAreaHuman.MaxX(), scanAreaHuman.MaxY()}},
                 };
                 to_json(scanItem[k_ItemScannerSettingsKey], *deviceOptions);
                 to_json(scanItem[k_ItemOutputSettingsKey], *outputOptions);
-                m_StateComponent->m_CurrentScanList.emplace_back(std::move(scanItem));
-
-                auto changeset = m_StateComponent->GetCurrentChangeset();
-                changeset->Set(ScanListStateChangeset::TypeFlag::ListContent);
+                AddItem(std::move(scanItem));
             }
 
             void AddScanAreaItem(const DeviceOptionsState *deviceOptions)
             {
-                auto itemId = 1;
-                if (!m_StateComponent->m_CurrentScanList.empty())
-                {
-                    auto lastItem = m_StateComponent->m_CurrentScanList.back();
-                    itemId = lastItem[k_ItemIdKey].get<int>() + 1;
-                }
-
                 std::string scanAreaUnits =
                         deviceOptions->GetScanAreaUnit() == ScanAreaUnit::e_Millimeters ? "mm" : "px";
                 auto scanAreaHuman = deviceOptions->GetScanArea();
                 auto scanItem = nlohmann::json{
-                        {k_ItemIdKey, itemId},
+                        {k_ItemIdKey, GetNextItemId()},
                         {k_ItemScanAreaUnitsKey, scanAreaUnits},
                         {k_ItemScanAreaHumanKey,
                          {scanAreaHuman.MinX(), scanAreaHuman.MinY(), scanAreaHuman.MaxX(), scanAreaHuman.MaxY()}},
@@ -356,16 +406,14 @@ namespace Gorfector
                         {DeviceOptionsState::k_BrxKey, {brx->GetValue()}},
                         {DeviceOptionsState::k_BryKey, {bry->GetValue()}},
                 };
-                m_StateComponent->m_CurrentScanList.emplace_back(std::move(scanItem));
-
-                auto changeset = m_StateComponent->GetCurrentChangeset();
-                changeset->Set(ScanListStateChangeset::TypeFlag::ListContent);
+                AddItem(std::move(scanItem));
             }
 
             void RemoveScanItemAt(size_t index)
             {
                 if (index < m_StateComponent->m_CurrentScanList.size())
                 {
+                    EraseSnapshots(m_StateComponent->GetScanItemId(index));
                     m_StateComponent->m_CurrentScanList.erase(
                             m_StateComponent->m_CurrentScanList.begin() + static_cast<long>(index));
 
@@ -391,6 +439,7 @@ namespace Gorfector
             {
                 m_StateComponent->m_CurrentScanList.clear();
                 m_StateComponent->m_SelectedIndex = -1;
+                ClearSnapshots();
 
                 auto changeset = m_StateComponent->GetCurrentChangeset();
                 changeset->Set(ScanListStateChangeset::TypeFlag::ListContent);
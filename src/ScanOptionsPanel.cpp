@@ -7,6 +7,7 @@
 #include "Commands/SetOutputDestinationCommand.hpp"
 #include "Commands/SetOutputDirectoryCommand.hpp"
 #include "Commands/SetOutputFileNameCommand.hpp"
+#include "Commands/SetUseDocumentFeederCommand.hpp"
 #include "DeviceOptionsState.hpp"
 #include "OptionRewriter.hpp"
 #include "OutputOptionsState.hpp"
@@ -323,15 +324,15 @@ Gorfector::ScanOptionsPanel::ScanOptionsPanel(
     if (m_DeviceName.empty())
         return;
 
-    m_Rewriter = new OptionRewriter(m_App->GetSystemConfigDirectoryPath(), m_App->GetUserConfigDirectoryPath());
+    m_Rewriter = new OptionRewriter();
     auto device = m_App->GetDeviceByName(m_DeviceName);
     if (device != nullptr)
     {
         m_Rewriter->LoadOptionDescriptionFile(
-                m_App->GetUserConfigDirectoryPath(), device->GetVendor(), device->GetModel());
+                *m_App->GetScannerDescriptionIndex(), device->GetVendor(), device->GetModel());
     }
 
-    m_DeviceOptions = new DeviceOptionsState(m_App->GetState(), m_DeviceName);
+    m_DeviceOptions = new DeviceOptionsState(m_App->GetState(), m_DeviceName, m_App->GetDeviceOptionCache());
     m_OutputOptions = new OutputOptionsState(m_App->GetState());
     m_App->GetState()->LoadFromPreferencesFile(m_OutputOptions);
 
@@ -382,6 +383,7 @@ Gorfector::ScanOptionsPanel::~ScanOptionsPanel()
     m_Dispatcher.UnregisterHandler<SetCreateMissingDirectoriesCommand>();
     m_Dispatcher.UnregisterHandler<SetOutputFileNameCommand>();
     m_Dispatcher.UnregisterHandler<SetFileExistsActionCommand>();
+    m_Dispatcher.UnregisterHandler<SetUseDocumentFeederCommand>();
 
     m_App->GetObserverManager()->RemoveObserver(m_OptionUpdateObserver);
     delete m_OptionUpdateObserver;
@@ -512,7 +514,8 @@ enum OutputOptions
     e_OutputDirectory,
     e_CreateMissingDirectories,
     e_OutputFileName,
-    e_FileExistsAction
+    e_FileExistsAction,
+    e_UseDocumentFeeder
 };
 
 void Gorfector::ScanOptionsPanel::AddOutputOptions()
@@ -600,11 +603,23 @@ void Gorfector::ScanOptionsPanel::AddOutputOptions()
             m_IfFileExistsCombo, destination == static_cast<guint>(OutputOptionsState::OutputDestination::e_File));
     AddWidgetToParent(group, m_IfFileExistsCombo);
 
+    m_DocumentFeederSwitch = adw_switch_row_new();
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(m_DocumentFeederSwitch), _("Empty Document Feeder"));
+    adw_action_row_set_subtitle(
+            ADW_ACTION_ROW(m_DocumentFeederSwitch),
+            _("Scan pages until the document feeder is empty. Each page is saved in its own file."));
+    adw_switch_row_set_active(ADW_SWITCH_ROW(m_DocumentFeederSwitch), m_OutputOptions->GetUseDocumentFeeder());
+    g_object_set_data(G_OBJECT(m_DocumentFeederSwitch), "OptionId", GINT_TO_POINTER(e_UseDocumentFeeder));
+    ConnectGtkSignalWithParamSpecs(
+            this, &ScanOptionsPanel::OnCheckBoxChanged, m_DocumentFeederSwitch, "notify::active");
+    AddWidgetToParent(group, m_DocumentFeederSwitch);
+
     m_Dispatcher.RegisterHandler(SetOutputDestinationCommand::Execute, m_OutputOptions);
     m_Dispatcher.RegisterHandler(SetOutputDirectoryCommand::Execute, m_OutputOptions);
     m_Dispatcher.RegisterHandler(SetCreateMissingDirectoriesCommand::Execute, m_OutputOptions);
     m_Dispatcher.RegisterHandler(SetOutputFileNameCommand::Execute, m_OutputOptions);
     m_Dispatcher.RegisterHandler(SetFileExistsActionCommand::Execute, m_OutputOptions);
+    m_Dispatcher.RegisterHandler(SetUseDocumentFeederCommand::Execute, m_OutputOptions);
 }
 
 void OnDirectorySelected(GObject *dialog, GAsyncResult *res, gpointer data)
@@ -832,6 +847,11 @@ void Gorfector::ScanOptionsPanel::OnCheckBoxChanged(GtkWidget *widget)
                 m_Dispatcher.Dispatch(SetCreateMissingDirectoriesCommand(isChecked));
                 break;
             }
+            case e_UseDocumentFeeder:
+            {
+                m_Dispatcher.Dispatch(SetUseDocumentFeederCommand(isChecked));
+                break;
+            }
             default:
                 break;
         }
@@ -1120,7 +1140,8 @@ void Gorfector::ScanOptionsPanel::SelectPage(Page page)
 void Gorfector::ScanOptionsPanel::Update(const std::vector<uint64_t> &lastSeenVersions)
 {
     auto firstChangesetVersion = m_DeviceOptions->FirstChangesetVersion();
-    auto deviceOptionsChangeset = m_DeviceOptions->GetAggregatedChangeset(lastSeenVersions[0]);
+    m_DeviceOptions->AggregateChangesets(lastSeenVersions[0], m_DeviceOptionsChangeset);
+    const auto *deviceOptionsChangeset = &m_DeviceOptionsChangeset;
 
     if (lastSeenVersions[1] < m_OutputOptions->GetVersion())
     {
@@ -1146,6 +1167,8 @@ void Gorfector::ScanOptionsPanel::Update(const std::vector<uint64_t> &lastSeenVe
         adw_combo_row_set_selected(ADW_COMBO_ROW(m_IfFileExistsCombo), selectedAction);
         gtk_widget_set_visible(
                 m_IfFileExistsCombo, destination == static_cast<guint>(OutputOptionsState::OutputDestination::e_File));
+
+        adw_switch_row_set_active(ADW_SWITCH_ROW(m_DocumentFeederSwitch), m_OutputOptions->GetUseDocumentFeeder());
     }
 
     if ((firstChangesetVersion != std::numeric_limits<uint64_t>::max() &&
@@ -1261,37 +1284,39 @@ void Gorfector::ScanOptionsPanel::Update(const std::vector<uint64_t> &lastSeenVe
         }
     }
 
-    auto appChangeset = m_App->GetAppState()->GetAggregatedChangeset(lastSeenVersions[2]);
-    if (appChangeset != nullptr)
+    m_App->GetAppState()->AggregateChangesets(lastSeenVersions[2], m_AppChangeset);
+    const auto *appChangeset = &m_AppChangeset;
+    if (appChangeset->IsChanged(AppStateChangeset::ChangeTypeFlag::e_ScanActivity))
     {
-        if (appChangeset->IsChanged(AppStateChangeset::ChangeTypeFlag::e_ScanActivity))
-        {
-            bool isScanning = m_App->GetAppState()->IsScanning() || m_App->GetAppState()->IsPreviewing();
+        bool isScanning = m_App->GetAppState()->IsScanning() || m_App->GetAppState()->IsPreviewing();
 
-            gtk_widget_set_sensitive(m_DestinationCombo, !isScanning);
-            if (m_LocationEntryRow != nullptr)
-            {
-                gtk_widget_set_sensitive(m_LocationEntryRow, !isScanning);
-            }
-            if (m_CreateDirSwitch != nullptr)
-            {
-                gtk_widget_set_sensitive(m_CreateDirSwitch, !isScanning);
-            }
-            if (m_FileNameEntry != nullptr)
-            {
-                gtk_widget_set_sensitive(m_FileNameEntry, !isScanning);
-            }
-            if (m_IfFileExistsCombo != nullptr)
-            {
-                gtk_widget_set_sensitive(m_IfFileExistsCombo, !isScanning);
-            }
+        gtk_widget_set_sensitive(m_DestinationCombo, !isScanning);
+        if (m_LocationEntryRow != nullptr)
+        {
+            gtk_widget_set_sensitive(m_LocationEntryRow, !isScanning);
+        }
+        if (m_CreateDirSwitch != nullptr)
+        {
+            gtk_widget_set_sensitive(m_CreateDirSwitch, !isScanning);
+        }
+        if (m_FileNameEntry != nullptr)
+        {
+            gtk_widget_set_sensitive(m_FileNameEntry, !isScanning);
+        }
+        if (m_IfFileExistsCombo != nullptr)
+        {
+            gtk_widget_set_sensitive(m_IfFileExistsCombo, !isScanning);
+        }
+        if (m_DocumentFeederSwitch != nullptr)
+        {
+            gtk_widget_set_sensitive(m_DocumentFeederSwitch, !isScanning);
+        }
 
-            for (auto &widget: m_Widgets | std::views::values)
+        for (auto &widget: m_Widgets | std::views::values)
+        {
+            if (widget != nullptr)
             {
-                if (widget != nullptr)
-                {
-                    gtk_widget_set_sensitive(widget, !isScanning);
-                }
+                gtk_widget_set_sensitive(widget, !isScanning);
             }
         }
     }
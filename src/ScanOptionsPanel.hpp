@@ -35,6 +35,10 @@ namespace Gorfector
         DeviceOptionsState *m_DeviceOptions;
         OutputOptionsState *m_OutputOptions;
 
+        // Receive the changes of the observed states, reused on every update.
+        DeviceOptionsStateChangeset m_DeviceOptionsChangeset{0};
+        AppStateChangeset m_AppChangeset{0};
+
         ZooLib::CommandDispatcher m_Dispatcher;
 
         GtkWidget *m_RootWidget{};
@@ -52,6 +56,7 @@ namespace Gorfector
         GtkWidget *m_CreateDirSwitch{};
         GtkWidget *m_FileNameEntry{};
         GtkWidget *m_IfFileExistsCombo{};
+        GtkWidget *m_DocumentFeederSwitch{};
 
         static std::string SaneIntOrFixedToString(int value, const DeviceOptionValueBase *option);
         static const char *SaneUnitToString(SANE_Unit unit);
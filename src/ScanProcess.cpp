@@ -7,11 +7,37 @@ static void DestroyProcess(gpointer data)
     delete scanProcess;
 }
 
+static gboolean DispatchUpdateSource(GSource *source, GSourceFunc callback, gpointer data)
+{
+    // Disarm the source before calling `Update()`, so that wake ups sent while it runs are not lost.
+    g_source_set_ready_time(source, -1);
+    return callback(data);
+}
+
+void Gorfector::ScanProcess::InstallUpdateSource(GSourceFunc update, GDestroyNotify destroyNotify)
+{
+    static GSourceFuncs s_UpdateSourceFuncs = []() {
+        GSourceFuncs funcs{};
+        funcs.dispatch = DispatchUpdateSource;
+        return funcs;
+    }();
+
+    m_UpdateSource = g_source_new(&s_UpdateSourceFuncs, sizeof(GSource));
+    g_source_set_name(m_UpdateSource, "Gorfector scan update");
+    // Below redraw priority: the main loop keeps the UI responsive and updates are coalesced while it is busy.
+    g_source_set_priority(m_UpdateSource, G_PRIORITY_DEFAULT_IDLE);
+    g_source_set_callback(m_UpdateSource, update, this, destroyNotify);
+    // The first dispatch starts the reader thread.
+    g_source_set_ready_time(m_UpdateSource, 0);
+    g_source_attach(m_UpdateSource, nullptr);
+    // The main context owns the source from now on.
+    g_source_unref(m_UpdateSource);
+}
+
 void Gorfector::ScanProcess::InstallGtkCallback()
 {
-    m_ScanCallbackId = gtk_widget_add_tick_callback(
-            m_MainWindow,
-            [](GtkWidget *widget, GdkFrameClock *frameClock, gpointer data) -> gboolean {
+    InstallUpdateSource(
+            [](gpointer data) -> gboolean {
                 auto *scanProcess = static_cast<ScanProcess *>(data);
                 if (scanProcess->Update())
                 {
@@ -21,5 +47,5 @@ void Gorfector::ScanProcess::InstallGtkCallback()
                 scanProcess->Stop(false);
                 return G_SOURCE_REMOVE;
             },
-            this, DestroyProcess);
+            DestroyProcess);
 }
@@ -1,14 +1,22 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <future>
 #include <gtk/gtk.h>
-#include <list>
+#include <memory>
+#include <span>
+#include <string>
 #include <thread>
 
 #include "AppState.hpp"
 #include "DeviceOptionsState.hpp"
 #include "OutputOptionsState.hpp"
 #include "PreviewState.hpp"
+#include "ScanDevice.hpp"
 #include "ZooLib/ErrorDialog.hpp"
+#include "ZooLib/SpscRingBuffer.hpp"
+#include "ZooLib/ThreadPool.hpp"
 
 namespace Gorfector
 {
@@ -17,178 +25,203 @@ namespace Gorfector
     protected:
         class ScanThread
         {
-            const SaneDevice *m_Device;
-            size_t m_ImageSize;
-            const size_t m_ChunkSize{};
-
-            std::list<SANE_Byte *> m_FreeChunks{};
-            std::list<SANE_Byte *> m_UsedChunks{};
+            /// Upper bound of the memory used to hold data read from the device but not yet processed.
+            static constexpr size_t k_MaxBufferSize = 16 * 1024 * 1024;
 
-            std::list<SANE_Byte *>::iterator m_CurrentWriteChunk{};
-            size_t m_WritePos{}; // 0 - m_ChunkSize
+            const ScanDevice *m_Device;
+            size_t m_ImageSize;
+            std::function<void()> m_OnDataAvailable;
 
-            std::list<SANE_Byte *>::iterator m_CurrentReadChunk{};
-            size_t m_ReadPos{}; // 0 - m_ChunkSize
+            // The capacity is a whole number of lines, so a line never wraps around the end of the ring and the
+            // reader always gets complete lines in a single span.
+            std::unique_ptr<ZooLib::SpscRingBuffer<SANE_Byte>> m_Buffer;
 
-            size_t m_TotalBytesWritten{}; // 0 - m_ImageSize
-            size_t m_TotalBytesRead{}; // 0 - m_ImageSize
+            std::atomic<bool> m_AbortRequested{};
+            std::atomic<bool> m_Finished{};
+            // Published by m_Finished.
+            SANE_Status m_ReadError{SANE_STATUS_GOOD};
 
-            bool m_AbortRequested{};
-            bool m_Finished{};
+            std::thread m_Thread{};
+            std::future<void> m_Task{};
 
-            std::mutex m_Mutex{};
+            static size_t ComputeBufferSize(size_t imageSize, size_t bytesPerLine)
+            {
+                bytesPerLine = std::max(bytesPerLine, static_cast<size_t>(1));
+                auto lines = std::max(std::min(imageSize, k_MaxBufferSize) / bytesPerLine, static_cast<size_t>(1));
+                return lines * bytesPerLine;
+            }
 
-        public:
-            ScanThread(const SaneDevice *device, size_t imageSize)
-                : m_Device(device)
-                , m_ImageSize(imageSize)
-                , m_ChunkSize(std::min(imageSize, static_cast<size_t>(2 * 1024 * 1024)))
+            void Run()
             {
-                auto chunk = new SANE_Byte[m_ChunkSize];
-                m_UsedChunks.push_back(chunk);
+                auto done = false;
+                while (!done && !m_AbortRequested.load(std::memory_order_relaxed))
+                {
+                    auto writeSpan = m_Buffer->GetWriteSpan();
+                    if (writeSpan.empty())
+                    {
+                        // The reader is behind: wait for it to release some space.
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                        continue;
+                    }
 
-                m_CurrentWriteChunk = m_UsedChunks.begin();
-                m_WritePos = 0;
+                    SANE_Int readLength = 0;
+                    SANE_Int maxLength = static_cast<SANE_Int>(
+                            std::min(writeSpan.size(), static_cast<size_t>(std::numeric_limits<SANE_Int>::max())));
+                    auto status = m_Device->Read(writeSpan.data(), maxLength, &readLength);
+                    done = status != SANE_STATUS_GOOD && status != SANE_STATUS_DEVICE_BUSY;
+                    if (done && status != SANE_STATUS_EOF)
+                    {
+                        // The frame is incomplete (e.g. a paper jam).
+                        m_ReadError = status;
+                    }
 
-                m_CurrentReadChunk = m_UsedChunks.begin();
-                m_ReadPos = 0;
+                    if (readLength > 0)
+                    {
+                        m_Buffer->CommitWrite(readLength);
+                        m_OnDataAvailable();
+                    }
+                    else if (!done)
+                    {
+                        // The device is busy: do not spin on it.
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                }
+
+                m_Finished.store(true, std::memory_order_release);
+                m_OnDataAvailable();
             }
 
-            ~ScanThread()
+        public:
+            using Buffer = ZooLib::SpscRingBuffer<SANE_Byte>;
+
+            /**
+             * \param onDataAvailable Called from the reader thread each time data is added to the buffer, and once
+             * when the thread finishes. Used to wake up the consumer.
+             * \param recycledBuffer The buffer of a previous scan thread, reused if it has the right size.
+             */
+            ScanThread(
+                    const ScanDevice *device, size_t imageSize, size_t bytesPerLine,
+                    std::function<void()> onDataAvailable, std::unique_ptr<Buffer> recycledBuffer = nullptr)
+                : m_Device(device)
+                , m_ImageSize(imageSize)
+                , m_OnDataAvailable(std::move(onDataAvailable))
             {
-                for (auto buffer: m_FreeChunks)
+                auto bufferSize = ComputeBufferSize(imageSize, bytesPerLine);
+                if (recycledBuffer != nullptr && recycledBuffer->GetCapacity() == bufferSize)
                 {
-                    delete[] buffer;
+                    recycledBuffer->Reset();
+                    m_Buffer = std::move(recycledBuffer);
                 }
-                m_FreeChunks.clear();
-
-                for (auto buffer: m_UsedChunks)
+                else
                 {
-                    delete[] buffer;
+                    m_Buffer = std::make_unique<Buffer>(bufferSize);
                 }
-                m_UsedChunks.clear();
             }
 
-            /// \returns true if there is still data to read
-            bool Copy(SANE_Byte *destBuffer, size_t maxLength, size_t &readLength)
+            ~ScanThread()
             {
-                if (destBuffer == nullptr || maxLength <= 0)
-                {
-                    readLength = 0;
-                    return !m_Finished || m_TotalBytesRead < m_TotalBytesWritten;
-                }
+                RequestAbort();
+                Join();
+            }
 
-                std::lock_guard lock(m_Mutex);
+            ScanThread(const ScanThread &) = delete;
+            ScanThread &operator=(const ScanThread &) = delete;
 
-                if (m_CurrentReadChunk == m_UsedChunks.end())
-                {
-                    m_CurrentReadChunk = m_UsedChunks.begin(); // if empty, == end()
-                    m_ReadPos = 0;
-                }
-
-                if (m_CurrentReadChunk == m_UsedChunks.end())
+            /**
+             * \param threadPool If not null, the data is read on one of its threads instead of a new thread.
+             */
+            void Start(ZooLib::ThreadPool *threadPool = nullptr)
+            {
+                if (m_ImageSize <= 0)
                 {
-                    // No data to read for now
-                    readLength = 0;
-                    return !m_Finished || m_TotalBytesRead < m_TotalBytesWritten;
+                    m_Finished.store(true, std::memory_order_release);
+                    m_OnDataAvailable();
+                    return;
                 }
 
-                auto dataAvailable = 0uz;
-                if (m_CurrentWriteChunk == m_CurrentReadChunk)
+                if (threadPool != nullptr)
                 {
-                    dataAvailable = m_WritePos - m_ReadPos;
+                    m_Task = threadPool->Submit([this]() { Run(); });
                 }
                 else
                 {
-                    dataAvailable = m_ChunkSize - m_ReadPos;
+                    m_Thread = std::thread(&ScanThread::Run, this);
                 }
+            }
 
-                readLength = std::min(maxLength, dataAvailable);
-                if (readLength > 0)
+            void Join()
+            {
+                if (m_Thread.joinable())
                 {
-                    std::memcpy(destBuffer, *m_CurrentReadChunk + m_ReadPos, readLength);
-                    m_ReadPos += readLength;
-                    m_TotalBytesRead += readLength;
+                    m_Thread.join();
                 }
 
-                if (m_ReadPos == m_ChunkSize)
+                if (m_Task.valid())
                 {
-                    m_FreeChunks.push_back(*m_CurrentReadChunk);
-                    m_CurrentReadChunk = m_UsedChunks.erase(m_CurrentReadChunk);
-                    m_ReadPos = 0;
+                    m_Task.get();
                 }
-
-                return !m_Finished || m_TotalBytesRead < m_TotalBytesWritten;
             }
 
-            [[nodiscard]] bool Finished() const
+            /**
+             * \brief Gets the data read from the device and not yet released, without copying it.
+             * \param outData Receives a span into the scan buffer. It stays valid until `Release()` is called.
+             * \returns true if there is still data to read
+             */
+            bool Peek(std::span<SANE_Byte> &outData)
             {
-                return m_Finished;
+                // Check m_Finished before looking at the buffer: once the reader thread is finished, everything it
+                // has written is visible.
+                auto finished = m_Finished.load(std::memory_order_acquire);
+                outData = m_Buffer->GetReadSpan();
+                return !finished || !outData.empty();
             }
 
-            void RequestAbort()
+            /**
+             * \brief Gives back to the reader thread the first bytes of the span returned by `Peek()`.
+             * \param length The number of bytes that were processed.
+             */
+            void Release(size_t length)
             {
-                m_AbortRequested = true;
+                m_Buffer->CommitRead(length);
             }
 
-            void operator()()
+            [[nodiscard]] bool Finished() const
             {
-                if (m_CurrentWriteChunk == m_UsedChunks.end() || m_ImageSize <= 0)
-                {
-                    return;
-                }
+                return m_Finished.load(std::memory_order_acquire);
+            }
 
-                auto done = false;
-                while (!done && !m_AbortRequested)
-                {
-                    SANE_Int readLength = 0;
-                    SANE_Int maxLength = static_cast<SANE_Int>(std::min(
-                            m_ChunkSize - m_WritePos, static_cast<size_t>(std::numeric_limits<SANE_Int>::max())));
-                    done = !m_Device->Read(*m_CurrentWriteChunk + m_WritePos, maxLength, &readLength);
+            /**
+             * \brief The error that stopped the reading before the end of the frame, or `SANE_STATUS_GOOD`. Only valid
+             * once `Finished()` returns true.
+             */
+            [[nodiscard]] SANE_Status GetReadError() const
+            {
+                return m_ReadError;
+            }
 
-                    {
-                        std::lock_guard lock(m_Mutex);
-
-                        m_WritePos += readLength;
-                        m_TotalBytesWritten += readLength;
-
-                        if (m_WritePos == m_ChunkSize)
-                        {
-                            m_WritePos = 0;
-                            m_CurrentWriteChunk = std::next(m_CurrentWriteChunk);
-
-                            if (m_CurrentWriteChunk == m_UsedChunks.end())
-                            {
-                                if (m_FreeChunks.empty())
-                                {
-                                    auto newChunk = new SANE_Byte[m_ChunkSize];
-                                    m_UsedChunks.push_back(newChunk);
-                                    m_CurrentWriteChunk = std::prev(m_UsedChunks.end());
-                                }
-                                else
-                                {
-                                    m_CurrentWriteChunk = m_FreeChunks.begin();
-                                    m_UsedChunks.push_back(*m_CurrentWriteChunk);
-                                    m_FreeChunks.erase(m_CurrentWriteChunk);
-                                    m_CurrentWriteChunk = std::prev(m_UsedChunks.end());
-                                }
-                            }
-                        }
-                    }
-                }
+            void RequestAbort()
+            {
+                m_AbortRequested.store(true, std::memory_order_relaxed);
+            }
 
-                m_Finished = true;
+            /**
+             * \brief Takes the buffer away from the thread, to give it to the scan thread of the next frame. The
+             * thread must be joined and its data no longer used.
+             */
+            std::unique_ptr<Buffer> TakeBuffer()
+            {
+                return std::move(m_Buffer);
             }
         };
 
-        SaneDevice *m_Device;
+        ScanDevice *m_Device;
         AppState *m_AppState;
         PreviewState *m_PreviewState;
         DeviceOptionsState *m_ScanOptions;
         OutputOptionsState *m_OutputOptions;
         GtkWidget *m_MainWindow;
         const std::function<void()> *m_FinishCallback;
-        guint m_ScanCallbackId{};
+        GSource *m_UpdateSource{};
         SANE_Parameters m_ScanParameters{};
         ScanThread *m_ScanThread{};
 
@@ -199,53 +232,129 @@ namespace Gorfector
 
         virtual void InstallGtkCallback();
 
+        /**
+         * \brief Attaches to the main context a source that calls `update` each time `WakeUp()` is called. Several
+         * calls to `WakeUp()` made before the source is dispatched result in a single call to `update`.
+         * \param update Called on the main thread. Returns `G_SOURCE_REMOVE` to destroy the source.
+         * \param destroyNotify Called with `this` when the source is destroyed.
+         */
+        void InstallUpdateSource(GSourceFunc update, GDestroyNotify destroyNotify);
+
+        /**
+         * \brief Schedules a call to `Update()` on the main thread. Can be called from any thread.
+         */
+        void WakeUp() const
+        {
+            g_source_set_ready_time(m_UpdateSource, 0);
+        }
+
+        ScanThread *CreateScanThread(
+                std::function<void()> onDataAvailable,
+                std::unique_ptr<ScanThread::Buffer> recycledBuffer = nullptr) const
+        {
+            auto imageSize = static_cast<size_t>(m_ScanParameters.bytes_per_line) * m_ScanParameters.lines;
+            return new ScanThread(
+                    m_Device, imageSize, m_ScanParameters.bytes_per_line, std::move(onDataAvailable),
+                    std::move(recycledBuffer));
+        }
+
         virtual bool AfterStartScanChecks()
         {
             return true;
         }
 
-        virtual bool Update()
+        /**
+         * \brief Reports an error to the user. Processes running without a main window override it.
+         * \param message The translated error message.
+         */
+        virtual void ShowError(const std::string &message)
         {
-            if (m_ScanThread == nullptr)
-            {
-                auto bufferSize = static_cast<size_t>(m_ScanParameters.bytes_per_line) * m_ScanParameters.lines;
-                m_ScanThread = new ScanThread(m_Device, bufferSize);
-                auto t(std::thread(std::ref(*m_ScanThread)));
-                t.detach();
+            ZooLib::ShowUserError(ADW_APPLICATION_WINDOW(m_MainWindow), message);
+        }
 
+        /**
+         * \brief Reports the error that stopped the reading of the current frame, if any. The scan thread must be
+         * finished.
+         * \return False if the frame is incomplete.
+         */
+        bool CheckReadError()
+        {
+            auto status = m_ScanThread->GetReadError();
+            if (status == SANE_STATUS_GOOD)
+            {
                 return true;
             }
 
-            size_t readLength = 0;
-            SANE_Byte *readBuffer = nullptr;
-            size_t maxReadLength = 0;
-            GetBuffer(readBuffer, maxReadLength);
+            ShowError(std::string(_("Failed to read from the device: ")) + sane_strstatus(status) + ".");
+            return false;
+        }
 
-            if (readBuffer == nullptr || maxReadLength <= 0)
+        /**
+         * \brief Called on the main thread each time bytes of the current frame are processed.
+         * \param length The number of bytes processed since the last call.
+         */
+        virtual void IncreaseProgress(size_t length)
+        {
+            if (m_PreviewState != nullptr && length > 0)
             {
-                return false;
+                auto previewPanelUpdater = PreviewState::Updater(m_PreviewState);
+                previewPanelUpdater.IncreaseProgress(length);
             }
-
-            bool continueScan = m_ScanThread->Copy(readBuffer, maxReadLength, readLength);
-            CommitBuffer(readLength);
-            return continueScan;
         }
 
-        virtual void GetBuffer(SANE_Byte *&outBuffer, size_t &outMaxReadLength)
+        virtual bool Update()
         {
-            outBuffer = nullptr;
-            outMaxReadLength = 0;
-        }
+            if (m_ScanThread == nullptr)
+            {
+                m_ScanThread = CreateScanThread([this]() { WakeUp(); });
+                m_ScanThread->Start();
 
-        virtual void CommitBuffer(size_t readLength)
-        {
-            if (m_PreviewState != nullptr)
+                return true;
+            }
+
+            // Consume everything available: the reader thread only wakes us up again when it adds more data.
+            while (true)
             {
-                auto previewPanelUpdater = PreviewState::Updater(m_PreviewState);
-                previewPanelUpdater.IncreaseProgress(readLength);
+                std::span<SANE_Byte> data;
+                bool continueScan = m_ScanThread->Peek(data);
+                if (data.empty())
+                {
+                    if (!continueScan)
+                    {
+                        CheckReadError();
+                    }
+                    return continueScan;
+                }
+
+                auto consumedLength = ConsumeBytes(data.data(), data.size());
+                m_ScanThread->Release(consumedLength);
+
+                if (consumedLength == 0)
+                {
+                    // The remaining bytes cannot be used yet (e.g. an incomplete last line). If no more data will
+                    // come, the scan is over.
+                    if (m_ScanThread->Finished())
+                    {
+                        CheckReadError();
+                        return false;
+                    }
+                    return true;
+                }
             }
         }
 
+        /**
+         * \brief Processes bytes read from the device.
+         * \param bytes Pointer into the scan buffer. The bytes can be modified in place.
+         * \param length Number of bytes available.
+         * \return The number of bytes processed. Unprocessed bytes are presented again on the next update.
+         */
+        virtual size_t ConsumeBytes(SANE_Byte *bytes, size_t length)
+        {
+            IncreaseProgress(length);
+            return length;
+        }
+
         virtual void Stop(bool canceled)
         {
             if (m_PreviewState != nullptr)
@@ -257,10 +366,7 @@ namespace Gorfector
             if (m_ScanThread != nullptr)
             {
                 m_ScanThread->RequestAbort();
-                while (!m_ScanThread->Finished())
-                {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
+                m_ScanThread->Join();
                 delete m_ScanThread;
                 m_ScanThread = nullptr;
             }
@@ -271,9 +377,54 @@ namespace Gorfector
             }
         }
 
+        /**
+         * \brief Starts the acquisition of a frame on the device and gets its parameters. Errors are reported with
+         * `ShowError()`; the caller stops the process on failure.
+         * \param isFeederEmpty If not null, receives whether the frame did not start because the document feeder is
+         * empty. No error is reported in this case.
+         */
+        bool StartFrame(bool *isFeederEmpty = nullptr)
+        {
+            if (auto status = m_Device->StartScan(); status != SANE_STATUS_GOOD)
+            {
+                if (status == SANE_STATUS_NO_DOCS && isFeederEmpty != nullptr)
+                {
+                    *isFeederEmpty = true;
+                }
+                else if (status == SANE_STATUS_NO_DOCS)
+                {
+                    ShowError(_("Failed to start scan: the document feeder is empty."));
+                }
+                else
+                {
+                    ShowError(_("Failed to start scan."));
+                }
+                return false;
+            }
+
+            if (!m_Device->GetParameters(&m_ScanParameters))
+            {
+                ShowError(_("Failed to start scan: cannot get parameters."));
+                return false;
+            }
+
+            // `AfterStartScanChecks()` shows its own errors.
+            return AfterStartScanChecks();
+        }
+
+        void InitProgress()
+        {
+            if (m_PreviewState != nullptr)
+            {
+                auto bufferSize = static_cast<size_t>(m_ScanParameters.bytes_per_line) * m_ScanParameters.lines;
+                auto previewPanelUpdater = PreviewState::Updater(m_PreviewState);
+                previewPanelUpdater.InitProgress(GetProgressString(), 0UL, bufferSize);
+            }
+        }
+
     public:
         ScanProcess(
-                SaneDevice *device, PreviewState *previewState, AppState *appState, DeviceOptionsState *scanOptions,
+                ScanDevice *device, PreviewState *previewState, AppState *appState, DeviceOptionsState *scanOptions,
                 OutputOptionsState *outputOptions, GtkWidget *mainWindow, const std::function<void()> *finishCallback)
             : m_Device(device)
             , m_AppState(appState)
@@ -292,36 +443,14 @@ namespace Gorfector
 
         virtual bool Start()
         {
-            if (!m_Device->StartScan())
-            {
-                Stop(true);
-                ZooLib::ShowUserError(ADW_APPLICATION_WINDOW(m_MainWindow), _("Failed to start scan."));
-                return false;
-            }
-
-            if (!m_Device->GetParameters(&m_ScanParameters))
-            {
-                Stop(true);
-                ZooLib::ShowUserError(
-                        ADW_APPLICATION_WINDOW(m_MainWindow), _("Failed to start scan: cannot get parameters."));
-                return false;
-            }
-
-            if (!AfterStartScanChecks())
+            if (!StartFrame())
             {
                 Stop(true);
-                // `AfterStartScanChecks()` already shows an error dialog
                 return false;
             }
 
-            auto bufferSize = static_cast<size_t>(m_ScanParameters.bytes_per_line) * m_ScanParameters.lines;
             InstallGtkCallback();
-
-            if (m_PreviewState != nullptr)
-            {
-                auto previewPanelUpdater = PreviewState::Updater(m_PreviewState);
-                previewPanelUpdater.InitProgress(GetProgressString(), 0UL, bufferSize);
-            }
+            InitProgress();
 
             return true;
         }
@@ -330,12 +459,12 @@ namespace Gorfector
         {
             Stop(true);
 
-            if (m_ScanCallbackId != 0)
+            if (m_UpdateSource != nullptr)
             {
-                auto scanCallbackId = m_ScanCallbackId;
-                m_ScanCallbackId = 0;
+                auto updateSource = m_UpdateSource;
+                m_UpdateSource = nullptr;
 
-                gtk_widget_remove_tick_callback(GTK_WIDGET(m_MainWindow), scanCallbackId);
+                g_source_destroy(updateSource);
                 // `this` is now deleted (by DestroyProcess()).
             }
         }
@@ -1,25 +1,339 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <format>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
 #include "ScanProcess.hpp"
 #include "Writers/FileWriter.hpp"
+#include "ZooLib/PathUtils.hpp"
+#include "ZooLib/Profiler.hpp"
+#include "ZooLib/ThreadPool.hpp"
 
 namespace Gorfector
 {
     class SingleScanProcess : public ScanProcess
     {
     protected:
+        /**
+         * Consumes the data read by a `ScanThread` and feeds it to a `FileWriter`, so that image encoding does not
+         * run on the main thread. The scan thread ring buffer is the bounded queue between the two threads: when
+         * encoding falls behind, the ring fills up and the scan thread waits. The scan thread wakes the encoder
+         * thread up through `NotifyDataAvailable()`. The number of bytes encoded is published through an atomic
+         * counter; the main thread is woken up to update the progress. When all the data is encoded, the encoder
+         * thread also closes the file, so that the main thread can start the next scan meanwhile. If the writer
+         * fails to write some lines, the rest of the data is discarded and the file is canceled.
+         */
+        class EncoderThread
+        {
+            static inline const ZooLib::Profiler::Metric s_AppendTime{
+                    "writer.append_bytes.time", ZooLib::Profiler::Unit::e_Nanoseconds};
+            static inline const ZooLib::Profiler::Metric s_AppendSize{
+                    "writer.append_bytes.bytes", ZooLib::Profiler::Unit::e_Bytes};
+
+            ScanThread *m_Source;
+            FileWriter *m_FileWriter;
+            SANE_Parameters m_Parameters;
+            std::function<void()> m_OnProgress;
+
+            std::mutex m_WakeUpMutex{};
+            std::condition_variable m_WakeUpCondition{};
+            bool m_WakeUpRequested{};
+
+            std::atomic<size_t> m_EncodedBytes{};
+            std::atomic<bool> m_AbortRequested{};
+            std::atomic<bool> m_Finished{};
+            uint64_t m_WrittenLines{};
+            bool m_HasWriteFailed{};
+            bool m_IsFileClosed{};
+            FileWriter::Error m_CloseError{};
+
+            std::future<void> m_Task{};
+
+            void Run()
+            {
+                while (!m_AbortRequested.load(std::memory_order_relaxed))
+                {
+                    std::span<SANE_Byte> data;
+                    bool moreData = m_Source->Peek(data);
+                    if (data.empty())
+                    {
+                        if (!moreData)
+                        {
+                            break;
+                        }
+
+                        // The scan thread is behind: wait for it to read more data.
+                        WaitForData();
+                        continue;
+                    }
+
+                    auto consumedLength = EncodeLines(data.data(), data.size());
+                    m_Source->Release(consumedLength);
+                    m_EncodedBytes.fetch_add(consumedLength, std::memory_order_relaxed);
+                    m_OnProgress();
+
+                    if (consumedLength == 0 && m_Source->Finished())
+                    {
+                        // The remaining bytes cannot be used (e.g. an incomplete last line) and no more data will come.
+                        break;
+                    }
+                }
+
+                // The main thread cancels the file of an incomplete frame.
+                if (!m_AbortRequested.load(std::memory_order_relaxed) &&
+                    m_Source->GetReadError() == SANE_STATUS_GOOD)
+                {
+                    if (m_HasWriteFailed)
+                    {
+                        m_FileWriter->CancelFile();
+                        m_CloseError = FileWriter::Error::CannotWriteFile;
+                    }
+                    else
+                    {
+                        m_CloseError = m_FileWriter->CloseFile();
+                    }
+                    m_IsFileClosed = true;
+                }
+
+                m_Finished.store(true, std::memory_order_release);
+                m_OnProgress();
+            }
+
+            void WaitForData()
+            {
+                std::unique_lock lock(m_WakeUpMutex);
+                m_WakeUpCondition.wait(lock, [this]() { return m_WakeUpRequested; });
+                m_WakeUpRequested = false;
+            }
+
+            void WakeUp()
+            {
+                {
+                    std::lock_guard lock(m_WakeUpMutex);
+                    m_WakeUpRequested = true;
+                }
+                m_WakeUpCondition.notify_one();
+            }
+
+            size_t EncodeLines(SANE_Byte *bytes, size_t length)
+            {
+                auto availableLines = length / m_Parameters.bytes_per_line;
+                if (availableLines == 0)
+                {
+                    // Wait for a complete line.
+                    return 0;
+                }
+
+                if (m_HasWriteFailed)
+                {
+                    // The file will be canceled: discard the data, so that the scan thread is not blocked.
+                    return availableLines * m_Parameters.bytes_per_line;
+                }
+
+                size_t savedBytes;
+                {
+                    ZooLib::Profiler::ScopedTimer timer(s_AppendTime);
+                    savedBytes = m_FileWriter->AppendBytes(bytes, availableLines, m_Parameters);
+                }
+                s_AppendSize.Record(savedBytes);
+                m_WrittenLines += savedBytes / m_Parameters.bytes_per_line;
+
+                if (savedBytes == 0)
+                {
+                    // Writers also return 0 on error: only discard the extra data if the writer has all its lines.
+                    if (m_Parameters.lines < 0 || m_WrittenLines < static_cast<uint64_t>(m_Parameters.lines))
+                    {
+                        m_HasWriteFailed = true;
+                    }
+                    savedBytes = availableLines * m_Parameters.bytes_per_line;
+                }
+
+                return savedBytes;
+            }
+
+        public:
+            /**
+             * \param onProgress Called from the encoder thread each time bytes are encoded, and once when the thread
+             * finishes.
+             */
+            EncoderThread(
+                    ScanThread *source, FileWriter *fileWriter, const SANE_Parameters &parameters,
+                    std::function<void()> onProgress)
+                : m_Source(source)
+                , m_FileWriter(fileWriter)
+                , m_Parameters(parameters)
+                , m_OnProgress(std::move(onProgress))
+            {
+            }
+
+            ~EncoderThread()
+            {
+                RequestAbort();
+                Join();
+            }
+
+            EncoderThread(const EncoderThread &) = delete;
+            EncoderThread &operator=(const EncoderThread &) = delete;
+
+            /**
+             * \param threadPool The pool running the encoding.
+             */
+            void Start(ZooLib::ThreadPool &threadPool)
+            {
+                if (m_Parameters.bytes_per_line <= 0)
+                {
+                    m_Finished.store(true, std::memory_order_release);
+                    m_OnProgress();
+                    return;
+                }
+
+                m_Task = threadPool.Submit([this]() { Run(); });
+            }
+
+            void Join()
+            {
+                if (m_Task.valid())
+                {
+                    m_Task.get();
+                }
+            }
+
+            /**
+             * \brief Wakes the encoder thread up when new data is available in the source. Can be called from any
+             * thread.
+             */
+            void NotifyDataAvailable()
+            {
+                WakeUp();
+            }
+
+            [[nodiscard]] size_t GetEncodedBytes() const
+            {
+                return m_EncodedBytes.load(std::memory_order_relaxed);
+            }
+
+            [[nodiscard]] bool Finished() const
+            {
+                return m_Finished.load(std::memory_order_acquire);
+            }
+
+            /**
+             * \brief Whether the thread closed the file after encoding all the data. Only valid after `Join()`.
+             */
+            [[nodiscard]] bool IsFileClosed() const
+            {
+                return m_IsFileClosed;
+            }
+
+            /**
+             * \brief The result of closing the file, when `IsFileClosed()`. Only valid after `Join()`.
+             */
+            [[nodiscard]] FileWriter::Error GetCloseError() const
+            {
+                return m_CloseError;
+            }
+
+            void RequestAbort()
+            {
+                m_AbortRequested.store(true, std::memory_order_relaxed);
+                WakeUp();
+            }
+        };
+
+        /**
+         * A frame entirely read from the device, whose encoder thread is still encoding and closing the file while
+         * the next frame starts. The frame owns its file writer.
+         */
+        struct ClosingFrame
+        {
+            size_t ItemIndex{};
+            size_t PageIndex{};
+            ScanThread *Reader{};
+            EncoderThread *Encoder{};
+            FileWriter *Writer{};
+            std::filesystem::path ImageFilePath{};
+            OutputOptionsState::OutputDestination Destination{};
+        };
+
+        /// The reader and encoder threads of the current frame, and the encoder thread of the closing frame.
+        static constexpr size_t k_WorkerThreadCount = 3;
+
+        /// The registered writer of the output format. The files are written by clones of it.
         FileWriter *m_FileWriter;
+        /// The writer of the file of the current frame, owned by the process.
+        FileWriter *m_FrameWriter{};
         std::filesystem::path m_ImageFilePath;
+        EncoderThread *m_EncoderThread{};
+        size_t m_ReportedBytes{};
+        bool m_IsFileClosed{};
+        FileWriter::Error m_CloseError{};
 
-        SANE_Byte *m_Buffer{};
-        size_t m_BufferSize{};
-        size_t m_WriteOffset{};
+        size_t m_PageIndex{};
+        bool m_HasFailed{};
+        std::optional<ClosingFrame> m_ClosingFrame{};
+        std::unique_ptr<ScanThread::Buffer> m_RecycledBuffer{};
+        // The frames reuse the same threads instead of starting new ones.
+        ZooLib::ThreadPool m_WorkerPool{k_WorkerThreadCount};
 
         virtual bool LoadSettings()
         {
             return true;
         }
 
+        /**
+         * \brief Gets the index of the scan list item being scanned; 0 when there is no scan list.
+         */
+        [[nodiscard]] virtual size_t GetItemIndex() const
+        {
+            return 0;
+        }
+
+        /**
+         * \brief Whether a frame may follow the current one: the next page of the document feeder, or the next item
+         * of a scan list.
+         */
+        [[nodiscard]] virtual bool HasNextFrame() const
+        {
+            return m_OutputOptions->GetUseDocumentFeeder();
+        }
+
+        /**
+         * \brief Called when there are no more pages to scan for the current item, after the device is canceled.
+         * \return True if the next item was started; false if there is none, or if it failed to start, in which case
+         * `m_HasFailed` is set.
+         */
+        virtual bool StartNextItem()
+        {
+            return false;
+        }
+
+        /**
+         * \brief Called when the device starts acquiring a page.
+         */
+        virtual void OnPageStarted()
+        {
+        }
+
+        /**
+         * \brief Called when the scan of a page stops, after its file is closed. Since the next page starts while the
+         * file is encoded and closed, this can happen after the next page has started.
+         * \param itemIndex The index of the scan list item of the page.
+         * \param pageIndex The index of the page in the document feeder; 0 when the feeder is not used.
+         * \param imageFilePath The path of the file of the page.
+         * \param canceled Whether the scan was canceled or failed.
+         */
+        virtual void OnPageStopped(
+                size_t itemIndex, size_t pageIndex, const std::filesystem::path &imageFilePath, bool canceled)
+        {
+        }
+
         std::string GetProgressString() override
         {
             return m_ImageFilePath.filename();
@@ -29,108 +343,323 @@ namespace Gorfector
         {
             if (m_ScanParameters.format != SANE_FRAME_GRAY && m_ScanParameters.format != SANE_FRAME_RGB)
             {
-                ZooLib::ShowUserError(ADW_APPLICATION_WINDOW(m_MainWindow), _("Unsupported format."));
+                ShowError(_("Unsupported format."));
                 return false;
             }
 
             if (m_ScanParameters.depth != 1 && m_ScanParameters.depth != 8 && m_ScanParameters.depth != 16)
             {
-                ZooLib::ShowUserError(ADW_APPLICATION_WINDOW(m_MainWindow), _("Unsupported depth."));
+                ShowError(_("Unsupported depth."));
                 return false;
             }
 
             if (m_FileWriter == nullptr)
             {
-                ZooLib::ShowUserError(ADW_APPLICATION_WINDOW(m_MainWindow), _("Unsupported file format."));
+                ShowError(_("Unsupported file format."));
                 return false;
             }
 
-            if (auto error = m_FileWriter->CreateFile(m_ImageFilePath, m_ScanOptions, m_ScanParameters);
+            // Each frame has its own writer, so that the file of the previous frame can be closed meanwhile.
+            m_FrameWriter = m_FileWriter->Clone();
+            if (auto error = m_FrameWriter->CreateFile(m_ImageFilePath, m_ScanOptions, m_ScanParameters);
                 error != FileWriter::Error::None)
             {
-                auto errorString = std::string(_("Failed to create file: ")) + m_FileWriter->GetError(error) + ".";
-                ZooLib::ShowUserError(ADW_APPLICATION_WINDOW(m_MainWindow), errorString);
+                auto errorString = std::string(_("Failed to create file: ")) + m_FrameWriter->GetError(error) + ".";
+                ShowError(errorString);
+                delete m_FrameWriter;
+                m_FrameWriter = nullptr;
                 return false;
             }
 
             return true;
         }
 
-        void GetBuffer(SANE_Byte *&outBuffer, size_t &outMaxReadLength) override
+        bool Update() override
         {
-            outBuffer = m_Buffer != nullptr ? m_Buffer + m_WriteOffset : nullptr;
-            outMaxReadLength = m_BufferSize - m_WriteOffset;
+            if (m_ClosingFrame.has_value() && m_ClosingFrame->Encoder->Finished() && !FinishClosingFrame())
+            {
+                return false;
+            }
+
+            if (m_ScanThread == nullptr)
+            {
+                // When the device has sent the whole frame, wake the main thread up too, to start the next frame
+                // without waiting for the encoder thread to close the file.
+                m_ScanThread = CreateScanThread(
+                        [this]() {
+                            m_EncoderThread->NotifyDataAvailable();
+                            if (m_ScanThread->Finished())
+                            {
+                                WakeUp();
+                            }
+                        },
+                        std::move(m_RecycledBuffer));
+
+                m_ReportedBytes = 0;
+                m_EncoderThread =
+                        new EncoderThread(m_ScanThread, m_FrameWriter, m_ScanParameters, [this]() { WakeUp(); });
+                m_EncoderThread->Start(m_WorkerPool);
+                m_ScanThread->Start(&m_WorkerPool);
+
+                return true;
+            }
+
+            // Read the finished flag first, so that the progress published below includes all the encoded bytes.
+            auto finished = m_EncoderThread->Finished();
+            PublishProgress();
+
+            if (m_ScanThread->Finished() && !CheckReadError())
+            {
+                // Stop() cancels the frame.
+                m_HasFailed = true;
+                return false;
+            }
+
+            // Start the next frame as soon as the device has sent the current one, without waiting for the encoder.
+            if (m_ScanThread->Finished() && HasNextFrame())
+            {
+                // The encoding is slower than the device: wait for the previous frame without blocking the main
+                // thread. Its encoder thread wakes the process up when it is done.
+                if (m_ClosingFrame.has_value())
+                {
+                    return true;
+                }
+
+                return StartNextFrame();
+            }
+
+            // The process stops once the files of both frames are closed.
+            return !finished || m_ClosingFrame.has_value();
+        }
+
+        void PublishProgress()
+        {
+            auto encodedBytes = m_EncoderThread->GetEncodedBytes();
+            IncreaseProgress(encodedBytes - m_ReportedBytes);
+            m_ReportedBytes = encodedBytes;
         }
 
-        void CommitBuffer(size_t readLength) override
+        /**
+         * \brief Hands the current frame over to its encoder thread, and starts the next one while the file is being
+         * encoded and closed: the next page of the document feeder or, once it is empty, the next item. The previous
+         * closing frame must be finished.
+         * \return False if there is no next frame, or if it failed to start, in which case `m_HasFailed` is set.
+         */
+        bool StartNextFrame()
         {
-            ScanProcess::CommitBuffer(readLength);
+            // The scan thread calls back into this object once more after it finishes.
+            m_ScanThread->Join();
 
-            auto availableBytes = m_WriteOffset + readLength;
-            auto availableLines = availableBytes / m_ScanParameters.bytes_per_line;
-            auto savedBytes = m_FileWriter->AppendBytes(m_Buffer, availableLines, m_ScanParameters);
-            if (savedBytes < availableBytes)
+            // The device has sent the whole frame; the rest of the frame progress is its encoding.
+            if (auto frameSize = static_cast<size_t>(m_ScanParameters.bytes_per_line) * m_ScanParameters.lines;
+                m_ScanParameters.lines > 0 && frameSize > m_ReportedBytes)
             {
-                memmove(m_Buffer, m_Buffer + savedBytes, availableBytes - savedBytes);
-                m_WriteOffset = availableBytes - savedBytes;
+                IncreaseProgress(frameSize - m_ReportedBytes);
             }
-            else
+
+            m_ClosingFrame = ClosingFrame{
+                    GetItemIndex(),
+                    m_PageIndex,
+                    std::exchange(m_ScanThread, nullptr),
+                    std::exchange(m_EncoderThread, nullptr),
+                    std::exchange(m_FrameWriter, nullptr),
+                    m_ImageFilePath,
+                    m_OutputOptions->GetOutputDestination(),
+            };
+
+            if (m_OutputOptions->GetUseDocumentFeeder())
+            {
+                // The device is not canceled between the pages of the document feeder.
+                ZooLib::IncrementPath(m_ImageFilePath);
+                ++m_PageIndex;
+
+                auto isFeederEmpty = false;
+                if (StartFrame(&isFeederEmpty))
+                {
+                    BeginFrame();
+                    return true;
+                }
+
+                if (!isFeederEmpty)
+                {
+                    m_HasFailed = true;
+                    return false;
+                }
+            }
+
+            m_Device->CancelScan();
+            return StartNextItem();
+        }
+
+        /**
+         * \brief Prepares the process to receive a frame started by `StartFrame()`.
+         */
+        void BeginFrame()
+        {
+            InitProgress();
+            OnPageStarted();
+
+            // Update() creates the scan and encoder threads of the new frame.
+            WakeUp();
+        }
+
+        /**
+         * \brief Reports an error closing the file of a frame. The process stops after the current frame.
+         * \return False if the file could not be saved.
+         */
+        bool CheckCloseError(
+                FileWriter *fileWriter, const std::filesystem::path &imageFilePath, FileWriter::Error error)
+        {
+            if (error == FileWriter::Error::None)
+            {
+                return true;
+            }
+
+            // The writer may have left an incomplete file.
+            std::error_code errorCode;
+            std::filesystem::remove(imageFilePath, errorCode);
+
+            auto fileName = imageFilePath.string();
+            auto errorDescription = fileWriter->GetError(error);
+            ShowError(std::vformat(
+                    _("Failed to save file {}: {}."), std::make_format_args(fileName, errorDescription)));
+            m_HasFailed = true;
+            return false;
+        }
+
+        /**
+         * \brief Waits for the encoder thread of the closing frame, then sends its file to its destination.
+         * \return False if the file could not be saved, in which case `m_HasFailed` is set.
+         */
+        bool FinishClosingFrame()
+        {
+            auto frame = std::move(*m_ClosingFrame);
+            m_ClosingFrame.reset();
+
+            frame.Encoder->Join();
+            auto isFileClosed = frame.Encoder->IsFileClosed();
+            auto closeResult = frame.Encoder->GetCloseError();
+            delete frame.Encoder;
+
+            // The next frame reuses the scan buffer instead of allocating a new one.
+            m_RecycledBuffer = frame.Reader->TakeBuffer();
+            delete frame.Reader;
+
+            auto closeError = isFileClosed ? closeResult : frame.Writer->CloseFile();
+            auto isSaved = CheckCloseError(frame.Writer, frame.ImageFilePath, closeError);
+            delete frame.Writer;
+            if (!isSaved)
+            {
+                OnPageStopped(frame.ItemIndex, frame.PageIndex, frame.ImageFilePath, true);
+                return false;
+            }
+
+            SendFileToDestination(frame.ImageFilePath, frame.Destination);
+            OnPageStopped(frame.ItemIndex, frame.PageIndex, frame.ImageFilePath, false);
+            return true;
+        }
+
+        void StopEncoderThread()
+        {
+            m_IsFileClosed = false;
+            if (m_EncoderThread != nullptr)
             {
-                m_WriteOffset = 0;
+                m_EncoderThread->RequestAbort();
+                m_EncoderThread->Join();
+                m_IsFileClosed = m_EncoderThread->IsFileClosed();
+                m_CloseError = m_EncoderThread->GetCloseError();
+                delete m_EncoderThread;
+                m_EncoderThread = nullptr;
             }
         }
 
         void Stop(bool canceled) override
         {
+            // The next frame could not be started by StartNextFrame().
+            canceled = canceled || m_HasFailed;
+
+            // The scan thread notifies the encoder thread: stop it first. The encoder thread uses the scan thread
+            // buffer and the file writer: stop it before both go away.
+            if (m_ScanThread != nullptr)
+            {
+                m_ScanThread->RequestAbort();
+                m_ScanThread->Join();
+            }
+            StopEncoderThread();
+
+            // The previous frame was entirely read: complete it even if the current one is canceled.
+            if (m_ClosingFrame.has_value())
+            {
+                FinishClosingFrame();
+            }
+
             ScanProcess::Stop(canceled);
 
             SendImageToDestination(canceled);
 
             auto updater = AppState::Updater(m_AppState);
             updater.SetIsScanning(false);
-
-            free(m_Buffer);
-            m_Buffer = nullptr;
-            m_BufferSize = 0;
-            m_WriteOffset = 0;
         }
 
         void SendImageToDestination(bool canceled)
         {
-            if (m_FileWriter != nullptr)
+            if (m_FrameWriter == nullptr)
             {
-                if (canceled)
-                {
-                    m_FileWriter->CancelFile();
-                }
-                else
-                {
-                    m_FileWriter->CloseFile();
-                }
-                m_FileWriter = nullptr;
+                // No frame was started.
+                return;
             }
 
-            if (!canceled && std::filesystem::exists(m_ImageFilePath))
+            if (canceled)
             {
-                auto destination = m_OutputOptions->GetOutputDestination();
-                if (destination == OutputOptionsState::OutputDestination::e_Email)
-                {
-                    auto command = "xdg-email --attach " + m_ImageFilePath.string();
-                    std::system(command.c_str());
-                }
-                else if (destination == OutputOptionsState::OutputDestination::e_Printer)
+                m_FrameWriter->CancelFile();
+                if (m_HasFailed)
                 {
-                    auto printDialog = gtk_print_dialog_new();
-                    auto imageFile = g_file_new_for_path(m_ImageFilePath.c_str());
-                    gtk_print_dialog_print_file(
-                            printDialog, GTK_WINDOW(m_MainWindow), nullptr, imageFile, nullptr, nullptr, nullptr);
+                    // Do not leave the incomplete file of a failed frame.
+                    std::error_code errorCode;
+                    std::filesystem::remove(m_ImageFilePath, errorCode);
                 }
             }
+            else
+            {
+                auto closeError = m_IsFileClosed ? m_CloseError : m_FrameWriter->CloseFile();
+                canceled = !CheckCloseError(m_FrameWriter, m_ImageFilePath, closeError);
+            }
+            delete m_FrameWriter;
+            m_FrameWriter = nullptr;
+
+            if (!canceled)
+            {
+                SendFileToDestination(m_ImageFilePath, m_OutputOptions->GetOutputDestination());
+            }
+
+            OnPageStopped(GetItemIndex(), m_PageIndex, m_ImageFilePath, canceled);
+        }
+
+        void SendFileToDestination(
+                const std::filesystem::path &imageFilePath, OutputOptionsState::OutputDestination destination) const
+        {
+            if (!std::filesystem::exists(imageFilePath))
+            {
+                return;
+            }
+
+            if (destination == OutputOptionsState::OutputDestination::e_Email)
+            {
+                auto command = "xdg-email --attach " + imageFilePath.string();
+                std::system(command.c_str());
+            }
+            else if (destination == OutputOptionsState::OutputDestination::e_Printer)
+            {
+                auto printDialog = gtk_print_dialog_new();
+                auto imageFile = g_file_new_for_path(imageFilePath.c_str());
+                gtk_print_dialog_print_file(
+                        printDialog, GTK_WINDOW(m_MainWindow), nullptr, imageFile, nullptr, nullptr, nullptr);
+            }
         }
 
     public:
         SingleScanProcess(
-                SaneDevice *device, PreviewState *previewState, AppState *appState, DeviceOptionsState *scanOptions,
+                ScanDevice *device, PreviewState *previewState, AppState *appState, DeviceOptionsState *scanOptions,
                 OutputOptionsState *outputOptions, GtkWidget *mainWindow, FileWriter *fileWriter,
                 std::filesystem::path imageFilePath, const std::function<void()> *finishCallback)
             : ScanProcess(device, previewState, appState, scanOptions, outputOptions, mainWindow, finishCallback)
@@ -139,14 +668,6 @@ namespace Gorfector
         {
         }
 
-        ~SingleScanProcess() override
-        {
-            if (m_Buffer != nullptr)
-            {
-                free(m_Buffer);
-            }
-        }
-
         bool Start() override
         {
             auto updater = AppState::Updater(m_AppState);
@@ -158,6 +679,7 @@ namespace Gorfector
                 return false;
             }
 
+            m_PageIndex = 0;
             if (!ScanProcess::Start())
             {
                 // Stop() has already been called
@@ -165,11 +687,7 @@ namespace Gorfector
                 return false;
             }
 
-            auto linesIn1MB = 1024UL * 1024 / m_ScanParameters.bytes_per_line;
-            m_BufferSize = m_ScanParameters.bytes_per_line * linesIn1MB;
-            m_Buffer = static_cast<SANE_Byte *>(calloc(m_BufferSize, sizeof(SANE_Byte)));
-            m_WriteOffset = 0;
-
+            OnPageStarted();
             return true;
         }
     };
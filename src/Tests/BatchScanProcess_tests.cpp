@@ -0,0 +1,572 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+#include "AppState.hpp"
+#include "BatchScanProcess.hpp"
+#include "CompareFiles.hpp"
+#include "FakeScanDevice.hpp"
+#include "OutputOptionsState.hpp"
+#include "ScanListState.hpp"
+#include "StateComponents.hpp"
+#include "Writers/PngWriter.hpp"
+
+using namespace TestsSupport;
+
+namespace Gorfector
+{
+    /**
+     * A writer checking that the frames overlap: closing the file of a frame waits until the writer of the next frame
+     * receives data. The files are empty.
+     */
+    class OverlappingFramesWriter final : public FileWriter
+    {
+        static constexpr std::chrono::seconds k_Timeout{2};
+        static inline const std::string k_Name = "Overlapping frames";
+
+        static inline std::mutex s_Mutex{};
+        static inline std::condition_variable s_Condition{};
+        static inline size_t s_FrameCount{};
+        static inline size_t s_CreatedFileCount{};
+        static inline std::set<size_t> s_FramesWithData{};
+        static inline size_t s_OverlappingCloseCount{};
+
+        size_t m_Frame{};
+
+    public:
+        OverlappingFramesWriter(ZooLib::State *, const std::string &applicationName)
+            : FileWriter(applicationName)
+        {
+        }
+
+        /**
+         * Resets the counters. The last of the `frameCount` frames does not wait for a next one.
+         */
+        static void Reset(size_t frameCount)
+        {
+            std::lock_guard lock(s_Mutex);
+            s_FrameCount = frameCount;
+            s_CreatedFileCount = 0;
+            s_FramesWithData.clear();
+            s_OverlappingCloseCount = 0;
+        }
+
+        /**
+         * Gets the number of files closed while the next frame was read.
+         */
+        static size_t GetOverlappingCloseCount()
+        {
+            std::lock_guard lock(s_Mutex);
+            return s_OverlappingCloseCount;
+        }
+
+        /**
+         * The writer has no settings.
+         */
+        [[nodiscard]] StateComponentA *GetStateComponent() const
+        {
+            return nullptr;
+        }
+
+        [[nodiscard]] const std::string &GetName() const override
+        {
+            return k_Name;
+        }
+
+        [[nodiscard]] std::vector<std::string> GetExtensions() const override
+        {
+            return {".overlap"};
+        }
+
+        [[nodiscard]] FileWriter *Clone() const override
+        {
+            return new OverlappingFramesWriter(nullptr, GetApplicationName());
+        }
+
+        Error CreateFile(
+                std::filesystem::path &path, const DeviceOptionsState *, const SANE_Parameters &) override
+        {
+            std::ofstream file(path);
+            std::lock_guard lock(s_Mutex);
+            m_Frame = s_CreatedFileCount++;
+            return file.good() ? Error::None : Error::CannotOpenFile;
+        }
+
+        size_t AppendBytes(SANE_Byte *, uint32_t numberOfLines, const SANE_Parameters &parameters) override
+        {
+            {
+                std::lock_guard lock(s_Mutex);
+                s_FramesWithData.insert(m_Frame);
+            }
+            s_Condition.notify_all();
+            return numberOfLines * parameters.bytes_per_line;
+        }
+
+        Error CloseFile() override
+        {
+            std::unique_lock lock(s_Mutex);
+            if (m_Frame + 1 < s_FrameCount &&
+                s_Condition.wait_for(lock, k_Timeout, [this]() { return s_FramesWithData.contains(m_Frame + 1); }))
+            {
+                ++s_OverlappingCloseCount;
+            }
+            return Error::None;
+        }
+
+        void CancelFile() override
+        {
+        }
+    };
+
+    /**
+     * A writer failing to write the lines after the first ones: `AppendBytes()` returns 0, as writers do on error.
+     */
+    class FailingWriter final : public FileWriter
+    {
+        static constexpr uint32_t k_WrittenLineCount = 10;
+        static inline const std::string k_Name = "Failing";
+
+        static inline std::atomic<size_t> s_ClosedCount{};
+        static inline std::atomic<size_t> s_CanceledCount{};
+
+        uint32_t m_LineCount{};
+
+    public:
+        FailingWriter(ZooLib::State *, const std::string &applicationName)
+            : FileWriter(applicationName)
+        {
+        }
+
+        static void Reset()
+        {
+            s_ClosedCount = 0;
+            s_CanceledCount = 0;
+        }
+
+        static size_t GetClosedCount()
+        {
+            return s_ClosedCount;
+        }
+
+        static size_t GetCanceledCount()
+        {
+            return s_CanceledCount;
+        }
+
+        /**
+         * The writer has no settings.
+         */
+        [[nodiscard]] StateComponentA *GetStateComponent() const
+        {
+            return nullptr;
+        }
+
+        [[nodiscard]] const std::string &GetName() const override
+        {
+            return k_Name;
+        }
+
+        [[nodiscard]] std::vector<std::string> GetExtensions() const override
+        {
+            return {".fail"};
+        }
+
+        [[nodiscard]] FileWriter *Clone() const override
+        {
+            return new FailingWriter(nullptr, GetApplicationName());
+        }
+
+        Error CreateFile(
+                std::filesystem::path &path, const DeviceOptionsState *, const SANE_Parameters &) override
+        {
+            std::ofstream file(path);
+            m_LineCount = 0;
+            return file.good() ? Error::None : Error::CannotOpenFile;
+        }
+
+        size_t AppendBytes(SANE_Byte *, uint32_t numberOfLines, const SANE_Parameters &parameters) override
+        {
+            auto lines = std::min(numberOfLines, k_WrittenLineCount - m_LineCount);
+            m_LineCount += lines;
+            return lines * parameters.bytes_per_line;
+        }
+
+        Error CloseFile() override
+        {
+            ++s_ClosedCount;
+            return Error::None;
+        }
+
+        void CancelFile() override
+        {
+            ++s_CanceledCount;
+        }
+    };
+
+    class Gorfector_BatchScanProcessTests : public testing::Test
+    {
+    protected:
+        ZooLib::State *m_State{};
+        AppState *m_AppState{};
+        DeviceOptionsState *m_DeviceOptions{};
+        OutputOptionsState *m_OutputOptions{};
+        ScanListState *m_ScanList{};
+        std::filesystem::path m_OutputDirectory{};
+        size_t m_ScannedCount{};
+
+        void SetUp() override
+        {
+            m_State = new ZooLib::State();
+            m_AppState = new AppState(m_State, false);
+            m_DeviceOptions = new DeviceOptionsState(m_State, "");
+            m_OutputOptions = new OutputOptionsState(m_State);
+            m_ScanList = new ScanListState(m_State);
+            FileWriter::Register<PngWriter>(m_State, "Gorfector_BatchScanProcessTests");
+            FileWriter::Register<OverlappingFramesWriter>(m_State, "Gorfector_BatchScanProcessTests");
+            FileWriter::Register<FailingWriter>(m_State, "Gorfector_BatchScanProcessTests");
+
+            const testing::TestInfo *const testInfo = testing::UnitTest::GetInstance()->current_test_info();
+            m_OutputDirectory = std::filesystem::path(testing::TempDir()) /
+                                (std::string(testInfo->test_suite_name()) + "_" + testInfo->name());
+            std::filesystem::create_directories(m_OutputDirectory);
+        }
+
+        void TearDown() override
+        {
+            delete m_ScanList;
+            delete m_OutputOptions;
+            delete m_DeviceOptions;
+            delete m_AppState;
+            FileWriter::Clear();
+            delete m_State;
+
+            if (g_CleanArtifacts)
+            {
+                std::filesystem::remove_all(m_OutputDirectory);
+            }
+        }
+
+        static nlohmann::json MakeItem(
+                int id, const std::filesystem::path &directory, const std::string &fileName,
+                OutputOptionsState::OutputDestination destination = OutputOptionsState::OutputDestination::e_File,
+                bool useDocumentFeeder = false)
+        {
+            return {
+                    {ScanListState::k_ItemIdKey, id},
+                    {ScanListState::k_ItemScannerSettingsKey,
+                     {
+                             {DeviceOptionsState::k_DeviceKey,
+                              {
+                                      {DeviceOptionsState::k_DeviceNameKey, "fake:0"},
+                                      {DeviceOptionsState::k_DeviceVendorKey, "Fake"},
+                                      {DeviceOptionsState::k_DeviceModelKey, "Scanner"},
+                                      {DeviceOptionsState::k_DeviceTypeKey, "flatbed scanner"},
+                              }},
+                             {DeviceOptionsState::k_OptionsKey, nlohmann::json::object()},
+                     }},
+                    {ScanListState::k_ItemOutputSettingsKey,
+                     {
+                             {OutputOptionsState::k_OutputDestinationKey, destination},
+                             {OutputOptionsState::k_OutputDirectoryKey, directory.string()},
+                             {OutputOptionsState::k_CreateMissingDirectoriesKey, false},
+                             {OutputOptionsState::k_OutputFileNameKey, fileName},
+                             {OutputOptionsState::k_FileExistsActionKey,
+                              OutputOptionsState::FileExistsAction::e_Overwrite},
+                             {OutputOptionsState::k_UseDocumentFeederKey, useDocumentFeeder},
+                     }},
+            };
+        }
+
+        void LoadScanList(const nlohmann::json &items) const
+        {
+            auto updater = ScanListState::Updater(m_ScanList);
+            updater.LoadFromJson({
+                    {ScanListState::k_AddAllParamsKey, false},
+                    {ScanListState::k_ScanListsKey, {{"Fake::Scanner", items}}},
+            });
+            updater.SetCurrentDeviceName("Fake", "Scanner");
+        }
+
+        /**
+         * Runs a batch scan process until it finishes, and returns the events it wrote.
+         */
+        std::vector<nlohmann::json> Scan(FakeScanDevice &device)
+        {
+            std::stringstream output;
+            auto finished = false;
+            BatchScanProcess *process{};
+            process = new BatchScanProcess(
+                    &device, m_ScanList, m_AppState, m_DeviceOptions, m_OutputOptions, output,
+                    new std::function<void()>([&]() {
+                        m_ScannedCount = process->GetScannedCount();
+                        finished = true;
+                    }));
+
+            if (!process->Start())
+            {
+                m_ScannedCount = process->GetScannedCount();
+                delete process;
+            }
+            else
+            {
+                while (!finished)
+                {
+                    g_main_context_iteration(nullptr, TRUE);
+                }
+            }
+
+            std::vector<nlohmann::json> events;
+            std::string line;
+            while (std::getline(output, line))
+            {
+                events.push_back(nlohmann::json::parse(line));
+            }
+            return events;
+        }
+
+        static std::string ReadFile(const std::filesystem::path &path)
+        {
+            std::ifstream file(path, std::ios::binary);
+            return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        }
+
+        static std::vector<nlohmann::json>
+        GetEvents(const std::vector<nlohmann::json> &events, const std::string &eventName)
+        {
+            std::vector<nlohmann::json> result;
+            std::ranges::copy_if(events, std::back_inserter(result), [&eventName](const nlohmann::json &event) {
+                return event["event"] == eventName;
+            });
+            return result;
+        }
+    };
+
+    TEST_F(Gorfector_BatchScanProcessTests, ScansEveryItemAndReportsProgress)
+    {
+        FakeScanDevice device({.PageCount = 2});
+        LoadScanList(nlohmann::json::array({
+                MakeItem(1, m_OutputDirectory, "a.png"),
+                MakeItem(2, m_OutputDirectory, "b.png"),
+        }));
+
+        auto events = Scan(device);
+
+        EXPECT_EQ(2UZ, m_ScannedCount);
+        EXPECT_FALSE(m_AppState->IsScanning());
+        EXPECT_TRUE(std::filesystem::exists(m_OutputDirectory / "a.png"));
+        EXPECT_TRUE(std::filesystem::exists(m_OutputDirectory / "b.png"));
+
+        auto started = GetEvents(events, "scan_started");
+        ASSERT_EQ(2UZ, started.size());
+        EXPECT_EQ(1, started[0]["item"]);
+        EXPECT_EQ(2, started[0]["count"]);
+        EXPECT_EQ((m_OutputDirectory / "a.png").string(), started[0]["file"]);
+        EXPECT_EQ(2, started[1]["item"]);
+
+        auto finished = GetEvents(events, "scan_finished");
+        ASSERT_EQ(2UZ, finished.size());
+        EXPECT_EQ((m_OutputDirectory / "b.png").string(), finished[1]["file"]);
+
+        auto progress = GetEvents(events, "progress");
+        ASSERT_FALSE(progress.empty());
+        EXPECT_EQ(100, progress.back()["percent"]);
+        EXPECT_EQ(progress.back()["total"], progress.back()["bytes"]);
+        EXPECT_TRUE(GetEvents(events, "error").empty());
+    }
+
+    TEST_F(Gorfector_BatchScanProcessTests, ItemsStartedWhileThePreviousFileIsClosingAreComplete)
+    {
+        FakeScanDevice::Settings settings{.PageCount = 3};
+        settings.Parameters.format = SANE_FRAME_RGB;
+        settings.Parameters.pixels_per_line = 2000;
+        settings.Parameters.lines = 1500;
+        FakeScanDevice device(settings);
+        LoadScanList(nlohmann::json::array({
+                MakeItem(1, m_OutputDirectory, "a.png"),
+                MakeItem(2, m_OutputDirectory, "b.png"),
+                MakeItem(3, m_OutputDirectory, "c.png"),
+        }));
+
+        auto events = Scan(device);
+
+        EXPECT_EQ(3UZ, m_ScannedCount);
+        EXPECT_EQ(3U, device.GetStatistics().PagesStarted);
+
+        auto finished = GetEvents(events, "scan_finished");
+        ASSERT_EQ(3UZ, finished.size());
+        for (auto i = 0UZ; i < finished.size(); ++i)
+        {
+            EXPECT_EQ(i + 1, finished[i]["item"]);
+        }
+        EXPECT_EQ((m_OutputDirectory / "a.png").string(), finished[0]["file"]);
+        EXPECT_EQ((m_OutputDirectory / "c.png").string(), finished[2]["file"]);
+
+        // Every page has the same content: the files must be identical.
+        auto firstFile = ReadFile(m_OutputDirectory / "a.png");
+        ASSERT_FALSE(firstFile.empty());
+        EXPECT_EQ(firstFile, ReadFile(m_OutputDirectory / "b.png"));
+        EXPECT_EQ(firstFile, ReadFile(m_OutputDirectory / "c.png"));
+    }
+
+    TEST_F(Gorfector_BatchScanProcessTests, FilesOfTheSameFormatAreClosedWhileTheNextItemIsRead)
+    {
+        FakeScanDevice device({.PageCount = 3});
+        LoadScanList(nlohmann::json::array({
+                MakeItem(1, m_OutputDirectory, "a.overlap"),
+                MakeItem(2, m_OutputDirectory, "b.overlap"),
+                MakeItem(3, m_OutputDirectory, "c.overlap"),
+        }));
+        OverlappingFramesWriter::Reset(3);
+
+        auto events = Scan(device);
+
+        EXPECT_EQ(3UZ, m_ScannedCount);
+        EXPECT_TRUE(GetEvents(events, "error").empty());
+        EXPECT_EQ(3UZ, GetEvents(events, "scan_finished").size());
+        EXPECT_EQ(2UZ, OverlappingFramesWriter::GetOverlappingCloseCount());
+    }
+
+    TEST_F(Gorfector_BatchScanProcessTests, ScansAllThePagesOfTheDocumentFeeder)
+    {
+        FakeScanDevice device({.PageCount = 3});
+        LoadScanList(nlohmann::json::array({
+                MakeItem(1, m_OutputDirectory, "a.png", OutputOptionsState::OutputDestination::e_File, true),
+        }));
+
+        auto events = Scan(device);
+
+        EXPECT_EQ(1UZ, m_ScannedCount);
+        EXPECT_EQ(3U, device.GetStatistics().PagesStarted);
+        EXPECT_FALSE(m_AppState->IsScanning());
+        EXPECT_TRUE(GetEvents(events, "error").empty());
+
+        const std::vector<std::filesystem::path> files{
+                m_OutputDirectory / "a.png", m_OutputDirectory / "a_01.png", m_OutputDirectory / "a_02.png"};
+        auto started = GetEvents(events, "scan_started");
+        auto finished = GetEvents(events, "scan_finished");
+        ASSERT_EQ(files.size(), started.size());
+        ASSERT_EQ(files.size(), finished.size());
+        for (auto i = 0UZ; i < files.size(); ++i)
+        {
+            EXPECT_EQ(1, finished[i]["item"]);
+            EXPECT_EQ(i + 1, started[i]["page"]);
+            EXPECT_EQ(i + 1, finished[i]["page"]);
+            EXPECT_EQ(files[i].string(), finished[i]["file"]);
+        }
+
+        auto firstFile = ReadFile(files[0]);
+        ASSERT_FALSE(firstFile.empty());
+        EXPECT_EQ(firstFile, ReadFile(files[1]));
+        EXPECT_EQ(firstFile, ReadFile(files[2]));
+    }
+
+    TEST_F(Gorfector_BatchScanProcessTests, FailsWhenTheDocumentFeederIsEmpty)
+    {
+        FakeScanDevice device({.PageCount = 0});
+        LoadScanList(nlohmann::json::array({
+                MakeItem(1, m_OutputDirectory, "a.png", OutputOptionsState::OutputDestination::e_File, true),
+        }));
+
+        auto events = Scan(device);
+
+        EXPECT_EQ(0UZ, m_ScannedCount);
+        EXPECT_FALSE(m_AppState->IsScanning());
+        EXPECT_EQ(1UZ, GetEvents(events, "error").size());
+        EXPECT_TRUE(GetEvents(events, "scan_finished").empty());
+    }
+
+    TEST_F(Gorfector_BatchScanProcessTests, StopsAtTheFirstFailingItem)
+    {
+        FakeScanDevice device({.PageCount = 3});
+        LoadScanList(nlohmann::json::array({
+                MakeItem(1, m_OutputDirectory, "a.png"),
+                MakeItem(2, m_OutputDirectory / "missing", "b.png"),
+                MakeItem(3, m_OutputDirectory, "c.png"),
+        }));
+
+        auto events = Scan(device);
+
+        EXPECT_EQ(1UZ, m_ScannedCount);
+        EXPECT_FALSE(m_AppState->IsScanning());
+        EXPECT_FALSE(std::filesystem::exists(m_OutputDirectory / "c.png"));
+
+        auto errors = GetEvents(events, "error");
+        ASSERT_EQ(1UZ, errors.size());
+        EXPECT_EQ(2, errors[0]["item"]);
+        EXPECT_EQ(1UZ, GetEvents(events, "scan_started").size());
+    }
+
+    TEST_F(Gorfector_BatchScanProcessTests, FileIsCanceledWhenTheWriterFailsToWriteLines)
+    {
+        FakeScanDevice device({});
+        LoadScanList(nlohmann::json::array({MakeItem(1, m_OutputDirectory, "a.fail")}));
+        FailingWriter::Reset();
+
+        auto events = Scan(device);
+
+        EXPECT_EQ(0UZ, m_ScannedCount);
+        EXPECT_EQ(0UZ, FailingWriter::GetClosedCount());
+        EXPECT_EQ(1UZ, FailingWriter::GetCanceledCount());
+        EXPECT_FALSE(std::filesystem::exists(m_OutputDirectory / "a.fail"));
+
+        auto errors = GetEvents(events, "error");
+        ASSERT_EQ(1UZ, errors.size());
+        EXPECT_NE(std::string::npos, errors[0]["message"].get<std::string>().find("a.fail"));
+    }
+
+    TEST_F(Gorfector_BatchScanProcessTests, PageIsCanceledWhenTheDeviceFailsDuringTheRead)
+    {
+        FakeScanDevice device({.PageCount = 2, .ReadError = SANE_STATUS_JAMMED});
+        LoadScanList(nlohmann::json::array({
+                MakeItem(1, m_OutputDirectory, "a.png"),
+                MakeItem(2, m_OutputDirectory, "b.png"),
+        }));
+
+        auto events = Scan(device);
+
+        EXPECT_EQ(0UZ, m_ScannedCount);
+        EXPECT_EQ(1U, device.GetStatistics().PagesStarted);
+        EXPECT_FALSE(std::filesystem::exists(m_OutputDirectory / "a.png"));
+        EXPECT_TRUE(GetEvents(events, "scan_finished").empty());
+        EXPECT_EQ(1UZ, GetEvents(events, "error").size());
+    }
+
+    TEST_F(Gorfector_BatchScanProcessTests, RejectsOtherDestinationsThanFiles)
+    {
+        FakeScanDevice device({});
+        LoadScanList(nlohmann::json::array(
+                {MakeItem(1, m_OutputDirectory, "a.png", OutputOptionsState::OutputDestination::e_Email)}));
+
+        auto events = Scan(device);
+
+        EXPECT_EQ(0UZ, m_ScannedCount);
+        ASSERT_EQ(1UZ, events.size());
+        EXPECT_EQ("error", events[0]["event"]);
+        EXPECT_EQ(0UZ, device.GetStatistics().BytesRead);
+    }
+
+    TEST_F(Gorfector_BatchScanProcessTests, NextPageOfTheDocumentFeederIsReadWhileTheFileIsClosed)
+    {
+        FakeScanDevice device({.PageCount = 3});
+        LoadScanList(nlohmann::json::array({
+                MakeItem(1, m_OutputDirectory, "a.overlap", OutputOptionsState::OutputDestination::e_File, true),
+        }));
+        OverlappingFramesWriter::Reset(3);
+
+        auto events = Scan(device);
+
+        EXPECT_EQ(1UZ, m_ScannedCount);
+        EXPECT_EQ(3U, device.GetStatistics().PagesStarted);
+        EXPECT_TRUE(GetEvents(events, "error").empty());
+        EXPECT_EQ(3UZ, GetEvents(events, "scan_finished").size());
+
+        // Page N + 1 is read before the file of page N is closed.
+        EXPECT_EQ(2UZ, OverlappingFramesWriter::GetOverlappingCloseCount());
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+
+namespace TestsSupport
+{
+    /**
+     * \brief Runs a function once and prints the time it took.
+     * \param name Description of the measured operation.
+     * \param operationCount Number of operations done by `func`, to also print the time of one operation.
+     * \param func The function to measure.
+     * \return The time taken by `func`, in milliseconds.
+     */
+    template<typename TFunc>
+    double Measure(const char *name, size_t operationCount, TFunc &&func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        auto end = std::chrono::steady_clock::now();
+
+        auto milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+        std::cout << name << ": " << milliseconds << " ms";
+        if (operationCount > 1)
+        {
+            std::cout << " (" << milliseconds * 1e6 / static_cast<double>(operationCount) << " ns per operation)";
+        }
+        std::cout << std::endl;
+
+        return milliseconds;
+    }
+}
@@ -0,0 +1,320 @@
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <sys/resource.h>
+#include <vector>
+
+#include "AppState.hpp"
+#include "FakeScanDevice.hpp"
+#include "OutputOptionsState.hpp"
+#include "SingleScanProcess.hpp"
+#include "Writers/JpegWriter.hpp"
+#include "Writers/PngWriter.hpp"
+#include "Writers/TiffWriter.hpp"
+
+// Scans synthetic pages from a fake device with every file format and every frame format/depth combination, through
+// the same scan process as the application, and reports the throughput, the latency of each stage and the peak
+// memory usage of each combination.
+
+using namespace Gorfector;
+using namespace TestsSupport;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        int Width{2480};
+        int Lines{3508};
+        double BytesPerSecond{};
+        uint32_t BusyInterval{};
+        uint32_t BusyMilliseconds{};
+        double ReadSizeJitter{};
+        std::filesystem::path OutputDirectory{std::filesystem::temp_directory_path()};
+        std::filesystem::path JsonFilePath{};
+    };
+
+    struct StageTimes
+    {
+        Clock::time_point StartTime{};
+        Clock::time_point StartedTime{};
+        Clock::time_point StopTime{};
+        Clock::time_point ClosedTime{};
+    };
+
+    struct Result
+    {
+        std::string FileFormat{};
+        std::string FrameFormat{};
+        int Depth{};
+        size_t ImageSize{};
+        double MegabytesPerSecond{};
+        double StartMilliseconds{};
+        double FirstReadMilliseconds{};
+        double ReadMilliseconds{};
+        double DrainMilliseconds{};
+        double CloseMilliseconds{};
+        double TotalMilliseconds{};
+        double PeakRssMegabytes{};
+        uint64_t BusyReadCount{};
+        bool Succeeded{};
+    };
+
+    /**
+     * Records when the scan stages end. The encoder drains the data read from the device before `Stop()` is called;
+     * `Stop()` then closes the file.
+     */
+    class BenchScanProcess final : public SingleScanProcess
+    {
+        StageTimes *m_Times;
+
+    protected:
+        void Stop(bool canceled) override
+        {
+            m_Times->StopTime = Clock::now();
+            SingleScanProcess::Stop(canceled);
+            m_Times->ClosedTime = Clock::now();
+        }
+
+    public:
+        BenchScanProcess(
+                ScanDevice *device, AppState *appState, OutputOptionsState *outputOptions, FileWriter *fileWriter,
+                std::filesystem::path imageFilePath, StageTimes *times, const std::function<void()> *finishCallback)
+            : SingleScanProcess(
+                      device, nullptr, appState, nullptr, outputOptions, nullptr, fileWriter, std::move(imageFilePath),
+                      finishCallback)
+            , m_Times(times)
+        {
+        }
+
+        bool Start() override
+        {
+            m_Times->StartTime = Clock::now();
+            auto started = SingleScanProcess::Start();
+            m_Times->StartedTime = Clock::now();
+            return started;
+        }
+    };
+
+    double Milliseconds(Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    /**
+     * Resets the peak resident set size of the process, so that each combination reports its own peak. Not all
+     * kernels support it; the peak then includes the previous combinations.
+     */
+    void ResetPeakRss()
+    {
+        std::ofstream("/proc/self/clear_refs") << "5";
+    }
+
+    double GetPeakRssMegabytes()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.starts_with("VmHWM:"))
+            {
+                return std::stod(line.substr(std::strlen("VmHWM:"))) / 1024.0;
+            }
+        }
+
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<double>(usage.ru_maxrss) / 1024.0;
+    }
+
+    Result Run(
+            const Options &options, FileWriter *fileWriter, SANE_Frame frameFormat, int depth, AppState *appState,
+            OutputOptionsState *outputOptions)
+    {
+        FakeScanDevice device({
+                .Parameters =
+                        {
+                                .format = frameFormat,
+                                .last_frame = SANE_TRUE,
+                                .bytes_per_line = 0,
+                                .pixels_per_line = options.Width,
+                                .lines = options.Lines,
+                                .depth = depth,
+                        },
+                .BytesPerSecond = options.BytesPerSecond,
+                .BusyInterval = options.BusyInterval,
+                .BusyDuration = std::chrono::milliseconds(options.BusyMilliseconds),
+                .ReadSizeJitter = options.ReadSizeJitter,
+        });
+        const auto &parameters = device.GetSettings().Parameters;
+
+        Result result{
+                .FileFormat = fileWriter->GetName(),
+                .FrameFormat = frameFormat == SANE_FRAME_RGB ? "RGB" : "Gray",
+                .Depth = depth,
+                .ImageSize = static_cast<size_t>(parameters.bytes_per_line) * parameters.lines,
+        };
+
+        auto filePath = options.OutputDirectory / ("gorfector-bench" + fileWriter->GetExtensions()[0]);
+        StageTimes times{};
+        auto finished = false;
+
+        ResetPeakRss();
+        auto process = new BenchScanProcess(
+                &device, appState, outputOptions, fileWriter, filePath, &times,
+                new std::function<void()>([&finished]() { finished = true; }));
+        if (!process->Start())
+        {
+            delete process;
+            return result;
+        }
+
+        while (!finished)
+        {
+            g_main_context_iteration(nullptr, TRUE);
+        }
+
+        const auto &statistics = device.GetStatistics();
+        result.Succeeded = statistics.BytesRead == result.ImageSize && std::filesystem::exists(filePath);
+        result.StartMilliseconds = Milliseconds(times.StartedTime - times.StartTime);
+        result.FirstReadMilliseconds = Milliseconds(statistics.FirstReadTime - statistics.StartTime);
+        result.ReadMilliseconds = Milliseconds(statistics.EndOfFrameTime - statistics.StartTime);
+        result.DrainMilliseconds = Milliseconds(times.StopTime - statistics.EndOfFrameTime);
+        result.CloseMilliseconds = Milliseconds(times.ClosedTime - times.StopTime);
+        result.TotalMilliseconds = Milliseconds(times.ClosedTime - times.StartTime);
+        result.MegabytesPerSecond = result.ImageSize / 1e6 / (result.TotalMilliseconds / 1000.0);
+        result.PeakRssMegabytes = GetPeakRssMegabytes();
+        result.BusyReadCount = statistics.BusyReadCount;
+
+        std::filesystem::remove(filePath);
+        return result;
+    }
+
+    nlohmann::json ToJson(const Result &result)
+    {
+        return nlohmann::json{
+                {"file_format", result.FileFormat},
+                {"frame_format", result.FrameFormat},
+                {"depth", result.Depth},
+                {"image_size", result.ImageSize},
+                {"succeeded", result.Succeeded},
+                {"mb_per_second", result.MegabytesPerSecond},
+                {"start_ms", result.StartMilliseconds},
+                {"first_read_ms", result.FirstReadMilliseconds},
+                {"read_ms", result.ReadMilliseconds},
+                {"drain_ms", result.DrainMilliseconds},
+                {"close_ms", result.CloseMilliseconds},
+                {"total_ms", result.TotalMilliseconds},
+                {"peak_rss_mb", result.PeakRssMegabytes},
+                {"busy_read_count", result.BusyReadCount},
+        };
+    }
+
+    bool ParseOptions(int argc, char **argv, Options &options)
+    {
+        for (auto i = 1; i < argc; ++i)
+        {
+            std::string_view argument = argv[i];
+            auto separator = argument.find('=');
+            auto name = argument.substr(0, separator);
+            auto value = separator == std::string_view::npos ? std::string{}
+                                                              : std::string(argument.substr(separator + 1));
+
+            try
+            {
+                if (name == "--width")
+                    options.Width = std::stoi(value);
+                else if (name == "--lines")
+                    options.Lines = std::stoi(value);
+                else if (name == "--bytes_per_second")
+                    options.BytesPerSecond = std::stod(value);
+                else if (name == "--busy_interval")
+                    options.BusyInterval = std::stoul(value);
+                else if (name == "--busy_ms")
+                    options.BusyMilliseconds = std::stoul(value);
+                else if (name == "--jitter")
+                    options.ReadSizeJitter = std::stod(value);
+                else if (name == "--output_dir")
+                    options.OutputDirectory = value;
+                else if (name == "--json")
+                    options.JsonFilePath = value;
+                else
+                    return false;
+            }
+            catch (const std::exception &)
+            {
+                return false;
+            }
+        }
+
+        return options.Width > 0 && options.Lines > 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options{};
+    if (!ParseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--width=PIXELS] [--lines=LINES] [--bytes_per_second=N] [--busy_interval=READS] [--busy_ms=MS]"
+                     " [--jitter=FRACTION] [--output_dir=DIR] [--json=FILE]"
+                  << std::endl;
+        return 2;
+    }
+
+    ZooLib::State state;
+    AppState appState(&state, false);
+    OutputOptionsState outputOptions(&state);
+
+    std::vector<std::unique_ptr<FileWriter>> fileWriters;
+    fileWriters.push_back(std::make_unique<TiffWriter>(&state, "gorfector-bench"));
+    fileWriters.push_back(std::make_unique<PngWriter>(&state, "gorfector-bench"));
+    fileWriters.push_back(std::make_unique<JpegWriter>(&state, "gorfector-bench"));
+
+    const std::pair<SANE_Frame, int> frameFormats[] = {
+            {SANE_FRAME_GRAY, 1}, {SANE_FRAME_GRAY, 8}, {SANE_FRAME_GRAY, 16},
+            {SANE_FRAME_RGB, 8},  {SANE_FRAME_RGB, 16},
+    };
+
+    std::cout << std::format(
+                         "{:<6} {:<5} {:>5} {:>9} {:>9} {:>9} {:>10} {:>9} {:>9} {:>9} {:>9} {:>10}", "file", "frame",
+                         "depth", "size MB", "MB/s", "start ms", "1st rd ms", "read ms", "drain ms", "close ms",
+                         "total ms", "peak RSS")
+              << std::endl;
+
+    auto results = nlohmann::json::array();
+    auto succeeded = true;
+    for (const auto &fileWriter: fileWriters)
+    {
+        for (const auto &[frameFormat, depth]: frameFormats)
+        {
+            auto result = Run(options, fileWriter.get(), frameFormat, depth, &appState, &outputOptions);
+            succeeded = succeeded && result.Succeeded;
+            results.push_back(ToJson(result));
+
+            std::cout << std::format(
+                                 "{:<6} {:<5} {:>5} {:>9.1f} {:>9.1f} {:>9.2f} {:>10.2f} {:>9.1f} {:>9.1f} {:>9.1f} "
+                                 "{:>9.1f} {:>7.1f} MB{}",
+                                 result.FileFormat, result.FrameFormat, result.Depth, result.ImageSize / 1e6,
+                                 result.MegabytesPerSecond, result.StartMilliseconds, result.FirstReadMilliseconds,
+                                 result.ReadMilliseconds, result.DrainMilliseconds, result.CloseMilliseconds,
+                                 result.TotalMilliseconds, result.PeakRssMegabytes, result.Succeeded ? "" : "  FAILED")
+                      << std::endl;
+        }
+    }
+
+    if (!options.JsonFilePath.empty())
+    {
+        std::ofstream(options.JsonFilePath) << results.dump(4);
+    }
+
+    return succeeded ? 0 : 1;
+}
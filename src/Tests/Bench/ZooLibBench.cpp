@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "Measure.hpp"
+#include "StateComponents.hpp"
+#include "ZooLib/CommandDispatcher.hpp"
+#include "ZooLib/ObserverManager.hpp"
+
+// Times the ZooLib operations run for each user interaction on synthetic data sized like a large application. The
+// unit tests check the results; this program only checks that the work was done.
+
+using namespace TestsSupport;
+using namespace ZooLib;
+
+namespace
+{
+    // Counts its runs and updates the component it modifies, so that its dependents are notified.
+    class ObserverThatUpdates : public Observer
+    {
+        size_t *m_RunCount{};
+
+    protected:
+        void UpdateImplementation() override
+        {
+            ++*m_RunCount;
+            StateComponentA::Updater updater(static_cast<StateComponentA *>(m_ModifiedComponents[0]));
+        }
+
+    public:
+        ObserverThatUpdates(
+                std::vector<const StateComponent *> observedComponents,
+                std::vector<StateComponent *> modifiedComponents, size_t *runCount)
+            : Observer(std::move(observedComponents), std::move(modifiedComponents))
+            , m_RunCount(runCount)
+        {
+        }
+    };
+
+    bool RunObserverManagerBenchmarks()
+    {
+        constexpr size_t k_ComponentCount = 2000;
+        constexpr size_t k_ObserverCount = 5000;
+
+        State state{};
+        std::vector<std::unique_ptr<StateComponentA>> components{};
+        std::vector<std::unique_ptr<ObserverThatUpdates>> observers{};
+        size_t runCount{};
+        ObserverManager observerManager{};
+
+        for (auto i = 0UZ; i < k_ComponentCount; ++i)
+        {
+            components.push_back(std::make_unique<StateComponentA>(&state));
+        }
+
+        // Observer i modifies one component, and observes two components with a lower index, so that the graph has no
+        // cycle. Observers are added in an order that does not match the dependencies.
+        for (auto i = 0UZ; i < k_ObserverCount; ++i)
+        {
+            auto modified = 1 + (i * 7919) % (k_ComponentCount - 1);
+            auto observed1 = (i * 31) % modified;
+            auto observed2 = (i * 17) % modified;
+            observers.push_back(std::make_unique<ObserverThatUpdates>(
+                    std::vector<const StateComponent *>{components[observed1].get(), components[observed2].get()},
+                    std::vector<StateComponent *>{components[modified].get()}, &runCount));
+            observerManager.AddObserver(observers.back().get());
+        }
+
+        Measure("Sort and notify all observers", 1, [&]() { observerManager.NotifyObservers(); });
+        auto success = runCount == k_ObserverCount;
+
+        state.SetComponentChangedCallback([&observerManager](const StateComponent *stateComponent) {
+            observerManager.MarkComponentChanged(stateComponent);
+        });
+
+        runCount = 0;
+        Measure("Notify the observers of 1000 changed components", 1000, [&]() {
+            for (auto i = 0UZ; i < 1000; ++i)
+            {
+                {
+                    StateComponentA::Updater updater(components[(i * 13) % k_ComponentCount].get());
+                }
+                observerManager.NotifyObservers();
+            }
+        });
+        success = success && runCount > 0;
+
+        uint64_t sum = 0;
+        Measure("Get the most recent observed version of all components", k_ComponentCount, [&]() {
+            for (auto &component: components)
+            {
+                sum += observerManager.GetMostRecentObservedVersion(component.get());
+            }
+        });
+        success = success && sum > 0;
+
+        Measure("Remove half of the observers and sort the others", 1, [&]() {
+            for (auto i = 0UZ; i < k_ObserverCount; i += 2)
+            {
+                observerManager.RemoveObserver(observers[i].get());
+            }
+            observerManager.NotifyObservers();
+        });
+        success = success && !observerManager.HasPendingNotifications();
+
+        state.SetComponentChangedCallback(nullptr);
+        return success;
+    }
+
+    // Commands of distinct types, so that the dispatchers hold several handlers.
+    template<int N>
+    class BenchmarkCommand : public Command
+    {
+    public:
+        static void Execute(const BenchmarkCommand &command, uint64_t *count)
+        {
+            ++*count;
+        }
+    };
+
+    template<int... N>
+    void RegisterHandlers(CommandDispatcher &dispatcher, uint64_t *count, std::integer_sequence<int, N...>)
+    {
+        (dispatcher.RegisterHandler(BenchmarkCommand<N>::Execute, count), ...);
+    }
+
+    template<typename TCommand>
+    void MeasureDispatch(const char *name, CommandDispatcher &dispatcher, size_t dispatchCount)
+    {
+        Measure(name, dispatchCount, [&dispatcher, dispatchCount]() {
+            for (auto i = 0UZ; i < dispatchCount; ++i)
+            {
+                dispatcher.Dispatch(TCommand());
+            }
+        });
+    }
+
+    bool RunCommandDispatcherBenchmarks()
+    {
+        constexpr uint64_t k_DispatchCount = 1000000;
+
+        uint64_t count{};
+        CommandDispatcher grandParent;
+        CommandDispatcher parent(&grandParent);
+        CommandDispatcher dispatcher(&parent);
+        RegisterHandlers(grandParent, &count, std::make_integer_sequence<int, 32>{});
+
+        MeasureDispatch<BenchmarkCommand<17>>("Dispatch to a handler of the grandparent", dispatcher, k_DispatchCount);
+        auto success = count == k_DispatchCount;
+
+        count = 0;
+        MeasureDispatch<BenchmarkCommand<17>>("Dispatch to a local handler", grandParent, k_DispatchCount);
+        success = success && count == k_DispatchCount;
+
+        count = 0;
+        MeasureDispatch<BenchmarkCommand<64>>("Dispatch a command without handler", dispatcher, k_DispatchCount);
+        success = success && count == 0;
+
+        return success;
+    }
+}
+
+int main()
+{
+    auto success = RunObserverManagerBenchmarks();
+    success = RunCommandDispatcherBenchmarks() && success;
+    if (!success)
+    {
+        std::cerr << "A benchmark did not produce the expected results." << std::endl;
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+
+#include "DeviceDiscovery.hpp"
+#include "SaneTestBackend.hpp"
+
+namespace Gorfector
+{
+    class Gorfector_DeviceDiscoveryTests : public testing::Test
+    {
+    protected:
+        TestsSupport::SaneTestBackend m_SaneBackend{"DeviceDiscoveryTests", 2};
+    };
+
+    TEST_F(Gorfector_DeviceDiscoveryTests, DiscoversTestDevices)
+    {
+        auto result = DeviceDiscovery::Discover(false);
+
+        ASSERT_TRUE(result.Succeeded);
+        ASSERT_EQ(2UZ, result.Devices.size());
+        EXPECT_EQ("test:0", result.Devices[0].Name);
+        EXPECT_EQ("test:1", result.Devices[1].Name);
+        EXPECT_EQ("Noname", result.Devices[0].Vendor);
+        EXPECT_EQ("frontend-tester", result.Devices[0].Model);
+    }
+
+    TEST_F(Gorfector_DeviceDiscoveryTests, DiscoveryRunsOnWorkerThread)
+    {
+        std::atomic<int> completedCount{};
+        std::atomic<std::thread::id> completedThreadId{};
+        DeviceDiscovery discovery([&]() {
+            completedThreadId = std::this_thread::get_id();
+            ++completedCount;
+        });
+
+        EXPECT_FALSE(discovery.TakeResult().has_value());
+
+        discovery.Start(false);
+        auto result = discovery.WaitForResult();
+
+        ASSERT_TRUE(result.has_value());
+        EXPECT_EQ(2UZ, result->Devices.size());
+        EXPECT_FALSE(discovery.IsRunning());
+        EXPECT_FALSE(discovery.TakeResult().has_value());
+
+        // WaitForResult() returns before the completion callback is called.
+        discovery.Start(false);
+        discovery.WaitForResult();
+        while (completedCount < 2)
+        {
+            std::this_thread::yield();
+        }
+        EXPECT_NE(std::this_thread::get_id(), completedThreadId.load());
+    }
+
+    TEST_F(Gorfector_DeviceDiscoveryTests, DiscoveredDevicesCanBeOpened)
+    {
+        DeviceDiscovery discovery(nullptr);
+        discovery.Start(false);
+        auto result = discovery.WaitForResult();
+        ASSERT_TRUE(result.has_value());
+        ASSERT_FALSE(result->Devices.empty());
+
+        // The device was discovered on the worker thread, and is opened on this one.
+        SaneDevice device(result->Devices[0]);
+        EXPECT_TRUE(device.Open());
+        device.Close();
+    }
+
+    TEST_F(Gorfector_DeviceDiscoveryTests, DeviceInfoOutlivesSane)
+    {
+        auto result = DeviceDiscovery::Discover(false);
+        ASSERT_FALSE(result.Devices.empty());
+
+        sane_exit();
+        SaneDevice device(result.Devices[1]);
+        EXPECT_STREQ("test:1", device.GetName());
+        EXPECT_STREQ("Noname", device.GetVendor());
+    }
+}
@@ -0,0 +1,99 @@
+#include "gtest/gtest.h"
+
+#include <filesystem>
+
+#include "DeviceOptionCache.hpp"
+#include "SaneTestBackend.hpp"
+
+namespace Gorfector
+{
+    class Gorfector_DeviceOptionCacheTests : public testing::Test
+    {
+    protected:
+        std::filesystem::path m_Directory{};
+        std::filesystem::path m_FilePath{};
+
+        void SetUp() override
+        {
+            m_Directory = std::filesystem::path(testing::TempDir()) / "DeviceOptionCacheTests";
+            std::filesystem::create_directories(m_Directory);
+            m_FilePath = m_Directory / "option-cache.bin";
+            std::filesystem::remove(m_FilePath);
+        }
+
+        void TearDown() override
+        {
+            std::filesystem::remove_all(m_Directory);
+        }
+
+        static OptionSnapshot Values(int resolution)
+        {
+            return *OptionSnapshot::FromJson(nlohmann::json{{"resolution", {resolution}}, {"mode", {"Color"}}});
+        }
+    };
+
+    TEST_F(Gorfector_DeviceOptionCacheTests, FindsStoredValues)
+    {
+        DeviceOptionCache cache(m_FilePath);
+        EXPECT_EQ(nullptr, cache.Find("Noname", "frontend-tester", "1234"));
+
+        cache.Store("Noname", "frontend-tester", "1234", Values(300));
+
+        auto values = cache.Find("Noname", "frontend-tester", "1234");
+        ASSERT_NE(nullptr, values);
+        EXPECT_EQ(Values(300).ToJson(), values->ToJson());
+        EXPECT_EQ(nullptr, cache.Find("Noname", "frontend-tester", "5678"));
+        EXPECT_EQ(nullptr, cache.Find("Noname", "other", "1234"));
+    }
+
+    TEST_F(Gorfector_DeviceOptionCacheTests, KeepsLatestOptionHashOfModel)
+    {
+        DeviceOptionCache cache(m_FilePath);
+        cache.Store("Noname", "frontend-tester", "1234", Values(300));
+        cache.Store("Noname", "frontend-tester2", "1234", Values(150));
+        cache.Store("Noname", "frontend-tester", "5678", Values(600));
+
+        EXPECT_EQ(nullptr, cache.Find("Noname", "frontend-tester", "1234"));
+        ASSERT_NE(nullptr, cache.Find("Noname", "frontend-tester", "5678"));
+        EXPECT_EQ(Values(600).ToJson(), cache.Find("Noname", "frontend-tester", "5678")->ToJson());
+        ASSERT_NE(nullptr, cache.Find("Noname", "frontend-tester2", "1234"));
+    }
+
+    TEST_F(Gorfector_DeviceOptionCacheTests, ValuesArePersisted)
+    {
+        {
+            DeviceOptionCache cache(m_FilePath);
+            cache.Store("Noname", "frontend-tester", "1234", Values(300));
+        }
+
+        DeviceOptionCache cache(m_FilePath);
+        auto values = cache.Find("Noname", "frontend-tester", "1234");
+        ASSERT_NE(nullptr, values);
+        EXPECT_EQ(Values(300).ToJson(), values->ToJson());
+    }
+
+    TEST_F(Gorfector_DeviceOptionCacheTests, OptionHashIsStable)
+    {
+        TestsSupport::SaneTestBackend saneBackend("DeviceOptionCacheTests_Sane", 1);
+
+        SANE_Int saneVersion;
+        ASSERT_EQ(SANE_STATUS_GOOD, sane_init(&saneVersion, nullptr));
+
+        SaneDevice device(SaneDeviceInfo("test:0", "Noname", "frontend-tester", "virtual device"));
+        ASSERT_TRUE(device.Open());
+
+        SANE_Int optionCount;
+        ASSERT_TRUE(device.GetOptionValue(0, &optionCount));
+        auto controlOptionCount = device.GetControlOptionCount();
+
+        auto options = DeviceOptionCache::DescribeOptions(&device, optionCount);
+        EXPECT_FALSE(options.empty());
+        EXPECT_EQ(
+                DeviceOptionCache::GetOptionHash(options),
+                DeviceOptionCache::GetOptionHash(DeviceOptionCache::DescribeOptions(&device, optionCount)));
+
+        // Describing the options does not read their values.
+        EXPECT_EQ(controlOptionCount, device.GetControlOptionCount());
+        device.Close();
+    }
+}
@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+
+#include "DeviceOptionsState.hpp"
+
+namespace Gorfector
+{
+    static WidgetIndex MakeIndex(uint32_t optionIndex, uint32_t valueIndex)
+    {
+        return WidgetIndex{{optionIndex, valueIndex}};
+    }
+
+    TEST(Gorfector_DeviceOptionsStateChangesetTests, IgnoresDuplicateIndices)
+    {
+        DeviceOptionsStateChangeset changeset(1);
+        changeset.AddChangedIndex(MakeIndex(3, 0));
+        changeset.AddChangedIndex(MakeIndex(3, 1));
+        changeset.AddChangedIndex(MakeIndex(3, 0));
+
+        ASSERT_EQ(changeset.GetChangedIndices().size(), 2);
+        EXPECT_EQ(changeset.GetChangedIndices()[0].CompositeIndex, MakeIndex(3, 0).CompositeIndex);
+        EXPECT_EQ(changeset.GetChangedIndices()[1].CompositeIndex, MakeIndex(3, 1).CompositeIndex);
+    }
+
+    TEST(Gorfector_DeviceOptionsStateChangesetTests, AggregatesWithoutDuplicates)
+    {
+        DeviceOptionsStateChangeset changeset1(1);
+        DeviceOptionsStateChangeset changeset2(2);
+        for (auto i = 0U; i < 1000; ++i)
+        {
+            changeset1.AddChangedIndex(MakeIndex(i, i % 3));
+            changeset2.AddChangedIndex(MakeIndex(i + 500, (i + 500) % 3));
+        }
+        changeset2.SetReloadOptions(true);
+
+        DeviceOptionsStateChangeset aggregated(0);
+        aggregated.Reset(1);
+        aggregated.Aggregate(changeset1);
+        aggregated.Aggregate(changeset2);
+
+        EXPECT_EQ(aggregated.GetStateInitialVersion(), 1);
+        EXPECT_TRUE(aggregated.ShouldRebuildOptions());
+        ASSERT_EQ(aggregated.GetChangedIndices().size(), 1500);
+        for (auto i = 0U; i < 1500; ++i)
+        {
+            EXPECT_EQ(aggregated.GetChangedIndices()[i].CompositeIndex, MakeIndex(i, i % 3).CompositeIndex);
+        }
+    }
+
+    TEST(Gorfector_DeviceOptionsStateChangesetTests, ResetClearsChanges)
+    {
+        DeviceOptionsStateChangeset changeset(1);
+        changeset.AddChangedIndex(MakeIndex(1, 0));
+        changeset.SetReloadOptions(true);
+
+        changeset.Reset(5);
+
+        EXPECT_EQ(changeset.GetStateInitialVersion(), 5);
+        EXPECT_FALSE(changeset.ShouldRebuildOptions());
+        EXPECT_TRUE(changeset.GetChangedIndices().empty());
+
+        changeset.AddChangedIndex(MakeIndex(1, 0));
+        EXPECT_EQ(changeset.GetChangedIndices().size(), 1);
+    }
+}
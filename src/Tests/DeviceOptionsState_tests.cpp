@@ -0,0 +1,293 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+
+#include "DeviceOptionCache.hpp"
+#include "DeviceOptionsState.hpp"
+#include "DeviceSelectorState.hpp"
+#include "SaneTestBackend.hpp"
+
+namespace Gorfector
+{
+    class Gorfector_DeviceOptionsStateTests : public testing::Test
+    {
+    protected:
+        // Destroyed last: SANE is exited after the devices are closed.
+        TestsSupport::SaneTestBackend m_SaneBackend{"DeviceOptionsStateTests", 1};
+        ZooLib::State *m_State{};
+        DeviceSelectorState *m_DeviceSelector{};
+        DeviceOptionsState *m_DeviceOptions{};
+
+        void SetUp() override
+        {
+            // The first device found is opened when the discovery completes.
+            m_State = new ZooLib::State();
+            m_DeviceSelector = new DeviceSelectorState(m_State);
+            while (m_DeviceSelector->IsDiscovering())
+            {
+                g_main_context_iteration(nullptr, TRUE);
+            }
+            ASSERT_EQ("test:0", m_DeviceSelector->GetSelectedDeviceName());
+
+            m_DeviceOptions = new DeviceOptionsState(m_State, "test:0");
+        }
+
+        void TearDown() override
+        {
+            delete m_DeviceOptions;
+            delete m_DeviceSelector;
+            delete m_State;
+        }
+
+        [[nodiscard]] SaneDevice *GetDevice() const
+        {
+            return m_DeviceSelector->GetDeviceByName("test:0");
+        }
+
+        void RebuildDeviceOptions()
+        {
+            delete m_DeviceOptions;
+            m_DeviceOptions = new DeviceOptionsState(m_State, "test:0");
+        }
+
+        /**
+         * Caches the current option values of the device, then sets the mode of the device to a different value.
+         * Returns the mode that is cached.
+         */
+        std::string CacheValuesAndChangeTheMode(DeviceOptionCache &optionCache)
+        {
+            delete m_DeviceOptions;
+            m_DeviceOptions = new DeviceOptionsState(m_State, "test:0", &optionCache);
+            auto modeIndex = GetOptionIndex("mode");
+            auto cachedMode = m_DeviceOptions->GetOption<std::string>(modeIndex)->GetValue(0);
+
+            RebuildDeviceOptions();
+            auto updater = DeviceOptionsState::Updater(m_DeviceOptions);
+            updater.SetOptionValue(modeIndex, 0, std::string(cachedMode == "Color" ? "Gray" : "Color"));
+            return cachedMode;
+        }
+
+        [[nodiscard]] uint32_t GetOptionIndex(const char *name) const
+        {
+            auto optionIndex = m_DeviceOptions->FindOptionIndex(name);
+            EXPECT_NE(DeviceOptionsState::k_InvalidIndex, optionIndex) << name;
+            return optionIndex;
+        }
+
+        /**
+         * Gets the number of round trips needed to reload the options.
+         */
+        [[nodiscard]] uint64_t GetReloadRoundTripCount() const
+        {
+            auto controlOptionCount = GetDevice()->GetControlOptionCount();
+            DeviceOptionsState::Updater(m_DeviceOptions).ReloadOptions();
+            return GetDevice()->GetControlOptionCount() - controlOptionCount;
+        }
+
+        /**
+         * Gets the options whose values changed since a version of the state, in the order they changed.
+         */
+        [[nodiscard]] std::vector<uint32_t> GetChangedOptions(uint64_t sinceVersion) const
+        {
+            DeviceOptionsStateChangeset changeset(sinceVersion);
+            m_DeviceOptions->AggregateChangesets(sinceVersion, changeset);
+
+            std::vector<uint32_t> changedOptions;
+            for (auto index: changeset.GetChangedIndices())
+            {
+                changedOptions.push_back(index.OptionValueIndices[0]);
+            }
+            return changedOptions;
+        }
+    };
+
+    TEST_F(Gorfector_DeviceOptionsStateTests, BatchWritesTheModeFirstAndTheScanAreaLast)
+    {
+        auto modeIndex = GetOptionIndex("mode");
+        auto resolutionIndex = GetOptionIndex("resolution");
+        auto tlxIndex = GetOptionIndex(DeviceOptionsState::k_TlxKey);
+
+        auto version = m_DeviceOptions->GetVersion();
+        DeviceOptionsState::BatchResult result;
+        {
+            auto updater = DeviceOptionsState::Updater(m_DeviceOptions);
+            updater.BeginBatch();
+            updater.SetOptionValue(tlxIndex, 0, 10.0);
+            updater.SetOptionValue(resolutionIndex, 0, 300.0);
+            updater.SetOptionValue(modeIndex, 0, std::string("Color"));
+            result = updater.CommitBatch();
+        }
+
+        // The values are only marked as changed when they are written.
+        EXPECT_EQ((std::vector{modeIndex, resolutionIndex, tlxIndex}), GetChangedOptions(version));
+        EXPECT_TRUE(result.Succeeded);
+        EXPECT_EQ(1U, result.ReloadCount);
+        EXPECT_EQ("Color", m_DeviceOptions->GetOption<std::string>(modeIndex)->GetValue(0));
+        EXPECT_EQ(SANE_FIX(300), m_DeviceOptions->GetOption<int>(resolutionIndex)->GetValue(0));
+        EXPECT_EQ(SANE_FIX(10), m_DeviceOptions->GetOption<int>(tlxIndex)->GetValue(0));
+    }
+
+    TEST_F(Gorfector_DeviceOptionsStateTests, OptionsThatReloadedTheOptionsAreWrittenFirst)
+    {
+        auto resolutionIndex = GetOptionIndex("resolution");
+        auto readLimitIndex = GetOptionIndex("read-limit");
+        ASSERT_LT(resolutionIndex, readLimitIndex);
+
+        {
+            auto updater = DeviceOptionsState::Updater(m_DeviceOptions);
+            updater.BeginBatch();
+            updater.SetOptionValue(readLimitIndex, 0, true);
+            EXPECT_EQ(1U, updater.CommitBatch().ReloadCount);
+        }
+
+        auto version = m_DeviceOptions->GetVersion();
+        {
+            auto updater = DeviceOptionsState::Updater(m_DeviceOptions);
+            updater.BeginBatch();
+            updater.SetOptionValue(resolutionIndex, 0, 200.0);
+            updater.SetOptionValue(readLimitIndex, 0, false);
+            EXPECT_TRUE(updater.CommitBatch().Succeeded);
+        }
+
+        EXPECT_EQ((std::vector{readLimitIndex, resolutionIndex}), GetChangedOptions(version));
+    }
+
+    TEST_F(Gorfector_DeviceOptionsStateTests, ReloadIsDeferredUntilAllValuesAreWritten)
+    {
+        auto reloadRoundTripCount = GetReloadRoundTripCount();
+        auto modeIndex = GetOptionIndex("mode");
+        auto readLimitIndex = GetOptionIndex("read-limit");
+
+        DeviceOptionsState::BatchResult result;
+        {
+            auto updater = DeviceOptionsState::Updater(m_DeviceOptions);
+            updater.BeginBatch();
+            updater.SetOptionValue(modeIndex, 0, std::string("Color"));
+            updater.SetOptionValue(readLimitIndex, 0, true);
+            result = updater.CommitBatch();
+        }
+
+        // Both options make the device reload the options, but they are reloaded once.
+        EXPECT_TRUE(result.Succeeded);
+        EXPECT_EQ(1U, result.ReloadCount);
+        EXPECT_EQ(2 + reloadRoundTripCount, result.RoundTripCount);
+        EXPECT_EQ(result.RoundTripCount, m_DeviceOptions->GetLastBatchResult().RoundTripCount);
+        EXPECT_TRUE(m_DeviceOptions->GetOption<bool>(readLimitIndex)->GetValue(0));
+    }
+
+    TEST_F(Gorfector_DeviceOptionsStateTests, OptionDeactivatedByAWriteIsNotWritten)
+    {
+        // The read limit size is only active when the read limit is enabled. The options that are inactive when the
+        // device options are built are not listed, so enable the limit first.
+        {
+            auto updater = DeviceOptionsState::Updater(m_DeviceOptions);
+            updater.SetOptionValue(GetOptionIndex("read-limit"), 0, true);
+        }
+        RebuildDeviceOptions();
+
+        auto reloadRoundTripCount = GetReloadRoundTripCount();
+        auto readLimitIndex = GetOptionIndex("read-limit");
+        auto readLimitSizeIndex = GetOptionIndex("read-limit-size");
+        ASSERT_FALSE(m_DeviceOptions->GetOption(readLimitSizeIndex)->ShouldHide());
+
+        DeviceOptionsState::BatchResult result;
+        {
+            auto updater = DeviceOptionsState::Updater(m_DeviceOptions);
+            updater.BeginBatch();
+            updater.SetOptionValue(readLimitIndex, 0, false);
+            updater.SetOptionValue(readLimitSizeIndex, 0, 200);
+            result = updater.CommitBatch();
+        }
+
+        // The size is inactive once the limit is disabled: it is neither written nor reported as not accepted.
+        EXPECT_TRUE(result.Succeeded);
+        EXPECT_EQ(1U, result.ReloadCount);
+        EXPECT_EQ(1 + reloadRoundTripCount, result.RoundTripCount);
+        EXPECT_TRUE(m_DeviceOptions->GetOption(readLimitSizeIndex)->ShouldHide());
+    }
+
+    TEST_F(Gorfector_DeviceOptionsStateTests, BatchStopsWhenTheDeviceAdjustsAValue)
+    {
+        auto modeIndex = GetOptionIndex("mode");
+
+        DeviceOptionsState::BatchResult result;
+        {
+            auto updater = DeviceOptionsState::Updater(m_DeviceOptions);
+            updater.BeginBatch();
+            // The device matches the value with its list of modes, and keeps "Color".
+            updater.SetOptionValue(modeIndex, 0, std::string("color"));
+            result = updater.CommitBatch();
+        }
+
+        EXPECT_FALSE(result.Succeeded);
+        EXPECT_GE(result.ReloadCount, 1U);
+        EXPECT_LE(result.ReloadCount, static_cast<uint32_t>(DeviceOptionsState::Updater::k_MaxBatchPassCount));
+        EXPECT_FALSE(m_DeviceOptions->GetLastBatchResult().Succeeded);
+        EXPECT_EQ("Color", m_DeviceOptions->GetOption<std::string>(modeIndex)->GetValue(0));
+    }
+
+    TEST_F(Gorfector_DeviceOptionsStateTests, CachedValuesAreRefreshedFromTheMainLoop)
+    {
+        DeviceOptionCache optionCache(m_SaneBackend.GetConfigDir() / "cache.json");
+        auto cachedMode = CacheValuesAndChangeTheMode(optionCache);
+
+        delete m_DeviceOptions;
+        m_DeviceOptions = new DeviceOptionsState(m_State, "test:0", &optionCache);
+        auto modeIndex = GetOptionIndex("mode");
+        EXPECT_EQ(cachedMode, m_DeviceOptions->GetOption<std::string>(modeIndex)->GetValue(0));
+
+        // The values are read on a worker thread and applied on the main thread.
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (m_DeviceOptions->GetOption<std::string>(modeIndex)->GetValue(0) == cachedMode &&
+               std::chrono::steady_clock::now() < deadline)
+        {
+            g_main_context_iteration(nullptr, FALSE);
+        }
+
+        EXPECT_NE(cachedMode, m_DeviceOptions->GetOption<std::string>(modeIndex)->GetValue(0));
+    }
+
+    TEST_F(Gorfector_DeviceOptionsStateTests, UpdaterWaitsForTheRefreshOfTheCachedValues)
+    {
+        DeviceOptionCache optionCache(m_SaneBackend.GetConfigDir() / "cache.json");
+        auto cachedMode = CacheValuesAndChangeTheMode(optionCache);
+
+        delete m_DeviceOptions;
+        m_DeviceOptions = new DeviceOptionsState(m_State, "test:0", &optionCache);
+        auto modeIndex = GetOptionIndex("mode");
+        {
+            // Without running the main loop.
+            auto updater = DeviceOptionsState::Updater(m_DeviceOptions);
+        }
+
+        EXPECT_NE(cachedMode, m_DeviceOptions->GetOption<std::string>(modeIndex)->GetValue(0));
+
+        // The refresh is not applied a second time.
+        auto version = m_DeviceOptions->GetVersion();
+        while (g_main_context_iteration(nullptr, FALSE))
+        {
+        }
+        EXPECT_EQ(version, m_DeviceOptions->GetVersion());
+    }
+
+    TEST_F(Gorfector_DeviceOptionsStateTests, ClosingTheDeviceWaitsForTheRefreshOfTheCachedValues)
+    {
+        DeviceOptionCache optionCache(m_SaneBackend.GetConfigDir() / "cache.json");
+        auto cachedMode = CacheValuesAndChangeTheMode(optionCache);
+
+        delete m_DeviceOptions;
+        m_DeviceOptions = new DeviceOptionsState(m_State, "test:0", &optionCache);
+        auto modeIndex = GetOptionIndex("mode");
+
+        // SANE handles are not reentrant: the handle is closed once the values are read.
+        GetDevice()->Close();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (m_DeviceOptions->GetOption<std::string>(modeIndex)->GetValue(0) == cachedMode &&
+               std::chrono::steady_clock::now() < deadline)
+        {
+            g_main_context_iteration(nullptr, FALSE);
+        }
+
+        EXPECT_NE(cachedMode, m_DeviceOptions->GetOption<std::string>(modeIndex)->GetValue(0));
+    }
+}
@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 
 #include "CompareFiles.hpp"
+#include "FileSizeLimit.hpp"
 #include "Writers/JpegWriter.hpp"
 
 #include "ImageGenerator.hpp"
@@ -35,6 +36,77 @@ namespace Gorfector
             m_ExpectedFilePath = std::filesystem::path(g_DataDir) / expectedFileName;
         }
 
+        // Decodes a JPEG file to 8 bit samples.
+        static std::vector<JSAMPLE> DecodeJpeg(const std::filesystem::path &path)
+        {
+            std::vector<JSAMPLE> samples;
+            auto file = fopen(path.c_str(), "rb");
+            if (file == nullptr)
+            {
+                return samples;
+            }
+
+            jpeg_decompress_struct decompressStruct{};
+            jpeg_error_mgr errorHandler{};
+            decompressStruct.err = jpeg_std_error(&errorHandler);
+            jpeg_create_decompress(&decompressStruct);
+            jpeg_stdio_src(&decompressStruct, file);
+            jpeg_read_header(&decompressStruct, TRUE);
+            jpeg_start_decompress(&decompressStruct);
+
+            auto rowSize = decompressStruct.output_width * decompressStruct.output_components;
+            samples.resize(rowSize * decompressStruct.output_height);
+            while (decompressStruct.output_scanline < decompressStruct.output_height)
+            {
+                JSAMPROW row = &samples[decompressStruct.output_scanline * rowSize];
+                jpeg_read_scanlines(&decompressStruct, &row, 1);
+            }
+
+            jpeg_finish_decompress(&decompressStruct);
+            jpeg_destroy_decompress(&decompressStruct);
+            fclose(file);
+
+            return samples;
+        }
+
+        // Writes the image with one thread then with several threads, and checks that both files decode to the same
+        // pixels: restart markers change the entropy coding, not the quantized coefficients.
+        void ExpectParallelJpegEq(SANE_Byte *buffer, const SANE_Parameters &saneParameters)
+        {
+            auto serialFilePath = m_TestFilePath;
+            serialFilePath.replace_extension(".serial.jpg");
+
+            for (auto workerCount: {1, 3})
+            {
+                auto path = workerCount == 1 ? serialFilePath : m_TestFilePath;
+                JpegWriter writer(m_State, std::string(typeid(Gorfector_JpegWriterTestsFixture).name()));
+                {
+                    auto updater = JpegWriterState::Updater(writer.GetStateComponent());
+                    updater.SetWorkerCount(workerCount);
+                }
+
+                writer.CreateFile(path, nullptr, saneParameters);
+                for (auto i = 0; i < saneParameters.lines; i += 10)
+                {
+                    auto lines = std::min(10, saneParameters.lines - i);
+                    auto row = buffer + i * saneParameters.bytes_per_line;
+                    auto byteWritten = writer.AppendBytes(row, lines, saneParameters);
+                    EXPECT_EQ(byteWritten, lines * saneParameters.bytes_per_line) << "Failed to write row " << i;
+                }
+                EXPECT_EQ(FileWriter::Error::None, writer.CloseFile());
+            }
+
+            auto serialSamples = DecodeJpeg(serialFilePath);
+            auto parallelSamples = DecodeJpeg(m_TestFilePath);
+            ASSERT_FALSE(serialSamples.empty());
+            EXPECT_TRUE(serialSamples == parallelSamples);
+
+            if (g_CleanArtifacts)
+            {
+                std::filesystem::remove(serialFilePath);
+            }
+        }
+
         void TearDown() override
         {
             delete m_State;
@@ -181,4 +253,83 @@ namespace Gorfector
 
         delete[] buffer;
     }
+
+    TEST_F(Gorfector_JpegWriterTestsFixture, CanWrite8BitColorJpegWithRestartIntervals)
+    {
+        SANE_Parameters saneParameters;
+        SANE_Byte *buffer = nullptr;
+        size_t bufferSize = 0;
+        ImageGenerator::Generate8BitColorImage(1200, 900, &saneParameters, &buffer, &bufferSize);
+
+        ExpectParallelJpegEq(buffer, saneParameters);
+
+        delete[] buffer;
+    }
+
+    TEST_F(Gorfector_JpegWriterTestsFixture, CanWrite16bitsGrayscaleJpegWithRestartIntervals)
+    {
+        SANE_Parameters saneParameters;
+        SANE_Byte *buffer = nullptr;
+        size_t bufferSize = 0;
+        ImageGenerator::Generate16BitGrayscaleImage(1000, 700, &saneParameters, &buffer, &bufferSize);
+
+        ExpectParallelJpegEq(buffer, saneParameters);
+
+        delete[] buffer;
+    }
+
+    TEST_F(Gorfector_JpegWriterTestsFixture, BandEncodingErrorsRemoveTheFile)
+    {
+        // Wider than the largest JPEG image libjpeg accepts: every band fails to start.
+        SANE_Parameters saneParameters{
+                .format = SANE_FRAME_GRAY,
+                .last_frame = SANE_TRUE,
+                .bytes_per_line = 70000,
+                .pixels_per_line = 70000,
+                .lines = 32,
+                .depth = 8,
+        };
+        std::vector<SANE_Byte> buffer(static_cast<size_t>(saneParameters.bytes_per_line) * saneParameters.lines);
+
+        JpegWriter writer(m_State, std::string(typeid(Gorfector_JpegWriterTestsFixture).name()));
+        {
+            auto updater = JpegWriterState::Updater(writer.GetStateComponent());
+            updater.SetWorkerCount(2);
+        }
+
+        ASSERT_EQ(FileWriter::Error::None, writer.CreateFile(m_TestFilePath, nullptr, saneParameters));
+        writer.AppendBytes(buffer.data(), saneParameters.lines, saneParameters);
+        EXPECT_EQ(FileWriter::Error::CannotWriteFile, writer.CloseFile());
+
+        EXPECT_FALSE(std::filesystem::exists(m_TestFilePath));
+    }
+
+    TEST_F(Gorfector_JpegWriterTestsFixture, WriteErrorsRemoveTheFile)
+    {
+        SANE_Parameters saneParameters;
+        SANE_Byte *buffer = nullptr;
+        size_t bufferSize = 0;
+        ImageGenerator::Generate8BitColorImage(100, 100, &saneParameters, &buffer, &bufferSize);
+
+        for (auto workerCount: {1, 2})
+        {
+            JpegWriter writer(m_State, std::string(typeid(Gorfector_JpegWriterTestsFixture).name()));
+            {
+                auto updater = JpegWriterState::Updater(writer.GetStateComponent());
+                updater.SetWorkerCount(workerCount);
+            }
+
+            ASSERT_EQ(FileWriter::Error::None, writer.CreateFile(m_TestFilePath, nullptr, saneParameters));
+            {
+                // The file cannot hold more than the JPEG start of image marker.
+                TestsSupport::FileSizeLimit limit(2);
+                writer.AppendBytes(buffer, saneParameters.lines, saneParameters);
+                EXPECT_EQ(FileWriter::Error::CannotWriteFile, writer.CloseFile()) << workerCount << " workers";
+            }
+
+            EXPECT_FALSE(std::filesystem::exists(m_TestFilePath)) << workerCount << " workers";
+        }
+
+        delete[] buffer;
+    }
 }
@@ -0,0 +1,156 @@
+#include "gtest/gtest.h"
+
+#include <filesystem>
+
+#include "DeviceOptionsState.hpp"
+#include "OptionSnapshot.hpp"
+
+namespace Gorfector
+{
+    static nlohmann::json TestSettings()
+    {
+        return nlohmann::json{
+                {DeviceOptionsState::k_DeviceKey,
+                 {{DeviceOptionsState::k_DeviceNameKey, "test:0"},
+                  {DeviceOptionsState::k_DeviceVendorKey, "Noname"},
+                  {DeviceOptionsState::k_DeviceModelKey, "frontend-tester"},
+                  {DeviceOptionsState::k_DeviceTypeKey, "virtual device"}}},
+                {DeviceOptionsState::k_OptionsKey,
+                 {{"preview", {false}},
+                  {"resolution", {300}},
+                  {"gamma-table", {0, 1, 2, 3}},
+                  {"mode", {"Color"}},
+                  {"source", {"Flatbed", "ADF"}}}},
+        };
+    }
+
+    TEST(Gorfector_OptionSnapshotTests, JsonRoundTrip)
+    {
+        auto settings = TestSettings();
+        auto snapshot = OptionSnapshot::FromJson(settings);
+
+        ASSERT_TRUE(snapshot.has_value());
+        EXPECT_TRUE(snapshot->HasDevice());
+        EXPECT_EQ("Noname", snapshot->GetDeviceVendor());
+        EXPECT_EQ("frontend-tester", snapshot->GetDeviceModel());
+        EXPECT_EQ(5U, snapshot->GetOptionCount());
+        EXPECT_EQ(settings, snapshot->ToJson());
+    }
+
+    TEST(Gorfector_OptionSnapshotTests, OptionsAreReadInOrder)
+    {
+        auto snapshot = OptionSnapshot::FromJson(TestSettings());
+        ASSERT_TRUE(snapshot.has_value());
+
+        // nlohmann::json objects are sorted by key.
+        std::vector<std::string> names;
+        snapshot->ForEachOption([&names](const OptionSnapshot::Option &option) {
+            names.emplace_back(option.GetName());
+            if (option.GetName() == "gamma-table")
+            {
+                EXPECT_EQ(OptionSnapshot::ValueType::e_Int, option.GetType());
+                EXPECT_EQ(4U, option.GetValueCount());
+                EXPECT_EQ(3, option.GetInt(3));
+            }
+            else if (option.GetName() == "source")
+            {
+                EXPECT_EQ(OptionSnapshot::ValueType::e_String, option.GetType());
+                EXPECT_EQ("ADF", option.GetString(1));
+            }
+            else if (option.GetName() == "preview")
+            {
+                EXPECT_EQ(OptionSnapshot::ValueType::e_Bool, option.GetType());
+                EXPECT_FALSE(option.GetBool(0));
+            }
+        });
+
+        EXPECT_EQ((std::vector<std::string>{"gamma-table", "mode", "preview", "resolution", "source"}), names);
+    }
+
+    TEST(Gorfector_OptionSnapshotTests, ScanAreaHasNoDevice)
+    {
+        auto scanArea = nlohmann::json{
+                {DeviceOptionsState::k_TlxKey, {0}},
+                {DeviceOptionsState::k_TlyKey, {0}},
+                {DeviceOptionsState::k_BrxKey, {13959168}},
+                {DeviceOptionsState::k_BryKey, {19464192}},
+        };
+        auto snapshot = OptionSnapshot::FromJson(scanArea);
+
+        ASSERT_TRUE(snapshot.has_value());
+        EXPECT_FALSE(snapshot->HasDevice());
+        EXPECT_EQ(4U, snapshot->GetOptionCount());
+        EXPECT_EQ(scanArea, snapshot->ToJson());
+    }
+
+    TEST(Gorfector_OptionSnapshotTests, InvalidOptionsAreSkipped)
+    {
+        auto settings = nlohmann::json{
+                {"empty", nlohmann::json::array()},
+                {"not-an-array", 1},
+                {"mixed", {1, "a"}},
+                {"valid", {1}},
+        };
+        auto snapshot = OptionSnapshot::FromJson(settings);
+
+        ASSERT_TRUE(snapshot.has_value());
+        EXPECT_EQ(1U, snapshot->GetOptionCount());
+        EXPECT_EQ((nlohmann::json{{"valid", {1}}}), snapshot->ToJson());
+        EXPECT_FALSE(OptionSnapshot::FromJson(nlohmann::json::array()).has_value());
+    }
+
+    TEST(Gorfector_OptionSnapshotTests, TruncatedBytesAreRejected)
+    {
+        auto snapshot = OptionSnapshot::FromJson(TestSettings());
+        ASSERT_TRUE(snapshot.has_value());
+
+        auto bytes = snapshot->GetBytes();
+        for (auto size = 0UZ; size < bytes.size(); ++size)
+        {
+            EXPECT_FALSE(OptionSnapshot::FromBytes(bytes.first(size), nullptr).has_value());
+        }
+        EXPECT_TRUE(OptionSnapshot::FromBytes(bytes, nullptr).has_value());
+    }
+
+    TEST(Gorfector_OptionSnapshotTests, FileRoundTrip)
+    {
+        auto filePath = std::filesystem::path(testing::TempDir()) / "OptionSnapshotTests.bin";
+
+        auto scanArea = nlohmann::json{{DeviceOptionsState::k_TlxKey, {10}}};
+        std::map<std::string, OptionSnapshot> snapshots;
+        snapshots.emplace("Device A", *OptionSnapshot::FromJson(TestSettings()));
+        snapshots.emplace("Device B", *OptionSnapshot::FromJson(scanArea));
+        ASSERT_TRUE(OptionSnapshotFile::Write(filePath, snapshots));
+
+        auto readSnapshots = OptionSnapshotFile::Read(filePath);
+        std::filesystem::remove(filePath);
+
+        ASSERT_TRUE(readSnapshots.has_value());
+        ASSERT_EQ(2UZ, readSnapshots->size());
+        EXPECT_EQ(TestSettings(), readSnapshots->at("Device A").ToJson());
+        EXPECT_EQ(scanArea, readSnapshots->at("Device B").ToJson());
+    }
+
+    TEST(Gorfector_OptionSnapshotTests, InvalidFileIsRejected)
+    {
+        auto filePath = std::filesystem::path(testing::TempDir()) / "NoSuchFile.bin";
+        EXPECT_FALSE(OptionSnapshotFile::Read(filePath).has_value());
+    }
+
+    TEST(Gorfector_OptionSnapshotTests, CacheCompilesOnce)
+    {
+        OptionSnapshotCache<std::string> cache;
+        auto settings = TestSettings();
+
+        auto snapshot = cache.Get("A", &settings);
+        ASSERT_NE(nullptr, snapshot);
+        EXPECT_EQ(snapshot, cache.Get("A", &settings));
+        EXPECT_EQ(nullptr, cache.Get("B", nullptr));
+
+        cache.Erase("A");
+        auto otherSettings = nlohmann::json{{"resolution", {600}}};
+        auto otherSnapshot = cache.Get("A", &otherSettings);
+        ASSERT_NE(nullptr, otherSnapshot);
+        EXPECT_EQ(otherSettings, otherSnapshot->ToJson());
+    }
+}
@@ -0,0 +1,234 @@
+#include "gtest/gtest.h"
+
+#include <bit>
+#include <numeric>
+#include <vector>
+
+#include "PixelConvert.hpp"
+
+namespace Gorfector
+{
+    // Sizes covering the vector loops and their scalar tails.
+    static std::vector<size_t> TestSizes()
+    {
+        std::vector<size_t> sizes(70);
+        std::iota(sizes.begin(), sizes.end(), 0);
+        sizes.insert(sizes.end(), {127, 128, 129, 1000, 1023, 1024, 1025, 4099});
+        return sizes;
+    }
+
+    TEST(Gorfector_PixelConvertTests, BestKernelsAreAvailable)
+    {
+        auto kernels = PixelConvert::GetAvailableKernels();
+
+        ASSERT_FALSE(kernels.empty());
+        EXPECT_STREQ(kernels.front()->m_Name, "Scalar");
+        EXPECT_EQ(&PixelConvert::GetKernels(), kernels.back());
+    }
+
+    TEST(Gorfector_PixelConvertTests, Depth16To8KeepsMostSignificantByte)
+    {
+        std::vector<uint16_t> samples(65536);
+        std::iota(samples.begin(), samples.end(), 0);
+        const auto *source = reinterpret_cast<const uint8_t *>(samples.data());
+
+        for (const auto *kernels: PixelConvert::GetAvailableKernels())
+        {
+            std::vector<uint8_t> destination(samples.size());
+            kernels->m_Depth16To8(source, destination.data(), samples.size());
+            for (auto i = 0UZ; i < samples.size(); ++i)
+            {
+                ASSERT_EQ(destination[i], samples[i] >> 8) << kernels->m_Name << ", sample " << i;
+            }
+        }
+    }
+
+    TEST(Gorfector_PixelConvertTests, Depth16To8KernelsMatchScalar)
+    {
+        std::vector<uint8_t> source(2 * 4099 + 3);
+        for (auto i = 0UZ; i < source.size(); ++i)
+        {
+            source[i] = static_cast<uint8_t>(i * 37 + i / 256);
+        }
+
+        auto availableKernels = PixelConvert::GetAvailableKernels();
+        const auto *scalar = availableKernels.front();
+        for (const auto *kernels: availableKernels)
+        {
+            for (auto size: TestSizes())
+            {
+                // Unaligned source.
+                for (auto offset = 0UZ; offset < 3; ++offset)
+                {
+                    std::vector<uint8_t> expected(size + 1, 0xA5);
+                    std::vector<uint8_t> actual(size + 1, 0xA5);
+                    scalar->m_Depth16To8(source.data() + offset, expected.data(), size);
+                    kernels->m_Depth16To8(source.data() + offset, actual.data(), size);
+                    ASSERT_EQ(actual, expected) << kernels->m_Name << ", size " << size << ", offset " << offset;
+                }
+            }
+        }
+    }
+
+    TEST(Gorfector_PixelConvertTests, Expand1BitTo8ConvertsAllBytes)
+    {
+        std::vector<uint8_t> source(256);
+        std::iota(source.begin(), source.end(), 0);
+
+        for (const auto *kernels: PixelConvert::GetAvailableKernels())
+        {
+            std::vector<uint8_t> destination(8 * source.size());
+            kernels->m_Expand1BitTo8(source.data(), destination.data(), destination.size());
+            for (auto i = 0UZ; i < destination.size(); ++i)
+            {
+                auto bitIsSet = (source[i / 8] >> (7 - i % 8)) & 1;
+                ASSERT_EQ(destination[i], bitIsSet ? 0 : 255) << kernels->m_Name << ", pixel " << i;
+            }
+        }
+    }
+
+    TEST(Gorfector_PixelConvertTests, Expand1BitTo8KernelsMatchScalar)
+    {
+        std::vector<uint8_t> source(4099 / 8 + 2);
+        for (auto i = 0UZ; i < source.size(); ++i)
+        {
+            source[i] = static_cast<uint8_t>(i * 73 + 11);
+        }
+
+        auto availableKernels = PixelConvert::GetAvailableKernels();
+        const auto *scalar = availableKernels.front();
+        for (const auto *kernels: availableKernels)
+        {
+            for (auto size: TestSizes())
+            {
+                std::vector<uint8_t> expected(size + 1, 0xA5);
+                std::vector<uint8_t> actual(size + 1, 0xA5);
+                scalar->m_Expand1BitTo8(source.data() + 1, expected.data(), size);
+                kernels->m_Expand1BitTo8(source.data() + 1, actual.data(), size);
+                ASSERT_EQ(actual, expected) << kernels->m_Name << ", size " << size;
+            }
+        }
+    }
+
+    TEST(Gorfector_PixelConvertTests, GrayToRgbKernelsMatchScalar)
+    {
+        std::vector<uint8_t> source(4099 + 1);
+        for (auto i = 0UZ; i < source.size(); ++i)
+        {
+            source[i] = static_cast<uint8_t>(i);
+        }
+
+        auto availableKernels = PixelConvert::GetAvailableKernels();
+        const auto *scalar = availableKernels.front();
+        for (const auto *kernels: availableKernels)
+        {
+            for (auto size: TestSizes())
+            {
+                std::vector<uint8_t> expected(3 * size + 1, 0xA5);
+                std::vector<uint8_t> actual(3 * size + 1, 0xA5);
+                scalar->m_GrayToRgb(source.data() + 1, expected.data(), size);
+                kernels->m_GrayToRgb(source.data() + 1, actual.data(), size);
+                ASSERT_EQ(actual, expected) << kernels->m_Name << ", size " << size;
+
+                for (auto i = 0UZ; i < size; ++i)
+                {
+                    ASSERT_EQ(actual[3 * i], source[i + 1]);
+                    ASSERT_EQ(actual[3 * i + 1], source[i + 1]);
+                    ASSERT_EQ(actual[3 * i + 2], source[i + 1]);
+                }
+            }
+        }
+    }
+
+    TEST(Gorfector_PixelConvertTests, CanConvert16BitGrayLineToRgb)
+    {
+        constexpr auto width = 2500;
+        std::vector<uint16_t> line(width);
+        for (auto x = 0; x < width; ++x)
+        {
+            line[x] = static_cast<uint16_t>(x * 26);
+        }
+
+        std::vector<uint8_t> rgb(3 * width);
+        PixelConvert::ConvertLineToRgb8(
+                reinterpret_cast<const uint8_t *>(line.data()), rgb.data(), width, 16, SANE_FRAME_GRAY);
+
+        for (auto x = 0; x < width; ++x)
+        {
+            ASSERT_EQ(rgb[3 * x], line[x] >> 8) << "Pixel " << x;
+            ASSERT_EQ(rgb[3 * x + 1], line[x] >> 8) << "Pixel " << x;
+            ASSERT_EQ(rgb[3 * x + 2], line[x] >> 8) << "Pixel " << x;
+        }
+    }
+
+    TEST(Gorfector_PixelConvertTests, CanConvert1BitLineToRgb)
+    {
+        constexpr auto width = 2051;
+        std::vector<uint8_t> line((width + 7) / 8);
+        for (auto i = 0UZ; i < line.size(); ++i)
+        {
+            line[i] = static_cast<uint8_t>(i * 13);
+        }
+
+        std::vector<uint8_t> rgb(3 * width);
+        PixelConvert::ConvertLineToRgb8(line.data(), rgb.data(), width, 1, SANE_FRAME_GRAY);
+
+        for (auto x = 0; x < width; ++x)
+        {
+            uint8_t expected = line[x / 8] & (1 << (7 - x % 8)) ? 0 : 255;
+            ASSERT_EQ(rgb[3 * x], expected) << "Pixel " << x;
+            ASSERT_EQ(rgb[3 * x + 1], expected) << "Pixel " << x;
+            ASSERT_EQ(rgb[3 * x + 2], expected) << "Pixel " << x;
+        }
+    }
+
+    TEST(Gorfector_PixelConvertTests, CanConvert16BitRgbLineTo8Bit)
+    {
+        constexpr auto width = 333;
+        std::vector<uint16_t> line(3 * width);
+        for (auto i = 0UZ; i < line.size(); ++i)
+        {
+            line[i] = static_cast<uint16_t>(i * 197);
+        }
+
+        std::vector<uint8_t> rgb(3 * width);
+        PixelConvert::ConvertLineTo8Bit(
+                reinterpret_cast<const uint8_t *>(line.data()), rgb.data(), width, 16, SANE_FRAME_RGB);
+
+        for (auto i = 0UZ; i < line.size(); ++i)
+        {
+            ASSERT_EQ(rgb[i], line[i] >> 8) << "Sample " << i;
+        }
+    }
+
+    TEST(Gorfector_PixelConvertTests, CanDownsampleRgbLines)
+    {
+        constexpr auto width = 7;
+        std::vector<uint8_t> line0(3 * width);
+        std::vector<uint8_t> line1(3 * width);
+        for (auto i = 0UZ; i < line0.size(); ++i)
+        {
+            line0[i] = static_cast<uint8_t>(i * 11);
+            line1[i] = static_cast<uint8_t>(255 - i * 5);
+        }
+
+        std::vector<uint8_t> halved(3 * ((width + 1) / 2));
+        PixelConvert::DownsampleRgb8(line0.data(), line1.data(), halved.data(), width);
+
+        for (auto x = 0UZ; x < width / 2; ++x)
+        {
+            for (auto c = 0UZ; c < 3; ++c)
+            {
+                auto sum = line0[6 * x + c] + line0[6 * x + 3 + c] + line1[6 * x + c] + line1[6 * x + 3 + c];
+                ASSERT_EQ(halved[3 * x + c], (sum + 2) / 4) << "Pixel " << x << ", component " << c;
+            }
+        }
+
+        // The odd last column is averaged on its own.
+        for (auto c = 0UZ; c < 3; ++c)
+        {
+            auto last = 3 * (width - 1) + c;
+            ASSERT_EQ(halved[3 * (width / 2) + c], (line0[last] + line1[last] + 1) / 2) << "Component " << c;
+        }
+    }
+}
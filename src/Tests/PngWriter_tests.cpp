@@ -1,6 +1,9 @@
 #include "gtest/gtest.h"
 
+#include <cstring>
+
 #include "CompareFiles.hpp"
+#include "FileSizeLimit.hpp"
 #include "Writers/PngWriter.hpp"
 
 #include "ImageGenerator.hpp"
@@ -35,6 +38,48 @@ namespace Gorfector
             m_ExpectedFilePath = std::filesystem::path(g_DataDir) / expectedFileName;
         }
 
+        void ExpectPngContentEq(const SANE_Byte *buffer, const SANE_Parameters &parameters) const
+        {
+            auto file = fopen(m_TestFilePath.c_str(), "rb");
+            ASSERT_NE(file, nullptr);
+
+            auto png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+            auto pngInfo = png_create_info_struct(png);
+            if (setjmp(png_jmpbuf(png))) // NOLINT(*-err52-cpp)
+            {
+                png_destroy_read_struct(&png, &pngInfo, nullptr);
+                fclose(file);
+                FAIL() << "Failed to read PNG file";
+            }
+
+            png_init_io(png, file);
+            png_read_info(png, pngInfo);
+            ASSERT_EQ(png_get_image_width(png, pngInfo), static_cast<png_uint_32>(parameters.pixels_per_line));
+            ASSERT_EQ(png_get_image_height(png, pngInfo), static_cast<png_uint_32>(parameters.lines));
+
+            if (parameters.depth == 1)
+            {
+                png_set_invert_mono(png);
+            }
+            // ReSharper disable once CppRedundantBooleanExpressionArgument
+            if (std::endian::native == std::endian::little && parameters.depth > 8)
+            {
+                png_set_swap(png);
+            }
+
+            std::vector<SANE_Byte> line(parameters.bytes_per_line);
+            for (auto i = 0; i < parameters.lines; ++i)
+            {
+                png_read_row(png, line.data(), nullptr);
+                EXPECT_EQ(std::memcmp(line.data(), buffer + i * parameters.bytes_per_line, line.size()), 0)
+                        << "Row " << i << " differs";
+            }
+            png_read_end(png, nullptr);
+
+            png_destroy_read_struct(&png, &pngInfo, nullptr);
+            fclose(file);
+        }
+
         void TearDown() override
         {
             delete m_State;
@@ -174,4 +219,115 @@ namespace Gorfector
         EXPECT_TRUE(std::filesystem::exists(m_TestFilePath));
         ASSERT_FILE_EQ(m_TestFilePath, m_ExpectedFilePath, "");
     }
+
+    TEST_F(Gorfector_PngWriterTestsFixture, CanWrite16bitsColorPngWithParallelDeflate)
+    {
+        SANE_Parameters saneParameters;
+        SANE_Byte *buffer = nullptr;
+        size_t bufferSize = 0;
+        ImageGenerator::Generate16BitColorImage(400, 300, &saneParameters, &buffer, &bufferSize);
+
+        PngWriter writer(m_State, std::string(typeid(Gorfector_PngWriterTestsFixture).name()));
+        {
+            auto updater = PngWriterState::Updater(writer.GetStateComponent());
+            updater.SetCompressionLevel(6);
+            updater.SetWorkerCount(3);
+        }
+
+        writer.CreateFile(m_TestFilePath, nullptr, saneParameters);
+        for (auto i = 0; i < saneParameters.lines; i += 7)
+        {
+            auto lines = std::min(7, saneParameters.lines - i);
+            auto row = buffer + i * saneParameters.bytes_per_line;
+            auto byteWritten = writer.AppendBytes(row, lines, saneParameters);
+            EXPECT_EQ(byteWritten, lines * saneParameters.bytes_per_line) << "Failed to write row " << i;
+        }
+        writer.CloseFile();
+
+        EXPECT_TRUE(std::filesystem::exists(m_TestFilePath));
+        ExpectPngContentEq(buffer, saneParameters);
+
+        delete[] buffer;
+    }
+
+    TEST_F(Gorfector_PngWriterTestsFixture, CanWrite1bitPngWithParallelDeflate)
+    {
+        SANE_Parameters saneParameters;
+        SANE_Byte *buffer = nullptr;
+        size_t bufferSize = 0;
+        ImageGenerator::Generate1BitImage(100, 100, &saneParameters, &buffer, &bufferSize);
+
+        PngWriter writer(m_State, std::string(typeid(Gorfector_PngWriterTestsFixture).name()));
+        {
+            auto updater = PngWriterState::Updater(writer.GetStateComponent());
+            updater.SetWorkerCount(2);
+        }
+
+        writer.CreateFile(m_TestFilePath, nullptr, saneParameters);
+        for (auto i = 0; i < saneParameters.lines; ++i)
+        {
+            auto row = buffer + i * saneParameters.bytes_per_line;
+            auto byteWritten = writer.AppendBytes(row, 1, saneParameters);
+            EXPECT_EQ(byteWritten, saneParameters.bytes_per_line) << "Failed to write row " << i;
+        }
+        writer.CloseFile();
+
+        EXPECT_TRUE(std::filesystem::exists(m_TestFilePath));
+        ExpectPngContentEq(buffer, saneParameters);
+
+        delete[] buffer;
+    }
+
+    TEST_F(Gorfector_PngWriterTestsFixture, FailedParallelDeflateRemovesTheFile)
+    {
+        SANE_Parameters saneParameters;
+        SANE_Byte *buffer = nullptr;
+        size_t bufferSize = 0;
+        ImageGenerator::Generate8BitColorImage(100, 100, &saneParameters, &buffer, &bufferSize);
+
+        PngWriter writer(m_State, std::string(typeid(Gorfector_PngWriterTestsFixture).name()));
+        {
+            // zlib rejects this compression level: no block can be compressed.
+            auto updater = PngWriterState::Updater(writer.GetStateComponent());
+            updater.SetCompressionLevel(42);
+            updater.SetWorkerCount(2);
+        }
+
+        ASSERT_EQ(FileWriter::Error::None, writer.CreateFile(m_TestFilePath, nullptr, saneParameters));
+        writer.AppendBytes(buffer, saneParameters.lines, saneParameters);
+        EXPECT_EQ(FileWriter::Error::CannotWriteFile, writer.CloseFile());
+
+        EXPECT_FALSE(std::filesystem::exists(m_TestFilePath));
+
+        delete[] buffer;
+    }
+
+    TEST_F(Gorfector_PngWriterTestsFixture, WriteErrorsRemoveTheFile)
+    {
+        SANE_Parameters saneParameters;
+        SANE_Byte *buffer = nullptr;
+        size_t bufferSize = 0;
+        ImageGenerator::Generate8BitColorImage(100, 100, &saneParameters, &buffer, &bufferSize);
+
+        for (auto workerCount: {1, 2})
+        {
+            PngWriter writer(m_State, std::string(typeid(Gorfector_PngWriterTestsFixture).name()));
+            {
+                auto updater = PngWriterState::Updater(writer.GetStateComponent());
+                updater.SetWorkerCount(workerCount);
+            }
+
+            ASSERT_EQ(FileWriter::Error::None, writer.CreateFile(m_TestFilePath, nullptr, saneParameters));
+            {
+                // The file cannot hold more than the PNG signature.
+                TestsSupport::FileSizeLimit limit(8);
+                writer.AppendBytes(buffer, saneParameters.lines, saneParameters);
+                EXPECT_EQ(FileWriter::Error::CannotWriteFile, writer.CloseFile()) << workerCount << " workers";
+            }
+
+            EXPECT_FALSE(std::filesystem::exists(m_TestFilePath)) << workerCount << " workers";
+        }
+
+        delete[] buffer;
+    }
 }
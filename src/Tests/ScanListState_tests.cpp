@@ -0,0 +1,118 @@
+#include "gtest/gtest.h"
+
+#include "DeviceOptionsState.hpp"
+#include "OutputOptionsState.hpp"
+#include "ScanListState.hpp"
+
+namespace Gorfector
+{
+    class Gorfector_ScanListStateTests : public testing::Test
+    {
+    protected:
+        ZooLib::State *m_State{};
+        DeviceOptionsState *m_DeviceOptions{};
+        OutputOptionsState *m_OutputOptions{};
+        ScanListState *m_ScanList{};
+
+        void SetUp() override
+        {
+            m_State = new ZooLib::State();
+            m_DeviceOptions = new DeviceOptionsState(m_State, "");
+            m_OutputOptions = new OutputOptionsState(m_State);
+            m_ScanList = new ScanListState(m_State);
+        }
+
+        void TearDown() override
+        {
+            delete m_ScanList;
+            delete m_OutputOptions;
+            delete m_DeviceOptions;
+            delete m_State;
+        }
+
+        static nlohmann::json MakeItem(int id, const std::string &deviceModel)
+        {
+            return {
+                    {ScanListState::k_ItemIdKey, id},
+                    {ScanListState::k_ItemScanAreaUnitsKey, "px"},
+                    {ScanListState::k_ItemScanAreaHumanKey, {0.0, 0.0, 10.0, 10.0}},
+                    {ScanListState::k_ItemScannerSettingsKey,
+                     {
+                             {DeviceOptionsState::k_DeviceKey,
+                              {
+                                      {DeviceOptionsState::k_DeviceNameKey, "fake:0"},
+                                      {DeviceOptionsState::k_DeviceVendorKey, "Fake"},
+                                      {DeviceOptionsState::k_DeviceModelKey, deviceModel},
+                                      {DeviceOptionsState::k_DeviceTypeKey, "flatbed scanner"},
+                              }},
+                             {DeviceOptionsState::k_OptionsKey, nlohmann::json::object()},
+                     }},
+            };
+        }
+
+        void LoadScanList(const nlohmann::json &items) const
+        {
+            auto updater = ScanListState::Updater(m_ScanList);
+            updater.LoadFromJson({
+                    {ScanListState::k_AddAllParamsKey, false},
+                    {ScanListState::k_ScanListsKey, {{"Fake::Scanner", items}}},
+            });
+            updater.SetCurrentDeviceName("Fake", "Scanner");
+        }
+    };
+
+    TEST_F(Gorfector_ScanListStateTests, AddedItemsHaveUniqueIds)
+    {
+        LoadScanList({MakeItem(1, "Scanner 1"), MakeItem(2, "Scanner 2")});
+        {
+            auto updater = ScanListState::Updater(m_ScanList);
+            updater.MoveScanListItem(1, -1);
+            updater.AddCompleteScanItem(m_DeviceOptions, m_OutputOptions);
+        }
+
+        ASSERT_EQ(3UZ, m_ScanList->GetScanListSize());
+        EXPECT_EQ(2, m_ScanList->GetScanItemId(0));
+        EXPECT_EQ(1, m_ScanList->GetScanItemId(1));
+        EXPECT_EQ(3, m_ScanList->GetScanItemId(2));
+    }
+
+    TEST_F(Gorfector_ScanListStateTests, AddedItemDoesNotGetTheSnapshotOfAnotherItem)
+    {
+        LoadScanList({MakeItem(1, "Scanner 1"), MakeItem(2, "Scanner 2")});
+
+        // Compile the snapshot of the item with the largest id, then move it before the other one.
+        auto snapshot = m_ScanList->GetScannerSettingsSnapshot(1);
+        ASSERT_NE(nullptr, snapshot);
+        EXPECT_EQ("Scanner 2", snapshot->GetDeviceModel());
+        {
+            auto updater = ScanListState::Updater(m_ScanList);
+            updater.MoveScanListItem(1, -1);
+            updater.AddCompleteScanItem(m_DeviceOptions, m_OutputOptions);
+        }
+
+        snapshot = m_ScanList->GetScannerSettingsSnapshot(0);
+        ASSERT_NE(nullptr, snapshot);
+        EXPECT_EQ("Scanner 2", snapshot->GetDeviceModel());
+        snapshot = m_ScanList->GetScannerSettingsSnapshot(1);
+        ASSERT_NE(nullptr, snapshot);
+        EXPECT_EQ("Scanner 1", snapshot->GetDeviceModel());
+
+        // The options of the added item have no device, so they have no snapshot.
+        EXPECT_EQ(nullptr, m_ScanList->GetScannerSettingsSnapshot(2));
+    }
+
+    TEST_F(Gorfector_ScanListStateTests, ItemAddedAfterRemovalDoesNotGetTheSnapshotOfTheRemovedItem)
+    {
+        LoadScanList({MakeItem(1, "Scanner 1"), MakeItem(2, "Scanner 2")});
+
+        ASSERT_NE(nullptr, m_ScanList->GetScannerSettingsSnapshot(1));
+        {
+            auto updater = ScanListState::Updater(m_ScanList);
+            updater.RemoveScanItemAt(1);
+            updater.AddCompleteScanItem(m_DeviceOptions, m_OutputOptions);
+        }
+
+        ASSERT_EQ(2UZ, m_ScanList->GetScanListSize());
+        EXPECT_EQ(nullptr, m_ScanList->GetScannerSettingsSnapshot(1));
+    }
+}
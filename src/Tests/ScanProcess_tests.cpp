@@ -0,0 +1,172 @@
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <tiffio.h>
+
+#include "AppState.hpp"
+#include "CompareFiles.hpp"
+#include "FakeScanDevice.hpp"
+#include "OutputOptionsState.hpp"
+#include "SingleScanProcess.hpp"
+#include "Writers/TiffWriter.hpp"
+
+using namespace TestsSupport;
+
+namespace Gorfector
+{
+    class Gorfector_ScanProcessTests : public testing::Test
+    {
+    protected:
+        ZooLib::State *m_State{};
+        AppState *m_AppState{};
+        OutputOptionsState *m_OutputOptions{};
+        std::filesystem::path m_TestFilePath{};
+
+        void SetUp() override
+        {
+            m_State = new ZooLib::State();
+            m_AppState = new AppState(m_State, false);
+            m_OutputOptions = new OutputOptionsState(m_State);
+
+            const testing::TestInfo *const testInfo = testing::UnitTest::GetInstance()->current_test_info();
+            m_TestFilePath = std::filesystem::path(testing::TempDir()) /
+                             (std::string(testInfo->test_suite_name()) + "_" + testInfo->name() + ".tiff");
+        }
+
+        void TearDown() override
+        {
+            delete m_OutputOptions;
+            delete m_AppState;
+            delete m_State;
+
+            if (g_CleanArtifacts && std::filesystem::exists(m_TestFilePath))
+            {
+                std::filesystem::remove(m_TestFilePath);
+            }
+        }
+
+        /**
+         * Runs a scan process until it finishes. The process deletes itself when it finishes.
+         */
+        bool Scan(FakeScanDevice &device, FileWriter *fileWriter)
+        {
+            auto finished = false;
+            auto process = new SingleScanProcess(
+                    &device, nullptr, m_AppState, nullptr, m_OutputOptions, nullptr, fileWriter, m_TestFilePath,
+                    new std::function<void()>([&finished]() { finished = true; }));
+
+            if (!process->Start())
+            {
+                delete process;
+                return false;
+            }
+
+            while (!finished)
+            {
+                g_main_context_iteration(nullptr, TRUE);
+            }
+
+            return true;
+        }
+
+        void ExpectTiffContentEq(const FakeScanDevice &device) const
+        {
+            const auto &parameters = device.GetSettings().Parameters;
+            auto file = TIFFOpen(m_TestFilePath.c_str(), "r");
+            ASSERT_NE(file, nullptr);
+
+            uint32_t height{};
+            TIFFGetField(file, TIFFTAG_IMAGELENGTH, &height);
+            EXPECT_EQ(static_cast<uint32_t>(parameters.lines), height);
+
+            std::vector<SANE_Byte> line(parameters.bytes_per_line);
+            std::vector<SANE_Byte> expectedLine(parameters.bytes_per_line);
+            for (auto i = 0; i < parameters.lines; ++i)
+            {
+                ASSERT_GE(TIFFReadScanline(file, line.data(), i, 0), 0) << "Failed to read row " << i;
+                auto offset = static_cast<size_t>(i) * parameters.bytes_per_line;
+                device.CopyPageData(offset, expectedLine.data(), line.size());
+                EXPECT_EQ(std::memcmp(line.data(), expectedLine.data(), line.size()), 0) << "Row " << i << " differs";
+            }
+
+            TIFFClose(file);
+        }
+    };
+
+    TEST_F(Gorfector_ScanProcessTests, FakeDeviceStreamsWholePages)
+    {
+        FakeScanDevice device({
+                .PageCount = 2,
+                .BusyInterval = 3,
+                .BusyDuration = std::chrono::microseconds(100),
+                .ReadSizeJitter = 0.9,
+        });
+        const auto &parameters = device.GetSettings().Parameters;
+        auto pageSize = static_cast<size_t>(parameters.bytes_per_line) * parameters.lines;
+
+        for (auto page = 0; page < 2; ++page)
+        {
+            ASSERT_EQ(SANE_STATUS_GOOD, device.StartScan());
+
+            std::vector<SANE_Byte> data(pageSize + 1);
+            auto offset = 0UZ;
+            SANE_Int length{};
+            SANE_Status status;
+            do
+            {
+                status = device.Read(data.data() + offset, static_cast<SANE_Int>(data.size() - offset), &length);
+                offset += length;
+            }
+            while (status == SANE_STATUS_GOOD || status == SANE_STATUS_DEVICE_BUSY);
+            EXPECT_EQ(SANE_STATUS_EOF, status);
+
+            std::vector<SANE_Byte> expected(pageSize);
+            device.CopyPageData(0, expected.data(), pageSize);
+            EXPECT_EQ(pageSize, offset);
+            EXPECT_EQ(0, std::memcmp(expected.data(), data.data(), pageSize));
+        }
+
+        EXPECT_EQ(SANE_STATUS_NO_DOCS, device.StartScan());
+        EXPECT_EQ(2 * pageSize, device.GetStatistics().BytesRead);
+        EXPECT_GT(device.GetStatistics().BusyReadCount, 0UZ);
+    }
+
+    TEST_F(Gorfector_ScanProcessTests, SingleScanProcessWritesEveryLine)
+    {
+        FakeScanDevice device({
+                .Parameters =
+                        {
+                                .format = SANE_FRAME_RGB,
+                                .last_frame = SANE_TRUE,
+                                .bytes_per_line = 0,
+                                .pixels_per_line = 517,
+                                .lines = 300,
+                                .depth = 8,
+                        },
+                .BusyInterval = 5,
+                .BusyDuration = std::chrono::milliseconds(2),
+                .ReadSizeJitter = 0.99,
+        });
+        TiffWriter writer(m_State, "Gorfector_ScanProcessTests");
+
+        ASSERT_TRUE(Scan(device, &writer));
+
+        EXPECT_FALSE(m_AppState->IsScanning());
+        EXPECT_GT(device.GetStatistics().BusyReadCount, 0UZ);
+        ExpectTiffContentEq(device);
+    }
+
+    TEST_F(Gorfector_ScanProcessTests, SingleScanProcessFollowsDeviceThroughput)
+    {
+        FakeScanDevice device({.BytesPerSecond = 10.0 * 1000 * 1000});
+        TiffWriter writer(m_State, "Gorfector_ScanProcessTests");
+
+        auto startTime = std::chrono::steady_clock::now();
+        ASSERT_TRUE(Scan(device, &writer));
+        auto duration = std::chrono::steady_clock::now() - startTime;
+
+        // 1 MB at 10 MB/s
+        EXPECT_GE(duration, std::chrono::milliseconds(100));
+        ExpectTiffContentEq(device);
+    }
+}
@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "OptionRewriter.hpp"
+
+namespace Gorfector
+{
+    class Gorfector_ScannerDescriptionIndexTests : public testing::Test
+    {
+    protected:
+        std::filesystem::path m_SystemConfigPath{};
+        std::filesystem::path m_UserConfigPath{};
+
+        void SetUp() override
+        {
+            auto directory = std::filesystem::path(testing::TempDir()) / "ScannerDescriptionIndexTests";
+            std::filesystem::remove_all(directory);
+            m_SystemConfigPath = directory / "system";
+            m_UserConfigPath = directory / "user";
+            std::filesystem::create_directories(m_SystemConfigPath / "scanners" / "noname");
+        }
+
+        void TearDown() override
+        {
+            std::filesystem::remove_all(m_SystemConfigPath.parent_path());
+        }
+
+        static void WriteDescriptionFile(const std::filesystem::path &filePath, const std::string &model)
+        {
+            auto device = nlohmann::json{{"vendor", "Noname"}, {"model", model}};
+            auto option = nlohmann::json{
+                    {"id", 2},
+                    {"title", model + " resolution"},
+                    {"description", ""},
+                    {"string_list", nlohmann::json::array()},
+                    {"flags", nlohmann::json::array({"ForceAdvanced"})},
+            };
+            auto description = nlohmann::json{
+                    {"devices", nlohmann::json::array({device})},
+                    {"options", nlohmann::json::array({option})},
+            };
+            std::ofstream(filePath) << description.dump(4);
+        }
+    };
+
+    TEST_F(Gorfector_ScannerDescriptionIndexTests, FindsDescriptionsByModel)
+    {
+        WriteDescriptionFile(m_SystemConfigPath / "scanners" / "noname" / "tester.json", "frontend-tester");
+
+        ScannerDescriptionIndex index(m_SystemConfigPath, m_UserConfigPath);
+
+        auto optionInfos = index.Find("Noname", "frontend-tester");
+        ASSERT_NE(nullptr, optionInfos);
+        ASSERT_TRUE(optionInfos->contains(2));
+        EXPECT_EQ("frontend-tester resolution", optionInfos->at(2).Title);
+        EXPECT_EQ(optionInfos, index.Find("Noname", "frontend-tester"));
+        EXPECT_EQ(nullptr, index.Find("Noname", "other"));
+        EXPECT_EQ(nullptr, index.Find("Other", "frontend-tester"));
+        EXPECT_TRUE(std::filesystem::exists(m_UserConfigPath / "scanners" / "index.json"));
+
+        OptionRewriter rewriter;
+        EXPECT_FALSE(rewriter.IsAdvanced(2, false));
+        rewriter.LoadOptionDescriptionFile(index, "Noname", "frontend-tester");
+        EXPECT_TRUE(rewriter.IsAdvanced(2, false));
+        EXPECT_FALSE(rewriter.IsAdvanced(1, false));
+    }
+
+    TEST_F(Gorfector_ScannerDescriptionIndexTests, UnchangedDirectoriesAreNotListed)
+    {
+        WriteDescriptionFile(m_SystemConfigPath / "scanners" / "noname" / "tester.json", "frontend-tester");
+        auto indexFilePath = m_UserConfigPath / "scanners" / "index.json";
+
+        {
+            ScannerDescriptionIndex index(m_SystemConfigPath, m_UserConfigPath);
+            EXPECT_EQ(3UZ, index.GetListedDirectoryCount());
+        }
+        auto indexModifiedTime = std::filesystem::last_write_time(indexFilePath);
+
+        ScannerDescriptionIndex index(m_SystemConfigPath, m_UserConfigPath);
+        EXPECT_EQ(0UZ, index.GetListedDirectoryCount());
+        EXPECT_NE(nullptr, index.Find("Noname", "frontend-tester"));
+        // The index file is not rewritten.
+        EXPECT_EQ(indexModifiedTime, std::filesystem::last_write_time(indexFilePath));
+    }
+
+    TEST_F(Gorfector_ScannerDescriptionIndexTests, ChangedDirectoriesAreListedAgain)
+    {
+        auto vendorDirectory = m_SystemConfigPath / "scanners" / "noname";
+        WriteDescriptionFile(vendorDirectory / "tester.json", "frontend-tester");
+        {
+            ScannerDescriptionIndex index(m_SystemConfigPath, m_UserConfigPath);
+        }
+
+        std::filesystem::remove(vendorDirectory / "tester.json");
+        WriteDescriptionFile(vendorDirectory / "tester2.json", "frontend-tester2");
+        // Make sure the modification time changes, whatever the resolution of the file system clock.
+        std::filesystem::last_write_time(
+                vendorDirectory, std::filesystem::last_write_time(vendorDirectory) + std::chrono::seconds(1));
+
+        ScannerDescriptionIndex index(m_SystemConfigPath, m_UserConfigPath);
+        EXPECT_EQ(1UZ, index.GetListedDirectoryCount());
+        EXPECT_EQ(nullptr, index.Find("Noname", "frontend-tester"));
+        EXPECT_NE(nullptr, index.Find("Noname", "frontend-tester2"));
+    }
+
+    TEST_F(Gorfector_ScannerDescriptionIndexTests, InvalidFilesAreIgnored)
+    {
+        std::filesystem::create_directories(m_UserConfigPath / "scanners");
+        std::ofstream(m_SystemConfigPath / "scanners" / "noname" / "invalid.json") << "{ \"devices\": [";
+        std::ofstream(m_UserConfigPath / "scanners" / "index.json") << "not json";
+
+        ScannerDescriptionIndex index(m_SystemConfigPath, m_UserConfigPath);
+        EXPECT_EQ(nullptr, index.Find("Noname", "frontend-tester"));
+    }
+}
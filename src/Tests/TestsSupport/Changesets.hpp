@@ -5,7 +5,26 @@ namespace TestsSupport
 {
     class ChangesetA : public ZooLib::ChangesetBase
     {
+        int m_AggregatedCount{};
+
     public:
         using ChangesetBase::ChangesetBase;
+
+        void Reset(uint64_t stateInitialVersion)
+        {
+            ChangesetBase::Reset(stateInitialVersion);
+            m_AggregatedCount = 0;
+        }
+
+        void Aggregate(const ChangesetA &changeset)
+        {
+            ChangesetBase::Aggregate(changeset);
+            m_AggregatedCount += 1;
+        }
+
+        [[nodiscard]] int GetAggregatedCount() const
+        {
+            return m_AggregatedCount;
+        }
     };
 }
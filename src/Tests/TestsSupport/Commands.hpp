@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include "ZooLib/Command.hpp"
 
 namespace TestsSupport
@@ -29,4 +31,21 @@ namespace TestsSupport
             return s_CommandHandled;
         }
     };
+
+    class CommandB : public ZooLib::Command
+    {
+        char m_Id{};
+
+    public:
+        explicit CommandB(char id)
+            : m_Id(id)
+        {
+        }
+
+        static void Execute(const CommandB &command, int *count, std::string *log)
+        {
+            ++*count;
+            log->push_back(command.m_Id);
+        }
+    };
 }
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "ScanDevice.hpp"
+
+namespace TestsSupport
+{
+    /**
+     * \brief A device that streams synthetic pages, to run the scan processes without a scanner.
+     *
+     * The device can be throttled to a number of bytes per second, can report `SANE_STATUS_DEVICE_BUSY` for a while
+     * every few reads, and can return fewer bytes than requested, as network and USB scanners do. The device has no
+     * options.
+     */
+    class FakeScanDevice final : public Gorfector::ScanDevice
+    {
+    public:
+        struct Settings
+        {
+            /// The parameters of each page. `bytes_per_line` is computed from the other values if it is 0.
+            SANE_Parameters Parameters{
+                    .format = SANE_FRAME_GRAY,
+                    .last_frame = SANE_TRUE,
+                    .bytes_per_line = 0,
+                    .pixels_per_line = 1000,
+                    .lines = 1000,
+                    .depth = 8,
+            };
+            /// The number of pages that can be scanned before `StartScan()` returns `SANE_STATUS_NO_DOCS`.
+            uint32_t PageCount{1};
+            /// The maximum read throughput, in bytes per second. 0 means unlimited.
+            double BytesPerSecond{};
+            /// The device is busy after every `BusyInterval` reads. 0 means never.
+            uint32_t BusyInterval{};
+            /// How long the device stays busy.
+            std::chrono::microseconds BusyDuration{};
+            /// The maximum fraction of each read that is not returned, between 0 and 1.
+            double ReadSizeJitter{};
+            /// If not `SANE_STATUS_GOOD`, the status returned by `Read()` once half of each page is read.
+            SANE_Status ReadError{SANE_STATUS_GOOD};
+            uint32_t Seed{1};
+        };
+
+        struct Statistics
+        {
+            uint64_t ReadCount{};
+            uint64_t BusyReadCount{};
+            uint64_t BytesRead{};
+            uint32_t PagesStarted{};
+            uint32_t CancelCount{};
+            std::chrono::steady_clock::time_point StartTime{};
+            std::chrono::steady_clock::time_point FirstReadTime{};
+            std::chrono::steady_clock::time_point EndOfFrameTime{};
+        };
+
+    private:
+        static constexpr int k_PatternLineCount = 64;
+
+        Settings m_Settings;
+        std::vector<SANE_Byte> m_Pattern{};
+
+        // The state of a SANE handle changes as the scan progresses, even if it is used through a const pointer.
+        mutable std::minstd_rand m_Random;
+        mutable bool m_Scanning{};
+        mutable size_t m_PageOffset{};
+        mutable uint64_t m_ReadsSinceBusy{};
+        mutable std::chrono::steady_clock::time_point m_BusyUntil{};
+        mutable Statistics m_Statistics{};
+
+        [[nodiscard]] size_t GetPageSize() const
+        {
+            return static_cast<size_t>(m_Settings.Parameters.bytes_per_line) * m_Settings.Parameters.lines;
+        }
+
+    public:
+        explicit FakeScanDevice(const Settings &settings)
+            : m_Settings(settings)
+            , m_Random(settings.Seed)
+        {
+            auto &parameters = m_Settings.Parameters;
+            if (parameters.bytes_per_line == 0)
+            {
+                auto channels = parameters.format == SANE_FRAME_RGB ? 3 : 1;
+                parameters.bytes_per_line = (parameters.pixels_per_line * channels * parameters.depth + 7) / 8;
+            }
+
+            // A gradient with some noise, so that the encoders do not compress it to nothing.
+            m_Pattern.resize(static_cast<size_t>(parameters.bytes_per_line) * k_PatternLineCount);
+            std::uniform_int_distribution<int> noise(0, 15);
+            for (auto y = 0; y < k_PatternLineCount; ++y)
+            {
+                for (auto x = 0; x < parameters.bytes_per_line; ++x)
+                {
+                    m_Pattern[y * parameters.bytes_per_line + x] =
+                            static_cast<SANE_Byte>((x + y * 4) / 8 + noise(m_Random));
+                }
+            }
+        }
+
+        [[nodiscard]] const Settings &GetSettings() const
+        {
+            return m_Settings;
+        }
+
+        [[nodiscard]] const Statistics &GetStatistics() const
+        {
+            return m_Statistics;
+        }
+
+        /**
+         * \brief Copies the data of a page, as `Read()` returns it.
+         * \param offset The offset of the first byte to copy in the page.
+         * \param buffer The buffer receiving the data.
+         * \param length The number of bytes to copy.
+         */
+        void CopyPageData(size_t offset, SANE_Byte *buffer, size_t length) const
+        {
+            auto copied = 0UZ;
+            while (copied < length)
+            {
+                auto patternOffset = (offset + copied) % m_Pattern.size();
+                auto chunkSize = std::min(length - copied, m_Pattern.size() - patternOffset);
+                std::memcpy(buffer + copied, m_Pattern.data() + patternOffset, chunkSize);
+                copied += chunkSize;
+            }
+        }
+
+        [[nodiscard]] const SANE_Option_Descriptor *GetOptionDescriptor(uint32_t optionIndex) const override
+        {
+            return nullptr;
+        }
+
+        bool GetOptionValue(uint32_t optionIndex, void *value) const override
+        {
+            return false;
+        }
+
+        bool SetOptionValue(uint32_t optionIndex, void *value, int *optionInfo) const override
+        {
+            return false;
+        }
+
+        SANE_Status StartScan() const override
+        {
+            if (m_Statistics.PagesStarted >= m_Settings.PageCount)
+            {
+                return SANE_STATUS_NO_DOCS;
+            }
+
+            ++m_Statistics.PagesStarted;
+            m_Scanning = true;
+            m_PageOffset = 0;
+            m_Statistics.StartTime = std::chrono::steady_clock::now();
+            m_Statistics.FirstReadTime = {};
+            m_Statistics.EndOfFrameTime = {};
+            return SANE_STATUS_GOOD;
+        }
+
+        bool GetParameters(SANE_Parameters *parameters) const override
+        {
+            *parameters = m_Settings.Parameters;
+            return true;
+        }
+
+        SANE_Status Read(SANE_Byte *buffer, SANE_Int maxLength, SANE_Int *length) const override
+        {
+            *length = 0;
+            if (!m_Scanning)
+            {
+                return SANE_STATUS_CANCELLED;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            ++m_Statistics.ReadCount;
+            if (m_Statistics.FirstReadTime == std::chrono::steady_clock::time_point{})
+            {
+                m_Statistics.FirstReadTime = now;
+            }
+
+            if (now < m_BusyUntil)
+            {
+                ++m_Statistics.BusyReadCount;
+                return SANE_STATUS_DEVICE_BUSY;
+            }
+
+            if (m_Settings.BusyInterval > 0 && ++m_ReadsSinceBusy > m_Settings.BusyInterval)
+            {
+                m_ReadsSinceBusy = 0;
+                m_BusyUntil = now + m_Settings.BusyDuration;
+                ++m_Statistics.BusyReadCount;
+                return SANE_STATUS_DEVICE_BUSY;
+            }
+
+            auto remaining = GetPageSize() - m_PageOffset;
+            if (remaining == 0)
+            {
+                m_Scanning = false;
+                m_Statistics.EndOfFrameTime = now;
+                return SANE_STATUS_EOF;
+            }
+
+            if (m_Settings.ReadError != SANE_STATUS_GOOD)
+            {
+                if (m_PageOffset >= GetPageSize() / 2)
+                {
+                    m_Scanning = false;
+                    return m_Settings.ReadError;
+                }
+
+                // Stop at the middle of the page.
+                remaining = GetPageSize() / 2 - m_PageOffset;
+            }
+
+            auto readSize = std::min(remaining, static_cast<size_t>(std::max(maxLength, 0)));
+            if (m_Settings.ReadSizeJitter > 0 && readSize > 1)
+            {
+                std::uniform_real_distribution jitter(0.0, m_Settings.ReadSizeJitter);
+                readSize = std::max(static_cast<size_t>(readSize * (1.0 - jitter(m_Random))), static_cast<size_t>(1));
+            }
+
+            if (m_Settings.BytesPerSecond > 0)
+            {
+                // Deliver the data when a device with this throughput would have it.
+                auto delay = std::chrono::duration<double>((m_PageOffset + readSize) / m_Settings.BytesPerSecond);
+                std::this_thread::sleep_until(
+                        m_Statistics.StartTime + std::chrono::duration_cast<std::chrono::nanoseconds>(delay));
+            }
+
+            CopyPageData(m_PageOffset, buffer, readSize);
+            m_PageOffset += readSize;
+            m_Statistics.BytesRead += readSize;
+            *length = static_cast<SANE_Int>(readSize);
+            return SANE_STATUS_GOOD;
+        }
+
+        void CancelScan() const override
+        {
+            ++m_Statistics.CancelCount;
+            m_Scanning = false;
+        }
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <csignal>
+#include <sys/resource.h>
+
+namespace TestsSupport
+{
+    /**
+     * \brief Limits the size of the files written by the process while in scope, to make file writes fail.
+     *
+     * Writing past the limit fails with `EFBIG` instead of raising `SIGXFSZ`, which is ignored while the limit is set.
+     */
+    class FileSizeLimit
+    {
+        rlimit m_PreviousLimit{};
+        void (*m_PreviousHandler)(int){};
+
+    public:
+        explicit FileSizeLimit(rlim_t maxFileSize)
+        {
+            m_PreviousHandler = std::signal(SIGXFSZ, SIG_IGN);
+            getrlimit(RLIMIT_FSIZE, &m_PreviousLimit);
+
+            auto limit = m_PreviousLimit;
+            limit.rlim_cur = maxFileSize;
+            setrlimit(RLIMIT_FSIZE, &limit);
+        }
+
+        ~FileSizeLimit()
+        {
+            setrlimit(RLIMIT_FSIZE, &m_PreviousLimit);
+            std::signal(SIGXFSZ, m_PreviousHandler);
+        }
+
+        FileSizeLimit(const FileSizeLimit &) = delete;
+        FileSizeLimit &operator=(const FileSizeLimit &) = delete;
+    };
+}
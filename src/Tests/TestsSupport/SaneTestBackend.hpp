@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <sane/sane.h>
+
+namespace TestsSupport
+{
+    /**
+     * \brief Configures SANE to load only its test backend, which provides virtual devices named test:0, test:1...
+     *
+     * The configuration is written to a temporary directory, used until the object is destroyed. SANE is exited
+     * when the object is destroyed: the devices must be closed before.
+     */
+    class SaneTestBackend
+    {
+        std::filesystem::path m_ConfigDir;
+
+    public:
+        /**
+         * \param directoryName The name of the configuration directory, in the test temporary directory.
+         * \param deviceCount The number of virtual devices.
+         */
+        SaneTestBackend(const std::string &directoryName, int deviceCount)
+            : m_ConfigDir(std::filesystem::path(testing::TempDir()) / directoryName)
+        {
+            std::filesystem::create_directories(m_ConfigDir);
+            std::ofstream(m_ConfigDir / "dll.conf") << "test\n";
+            std::ofstream(m_ConfigDir / "test.conf") << "number_of_devices " << deviceCount << "\n";
+
+            // Without a trailing separator, only this directory is searched for configuration files.
+            setenv("SANE_CONFIG_DIR", m_ConfigDir.c_str(), 1);
+        }
+
+        ~SaneTestBackend()
+        {
+            sane_exit();
+            unsetenv("SANE_CONFIG_DIR");
+            std::filesystem::remove_all(m_ConfigDir);
+        }
+
+        SaneTestBackend(const SaneTestBackend &) = delete;
+        SaneTestBackend &operator=(const SaneTestBackend &) = delete;
+
+        /**
+         * \brief The configuration directory. Tests can also write their own files in it.
+         */
+        [[nodiscard]] const std::filesystem::path &GetConfigDir() const
+        {
+            return m_ConfigDir;
+        }
+    };
+}
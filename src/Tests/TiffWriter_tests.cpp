@@ -1,5 +1,7 @@
 #include "gtest/gtest.h"
 
+#include <cstring>
+
 #include "CompareFiles.hpp"
 #include "Writers/TiffWriter.hpp"
 
@@ -35,6 +37,22 @@ namespace Gorfector
             m_ExpectedFilePath = std::filesystem::path(g_DataDir) / expectedFileName;
         }
 
+        void ExpectTiffContentEq(const SANE_Byte *buffer, const SANE_Parameters &parameters) const
+        {
+            auto file = TIFFOpen(m_TestFilePath.c_str(), "r");
+            ASSERT_NE(file, nullptr);
+
+            std::vector<SANE_Byte> line(parameters.bytes_per_line);
+            for (auto i = 0; i < parameters.lines; ++i)
+            {
+                ASSERT_GE(TIFFReadScanline(file, line.data(), i, 0), 0) << "Failed to read row " << i;
+                EXPECT_EQ(std::memcmp(line.data(), buffer + i * parameters.bytes_per_line, line.size()), 0)
+                        << "Row " << i << " differs";
+            }
+
+            TIFFClose(file);
+        }
+
         void TearDown() override
         {
             delete m_State;
@@ -178,4 +196,126 @@ namespace Gorfector
 
         delete[] buffer;
     }
+
+    TEST_F(Gorfector_TiffWriterTestsFixture, CanWrite16bitsColorTiffWithParallelDeflate)
+    {
+        SANE_Parameters saneParameters;
+        SANE_Byte *buffer = nullptr;
+        size_t bufferSize = 0;
+        ImageGenerator::Generate16BitColorImage(100, 100, &saneParameters, &buffer, &bufferSize);
+
+        TiffWriter writer(m_State, std::string(typeid(Gorfector_TiffWriterTestsFixture).name()));
+        {
+            auto updater = TiffWriterState::Updater(writer.GetStateComponent());
+            updater.SetCompression(TiffWriterState::Compression::Deflate);
+            updater.SetDeflateCompressionLevel(9);
+            updater.SetStripHeight(16);
+            updater.SetWorkerCount(4);
+        }
+
+        writer.CreateFile(m_TestFilePath, nullptr, saneParameters);
+        for (auto i = 0; i < saneParameters.lines; i += 7)
+        {
+            auto row = buffer + i * saneParameters.bytes_per_line;
+            auto lineCount = std::min(7, saneParameters.lines - i);
+            auto byteWritten = writer.AppendBytes(row, lineCount, saneParameters);
+            EXPECT_EQ(byteWritten, lineCount * saneParameters.bytes_per_line) << "Failed to write row " << i;
+        }
+        writer.CloseFile();
+
+        EXPECT_TRUE(std::filesystem::exists(m_TestFilePath));
+        ExpectTiffContentEq(buffer, saneParameters);
+
+        delete[] buffer;
+    }
+
+    TEST_F(Gorfector_TiffWriterTestsFixture, CanWrite8BitGrayscaleTiffWithParallelPackbits)
+    {
+        SANE_Parameters saneParameters;
+        SANE_Byte *buffer = nullptr;
+        size_t bufferSize = 0;
+        ImageGenerator::Generate8BitGrayscaleImage(100, 100, &saneParameters, &buffer, &bufferSize);
+
+        TiffWriter writer(m_State, std::string(typeid(Gorfector_TiffWriterTestsFixture).name()));
+        {
+            auto updater = TiffWriterState::Updater(writer.GetStateComponent());
+            updater.SetCompression(TiffWriterState::Compression::Packbits);
+            updater.SetStripHeight(10);
+            updater.SetWorkerCount(3);
+        }
+
+        writer.CreateFile(m_TestFilePath, nullptr, saneParameters);
+        for (auto i = 0; i < saneParameters.lines; ++i)
+        {
+            auto row = buffer + i * saneParameters.bytes_per_line;
+            auto byteWritten = writer.AppendBytes(row, 1, saneParameters);
+            EXPECT_EQ(byteWritten, saneParameters.bytes_per_line) << "Failed to write row " << i;
+        }
+        writer.CloseFile();
+
+        EXPECT_TRUE(std::filesystem::exists(m_TestFilePath));
+        ExpectTiffContentEq(buffer, saneParameters);
+
+        delete[] buffer;
+    }
+
+    TEST_F(Gorfector_TiffWriterTestsFixture, CanWriteTiledPyramidTiff)
+    {
+        SANE_Parameters saneParameters;
+        SANE_Byte *buffer = nullptr;
+        size_t bufferSize = 0;
+        ImageGenerator::Generate8BitColorImage(600, 300, &saneParameters, &buffer, &bufferSize);
+
+        TiffWriter writer(m_State, std::string(typeid(Gorfector_TiffWriterTestsFixture).name()));
+        {
+            auto updater = TiffWriterState::Updater(writer.GetStateComponent());
+            updater.SetTiledPyramid(true);
+        }
+
+        writer.CreateFile(m_TestFilePath, nullptr, saneParameters);
+        for (auto i = 0; i < saneParameters.lines; ++i)
+        {
+            auto row = buffer + i * saneParameters.bytes_per_line;
+            auto byteWritten = writer.AppendBytes(row, 1, saneParameters);
+            EXPECT_EQ(byteWritten, saneParameters.bytes_per_line) << "Failed to write row " << i;
+        }
+        writer.CloseFile();
+
+        auto file = TIFFOpen(m_TestFilePath.c_str(), "r");
+        ASSERT_NE(file, nullptr);
+
+        // Full resolution image: compare the first tile.
+        constexpr auto tileSize = TiffPyramidEncoder::k_TileSize;
+        std::vector<SANE_Byte> tile(tileSize * tileSize * 3);
+        ASSERT_GE(TIFFReadTile(file, tile.data(), 0, 0, 0, 0), 0);
+        for (auto y = 0U; y < tileSize; ++y)
+        {
+            auto tileRow = tile.data() + y * tileSize * 3;
+            auto imageRow = buffer + y * saneParameters.bytes_per_line;
+            EXPECT_EQ(std::memcmp(tileRow, imageRow, tileSize * 3), 0) << "Row " << y << " differs";
+        }
+
+        // 600x300 -> 300x150 -> 150x75
+        uint16_t subDirectoryCount = 0;
+        toff_t *subDirectoryOffsets = nullptr;
+        ASSERT_TRUE(TIFFGetField(file, TIFFTAG_SUBIFD, &subDirectoryCount, &subDirectoryOffsets));
+        ASSERT_EQ(subDirectoryCount, 2);
+
+        std::vector<toff_t> offsets(subDirectoryOffsets, subDirectoryOffsets + subDirectoryCount);
+        uint32_t expectedWidth = 600;
+        for (auto offset: offsets)
+        {
+            ASSERT_TRUE(TIFFSetSubDirectory(file, offset));
+
+            uint32_t width = 0;
+            TIFFGetField(file, TIFFTAG_IMAGEWIDTH, &width);
+            expectedWidth /= 2;
+            EXPECT_EQ(width, expectedWidth);
+            EXPECT_GE(TIFFReadTile(file, tile.data(), 0, 0, 0, 0), 0);
+        }
+
+        TIFFClose(file);
+
+        delete[] buffer;
+    }
 }
@@ -35,9 +35,30 @@ namespace ZooLib
         auto changeset2 = changesetManager.GetCurrentChangeset(2); // side effect: create changeset
         changesetManager.PushCurrentChangeset();
 
-        auto aggregatedChangeset = changesetManager.GetAggregatedChangeset(1);
+        TestsSupport::ChangesetA aggregatedChangeset(0);
+        changesetManager.AggregateChangesets(1, aggregatedChangeset);
 
-        EXPECT_NE(aggregatedChangeset, nullptr);
-        EXPECT_EQ(aggregatedChangeset->GetStateInitialVersion(), 1);
+        EXPECT_EQ(aggregatedChangeset.GetStateInitialVersion(), 1);
+        EXPECT_EQ(aggregatedChangeset.GetAggregatedCount(), 2);
+    }
+
+    TEST(ZooLib_ChangesetManagerTests, ResetsTheAccumulatorBeforeAggregating)
+    {
+        ChangesetManager<TestsSupport::ChangesetA> changesetManager;
+        auto changeset1 = changesetManager.GetCurrentChangeset(1); // side effect: create changeset
+        changesetManager.PushCurrentChangeset();
+
+        auto changeset2 = changesetManager.GetCurrentChangeset(2); // side effect: create changeset
+        changesetManager.PushCurrentChangeset();
+
+        auto changeset3 = changesetManager.GetCurrentChangeset(3); // side effect: create changeset
+
+        TestsSupport::ChangesetA aggregatedChangeset(0);
+        changesetManager.AggregateChangesets(1, aggregatedChangeset);
+        EXPECT_EQ(aggregatedChangeset.GetAggregatedCount(), 3);
+
+        changesetManager.AggregateChangesets(2, aggregatedChangeset);
+        EXPECT_EQ(aggregatedChangeset.GetStateInitialVersion(), 2);
+        EXPECT_EQ(aggregatedChangeset.GetAggregatedCount(), 2);
     }
 }
@@ -28,4 +28,66 @@ namespace ZooLib
 
         EXPECT_EQ(0, command.GetCommandHandled());
     }
+
+    TEST(ZooLib_CommandDispatcherTests, CommandIsDispatchedToParent)
+    {
+        CommandDispatcher parent;
+        CommandDispatcher child(&parent);
+
+        parent.RegisterHandler<TestsSupport::CommandA>(TestsSupport::CommandA::Execute);
+
+        TestsSupport::CommandA command;
+        child.Dispatch(command);
+
+        EXPECT_EQ(1, command.GetCommandHandled());
+    }
+
+    TEST(ZooLib_CommandDispatcherTests, CommandIsDispatchedToGrandParent)
+    {
+        CommandDispatcher grandParent;
+        CommandDispatcher parent(&grandParent);
+        CommandDispatcher child(&parent);
+
+        grandParent.RegisterHandler<TestsSupport::CommandA>(TestsSupport::CommandA::Execute);
+
+        TestsSupport::CommandA command;
+        child.Dispatch(command);
+        child.Dispatch(command);
+
+        EXPECT_EQ(2, command.GetCommandHandled());
+    }
+
+    TEST(ZooLib_CommandDispatcherTests, HandlerRegisteredAfterDispatchIsUsed)
+    {
+        CommandDispatcher parent;
+        CommandDispatcher child(&parent);
+
+        TestsSupport::CommandA command;
+        child.Dispatch(command);
+        EXPECT_EQ(0, command.GetCommandHandled());
+
+        parent.RegisterHandler<TestsSupport::CommandA>(TestsSupport::CommandA::Execute);
+        child.Dispatch(command);
+        EXPECT_EQ(1, command.GetCommandHandled());
+
+        parent.UnregisterHandler<TestsSupport::CommandA>();
+        child.Dispatch(command);
+        EXPECT_EQ(1, command.GetCommandHandled());
+    }
+
+    TEST(ZooLib_CommandDispatcherTests, StateArgumentsArePassedToHandler)
+    {
+        CommandDispatcher dispatcher;
+
+        int count = 0;
+        std::string log;
+        dispatcher.RegisterHandler<TestsSupport::CommandB, int, std::string>(
+                TestsSupport::CommandB::Execute, &count, &log);
+
+        dispatcher.Dispatch(TestsSupport::CommandB('x'));
+        dispatcher.Dispatch(TestsSupport::CommandB('y'));
+
+        EXPECT_EQ(2, count);
+        EXPECT_EQ("xy", log);
+    }
 }
@@ -1,3 +1,6 @@
+#include <memory>
+#include <unordered_map>
+
 #include "ZooLib/ObserverManager.hpp"
 #include "../TestsSupport/LogStateComponent.hpp"
 #include "../TestsSupport/Observers.hpp"
@@ -33,6 +36,28 @@ namespace ZooLib
         }
     };
 
+    // Records when it is run and updates the component it modifies, so that its dependents are notified.
+    class ObserverThatUpdates : public Observer
+    {
+        std::vector<const Observer *> *m_RunOrder{};
+
+    protected:
+        void UpdateImplementation() override
+        {
+            m_RunOrder->push_back(this);
+            StateComponentA::Updater updater(static_cast<StateComponentA *>(m_ModifiedComponents[0]));
+        }
+
+    public:
+        ObserverThatUpdates(
+                std::vector<const StateComponent *> observedComponents,
+                std::vector<StateComponent *> modifiedComponents, std::vector<const Observer *> *runOrder)
+            : Observer(std::move(observedComponents), std::move(modifiedComponents))
+            , m_RunOrder(runOrder)
+        {
+        }
+    };
+
     testing::AssertionResult
     IsPermutation(const char *expr1, const char *expr2, const std::string &str, const std::string &perm)
     {
@@ -140,6 +165,28 @@ namespace ZooLib
         delete obs3;
     }
 
+    TEST_F(ZooLib_ObserverManagerTestFixture, CyclicDependenciesThrow)
+    {
+        auto scA = new StateComponentA(m_State);
+        auto scC = new StateComponentC(m_State);
+
+        auto obs1 = new TestObserver({scA}, {scC});
+        auto obs2 = new TestObserver({scC}, {scA});
+
+        m_ObserverManager->AddObserver(obs1);
+        m_ObserverManager->AddObserver(obs2);
+        EXPECT_THROW(m_ObserverManager->NotifyObservers(), std::runtime_error);
+
+        m_ObserverManager->RemoveObserver(obs2);
+        EXPECT_NO_THROW(m_ObserverManager->NotifyObservers());
+
+        delete scA;
+        delete scC;
+
+        delete obs1;
+        delete obs2;
+    }
+
     TEST_F(ZooLib_ObserverManagerTestFixture, ObserverDeletedByAnotherObserverIsNotRun)
     {
         auto scA = new StateComponentA(m_State);
@@ -160,4 +207,129 @@ namespace ZooLib
 
         delete obs1;
     }
+
+    TEST_F(ZooLib_ObserverManagerTestFixture, OnlyObserversOfChangedComponentsAreNotified)
+    {
+        auto scA = new StateComponentA(m_State);
+        auto scC = new StateComponentC(m_State);
+
+        auto obs1 = new ObserverThatLogs({scA}, {m_Log}, 'a');
+        auto obs2 = new ObserverThatLogs({scC}, {m_Log}, 'c');
+
+        auto notificationRequests = 0;
+        m_ObserverManager->SetNotificationNeededCallback([&notificationRequests]() { ++notificationRequests; });
+        m_State->SetComponentChangedCallback([this](const StateComponent *stateComponent) {
+            m_ObserverManager->MarkComponentChanged(stateComponent);
+        });
+
+        m_ObserverManager->AddObserver(obs1);
+        m_ObserverManager->AddObserver(obs2);
+        m_ObserverManager->NotifyObservers();
+
+        EXPECT_PRED_FORMAT2(IsPermutation, "ac", m_Log->GetLog());
+        EXPECT_FALSE(m_ObserverManager->HasPendingNotifications());
+
+        // Nothing changed: no notification is requested.
+        notificationRequests = 0;
+        m_ObserverManager->NotifyObservers();
+        EXPECT_EQ(0, notificationRequests);
+
+        {
+            StateComponentA::Updater updater(scA);
+        }
+        {
+            StateComponentA::Updater updater(scA);
+        }
+
+        EXPECT_EQ(1, notificationRequests);
+        EXPECT_TRUE(m_ObserverManager->HasPendingNotifications());
+
+        m_ObserverManager->NotifyObservers();
+
+        EXPECT_EQ(3UZ, m_Log->GetLog().size());
+        EXPECT_EQ('a', m_Log->GetLog().back());
+        EXPECT_FALSE(m_ObserverManager->HasPendingNotifications());
+
+        m_State->SetComponentChangedCallback(nullptr);
+
+        delete scA;
+        delete scC;
+
+        delete obs1;
+        delete obs2;
+    }
+
+    TEST_F(ZooLib_ObserverManagerTestFixture, ObserversOfAGraphAreRunAfterTheirDependencies)
+    {
+        constexpr size_t k_ComponentCount = 40;
+        constexpr size_t k_ObserverCount = 100;
+
+        std::vector<std::unique_ptr<StateComponentA>> components;
+        for (auto i = 0UZ; i < k_ComponentCount; ++i)
+        {
+            components.push_back(std::make_unique<StateComponentA>(m_State));
+        }
+
+        // Observer i modifies one component, and observes two components with a lower index, so that the graph has no
+        // cycle. Observers are added in an order that does not match the dependencies.
+        std::vector<const Observer *> runOrder;
+        std::vector<std::unique_ptr<ObserverThatUpdates>> observers;
+        for (auto i = 0UZ; i < k_ObserverCount; ++i)
+        {
+            auto modified = 1 + (i * 7919) % (k_ComponentCount - 1);
+            auto observed1 = (i * 31) % modified;
+            auto observed2 = (i * 17) % modified;
+            observers.push_back(std::make_unique<ObserverThatUpdates>(
+                    std::vector<const StateComponent *>{components[observed1].get(), components[observed2].get()},
+                    std::vector<StateComponent *>{components[modified].get()}, &runOrder));
+            m_ObserverManager->AddObserver(observers.back().get());
+        }
+
+        m_ObserverManager->NotifyObservers();
+
+        // Each observer must run after the observers that modify its observed components.
+        ASSERT_EQ(k_ObserverCount, runOrder.size());
+        std::unordered_map<const Observer *, size_t> positions;
+        for (auto i = 0UZ; i < runOrder.size(); ++i)
+        {
+            positions[runOrder[i]] = i;
+        }
+
+        for (auto &observer: observers)
+        {
+            for (auto &other: observers)
+            {
+                if (std::ranges::find(observer->GetObservedComponents(), other->GetModifiedComponents()[0]) !=
+                    observer->GetObservedComponents().end())
+                {
+                    EXPECT_LT(positions[other.get()], positions[observer.get()]);
+                }
+            }
+        }
+
+        for (auto &component: components)
+        {
+            uint64_t mostRecentVersion = 0;
+            for (auto &observer: observers)
+            {
+                mostRecentVersion = std::max(mostRecentVersion, observer->GetObservedVersion(component.get()));
+            }
+            EXPECT_EQ(mostRecentVersion, m_ObserverManager->GetMostRecentObservedVersion(component.get()));
+        }
+
+        for (auto i = 0UZ; i < k_ObserverCount; i += 2)
+        {
+            m_ObserverManager->RemoveObserver(observers[i].get());
+        }
+        m_ObserverManager->NotifyObservers();
+
+        // Nothing changed since the first notification, so the remaining observers did not run again.
+        EXPECT_EQ(k_ObserverCount, runOrder.size());
+        EXPECT_FALSE(m_ObserverManager->HasPendingNotifications());
+
+        for (auto i = 1UZ; i < k_ObserverCount; i += 2)
+        {
+            m_ObserverManager->RemoveObserver(observers[i].get());
+        }
+    }
 }
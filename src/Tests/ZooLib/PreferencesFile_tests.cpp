@@ -0,0 +1,149 @@
+#include <filesystem>
+#include <fstream>
+
+#include "ZooLib/PreferencesFile.hpp"
+#include "gtest/gtest.h"
+
+namespace ZooLib
+{
+    class ZooLib_PreferencesFileTests : public testing::Test
+    {
+    protected:
+        std::filesystem::path m_FilePath{};
+
+        void SetUp() override
+        {
+            auto testName = testing::UnitTest::GetInstance()->current_test_info()->name();
+            m_FilePath = std::filesystem::path(testing::TempDir()) / "PreferencesFileTests" / testName /
+                         "preferences.json";
+            std::filesystem::remove_all(m_FilePath.parent_path());
+        }
+
+        void TearDown() override
+        {
+            std::filesystem::remove_all(m_FilePath.parent_path());
+        }
+
+        [[nodiscard]] nlohmann::json ReadFile() const
+        {
+            std::ifstream f(m_FilePath);
+            return nlohmann::json::parse(f);
+        }
+    };
+
+    TEST_F(ZooLib_PreferencesFileTests, ValuesAreWrittenOnFlush)
+    {
+        PreferencesFile preferencesFile(m_FilePath);
+        preferencesFile.Set("A", 1);
+        preferencesFile.Set("B", "b");
+        preferencesFile.Flush();
+
+        EXPECT_EQ(1UZ, preferencesFile.GetWriteCount());
+        auto json = ReadFile();
+        EXPECT_EQ(1, json["A"]);
+        EXPECT_EQ("b", json["B"]);
+        EXPECT_FALSE(std::filesystem::exists(m_FilePath.string() + ".tmp"));
+    }
+
+    TEST_F(ZooLib_PreferencesFileTests, ValuesAreWrittenOnDestruction)
+    {
+        {
+            PreferencesFile preferencesFile(m_FilePath);
+            for (auto i = 0; i < 100; ++i)
+            {
+                preferencesFile.Set("Key" + std::to_string(i), i);
+            }
+        }
+
+        auto json = ReadFile();
+        EXPECT_EQ(100UZ, json.size());
+        EXPECT_EQ(99, json["Key99"]);
+    }
+
+    TEST_F(ZooLib_PreferencesFileTests, ModificationsAreCoalesced)
+    {
+        PreferencesFile preferencesFile(m_FilePath);
+        for (auto i = 0; i < 100; ++i)
+        {
+            preferencesFile.Set("Key", i);
+        }
+
+        preferencesFile.Flush();
+
+        EXPECT_EQ(1UZ, preferencesFile.GetWriteCount());
+        EXPECT_EQ(99, ReadFile()["Key"]);
+    }
+
+    TEST_F(ZooLib_PreferencesFileTests, FailedWriteIsRetried)
+    {
+        // A regular file in place of the parent directory makes the write fail.
+        std::filesystem::create_directories(m_FilePath.parent_path().parent_path());
+        {
+            std::ofstream f(m_FilePath.parent_path());
+        }
+
+        PreferencesFile preferencesFile(m_FilePath);
+        preferencesFile.Set("A", 1);
+        preferencesFile.Flush();
+        EXPECT_EQ(0UZ, preferencesFile.GetWriteCount());
+
+        std::filesystem::remove(m_FilePath.parent_path());
+        preferencesFile.Flush();
+
+        EXPECT_EQ(1UZ, preferencesFile.GetWriteCount());
+        EXPECT_EQ(1, ReadFile()["A"]);
+    }
+
+    TEST_F(ZooLib_PreferencesFileTests, ExistingValuesArePreserved)
+    {
+        {
+            PreferencesFile preferencesFile(m_FilePath);
+            preferencesFile.Set("A", 1);
+            preferencesFile.Set("B", 2);
+        }
+
+        PreferencesFile preferencesFile(m_FilePath);
+        nlohmann::json value;
+        EXPECT_TRUE(preferencesFile.Get("A", value));
+        EXPECT_EQ(1, value);
+        EXPECT_FALSE(preferencesFile.Get("C", value));
+
+        preferencesFile.Set("B", 3);
+        preferencesFile.Flush();
+
+        auto json = ReadFile();
+        EXPECT_EQ(1, json["A"]);
+        EXPECT_EQ(3, json["B"]);
+    }
+
+    TEST_F(ZooLib_PreferencesFileTests, InvalidFileIsReplaced)
+    {
+        std::filesystem::create_directories(m_FilePath.parent_path());
+        {
+            std::ofstream f(m_FilePath);
+            f << "{ not json";
+        }
+
+        PreferencesFile preferencesFile(m_FilePath);
+        nlohmann::json value;
+        EXPECT_FALSE(preferencesFile.Get("A", value));
+
+        preferencesFile.Set("A", 1);
+        preferencesFile.Flush();
+
+        EXPECT_EQ(1, ReadFile()["A"]);
+    }
+
+    TEST_F(ZooLib_PreferencesFileTests, FileIsNotWrittenWithoutModifications)
+    {
+        {
+            PreferencesFile preferencesFile(m_FilePath);
+            nlohmann::json value;
+            preferencesFile.Get("A", value);
+            preferencesFile.Flush();
+            EXPECT_EQ(0UZ, preferencesFile.GetWriteCount());
+        }
+
+        EXPECT_FALSE(std::filesystem::exists(m_FilePath));
+    }
+}
@@ -0,0 +1,136 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <nlohmann/json.hpp>
+#include <thread>
+#include <vector>
+
+#include "ZooLib/Profiler.hpp"
+
+namespace ZooLib
+{
+    static const Profiler::Metric s_TestCount{"tests.count", Profiler::Unit::e_Count};
+    static const Profiler::Metric s_TestTime{"tests.time", Profiler::Unit::e_Nanoseconds};
+
+    class ZooLib_ProfilerTests : public testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            Profiler::Reset();
+            Profiler::SetEnabled(true);
+        }
+
+        void TearDown() override
+        {
+            Profiler::SetEnabled(false);
+            Profiler::Reset();
+        }
+
+        static Profiler::Summary GetSummary(const Profiler::Metric &metric)
+        {
+            auto summaries = Profiler::GetSummaries();
+            auto it = std::ranges::find(summaries, metric.GetName(), &Profiler::Summary::Name);
+            return it == summaries.end() ? Profiler::Summary{} : *it;
+        }
+    };
+
+    TEST_F(ZooLib_ProfilerTests, BucketsArePowersOfTwo)
+    {
+        EXPECT_EQ(Profiler::GetBucketIndex(0), 0UZ);
+        EXPECT_EQ(Profiler::GetBucketIndex(1), 1UZ);
+        EXPECT_EQ(Profiler::GetBucketIndex(2), 2UZ);
+        EXPECT_EQ(Profiler::GetBucketIndex(3), 2UZ);
+        EXPECT_EQ(Profiler::GetBucketIndex(4), 3UZ);
+        EXPECT_EQ(Profiler::GetBucketIndex(UINT64_MAX), Profiler::k_BucketCount - 1);
+    }
+
+    TEST_F(ZooLib_ProfilerTests, RecordedValuesAreSummarized)
+    {
+        for (auto value = 1UL; value <= 100; ++value)
+        {
+            s_TestCount.Record(value);
+        }
+
+        auto summary = GetSummary(s_TestCount);
+        EXPECT_EQ(summary.Name, "tests.count");
+        EXPECT_EQ(summary.Count, 100UL);
+        EXPECT_EQ(summary.Sum, 5050UL);
+        EXPECT_EQ(summary.Max, 100UL);
+        EXPECT_DOUBLE_EQ(summary.GetMean(), 50.5);
+
+        // The percentiles are the upper bounds of the buckets.
+        EXPECT_EQ(summary.GetPercentile(0.5), 63UL);
+        EXPECT_EQ(summary.GetPercentile(0.99), 100UL);
+        EXPECT_EQ(summary.GetPercentile(0.01), 1UL);
+    }
+
+    TEST_F(ZooLib_ProfilerTests, NothingIsRecordedWhenDisabled)
+    {
+        Profiler::SetEnabled(false);
+        s_TestCount.Record(1);
+        {
+            Profiler::ScopedTimer timer(s_TestTime);
+        }
+
+        EXPECT_EQ(GetSummary(s_TestCount).Count, 0UL);
+        EXPECT_EQ(GetSummary(s_TestTime).Count, 0UL);
+    }
+
+    TEST_F(ZooLib_ProfilerTests, ScopedTimerRecordsElapsedTime)
+    {
+        {
+            Profiler::ScopedTimer timer(s_TestTime);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        auto summary = GetSummary(s_TestTime);
+        EXPECT_EQ(summary.Count, 1UL);
+        EXPECT_GE(summary.Sum, 2'000'000UL);
+    }
+
+    TEST_F(ZooLib_ProfilerTests, ValuesOfAllThreadsAreSummed)
+    {
+        constexpr auto k_ThreadCount = 4;
+        constexpr auto k_ValueCount = 10000UL;
+
+        // Successive generations of threads reuse the histograms of the threads that exited.
+        for (auto generation = 0; generation < 2; ++generation)
+        {
+            std::vector<std::thread> threads;
+            for (auto i = 0; i < k_ThreadCount; ++i)
+            {
+                threads.emplace_back([]() {
+                    for (auto value = 0UL; value < k_ValueCount; ++value)
+                    {
+                        s_TestCount.Record(1);
+                    }
+                });
+            }
+            for (auto &thread: threads)
+            {
+                thread.join();
+            }
+        }
+
+        auto summary = GetSummary(s_TestCount);
+        EXPECT_EQ(summary.Count, 2 * k_ThreadCount * k_ValueCount);
+        EXPECT_EQ(summary.Buckets[1], 2 * k_ThreadCount * k_ValueCount);
+    }
+
+    TEST_F(ZooLib_ProfilerTests, JsonHoldsTheNonEmptyBuckets)
+    {
+        s_TestCount.Record(0);
+        s_TestCount.Record(5);
+        s_TestCount.Record(6);
+
+        auto json = Profiler::ToJson(Profiler::GetSummaries());
+        ASSERT_TRUE(json.contains("tests.count"));
+
+        const auto &metric = json["tests.count"];
+        EXPECT_EQ(metric["unit"], "count");
+        EXPECT_EQ(metric["count"], 3);
+        EXPECT_EQ(metric["max"], 6);
+        EXPECT_EQ(metric["histogram"], nlohmann::json::parse("[[0, 0, 1], [4, 7, 2]]"));
+    }
+}
@@ -0,0 +1,131 @@
+#include "gtest/gtest.h"
+
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "ZooLib/SpscRingBuffer.hpp"
+
+namespace ZooLib
+{
+    TEST(ZooLib_SpscRingBufferTests, NewBufferIsEmpty)
+    {
+        SpscRingBuffer<int> ringBuffer(16);
+
+        EXPECT_EQ(ringBuffer.GetCapacity(), 16);
+        EXPECT_EQ(ringBuffer.GetSize(), 0);
+        EXPECT_TRUE(ringBuffer.GetReadSpan().empty());
+        EXPECT_EQ(ringBuffer.GetWriteSpan().size(), 16);
+    }
+
+    TEST(ZooLib_SpscRingBufferTests, CommittedWritesAreReadable)
+    {
+        SpscRingBuffer<int> ringBuffer(16);
+
+        auto writeSpan = ringBuffer.GetWriteSpan();
+        for (auto i = 0; i < 5; ++i)
+        {
+            writeSpan[i] = i;
+        }
+        ringBuffer.CommitWrite(5);
+
+        auto readSpan = ringBuffer.GetReadSpan();
+        ASSERT_EQ(readSpan.size(), 5);
+        for (auto i = 0; i < 5; ++i)
+        {
+            EXPECT_EQ(readSpan[i], i);
+        }
+
+        // Read spans point into the ring storage.
+        EXPECT_EQ(readSpan.data(), writeSpan.data());
+    }
+
+    TEST(ZooLib_SpscRingBufferTests, FullBufferHasNoWriteSpace)
+    {
+        SpscRingBuffer<int> ringBuffer(8);
+
+        ringBuffer.CommitWrite(ringBuffer.GetWriteSpan().size());
+
+        EXPECT_EQ(ringBuffer.GetSize(), 8);
+        EXPECT_TRUE(ringBuffer.GetWriteSpan().empty());
+
+        ringBuffer.CommitRead(3);
+        EXPECT_EQ(ringBuffer.GetWriteSpan().size(), 3);
+    }
+
+    TEST(ZooLib_SpscRingBufferTests, SpansStopAtTheEndOfTheStorage)
+    {
+        SpscRingBuffer<int> ringBuffer(8);
+
+        ringBuffer.CommitWrite(6);
+        ringBuffer.CommitRead(6);
+
+        // Only 2 elements are contiguous before the end of the storage.
+        auto writeSpan = ringBuffer.GetWriteSpan();
+        EXPECT_EQ(writeSpan.size(), 2);
+        ringBuffer.CommitWrite(2);
+
+        writeSpan = ringBuffer.GetWriteSpan();
+        EXPECT_EQ(writeSpan.size(), 6);
+        ringBuffer.CommitWrite(3);
+
+        auto readSpan = ringBuffer.GetReadSpan();
+        EXPECT_EQ(readSpan.size(), 2);
+        ringBuffer.CommitRead(2);
+
+        readSpan = ringBuffer.GetReadSpan();
+        EXPECT_EQ(readSpan.size(), 3);
+    }
+
+    TEST(ZooLib_SpscRingBufferTests, ResetBufferStartsAtTheBeginningOfTheStorage)
+    {
+        SpscRingBuffer<int> ringBuffer(8);
+        auto *storage = ringBuffer.GetWriteSpan().data();
+
+        ringBuffer.CommitWrite(5);
+        ringBuffer.CommitRead(3);
+        ringBuffer.Reset();
+
+        EXPECT_EQ(ringBuffer.GetSize(), 0);
+        EXPECT_TRUE(ringBuffer.GetReadSpan().empty());
+
+        auto writeSpan = ringBuffer.GetWriteSpan();
+        EXPECT_EQ(writeSpan.data(), storage);
+        EXPECT_EQ(writeSpan.size(), 8);
+    }
+
+    TEST(ZooLib_SpscRingBufferTests, TransfersDataBetweenThreadsInOrder)
+    {
+        constexpr size_t k_Count = 100'000;
+        SpscRingBuffer<uint32_t> ringBuffer(1000);
+
+        std::thread producer([&ringBuffer]() {
+            uint32_t next = 0;
+            while (next < k_Count)
+            {
+                auto writeSpan = ringBuffer.GetWriteSpan();
+                auto count = std::min(writeSpan.size(), k_Count - next);
+                std::iota(writeSpan.begin(), writeSpan.begin() + static_cast<std::ptrdiff_t>(count), next);
+                next += count;
+                ringBuffer.CommitWrite(count);
+            }
+        });
+
+        uint32_t expected = 0;
+        bool inOrder = true;
+        while (expected < k_Count)
+        {
+            auto readSpan = ringBuffer.GetReadSpan();
+            for (auto value: readSpan)
+            {
+                inOrder &= (value == expected++);
+            }
+            ringBuffer.CommitRead(readSpan.size());
+        }
+
+        producer.join();
+
+        EXPECT_TRUE(inOrder);
+        EXPECT_EQ(ringBuffer.GetSize(), 0);
+    }
+}
@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <vector>
+
+#include "ZooLib/ThreadPool.hpp"
+
+namespace ZooLib
+{
+    TEST(ZooLib_ThreadPoolTests, HasAtLeastOneThread)
+    {
+        ThreadPool threadPool(0);
+
+        EXPECT_EQ(threadPool.GetThreadCount(), 1);
+    }
+
+    TEST(ZooLib_ThreadPoolTests, SubmitReturnsTaskResult)
+    {
+        ThreadPool threadPool(4);
+
+        std::vector<std::future<int>> results;
+        for (auto i = 0; i < 100; ++i)
+        {
+            results.push_back(threadPool.Submit([i]() { return i * i; }));
+        }
+
+        for (auto i = 0; i < 100; ++i)
+        {
+            EXPECT_EQ(results[i].get(), i * i);
+        }
+    }
+
+    TEST(ZooLib_ThreadPoolTests, ExceptionsArePropagatedToTheFuture)
+    {
+        ThreadPool threadPool(2);
+
+        auto result = threadPool.Submit([]() -> int { throw std::runtime_error("task failed"); });
+
+        EXPECT_THROW(result.get(), std::runtime_error);
+    }
+
+    TEST(ZooLib_ThreadPoolTests, DestructorCompletesQueuedTasks)
+    {
+        std::atomic<int> completedTasks{};
+
+        {
+            ThreadPool threadPool(2);
+            for (auto i = 0; i < 50; ++i)
+            {
+                threadPool.Submit([&completedTasks]() { completedTasks.fetch_add(1); });
+            }
+        }
+
+        EXPECT_EQ(completedTasks.load(), 50);
+    }
+}
@@ -33,6 +33,7 @@ namespace Gorfector
             None, /**< No error occurred. */
             CannotOpenFile, /**< The file could not be opened. */
             ImageTooLarge, /**< The image size exceeds the allowed limit. */
+            CannotWriteFile, /**< The image could not be written completely. */
             UnknownError /**< An unknown error occurred. */
         };
 
@@ -169,6 +170,14 @@ namespace Gorfector
          */
         [[nodiscard]] virtual std::vector<std::string> GetExtensions() const = 0;
 
+        /**
+         * \brief Creates a writer of the same format and with the same settings. The registered writers are
+         * prototypes: each file is written by its own instance, so that several files of the same format can be
+         * written at the same time.
+         * \return A new writer, owned by the caller. It must not outlive this writer.
+         */
+        [[nodiscard]] virtual FileWriter *Clone() const = 0;
+
         /**
          * \brief Creates a new file for writing.
          * \param path The file path to create.
@@ -191,8 +200,9 @@ namespace Gorfector
 
         /**
          * \brief Closes the file after writing.
+         * \return An error code indicating the result of the operation. On error, the incomplete file is removed.
          */
-        virtual void CloseFile() = 0;
+        virtual Error CloseFile() = 0;
 
         /**
          * \brief Cancels the file writing operation.
@@ -214,6 +224,8 @@ namespace Gorfector
                     return "Cannot open file";
                 case Error::ImageTooLarge:
                     return "Image too large";
+                case Error::CannotWriteFile:
+                    return "Cannot write file";
                 case Error::UnknownError:
                 default:
                     return "Unknown error";
@@ -0,0 +1,450 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include <jpeglib.h>
+
+#include "ZooLib/ThreadPool.hpp"
+
+namespace Gorfector
+{
+    /**
+     * \class JpegBandEncoder
+     * \brief Encodes a baseline JPEG image as horizontal bands compressed in parallel.
+     *
+     * The image is split into bands of whole MCU rows, and the restart interval of the image is set to the number of
+     * MCUs in a band. Since the DC predictions are reset at each restart marker, each band can be encoded as an
+     * independent JPEG image by a worker thread. The entropy-coded data of the bands are then written to the file in
+     * order, separated by restart markers, after the headers of the first band. The quantization and Huffman tables
+     * are the libjpeg defaults and are the same for all the bands.
+     *
+     * Each band owns a libjpeg compression object and its buffers, which are reused for the next bands, so encoding
+     * does not allocate memory once the first few bands are written. libjpeg errors do not exit the process: they
+     * make the band, and the image, fail.
+     */
+    class JpegBandEncoder
+    {
+        /**
+         * \brief Target size of the uncompressed data of a band.
+         */
+        static constexpr size_t k_BandSize = 512 * 1024;
+
+    public:
+        /**
+         * \brief A libjpeg error manager returning to the last `setjmp()` on its jump buffer instead of exiting.
+         * Also used by `JpegWriter` when it compresses the image on a single thread.
+         */
+        struct ErrorManager
+        {
+            jpeg_error_mgr m_Base{};
+            std::jmp_buf m_JumpBuffer{};
+
+            explicit ErrorManager(jpeg_compress_struct *compressStruct)
+            {
+                compressStruct->err = jpeg_std_error(&m_Base);
+                m_Base.error_exit = [](j_common_ptr info) {
+                    // m_Base is the first member: the error manager is the ErrorManager.
+                    std::longjmp(reinterpret_cast<ErrorManager *>(info->err)->m_JumpBuffer, 1);
+                };
+                m_Base.output_message = [](j_common_ptr) {};
+            }
+        };
+
+    private:
+        /**
+         * \brief A band of the image: its 8 bit samples, and its encoded data once compressed.
+         */
+        struct Band
+        {
+            jpeg_compress_struct m_CompressStruct{};
+            ErrorManager m_ErrorManager{&m_CompressStruct};
+            std::vector<JSAMPLE> m_Samples{};
+            std::vector<JSAMPROW> m_RowPointers{};
+            uint32_t m_Lines{};
+
+            /// Buffer given to the libjpeg memory destination; it grows to fit the largest band.
+            std::vector<uint8_t> m_Encoded{};
+            size_t m_EncodedSize{};
+
+            /// The memory destination buffer, allocated by libjpeg when `m_Encoded` is too small.
+            unsigned char *m_Destination{};
+            unsigned long m_DestinationSize{};
+
+            std::future<bool> m_Encoding{};
+
+            Band()
+            {
+                if (setjmp(m_ErrorManager.m_JumpBuffer)) // NOLINT(*-err52-cpp)
+                {
+                    // Out of memory: encoding the band fails.
+                    return;
+                }
+
+                jpeg_create_compress(&m_CompressStruct);
+            }
+
+            ~Band()
+            {
+                jpeg_destroy_compress(&m_CompressStruct);
+            }
+
+            Band(const Band &) = delete;
+            Band &operator=(const Band &) = delete;
+        };
+
+        FILE *m_File;
+        uint32_t m_Width;
+        uint32_t m_Height;
+        int m_Components;
+        int m_Quality;
+        size_t m_SamplesPerLine;
+
+        uint32_t m_LinesPerBand{};
+        unsigned int m_RestartInterval{};
+        size_t m_MaxPendingBands;
+
+        std::unique_ptr<Band> m_CurrentBand{};
+        std::deque<std::unique_ptr<Band>> m_PendingBands{};
+        std::vector<std::unique_ptr<Band>> m_FreeBands{};
+        uint32_t m_NextBandIndex{};
+        bool m_Failed{};
+
+        ZooLib::ThreadPool m_ThreadPool;
+
+        /**
+         * \brief Sets the compression parameters of the image on a libjpeg compression object.
+         */
+        static void SetImageParameters(
+                jpeg_compress_struct *compressStruct, uint32_t width, uint32_t height, int components, int quality)
+        {
+            compressStruct->image_width = width;
+            compressStruct->image_height = height;
+            compressStruct->input_components = components;
+            compressStruct->in_color_space = components == 3 ? JCS_RGB : JCS_GRAYSCALE;
+            jpeg_set_defaults(compressStruct);
+            jpeg_set_quality(compressStruct, quality, FALSE);
+        }
+
+        /**
+         * \brief Compresses a band to memory. Called on a worker thread.
+         * \return False if libjpeg reported an error.
+         */
+        static bool EncodeBand(Band *band, uint32_t width, int components, int quality, unsigned int restartInterval)
+        {
+            auto *compressStruct = &band->m_CompressStruct;
+            band->m_Destination = band->m_Encoded.data();
+            band->m_DestinationSize = band->m_Encoded.size();
+
+            if (setjmp(band->m_ErrorManager.m_JumpBuffer)) // NOLINT(*-err52-cpp)
+            {
+                // Return the compression object to its idle state, so that it can be used for the next bands.
+                jpeg_abort_compress(compressStruct);
+                if (band->m_Destination != band->m_Encoded.data())
+                {
+                    free(band->m_Destination);
+                }
+                return false;
+            }
+
+            SetImageParameters(compressStruct, width, band->m_Lines, components, quality);
+            compressStruct->restart_interval = restartInterval;
+            jpeg_mem_dest(compressStruct, &band->m_Destination, &band->m_DestinationSize);
+
+            jpeg_start_compress(compressStruct, TRUE);
+            jpeg_write_scanlines(compressStruct, band->m_RowPointers.data(), band->m_Lines);
+            jpeg_finish_compress(compressStruct);
+
+            band->m_EncodedSize = band->m_DestinationSize;
+            if (band->m_Destination != band->m_Encoded.data())
+            {
+                // libjpeg needed a larger buffer: keep it for the next bands.
+                band->m_Encoded.assign(band->m_Destination, band->m_Destination + band->m_DestinationSize);
+                free(band->m_Destination);
+            }
+
+            return true;
+        }
+
+        /**
+         * \brief Finds the start of the entropy-coded data, right after the SOS marker segment.
+         * \param data The encoded band.
+         * \param size The size of the encoded band.
+         * \param frameHeightOffset Receives the offset of the image height in the SOF marker segment.
+         * \return The offset of the entropy-coded data, or 0 if the data is not a valid JPEG image.
+         */
+        static size_t FindEntropyCodedData(const uint8_t *data, size_t size, size_t *frameHeightOffset)
+        {
+            // Skip the SOI marker.
+            auto position = 2UZ;
+            while (position + 4 <= size && data[position] == 0xFF)
+            {
+                auto marker = data[position + 1];
+                auto length = static_cast<size_t>(data[position + 2] << 8 | data[position + 3]);
+                if (marker >= 0xC0 && marker <= 0xC2)
+                {
+                    // Marker, length, sample precision, then the image height.
+                    *frameHeightOffset = position + 5;
+                }
+                else if (marker == 0xDA)
+                {
+                    return position + 2 + length;
+                }
+
+                position += 2 + length;
+            }
+
+            return 0;
+        }
+
+        std::unique_ptr<Band> AcquireBand()
+        {
+            std::unique_ptr<Band> band;
+            if (m_FreeBands.empty())
+            {
+                band = std::make_unique<Band>();
+                band->m_Samples.resize(m_LinesPerBand * m_SamplesPerLine);
+                band->m_RowPointers.resize(m_LinesPerBand);
+                for (auto i = 0U; i < m_LinesPerBand; ++i)
+                {
+                    band->m_RowPointers[i] = band->m_Samples.data() + i * m_SamplesPerLine;
+                }
+                band->m_Encoded.resize(band->m_Samples.size() / 4 + 4096);
+            }
+            else
+            {
+                band = std::move(m_FreeBands.back());
+                m_FreeBands.pop_back();
+            }
+
+            band->m_Lines = 0;
+            return band;
+        }
+
+        void SubmitCurrentBand()
+        {
+            auto *band = m_CurrentBand.get();
+            band->m_Encoding = m_ThreadPool.Submit(
+                    [band, width = m_Width, components = m_Components, quality = m_Quality,
+                     restartInterval = m_RestartInterval]() {
+                        return EncodeBand(band, width, components, quality, restartInterval);
+                    });
+
+            m_PendingBands.push_back(std::move(m_CurrentBand));
+        }
+
+        /**
+         * \brief Waits for the first pending band to be encoded, then writes its entropy-coded data to the file.
+         */
+        void WriteFirstPendingBand()
+        {
+            auto band = std::move(m_PendingBands.front());
+            m_PendingBands.pop_front();
+
+            auto bandIndex = m_NextBandIndex++;
+            auto encoded = band->m_Encoding.get();
+            auto *data = band->m_Encoded.data();
+            auto size = band->m_EncodedSize;
+            size_t frameHeightOffset = 0;
+            auto dataStart = encoded ? FindEntropyCodedData(data, size, &frameHeightOffset) : 0;
+
+            // The band must end with the EOI marker.
+            if (dataStart == 0 || frameHeightOffset == 0 || size < dataStart + 2 || data[size - 1] != 0xD9)
+            {
+                m_Failed = true;
+            }
+
+            if (!m_Failed)
+            {
+                if (bandIndex == 0)
+                {
+                    // Headers of the first band, with the height of the whole image.
+                    data[frameHeightOffset] = static_cast<uint8_t>(m_Height >> 8);
+                    data[frameHeightOffset + 1] = static_cast<uint8_t>(m_Height);
+                    fwrite(data, 1, dataStart, m_File);
+                }
+                else
+                {
+                    uint8_t restartMarker[2] = {0xFF, static_cast<uint8_t>(0xD0 + (bandIndex - 1) % 8)};
+                    fwrite(restartMarker, 1, sizeof(restartMarker), m_File);
+                }
+
+                fwrite(data + dataStart, 1, size - 2 - dataStart, m_File);
+            }
+
+            m_FreeBands.push_back(std::move(band));
+        }
+
+        void WriteEncodedBands()
+        {
+            while (!m_PendingBands.empty() &&
+                   m_PendingBands.front()->m_Encoding.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                WriteFirstPendingBand();
+            }
+        }
+
+    public:
+        /**
+         * \brief Constructs a JpegBandEncoder.
+         * \param file The file to write to.
+         * \param width Width of the image, in pixels.
+         * \param height Height of the image, in pixels.
+         * \param components Number of color components: 1 or 3.
+         * \param quality The JPEG quality, from 0 to 100.
+         * \param workerCount Number of threads compressing bands.
+         */
+        JpegBandEncoder(FILE *file, uint32_t width, uint32_t height, int components, int quality, size_t workerCount)
+            : m_File(file)
+            , m_Width(width)
+            , m_Height(height)
+            , m_Components(components)
+            , m_Quality(quality)
+            , m_SamplesPerLine(static_cast<size_t>(width) * components)
+            , m_MaxPendingBands(2 * std::max(workerCount, static_cast<size_t>(1)))
+            , m_ThreadPool(workerCount)
+        {
+            // The MCU size depends on the chroma subsampling chosen by jpeg_set_defaults().
+            jpeg_compress_struct compressStruct{};
+            ErrorManager errorManager(&compressStruct);
+            if (setjmp(errorManager.m_JumpBuffer)) // NOLINT(*-err52-cpp)
+            {
+                // The encoder is not valid.
+                jpeg_destroy_compress(&compressStruct);
+                return;
+            }
+
+            jpeg_create_compress(&compressStruct);
+            SetImageParameters(&compressStruct, width, height, components, quality);
+            auto maxHSampleFactor = 1;
+            auto maxVSampleFactor = 1;
+            for (auto i = 0; i < compressStruct.num_components; ++i)
+            {
+                maxHSampleFactor = std::max(maxHSampleFactor, compressStruct.comp_info[i].h_samp_factor);
+                maxVSampleFactor = std::max(maxVSampleFactor, compressStruct.comp_info[i].v_samp_factor);
+            }
+            jpeg_destroy_compress(&compressStruct);
+
+            auto mcuWidth = static_cast<uint32_t>(maxHSampleFactor * DCTSIZE);
+            auto mcuHeight = static_cast<uint32_t>(maxVSampleFactor * DCTSIZE);
+            auto mcusPerRow = (width + mcuWidth - 1) / mcuWidth;
+            if (mcusPerRow == 0 || mcusPerRow > 65535)
+            {
+                return;
+            }
+
+            auto mcuRowsPerBand = std::max(k_BandSize / std::max(m_SamplesPerLine * mcuHeight, 1UZ), 1UZ);
+            // The restart interval is a 16 bit value.
+            mcuRowsPerBand = std::min(mcuRowsPerBand, static_cast<size_t>(65535 / mcusPerRow));
+            m_LinesPerBand = static_cast<uint32_t>(mcuRowsPerBand) * mcuHeight;
+            m_RestartInterval = static_cast<unsigned int>(mcuRowsPerBand * mcusPerRow);
+        }
+
+        /**
+         * \brief Destructor. Discards the bands not written yet.
+         */
+        ~JpegBandEncoder()
+        {
+            Cancel();
+        }
+
+        JpegBandEncoder(const JpegBandEncoder &) = delete;
+        JpegBandEncoder &operator=(const JpegBandEncoder &) = delete;
+
+        /**
+         * \brief Checks whether the image can be split in bands. Very wide images cannot.
+         * \return True if the encoder can be used.
+         */
+        [[nodiscard]] bool IsValid() const
+        {
+            return m_LinesPerBand > 0 && m_Height > 0;
+        }
+
+        /**
+         * \brief Gets the storage for the next line of the image, to be filled with 8 bit samples.
+         *
+         * The line must be filled before calling `CommitLine()`.
+         *
+         * \return Pointer to the line samples.
+         */
+        JSAMPLE *GetNextLine()
+        {
+            if (m_CurrentBand == nullptr)
+            {
+                m_CurrentBand = AcquireBand();
+            }
+
+            return m_CurrentBand->m_RowPointers[m_CurrentBand->m_Lines];
+        }
+
+        /**
+         * \brief Adds the line returned by `GetNextLine()` to the image.
+         *
+         * Complete bands are submitted for encoding. This method blocks when too many bands are waiting to be
+         * encoded.
+         */
+        void CommitLine()
+        {
+            if (++m_CurrentBand->m_Lines < m_LinesPerBand)
+            {
+                return;
+            }
+
+            SubmitCurrentBand();
+            if (m_PendingBands.size() >= m_MaxPendingBands)
+            {
+                WriteFirstPendingBand();
+            }
+
+            WriteEncodedBands();
+        }
+
+        /**
+         * \brief Encodes the last, possibly incomplete, band, writes all remaining bands and the EOI marker.
+         * \return False if a band could not be encoded or written.
+         */
+        bool Finish()
+        {
+            if (m_CurrentBand != nullptr && m_CurrentBand->m_Lines > 0)
+            {
+                SubmitCurrentBand();
+            }
+
+            while (!m_PendingBands.empty())
+            {
+                WriteFirstPendingBand();
+            }
+
+            if (!m_Failed && m_NextBandIndex > 0)
+            {
+                uint8_t endOfImage[2] = {0xFF, 0xD9};
+                fwrite(endOfImage, 1, sizeof(endOfImage), m_File);
+            }
+
+            return !m_Failed && m_NextBandIndex > 0 && ferror(m_File) == 0;
+        }
+
+        /**
+         * \brief Discards the bands not written yet.
+         */
+        void Cancel()
+        {
+            for (auto &band: m_PendingBands)
+            {
+                // The worker threads use the band buffers: wait for them to be done.
+                band->m_Encoding.wait();
+            }
+
+            m_PendingBands.clear();
+            m_CurrentBand = nullptr;
+        }
+    };
+}
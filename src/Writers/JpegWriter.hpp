@@ -6,7 +6,9 @@
 #include <jpeglib.h>
 
 #include "FileWriter.hpp"
+#include "JpegBandEncoder.hpp"
 #include "JpegWriterState.hpp"
+#include "PixelConvert.hpp"
 
 namespace Gorfector
 {
@@ -34,21 +36,82 @@ namespace Gorfector
          */
         JpegWriterState *m_StateComponent{};
 
+        /**
+         * \brief Whether this writer deletes the state component; false for the writers created by `Clone()`.
+         */
+        bool m_OwnsStateComponent{true};
+
         /**
          * \brief JPEG compression structure used by libjpeg.
          */
         jpeg_compress_struct *m_CompressStruct{};
 
         /**
-         * \brief Error handler for libjpeg operations.
+         * \brief Error handler for libjpeg operations, returning to the caller instead of exiting the process.
+         */
+        JpegBandEncoder::ErrorManager *m_ErrorHandler{};
+
+        /**
+         * \brief Whether libjpeg failed to compress or write the image.
          */
-        jpeg_error_mgr *m_ErrorHandler{};
+        bool m_HasWriteFailed{};
 
         /**
          * \brief File pointer for the output JPEG file.
          */
         FILE *m_File{};
 
+        /**
+         * \brief Path of the output JPEG file, removed when it cannot be written completely.
+         */
+        std::filesystem::path m_FilePath{};
+
+        /**
+         * \brief Encoder writing the image when it is compressed by more than one thread; null otherwise.
+         */
+        JpegBandEncoder *m_BandEncoder{};
+
+        /**
+         * \brief Number of lines written to the file.
+         */
+        uint32_t m_LinesWritten{};
+
+        /**
+         * \brief Row pointers passed to libjpeg, reused for the lifetime of the file.
+         */
+        std::vector<JSAMPROW> m_RowPointers{};
+
+        /**
+         * \brief Lines converted to 8 bit samples, reused for the lifetime of the file.
+         */
+        std::vector<JSAMPLE> m_ConvertedLines{};
+
+        /**
+         * \brief Constructs a writer sharing the state component of another one.
+         * \param prototype The writer whose settings are used.
+         */
+        explicit JpegWriter(const JpegWriter *prototype)
+            : FileWriter(prototype->GetApplicationName())
+            , m_StateComponent(prototype->m_StateComponent)
+            , m_OwnsStateComponent(false)
+        {
+        }
+
+        /**
+         * \brief Completes the compression of the image written on a single thread.
+         * \return False if libjpeg failed to compress or write the end of the image.
+         */
+        bool FinishCompress()
+        {
+            if (setjmp(m_ErrorHandler->m_JumpBuffer)) // NOLINT(*-err52-cpp)
+            {
+                return false;
+            }
+
+            jpeg_finish_compress(m_CompressStruct);
+            return true;
+        }
+
     public:
         /**
          * \brief Constructor for the JpegWriter class.
@@ -66,7 +129,10 @@ namespace Gorfector
          */
         ~JpegWriter() override
         {
-            delete m_StateComponent;
+            if (m_OwnsStateComponent)
+            {
+                delete m_StateComponent;
+            }
         }
 
         /**
@@ -96,6 +162,15 @@ namespace Gorfector
             return k_Extensions;
         }
 
+        /**
+         * \brief Creates a JPEG writer with the same settings, to write a file while this one writes another.
+         * \return A new writer, owned by the caller.
+         */
+        [[nodiscard]] FileWriter *Clone() const override
+        {
+            return new JpegWriter(this);
+        }
+
         /**
          * \brief Creates a new JPEG file for writing.
          * \param path The file path to create.
@@ -107,24 +182,48 @@ namespace Gorfector
                 std::filesystem::path &path, const DeviceOptionsState *deviceOptions,
                 const SANE_Parameters &parameters) override
         {
-            m_CompressStruct = new jpeg_compress_struct();
-            m_ErrorHandler = new jpeg_error_mgr();
-
-            m_CompressStruct->err = jpeg_std_error(m_ErrorHandler);
-            jpeg_create_compress(m_CompressStruct);
             m_File = fopen(path.string().c_str(), "wb");
             if (m_File == nullptr)
             {
-                jpeg_destroy_compress(m_CompressStruct);
-                delete m_CompressStruct;
-                delete m_ErrorHandler;
                 return Error::CannotOpenFile;
             }
+            m_FilePath = path;
+
+            m_LinesWritten = 0;
+            m_HasWriteFailed = false;
+            auto components = parameters.format == SANE_FRAME_RGB ? 3 : 1;
+
+            if (m_StateComponent->GetWorkerCount() > 1 && parameters.lines > 0)
+            {
+                m_BandEncoder = new JpegBandEncoder(
+                        m_File, parameters.pixels_per_line, parameters.lines, components,
+                        m_StateComponent->GetQuality(), m_StateComponent->GetWorkerCount());
+                if (m_BandEncoder->IsValid())
+                {
+                    return Error::None;
+                }
+
+                // The image is too wide to be split in bands.
+                delete m_BandEncoder;
+                m_BandEncoder = nullptr;
+            }
+
+            m_CompressStruct = new jpeg_compress_struct();
+            m_ErrorHandler = new JpegBandEncoder::ErrorManager(m_CompressStruct);
+            if (setjmp(m_ErrorHandler->m_JumpBuffer)) // NOLINT(*-err52-cpp)
+            {
+                CancelFile();
+                std::error_code errorCode;
+                std::filesystem::remove(m_FilePath, errorCode);
+                return Error::CannotWriteFile;
+            }
+
+            jpeg_create_compress(m_CompressStruct);
 
             jpeg_stdio_dest(m_CompressStruct, m_File);
             m_CompressStruct->image_width = parameters.pixels_per_line;
             m_CompressStruct->image_height = parameters.lines;
-            m_CompressStruct->input_components = parameters.format == SANE_FRAME_RGB ? 3 : 1;
+            m_CompressStruct->input_components = components;
             m_CompressStruct->in_color_space = parameters.format == SANE_FRAME_RGB ? JCS_RGB : JCS_GRAYSCALE;
             jpeg_set_defaults(m_CompressStruct);
             jpeg_set_quality(m_CompressStruct, m_StateComponent->GetQuality(), FALSE);
@@ -142,91 +241,104 @@ namespace Gorfector
          */
         size_t AppendBytes(SANE_Byte *bytes, uint32_t numberOfLines, const SANE_Parameters &parameters) override
         {
-            if (numberOfLines == 0 || m_CompressStruct == nullptr)
+            if (numberOfLines == 0 || m_HasWriteFailed || (m_CompressStruct == nullptr && m_BandEncoder == nullptr))
                 return 0;
 
-            if (m_CompressStruct->image_height <= m_CompressStruct->next_scanline)
+            auto imageHeight = static_cast<uint32_t>(parameters.lines);
+            if (imageHeight <= m_LinesWritten)
                 return 0;
 
-            auto numLinesToWrite =
-                    std::min(numberOfLines, m_CompressStruct->image_height - m_CompressStruct->next_scanline);
-
-            auto rowPointer = new JSAMPROW[numLinesToWrite];
-            SANE_Byte *auxBuffer = nullptr;
+            auto numLinesToWrite = std::min(numberOfLines, imageHeight - m_LinesWritten);
+            m_LinesWritten += numLinesToWrite;
 
-            if (parameters.depth == 1)
+            if (m_BandEncoder != nullptr)
             {
-                // Convert 1-bit grayscale to 8-bit grayscale
-                auxBuffer = new SANE_Byte[numLinesToWrite * parameters.pixels_per_line];
                 for (auto i = 0U; i < numLinesToWrite; ++i)
                 {
-                    auto line = &bytes[i * parameters.bytes_per_line];
-                    for (auto j = 0; j < parameters.pixels_per_line; ++j)
-                    {
-                        // 0 is white
-                        auxBuffer[i * parameters.pixels_per_line + j] = line[j / 8] & (1 << (7 - (j % 8))) ? 0 : 255;
-                    }
-                    rowPointer[i] = &auxBuffer[i * parameters.pixels_per_line];
+                    PixelConvert::ConvertLineTo8Bit(
+                            &bytes[i * parameters.bytes_per_line], m_BandEncoder->GetNextLine(),
+                            parameters.pixels_per_line, parameters.depth, parameters.format);
+                    m_BandEncoder->CommitLine();
                 }
+
+                return numLinesToWrite * parameters.bytes_per_line;
             }
-            else if (parameters.depth == 8)
+
+            if (m_RowPointers.size() < numLinesToWrite)
+            {
+                m_RowPointers.resize(numLinesToWrite);
+            }
+
+            if (parameters.depth == 8)
             {
                 for (auto i = 0U; i < numLinesToWrite; ++i)
                 {
-                    rowPointer[i] = &bytes[i * parameters.bytes_per_line];
+                    m_RowPointers[i] = &bytes[i * parameters.bytes_per_line];
                 }
             }
-            else if (parameters.depth == 16)
+            else
             {
-                // ReSharper disable once CppDFAUnreachableCode
-                constexpr auto offset = std::endian::native == std::endian::little ? 1 : 0;
-
-                if (parameters.format == SANE_FRAME_GRAY)
+                auto samplesPerLine = static_cast<size_t>(m_CompressStruct->image_width) *
+                                      m_CompressStruct->input_components;
+                if (m_ConvertedLines.size() < numLinesToWrite * samplesPerLine)
                 {
-                    for (auto j = 0U; j < numLinesToWrite; ++j)
-                    {
-                        auto line = &bytes[j * parameters.bytes_per_line];
-                        for (auto i = 0; i < parameters.pixels_per_line; ++i)
-                        {
-                            bytes[j * parameters.pixels_per_line + i] = line[2 * i + offset];
-                        }
-
-                        rowPointer[j] = &bytes[j * parameters.pixels_per_line];
-                    }
+                    m_ConvertedLines.resize(numLinesToWrite * samplesPerLine);
                 }
-                else if (parameters.format == SANE_FRAME_RGB)
+
+                for (auto i = 0U; i < numLinesToWrite; ++i)
                 {
-                    for (auto j = 0U; j < numLinesToWrite; ++j)
-                    {
-                        auto line = &bytes[j * parameters.bytes_per_line];
-                        for (auto i = 0; i < parameters.pixels_per_line; ++i)
-                        {
-                            bytes[3 * (j * parameters.pixels_per_line + i)] = line[6 * i + offset];
-                            bytes[3 * (j * parameters.pixels_per_line + i) + 1] = line[6 * i + 2 + offset];
-                            bytes[3 * (j * parameters.pixels_per_line + i) + 2] = line[6 * i + 4 + offset];
-                        }
-
-                        rowPointer[j] = &bytes[3 * j * parameters.pixels_per_line];
-                    }
+                    m_RowPointers[i] = &m_ConvertedLines[i * samplesPerLine];
+                    PixelConvert::ConvertLineTo8Bit(
+                            &bytes[i * parameters.bytes_per_line], m_RowPointers[i], parameters.pixels_per_line,
+                            parameters.depth, parameters.format);
                 }
             }
 
-            jpeg_write_scanlines(m_CompressStruct, rowPointer, numLinesToWrite);
+            if (setjmp(m_ErrorHandler->m_JumpBuffer)) // NOLINT(*-err52-cpp)
+            {
+                m_HasWriteFailed = true;
+                return 0;
+            }
 
-            delete[] rowPointer;
-            delete[] auxBuffer;
+            jpeg_write_scanlines(m_CompressStruct, m_RowPointers.data(), numLinesToWrite);
 
             return numLinesToWrite * parameters.bytes_per_line;
         }
 
         /**
          * \brief Closes the JPEG file after writing.
+         * \return An error code indicating the result of the operation. On error, the incomplete file is removed.
          */
-        void CloseFile() override
+        Error CloseFile() override
         {
-            jpeg_finish_compress(m_CompressStruct);
+            auto success = !m_HasWriteFailed;
+            if (m_BandEncoder != nullptr)
+            {
+                success = m_BandEncoder->Finish() && success;
+            }
+            else if (m_CompressStruct != nullptr && success)
+            {
+                // jpeg_finish_compress() also flushes the file and checks for write errors.
+                success = FinishCompress();
+            }
+
+            if (m_File != nullptr)
+            {
+                success = ferror(m_File) == 0 && success;
+                success = fclose(m_File) == 0 && success;
+                m_File = nullptr;
+            }
 
             CancelFile();
+
+            if (!success)
+            {
+                std::error_code errorCode;
+                std::filesystem::remove(m_FilePath, errorCode);
+                return Error::CannotWriteFile;
+            }
+
+            return Error::None;
         }
 
         /**
@@ -234,6 +346,9 @@ namespace Gorfector
          */
         void CancelFile() override
         {
+            delete m_BandEncoder;
+            m_BandEncoder = nullptr;
+
             if (m_File != nullptr)
             {
                 fclose(m_File);
@@ -249,6 +364,11 @@ namespace Gorfector
 
             delete m_ErrorHandler;
             m_ErrorHandler = nullptr;
+
+            m_RowPointers.clear();
+            m_RowPointers.shrink_to_fit();
+            m_ConvertedLines.clear();
+            m_ConvertedLines.shrink_to_fit();
         }
     };
 }
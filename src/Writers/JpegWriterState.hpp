@@ -20,8 +20,14 @@ namespace Gorfector
          */
         static constexpr const char *k_QualityKey = "Quality";
 
+        /**
+         * \brief Key used for storing the number of compression threads in JSON.
+         */
+        static constexpr const char *k_WorkerCountKey = "WorkerCount";
+
     private:
         int m_Quality; ///< The quality of the JPEG output (default is 75).
+        int m_WorkerCount; ///< The number of threads compressing bands of the image (default is 1).
 
         friend void to_json(nlohmann::json &j, const JpegWriterState &p);
         friend void from_json(const nlohmann::json &j, JpegWriterState &p);
@@ -34,6 +40,7 @@ namespace Gorfector
         explicit JpegWriterState(ZooLib::State *state)
             : StateComponent(state)
             , m_Quality(75)
+            , m_WorkerCount(1)
         {
         }
 
@@ -63,6 +70,15 @@ namespace Gorfector
             return m_Quality;
         }
 
+        /**
+         * \brief Gets the number of threads compressing bands of the image.
+         * \return The number of compression threads.
+         */
+        [[nodiscard]] int GetWorkerCount() const
+        {
+            return m_WorkerCount;
+        }
+
         /**
          * \class Updater
          * \brief A helper class for updating the `JpegWriterState`.
@@ -99,6 +115,15 @@ namespace Gorfector
             {
                 m_StateComponent->m_Quality = quality;
             }
+
+            /**
+             * \brief Sets the number of threads compressing bands of the image.
+             * \param workerCount The new number of compression threads.
+             */
+            void SetWorkerCount(int workerCount) const
+            {
+                m_StateComponent->m_WorkerCount = workerCount;
+            }
         };
     };
 
@@ -109,7 +134,8 @@ namespace Gorfector
      */
     inline void to_json(nlohmann::json &j, const JpegWriterState &p)
     {
-        j = nlohmann::json{{JpegWriterState::k_QualityKey, p.m_Quality}};
+        j = nlohmann::json{
+                {JpegWriterState::k_QualityKey, p.m_Quality}, {JpegWriterState::k_WorkerCountKey, p.m_WorkerCount}};
     }
 
     /**
@@ -120,5 +146,11 @@ namespace Gorfector
     inline void from_json(const nlohmann::json &j, JpegWriterState &p)
     {
         j.at(JpegWriterState::k_QualityKey).get_to(p.m_Quality);
+
+        // Older preference files do not have this key.
+        if (j.contains(JpegWriterState::k_WorkerCountKey))
+        {
+            j.at(JpegWriterState::k_WorkerCountKey).get_to(p.m_WorkerCount);
+        }
     }
 }
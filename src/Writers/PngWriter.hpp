@@ -5,6 +5,7 @@
 
 #include "App.hpp"
 #include "FileWriter.hpp"
+#include "PngIdatEncoder.hpp"
 #include "PngWriterState.hpp"
 
 namespace Gorfector
@@ -32,11 +33,26 @@ namespace Gorfector
          */
         PngWriterState *m_StateComponent{};
 
+        /**
+         * \brief Whether this writer deletes the state component; false for the writers created by `Clone()`.
+         */
+        bool m_OwnsStateComponent{true};
+
         /**
          * \brief File pointer for the output PNG file.
          */
         FILE *m_File{};
 
+        /**
+         * \brief Path of the output PNG file, removed when it cannot be written completely.
+         */
+        std::filesystem::path m_FilePath{};
+
+        /**
+         * \brief Whether a chunk written outside libpng could not be written completely.
+         */
+        bool m_HasWriteFailed{};
+
         /**
          * \brief Pointer to the libpng write structure.
          */
@@ -57,6 +73,57 @@ namespace Gorfector
          */
         size_t m_LinePointerSize{};
 
+        /**
+         * \brief Encoder writing the image data when it is compressed by more than one thread; null otherwise.
+         */
+        PngIdatEncoder *m_IdatEncoder{};
+
+        /**
+         * \brief Writes a chunk to the file, after the ones written by libpng.
+         * \param type The four letter chunk type.
+         * \param data Pointer to the chunk data.
+         * \param length Size of the chunk data.
+         */
+        void WriteChunk(const char *type, const uint8_t *data, size_t length)
+        {
+            uint8_t header[8];
+            for (auto i = 0; i < 4; ++i)
+            {
+                header[i] = static_cast<uint8_t>(length >> (24 - 8 * i));
+                header[4 + i] = static_cast<uint8_t>(type[i]);
+            }
+
+            auto crc = crc32(0, header + 4, 4);
+            if (length > 0)
+            {
+                crc = crc32(crc, data, static_cast<uInt>(length));
+            }
+
+            uint8_t trailer[4];
+            for (auto i = 0; i < 4; ++i)
+            {
+                trailer[i] = static_cast<uint8_t>(crc >> (24 - 8 * i));
+            }
+
+            if (fwrite(header, 1, sizeof(header), m_File) != sizeof(header) ||
+                (length > 0 && fwrite(data, 1, length, m_File) != length) ||
+                fwrite(trailer, 1, sizeof(trailer), m_File) != sizeof(trailer))
+            {
+                m_HasWriteFailed = true;
+            }
+        }
+
+        /**
+         * \brief Constructs a writer sharing the state component of another one.
+         * \param prototype The writer whose settings are used.
+         */
+        explicit PngWriter(const PngWriter *prototype)
+            : FileWriter(prototype->GetApplicationName())
+            , m_StateComponent(prototype->m_StateComponent)
+            , m_OwnsStateComponent(false)
+        {
+        }
+
     public:
         /**
          * \brief Constructor for the PngWriter class.
@@ -74,7 +141,10 @@ namespace Gorfector
          */
         ~PngWriter() override
         {
-            delete m_StateComponent;
+            if (m_OwnsStateComponent)
+            {
+                delete m_StateComponent;
+            }
         }
 
         /**
@@ -104,6 +174,15 @@ namespace Gorfector
             return k_Extensions;
         }
 
+        /**
+         * \brief Creates a PNG writer with the same settings, to write a file while this one writes another.
+         * \return A new writer, owned by the caller.
+         */
+        [[nodiscard]] FileWriter *Clone() const override
+        {
+            return new PngWriter(this);
+        }
+
         /**
          * \brief Creates a new PNG file.
          * \param path Path to the file to be created.
@@ -126,6 +205,8 @@ namespace Gorfector
             {
                 return Error::CannotOpenFile;
             }
+            m_FilePath = path;
+            m_HasWriteFailed = false;
 
             m_Png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
             if (!m_Png)
@@ -167,9 +248,10 @@ namespace Gorfector
             }
 
             std::string appId = GetApplicationName();
-            std::string creator = deviceOptions != nullptr ? std::string(deviceOptions->GetDeviceVendor()) + " " +
-                                                                     deviceOptions->GetDeviceModel()
-                                                           : "";
+            std::string creator = deviceOptions != nullptr && deviceOptions->GetDeviceVendor() != nullptr
+                                          ? std::string(deviceOptions->GetDeviceVendor()) + " " +
+                                                    deviceOptions->GetDeviceModel()
+                                          : "";
 
             constexpr int numTexts = 2;
             png_text textData[numTexts];
@@ -201,6 +283,16 @@ namespace Gorfector
 
             png_set_flush(m_Png, 128);
 
+            if (m_StateComponent->GetWorkerCount() > 1)
+            {
+                // The IDAT chunks are written by the encoder, bypassing the libpng row transformations and filters.
+                auto samplesPerPixel = parameters.format == SANE_FRAME_RGB ? 3 : 1;
+                m_IdatEncoder = new PngIdatEncoder(
+                        m_StateComponent->GetCompressionLevel(), parameters.bytes_per_line, samplesPerPixel,
+                        parameters.depth, m_StateComponent->GetWorkerCount(),
+                        [this](const uint8_t *data, size_t length) { WriteChunk("IDAT", data, length); });
+            }
+
             m_LinePointers = nullptr;
             m_LinePointerSize = 0;
 
@@ -221,6 +313,12 @@ namespace Gorfector
                 return 0;
             }
 
+            if (m_IdatEncoder != nullptr)
+            {
+                m_IdatEncoder->AppendRows(bytes, numberOfLines);
+                return numberOfLines * parameters.bytes_per_line;
+            }
+
             if (m_LinePointers == nullptr || m_LinePointerSize < numberOfLines)
             {
                 delete[] m_LinePointers;
@@ -246,8 +344,9 @@ namespace Gorfector
 
         /**
          * \brief Closes the PNG file, finalizing the write process.
+         * \return An error code indicating the result of the operation. On error, the incomplete file is removed.
          */
-        void CloseFile() override
+        Error CloseFile() override
         {
             if (setjmp(png_jmpbuf(m_Png))) // NOLINT(*-err52-cpp)
             {
@@ -264,18 +363,52 @@ namespace Gorfector
                     m_LinePointerSize = 0;
                 }
 
+                delete m_IdatEncoder;
+                m_IdatEncoder = nullptr;
+
                 m_File = nullptr;
                 m_Png = nullptr;
                 m_PngInfo = nullptr;
-                return;
+
+                std::error_code errorCode;
+                std::filesystem::remove(m_FilePath, errorCode);
+                return Error::CannotWriteFile;
             }
 
-            if (m_Png != nullptr && m_PngInfo != nullptr)
+            auto success = true;
+            if (m_IdatEncoder != nullptr && m_Png != nullptr)
+            {
+                // libpng did not write the IDAT chunks, so png_write_end() cannot be used.
+                success = m_IdatEncoder->Finish();
+                if (success)
+                {
+                    WriteChunk("IEND", nullptr, 0);
+                }
+            }
+            else if (m_Png != nullptr && m_PngInfo != nullptr)
             {
                 png_write_end(m_Png, m_PngInfo);
             }
 
+            if (m_File != nullptr)
+            {
+                // The data buffered by stdio is only written by fclose().
+                success = success && !m_HasWriteFailed && ferror(m_File) == 0;
+                success = fclose(m_File) == 0 && success;
+                m_File = nullptr;
+            }
+
             CancelFile();
+
+            if (!success)
+            {
+                // Without some of its data, the file would be a truncated PNG, possibly valid.
+                std::error_code errorCode;
+                std::filesystem::remove(m_FilePath, errorCode);
+                return Error::CannotWriteFile;
+            }
+
+            return Error::None;
         }
 
         /**
@@ -283,6 +416,9 @@ namespace Gorfector
          */
         void CancelFile() override
         {
+            delete m_IdatEncoder;
+            m_IdatEncoder = nullptr;
+
             if (m_Png != nullptr && m_PngInfo != nullptr)
             {
                 png_destroy_write_struct(&m_Png, &m_PngInfo);
@@ -7,7 +7,7 @@ namespace Gorfector
     /**
      * \brief Represents the state of the PNG writer component.
      *
-     * This class manages the state of the PNG writer, including its compression level.
+     * This class manages the state of the PNG writer, including its compression level and number of threads.
      * It provides serialization and deserialization functionality using JSON.
      * The state is automatically saved to a file upon destruction.
      */
@@ -19,6 +19,11 @@ namespace Gorfector
          */
         static constexpr const char *k_CompressionLevelKey = "CompressionLevel";
 
+        /**
+         * \brief Key used for the number of compression threads in JSON serialization.
+         */
+        static constexpr const char *k_WorkerCountKey = "WorkerCount";
+
     private:
         /**
          * \brief The compression level for the PNG writer.
@@ -28,6 +33,14 @@ namespace Gorfector
          */
         int m_CompressionLevel{};
 
+        /**
+         * \brief The number of threads compressing the image data.
+         *
+         * When greater than 1, the image data is filtered and compressed by a PngIdatEncoder instead of libpng.
+         * The default value is 1.
+         */
+        int m_WorkerCount{};
+
         friend void to_json(nlohmann::json &j, const PngWriterState &p);
         friend void from_json(const nlohmann::json &j, PngWriterState &p);
 
@@ -39,6 +52,7 @@ namespace Gorfector
         explicit PngWriterState(ZooLib::State *state)
             : StateComponent(state)
             , m_CompressionLevel(1)
+            , m_WorkerCount(1)
         {
         }
 
@@ -68,6 +82,15 @@ namespace Gorfector
             return m_CompressionLevel;
         }
 
+        /**
+         * \brief Gets the number of threads compressing the image data.
+         * \return The number of compression threads.
+         */
+        [[nodiscard]] int GetWorkerCount() const
+        {
+            return m_WorkerCount;
+        }
+
         /**
          * \brief Provides an updater for modifying the state.
          *
@@ -103,6 +126,15 @@ namespace Gorfector
             {
                 m_StateComponent->m_CompressionLevel = compressionLevel;
             }
+
+            /**
+             * \brief Sets the number of threads compressing the image data.
+             * \param workerCount The new number of compression threads.
+             */
+            void SetWorkerCount(int workerCount) const
+            {
+                m_StateComponent->m_WorkerCount = workerCount;
+            }
         };
     };
 
@@ -113,7 +145,9 @@ namespace Gorfector
      */
     inline void to_json(nlohmann::json &j, const PngWriterState &p)
     {
-        j = nlohmann::json{{PngWriterState::k_CompressionLevelKey, p.m_CompressionLevel}};
+        j = nlohmann::json{
+                {PngWriterState::k_CompressionLevelKey, p.m_CompressionLevel},
+                {PngWriterState::k_WorkerCountKey, p.m_WorkerCount}};
     }
 
     /**
@@ -124,5 +158,11 @@ namespace Gorfector
     inline void from_json(const nlohmann::json &j, PngWriterState &p)
     {
         j.at(PngWriterState::k_CompressionLevelKey).get_to(p.m_CompressionLevel);
+
+        // Older preference files do not have this key.
+        if (j.contains(PngWriterState::k_WorkerCountKey))
+        {
+            j.at(PngWriterState::k_WorkerCountKey).get_to(p.m_WorkerCount);
+        }
     }
 }
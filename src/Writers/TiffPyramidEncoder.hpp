@@ -0,0 +1,387 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <tiffio.h>
+#include <vector>
+
+namespace Gorfector
+{
+    /**
+     * @class TiffPyramidEncoder
+     * @brief Writes a tiled TIFF image and its reduced-resolution versions (an image pyramid) as lines arrive.
+     *
+     * The full resolution image is written to the main directory of the file, one row of tiles at a time. Each
+     * reduced-resolution level is half the size of the previous one, computed by averaging 2x2 pixel blocks as
+     * lines arrive, until the level fits in a single tile. The levels are written as sub-directories (SubIFDs) of
+     * the main directory.
+     *
+     * libtiff can only write image data to the current directory, and the sub-directories must be written after
+     * the main directory. Tiles of the reduced-resolution levels are therefore spilled to temporary files until
+     * the main image is complete. Memory use is bounded to one row of tiles and one line per level.
+     */
+    class TiffPyramidEncoder
+    {
+    public:
+        /**
+         * @brief Width and height of the tiles, in pixels. Multiple of 16, as required by the TIFF specification.
+         */
+        static constexpr uint32_t k_TileSize = 256;
+
+        /**
+         * @brief Callback setting the image fields (size excepted) of the current directory.
+         */
+        using SetImageFieldsCallback = std::function<void(TIFF *file)>;
+
+    private:
+        /**
+         * @brief The state of one resolution level.
+         */
+        struct Level
+        {
+            uint32_t m_Width{};
+            uint32_t m_Height{};
+            size_t m_BytesPerLine{};
+
+            /// Lines of the current row of tiles.
+            std::vector<uint8_t> m_TileRow{};
+            uint32_t m_TileRowLines{};
+            uint32_t m_TileRowIndex{};
+
+            /// Even lines wait here for the next line before being downsampled to the next level.
+            std::vector<uint8_t> m_PendingLine{};
+            bool m_HasPendingLine{};
+
+            /// Buffer receiving the downsampled line sent to the next level.
+            std::vector<uint8_t> m_DownsampledLine{};
+
+            /// Temporary file receiving the tiles, for reduced-resolution levels.
+            FILE *m_SpillFile{};
+        };
+
+        TIFF *m_File;
+        SetImageFieldsCallback m_SetImageFields;
+        uint32_t m_SamplesPerPixel;
+        uint32_t m_BitsPerSample;
+        size_t m_TileBytesPerLine;
+        std::vector<Level> m_Levels{};
+        std::vector<uint8_t> m_Tile{};
+        bool m_HasFailed{};
+
+        [[nodiscard]] size_t GetBytesPerLine(uint32_t width) const
+        {
+            return (static_cast<size_t>(width) * m_SamplesPerPixel * m_BitsPerSample + 7) / 8;
+        }
+
+        /**
+         * @brief Averages two lines of a level into a line of the next level.
+         */
+        void Downsample(const Level &level, const uint8_t *line0, const uint8_t *line1, uint8_t *outLine) const
+        {
+            const auto samplesPerPixel = m_SamplesPerPixel;
+            const auto outWidth = (level.m_Width + 1) / 2;
+
+            for (auto x = 0U; x < outWidth; ++x)
+            {
+                // Replicate the last column when the width is odd.
+                auto x0 = 2 * x;
+                auto x1 = std::min(x0 + 1, level.m_Width - 1);
+
+                for (auto s = 0U; s < samplesPerPixel; ++s)
+                {
+                    auto i0 = x0 * samplesPerPixel + s;
+                    auto i1 = x1 * samplesPerPixel + s;
+                    auto o = x * samplesPerPixel + s;
+
+                    if (m_BitsPerSample == 8)
+                    {
+                        outLine[o] = static_cast<uint8_t>((line0[i0] + line0[i1] + line1[i0] + line1[i1] + 2) / 4);
+                    }
+                    else if (m_BitsPerSample == 16)
+                    {
+                        uint16_t a, b, c, d;
+                        std::memcpy(&a, line0 + 2 * i0, 2);
+                        std::memcpy(&b, line0 + 2 * i1, 2);
+                        std::memcpy(&c, line1 + 2 * i0, 2);
+                        std::memcpy(&d, line1 + 2 * i1, 2);
+                        auto average = static_cast<uint16_t>((a + b + c + d + 2) / 4);
+                        std::memcpy(outLine + 2 * o, &average, 2);
+                    }
+                    else
+                    {
+                        // 1 bit: the output bit is set if at least half of the input bits are set.
+                        auto bit = [](const uint8_t *l, uint32_t i) { return (l[i / 8] >> (7 - i % 8)) & 1; };
+                        auto count = bit(line0, i0) + bit(line0, i1) + bit(line1, i0) + bit(line1, i1);
+                        auto mask = static_cast<uint8_t>(0x80 >> (o % 8));
+                        outLine[o / 8] = count >= 2 ? outLine[o / 8] | mask : outLine[o / 8] & ~mask;
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Cuts the current row of tiles of a level into tiles, and writes them.
+         */
+        void FlushTileRow(size_t levelIndex)
+        {
+            auto &level = m_Levels[levelIndex];
+            if (level.m_TileRowLines == 0)
+            {
+                return;
+            }
+
+            auto tilesAcross = (level.m_Width + k_TileSize - 1) / k_TileSize;
+            for (auto column = 0U; column < tilesAcross; ++column)
+            {
+                // Tiles on the right and bottom edges are padded with zeros.
+                std::fill(m_Tile.begin(), m_Tile.end(), 0);
+
+                auto offset = column * m_TileBytesPerLine;
+                auto length = std::min(m_TileBytesPerLine, level.m_BytesPerLine - offset);
+                for (auto y = 0U; y < level.m_TileRowLines; ++y)
+                {
+                    std::memcpy(
+                            m_Tile.data() + y * m_TileBytesPerLine,
+                            level.m_TileRow.data() + y * level.m_BytesPerLine + offset, length);
+                }
+
+                if (level.m_SpillFile == nullptr)
+                {
+                    auto tileIndex = level.m_TileRowIndex * tilesAcross + column;
+                    auto tileSize = static_cast<tmsize_t>(m_Tile.size());
+                    if (TIFFWriteEncodedTile(m_File, tileIndex, m_Tile.data(), tileSize) < 0)
+                    {
+                        m_HasFailed = true;
+                    }
+                }
+                else if (std::fwrite(m_Tile.data(), 1, m_Tile.size(), level.m_SpillFile) != m_Tile.size())
+                {
+                    m_HasFailed = true;
+                }
+            }
+
+            level.m_TileRowLines = 0;
+            ++level.m_TileRowIndex;
+        }
+
+        /**
+         * @brief Adds a line to a level, and propagates it to the next levels.
+         */
+        void AddLine(size_t levelIndex, const uint8_t *line)
+        {
+            auto &level = m_Levels[levelIndex];
+
+            std::memcpy(
+                    level.m_TileRow.data() + level.m_TileRowLines * level.m_BytesPerLine, line, level.m_BytesPerLine);
+            if (++level.m_TileRowLines == k_TileSize)
+            {
+                FlushTileRow(levelIndex);
+            }
+
+            if (levelIndex + 1 >= m_Levels.size())
+            {
+                return;
+            }
+
+            if (!level.m_HasPendingLine)
+            {
+                std::memcpy(level.m_PendingLine.data(), line, level.m_BytesPerLine);
+                level.m_HasPendingLine = true;
+                return;
+            }
+
+            Downsample(level, level.m_PendingLine.data(), line, level.m_DownsampledLine.data());
+            level.m_HasPendingLine = false;
+            AddLine(levelIndex + 1, level.m_DownsampledLine.data());
+        }
+
+        /**
+         * @brief Copies the tiles of a reduced-resolution level from its temporary file to the current directory.
+         */
+        void WriteSpilledTiles(Level &level)
+        {
+            std::rewind(level.m_SpillFile);
+
+            auto tileCount = (level.m_Width + k_TileSize - 1) / k_TileSize * level.m_TileRowIndex;
+            auto tileIndex = 0U;
+            while (tileIndex < tileCount &&
+                   std::fread(m_Tile.data(), 1, m_Tile.size(), level.m_SpillFile) == m_Tile.size())
+            {
+                if (TIFFWriteEncodedTile(m_File, tileIndex++, m_Tile.data(), static_cast<tmsize_t>(m_Tile.size())) < 0)
+                {
+                    m_HasFailed = true;
+                }
+            }
+
+            if (tileIndex != tileCount)
+            {
+                m_HasFailed = true;
+            }
+
+            std::fclose(level.m_SpillFile);
+            level.m_SpillFile = nullptr;
+        }
+
+    public:
+        /**
+         * @brief Computes the number of reduced-resolution levels of an image.
+         * @param width The width of the full resolution image.
+         * @param height The height of the full resolution image.
+         * @return The number of levels, not counting the full resolution image.
+         */
+        static uint16_t ComputeReducedLevelCount(uint32_t width, uint32_t height)
+        {
+            uint16_t count = 0;
+            while (width > k_TileSize || height > k_TileSize)
+            {
+                width = (width + 1) / 2;
+                height = (height + 1) / 2;
+                ++count;
+            }
+
+            return count;
+        }
+
+        /**
+         * @brief Constructs a TiffPyramidEncoder.
+         *
+         * The fields of the main directory must already be set, including the tile size and the SubIFD count
+         * returned by `ComputeReducedLevelCount()`.
+         *
+         * @param file The TIFF file to write to.
+         * @param width The width of the full resolution image.
+         * @param height The height of the full resolution image.
+         * @param samplesPerPixel Number of samples per pixel.
+         * @param bitsPerSample Number of bits per sample: 1, 8 or 16.
+         * @param setImageFields Called to set the fields of the reduced-resolution directories, except the size.
+         */
+        TiffPyramidEncoder(
+                TIFF *file, uint32_t width, uint32_t height, uint32_t samplesPerPixel, uint32_t bitsPerSample,
+                SetImageFieldsCallback setImageFields)
+            : m_File(file)
+            , m_SetImageFields(std::move(setImageFields))
+            , m_SamplesPerPixel(samplesPerPixel)
+            , m_BitsPerSample(bitsPerSample)
+            , m_TileBytesPerLine(GetBytesPerLine(k_TileSize))
+        {
+            m_Tile.resize(m_TileBytesPerLine * k_TileSize);
+
+            auto levelCount = ComputeReducedLevelCount(width, height) + 1;
+            m_Levels.resize(levelCount);
+            for (auto i = 0UZ; i < m_Levels.size(); ++i)
+            {
+                auto &level = m_Levels[i];
+                level.m_Width = width;
+                level.m_Height = height;
+                level.m_BytesPerLine = GetBytesPerLine(width);
+                level.m_TileRow.resize(level.m_BytesPerLine * k_TileSize);
+
+                if (i + 1 < m_Levels.size())
+                {
+                    level.m_PendingLine.resize(level.m_BytesPerLine);
+                    level.m_DownsampledLine.resize(GetBytesPerLine((width + 1) / 2));
+                }
+
+                if (i > 0)
+                {
+                    level.m_SpillFile = std::tmpfile();
+                }
+
+                width = (width + 1) / 2;
+                height = (height + 1) / 2;
+            }
+        }
+
+        /**
+         * @brief Destructor. Discards the reduced-resolution levels not written yet.
+         */
+        ~TiffPyramidEncoder()
+        {
+            for (auto &level: m_Levels)
+            {
+                if (level.m_SpillFile != nullptr)
+                {
+                    std::fclose(level.m_SpillFile);
+                    level.m_SpillFile = nullptr;
+                }
+            }
+        }
+
+        TiffPyramidEncoder(const TiffPyramidEncoder &) = delete;
+        TiffPyramidEncoder &operator=(const TiffPyramidEncoder &) = delete;
+
+        /**
+         * @brief Checks that the temporary files needed for the reduced-resolution levels could be created.
+         * @return True if the encoder can be used.
+         */
+        [[nodiscard]] bool IsValid() const
+        {
+            return std::all_of(m_Levels.begin() + 1, m_Levels.end(), [](const Level &level) {
+                return level.m_SpillFile != nullptr;
+            });
+        }
+
+        /**
+         * @brief Appends lines to the full resolution image.
+         * @param bytes Pointer to the image data.
+         * @param numberOfLines The number of lines to append.
+         */
+        void AppendLines(const uint8_t *bytes, uint32_t numberOfLines)
+        {
+            for (auto i = 0U; i < numberOfLines; ++i)
+            {
+                AddLine(0, bytes + i * m_Levels[0].m_BytesPerLine);
+            }
+        }
+
+        /**
+         * @brief Writes the incomplete rows of tiles, the main directory, and the reduced-resolution directories.
+         * @return False if a tile or a directory could not be written.
+         */
+        bool Finish()
+        {
+            for (auto i = 0UZ; i < m_Levels.size(); ++i)
+            {
+                auto &level = m_Levels[i];
+                if (level.m_HasPendingLine)
+                {
+                    // Odd number of lines: the last line is averaged with itself.
+                    Downsample(
+                            level, level.m_PendingLine.data(), level.m_PendingLine.data(),
+                            level.m_DownsampledLine.data());
+                    level.m_HasPendingLine = false;
+                    AddLine(i + 1, level.m_DownsampledLine.data());
+                }
+
+                FlushTileRow(i);
+            }
+
+            if (!TIFFWriteDirectory(m_File))
+            {
+                m_HasFailed = true;
+            }
+
+            for (auto i = 1UZ; i < m_Levels.size(); ++i)
+            {
+                auto &level = m_Levels[i];
+
+                m_SetImageFields(m_File);
+                TIFFSetField(m_File, TIFFTAG_SUBFILETYPE, FILETYPE_REDUCEDIMAGE);
+                TIFFSetField(m_File, TIFFTAG_IMAGEWIDTH, level.m_Width);
+                TIFFSetField(m_File, TIFFTAG_IMAGELENGTH, level.m_Height);
+                TIFFSetField(m_File, TIFFTAG_TILEWIDTH, k_TileSize);
+                TIFFSetField(m_File, TIFFTAG_TILELENGTH, k_TileSize);
+
+                WriteSpilledTiles(level);
+                if (!TIFFWriteDirectory(m_File))
+                {
+                    m_HasFailed = true;
+                }
+            }
+
+            return !m_HasFailed;
+        }
+    };
+}
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <tiffio.h>
+#include <vector>
+#include <zlib.h>
+
+#include "ZooLib/ThreadPool.hpp"
+
+namespace Gorfector
+{
+    /**
+     * @class TiffStripEncoder
+     * @brief Compresses the strips of a TIFF image on a thread pool and writes them to the file in order.
+     *
+     * Lines are accumulated into strips. Each complete strip is compressed by a worker thread, outside libtiff,
+     * then written to the file with `TIFFWriteRawStrip()` by the thread calling `AppendLines()`, in strip order.
+     * The number of strips being compressed at any time is bounded, so memory use does not depend on the image
+     * size.
+     *
+     * Only the compressions for which `SupportsCompression()` returns true can be used.
+     */
+    class TiffStripEncoder
+    {
+        /**
+         * @brief A strip of the image: its uncompressed lines, and its compressed data once encoded.
+         */
+        struct Strip
+        {
+            std::vector<uint8_t> m_Raw{};
+            std::vector<uint8_t> m_Encoded{};
+            std::future<bool> m_Encoding{};
+        };
+
+        /**
+         * @brief Pointer to the TIFF file being written.
+         */
+        TIFF *m_File;
+
+        /**
+         * @brief The TIFF compression constant.
+         */
+        int m_Compression;
+
+        /**
+         * @brief Compression level used for the Deflate algorithm.
+         */
+        int m_DeflateCompressionLevel;
+
+        /**
+         * @brief Number of lines in a strip. Must match the TIFFTAG_ROWSPERSTRIP field of the file.
+         */
+        uint32_t m_RowsPerStrip;
+
+        /**
+         * @brief Number of bytes in a line.
+         */
+        size_t m_BytesPerLine;
+
+        /**
+         * @brief Maximum number of strips being encoded or waiting to be written.
+         */
+        size_t m_MaxPendingStrips;
+
+        /**
+         * @brief The strip being filled by `AppendLines()`.
+         */
+        std::unique_ptr<Strip> m_CurrentStrip{};
+
+        /**
+         * @brief Number of lines in `m_CurrentStrip`.
+         */
+        uint32_t m_CurrentStripLines{};
+
+        /**
+         * @brief Strips submitted for encoding, in strip order.
+         */
+        std::deque<std::unique_ptr<Strip>> m_PendingStrips{};
+
+        /**
+         * @brief Strips already written, kept to reuse their buffers.
+         */
+        std::vector<std::unique_ptr<Strip>> m_FreeStrips{};
+
+        /**
+         * @brief Index of the next strip to write to the file.
+         */
+        uint32_t m_NextStripIndex{};
+
+        /**
+         * @brief Whether a strip could not be compressed or written.
+         */
+        bool m_HasFailed{};
+
+        /**
+         * @brief Worker threads encoding the strips.
+         */
+        ZooLib::ThreadPool m_ThreadPool;
+
+        /**
+         * @brief Compresses a buffer with zlib, as the libtiff Deflate codec does.
+         */
+        static bool EncodeDeflate(const std::vector<uint8_t> &raw, std::vector<uint8_t> &encoded, int level)
+        {
+            auto encodedLength = compressBound(raw.size());
+            encoded.resize(encodedLength);
+            if (compress2(encoded.data(), &encodedLength, raw.data(), raw.size(), level) != Z_OK)
+            {
+                return false;
+            }
+
+            encoded.resize(encodedLength);
+            return true;
+        }
+
+        /**
+         * @brief Compresses a buffer with the PackBits algorithm. Like libtiff, each line is encoded separately.
+         */
+        static bool EncodePackBits(const std::vector<uint8_t> &raw, std::vector<uint8_t> &encoded, size_t bytesPerLine)
+        {
+            encoded.clear();
+            // Worst case: one header byte for every 128 literal bytes.
+            encoded.reserve(raw.size() + raw.size() / 128 + raw.size() / bytesPerLine + 1);
+
+            for (auto lineStart = 0UZ; lineStart < raw.size(); lineStart += bytesPerLine)
+            {
+                const auto *line = raw.data() + lineStart;
+                const auto lineLength = std::min(bytesPerLine, raw.size() - lineStart);
+
+                auto i = 0UZ;
+                while (i < lineLength)
+                {
+                    auto runLength = 1UZ;
+                    while (i + runLength < lineLength && runLength < 128 && line[i + runLength] == line[i])
+                    {
+                        ++runLength;
+                    }
+
+                    if (runLength >= 3)
+                    {
+                        encoded.push_back(static_cast<uint8_t>(257 - runLength));
+                        encoded.push_back(line[i]);
+                        i += runLength;
+                        continue;
+                    }
+
+                    // Literal bytes, up to the next run of at least 3 identical bytes.
+                    auto literalStart = i;
+                    do
+                    {
+                        ++i;
+                    }
+                    while (i < lineLength && i - literalStart < 128 &&
+                           !(i + 2 < lineLength && line[i] == line[i + 1] && line[i] == line[i + 2]));
+
+                    encoded.push_back(static_cast<uint8_t>(i - literalStart - 1));
+                    encoded.insert(encoded.end(), line + literalStart, line + i);
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Compresses a strip. Called on a worker thread.
+         */
+        static bool EncodeStrip(Strip *strip, int compression, int deflateCompressionLevel, size_t bytesPerLine)
+        {
+            switch (compression)
+            {
+                case COMPRESSION_ADOBE_DEFLATE:
+                    return EncodeDeflate(strip->m_Raw, strip->m_Encoded, deflateCompressionLevel);
+                case COMPRESSION_PACKBITS:
+                    return EncodePackBits(strip->m_Raw, strip->m_Encoded, bytesPerLine);
+                default:
+                    return false;
+            }
+        }
+
+        /**
+         * @brief Gets an empty strip, reusing the buffers of an already written strip if possible.
+         */
+        std::unique_ptr<Strip> AcquireStrip()
+        {
+            if (m_FreeStrips.empty())
+            {
+                return std::make_unique<Strip>();
+            }
+
+            auto strip = std::move(m_FreeStrips.back());
+            m_FreeStrips.pop_back();
+            return strip;
+        }
+
+        /**
+         * @brief Submits the current strip for encoding.
+         */
+        void SubmitCurrentStrip()
+        {
+            auto *strip = m_CurrentStrip.get();
+            strip->m_Raw.resize(m_CurrentStripLines * m_BytesPerLine);
+            strip->m_Encoding = m_ThreadPool.Submit(
+                    [strip, compression = m_Compression, level = m_DeflateCompressionLevel,
+                     bytesPerLine = m_BytesPerLine]() { return EncodeStrip(strip, compression, level, bytesPerLine); });
+
+            m_PendingStrips.push_back(std::move(m_CurrentStrip));
+            m_CurrentStripLines = 0;
+        }
+
+        /**
+         * @brief Waits for the first pending strip to be encoded, then writes it to the file.
+         */
+        void WriteFirstPendingStrip()
+        {
+            auto strip = std::move(m_PendingStrips.front());
+            m_PendingStrips.pop_front();
+
+            auto stripIndex = m_NextStripIndex++;
+            if (!strip->m_Encoding.get())
+            {
+                TIFFError(TIFFFileName(m_File), "Failed to compress strip %u", stripIndex);
+                m_HasFailed = true;
+            }
+            else if (
+                    !m_HasFailed && TIFFWriteRawStrip(
+                                            m_File, stripIndex, strip->m_Encoded.data(),
+                                            static_cast<tmsize_t>(strip->m_Encoded.size())) < 0)
+            {
+                m_HasFailed = true;
+            }
+
+            m_FreeStrips.push_back(std::move(strip));
+        }
+
+        /**
+         * @brief Writes the strips that are already encoded, without waiting for the others.
+         */
+        void WriteEncodedStrips()
+        {
+            while (!m_PendingStrips.empty() &&
+                   m_PendingStrips.front()->m_Encoding.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                WriteFirstPendingStrip();
+            }
+        }
+
+    public:
+        /**
+         * @brief Checks whether strips compressed with the given algorithm can be encoded by this class.
+         * @param compression The TIFF compression constant.
+         * @return True if the compression is supported.
+         */
+        static bool SupportsCompression(int compression)
+        {
+            return compression == COMPRESSION_ADOBE_DEFLATE || compression == COMPRESSION_PACKBITS;
+        }
+
+        /**
+         * @brief Constructs a TiffStripEncoder.
+         * @param file The TIFF file to write to. Its fields must already be set.
+         * @param compression The TIFF compression constant. Must be supported by `SupportsCompression()`.
+         * @param deflateCompressionLevel Compression level used for the Deflate algorithm.
+         * @param rowsPerStrip Number of lines in a strip, as set in the file TIFFTAG_ROWSPERSTRIP field.
+         * @param bytesPerLine Number of bytes in a line.
+         * @param workerCount Number of threads compressing strips.
+         */
+        TiffStripEncoder(
+                TIFF *file, int compression, int deflateCompressionLevel, uint32_t rowsPerStrip, size_t bytesPerLine,
+                size_t workerCount)
+            : m_File(file)
+            , m_Compression(compression)
+            , m_DeflateCompressionLevel(deflateCompressionLevel)
+            , m_RowsPerStrip(std::max(rowsPerStrip, 1U))
+            , m_BytesPerLine(std::max(bytesPerLine, static_cast<size_t>(1)))
+            , m_MaxPendingStrips(2 * std::max(workerCount, static_cast<size_t>(1)))
+            , m_ThreadPool(workerCount)
+        {
+        }
+
+        /**
+         * @brief Destructor. Discards the strips not written yet.
+         */
+        ~TiffStripEncoder()
+        {
+            Cancel();
+        }
+
+        TiffStripEncoder(const TiffStripEncoder &) = delete;
+        TiffStripEncoder &operator=(const TiffStripEncoder &) = delete;
+
+        /**
+         * @brief Appends lines to the image.
+         *
+         * Strips are written to the file when their encoding is complete. This method blocks when too many strips
+         * are waiting to be encoded.
+         *
+         * @param bytes Pointer to the image data.
+         * @param numberOfLines The number of lines to append.
+         */
+        void AppendLines(const uint8_t *bytes, uint32_t numberOfLines)
+        {
+            while (numberOfLines > 0)
+            {
+                if (m_CurrentStrip == nullptr)
+                {
+                    m_CurrentStrip = AcquireStrip();
+                    m_CurrentStrip->m_Raw.resize(m_RowsPerStrip * m_BytesPerLine);
+                }
+
+                auto lines = std::min(numberOfLines, m_RowsPerStrip - m_CurrentStripLines);
+                std::memcpy(
+                        m_CurrentStrip->m_Raw.data() + m_CurrentStripLines * m_BytesPerLine, bytes,
+                        lines * m_BytesPerLine);
+                m_CurrentStripLines += lines;
+                bytes += lines * m_BytesPerLine;
+                numberOfLines -= lines;
+
+                if (m_CurrentStripLines == m_RowsPerStrip)
+                {
+                    SubmitCurrentStrip();
+
+                    if (m_PendingStrips.size() >= m_MaxPendingStrips)
+                    {
+                        WriteFirstPendingStrip();
+                    }
+                }
+            }
+
+            WriteEncodedStrips();
+        }
+
+        /**
+         * @brief Encodes the last, possibly incomplete, strip and writes all remaining strips to the file.
+         * @return False if a strip could not be compressed or written.
+         */
+        bool Finish()
+        {
+            if (m_CurrentStrip != nullptr && m_CurrentStripLines > 0)
+            {
+                SubmitCurrentStrip();
+            }
+
+            while (!m_PendingStrips.empty())
+            {
+                WriteFirstPendingStrip();
+            }
+
+            return !m_HasFailed;
+        }
+
+        /**
+         * @brief Discards the strips not written yet.
+         */
+        void Cancel()
+        {
+            for (auto &strip: m_PendingStrips)
+            {
+                // The worker threads use the strip buffers: wait for them to be done.
+                strip->m_Encoding.wait();
+            }
+
+            m_PendingStrips.clear();
+            m_CurrentStrip = nullptr;
+            m_CurrentStripLines = 0;
+        }
+    };
+}
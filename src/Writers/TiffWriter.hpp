@@ -4,6 +4,8 @@
 
 #include "DeviceOptionsState.hpp"
 #include "FileWriter.hpp"
+#include "TiffPyramidEncoder.hpp"
+#include "TiffStripEncoder.hpp"
 #include "TiffWriterState.hpp"
 
 namespace Gorfector
@@ -13,7 +15,9 @@ namespace Gorfector
      * @brief A class for writing TIFF files, inheriting from FileWriter.
      *
      * This class provides functionality to create, write, and manage TIFF files.
-     * It uses the libtiff library for handling TIFF file operations.
+     * It uses the libtiff library for handling TIFF file operations. When the state component
+     * asks for more than one worker thread, strips are compressed in parallel by a `TiffStripEncoder`.
+     * When it asks for a tiled pyramid, the image is written by a `TiffPyramidEncoder`.
      */
     class TiffWriter final : public FileWriter
     {
@@ -32,16 +36,90 @@ namespace Gorfector
          */
         TiffWriterState *m_StateComponent{};
 
+        /**
+         * @brief Whether this writer deletes the state component; false for the writers created by `Clone()`.
+         */
+        bool m_OwnsStateComponent{true};
+
         /**
          * @brief Pointer to the TIFF file being written.
          */
         TIFF *m_File{};
 
+        /**
+         * @brief Path of the TIFF file being written, removed when it cannot be written completely.
+         */
+        std::filesystem::path m_FilePath{};
+
+        /**
+         * @brief Whether a line could not be written to the file.
+         */
+        bool m_HasWriteFailed{};
+
+        /**
+         * @brief Encoder compressing the strips in parallel, or `nullptr` to let libtiff compress the image.
+         */
+        TiffStripEncoder *m_StripEncoder{};
+
+        /**
+         * @brief Encoder writing a tiled image with reduced-resolution levels, or `nullptr` to write strips.
+         */
+        TiffPyramidEncoder *m_PyramidEncoder{};
+
         /**
          * @brief Counter for the number of lines written to the TIFF file.
          */
         int m_LineCounter{};
 
+        /**
+         * @brief Sets the fields describing the pixels and their compression in the current directory.
+         * @param file The TIFF file.
+         * @param parameters The `SANE_Parameters` structure containing image parameters.
+         */
+        void SetPixelFields(TIFF *file, const SANE_Parameters &parameters) const
+        {
+            TIFFSetField(file, TIFFTAG_SAMPLESPERPIXEL, parameters.format == SANE_FRAME_RGB ? 3 : 1);
+            TIFFSetField(file, TIFFTAG_BITSPERSAMPLE, parameters.depth);
+            TIFFSetField(file, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
+            TIFFSetField(file, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+            if (parameters.format == SANE_FRAME_RGB)
+            {
+                TIFFSetField(file, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+            }
+            else if (parameters.format == SANE_FRAME_GRAY)
+            {
+                if (parameters.depth == 1)
+                {
+                    TIFFSetField(file, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISWHITE);
+                }
+                else
+                {
+                    TIFFSetField(file, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+                }
+            }
+
+            TIFFSetField(file, TIFFTAG_COMPRESSION, m_StateComponent->GetTiffCompression());
+            if (m_StateComponent->GetTiffCompression() == COMPRESSION_JPEG)
+            {
+                TIFFSetField(file, TIFFTAG_JPEGQUALITY, m_StateComponent->GetJpegQuality());
+            }
+            else if (m_StateComponent->GetTiffCompression() == COMPRESSION_ADOBE_DEFLATE)
+            {
+                TIFFSetField(file, TIFFTAG_ZIPQUALITY, m_StateComponent->GetDeflateCompressionLevel());
+            }
+        }
+
+        /**
+         * @brief Constructs a writer sharing the state component of another one.
+         * @param prototype The writer whose settings are used.
+         */
+        explicit TiffWriter(const TiffWriter *prototype)
+            : FileWriter(prototype->GetApplicationName())
+            , m_StateComponent(prototype->m_StateComponent)
+            , m_OwnsStateComponent(false)
+        {
+        }
+
     public:
         /**
          * @brief Constructs a TiffWriter object.
@@ -61,7 +139,10 @@ namespace Gorfector
          */
         ~TiffWriter() override
         {
-            delete m_StateComponent;
+            if (m_OwnsStateComponent)
+            {
+                delete m_StateComponent;
+            }
         }
 
         /**
@@ -91,6 +172,15 @@ namespace Gorfector
             return k_Extensions;
         }
 
+        /**
+         * @brief Creates a TIFF writer with the same settings, to write a file while this one writes another.
+         * @return A new writer, owned by the caller.
+         */
+        [[nodiscard]] FileWriter *Clone() const override
+        {
+            return new TiffWriter(this);
+        }
+
         /**
          * @brief Creates a new TIFF file and initializes it with the provided parameters.
          *
@@ -113,9 +203,19 @@ namespace Gorfector
                                  : deviceOptions->GetYResolution() == 0 ? deviceOptions->GetResolution()
                                                                         : deviceOptions->GetYResolution();
 
+            // A pyramid needs tiles of known size, and the number of levels must be known before writing.
+            auto tiledPyramid = m_StateComponent->IsTiledPyramid() && parameters.lines > 0 &&
+                                parameters.pixels_per_line > 0;
+
+            auto imageSize = static_cast<uint64_t>(parameters.bytes_per_line) * static_cast<uint64_t>(parameters.lines);
+            if (tiledPyramid)
+            {
+                // The reduced-resolution levels add up to a third of the full resolution image.
+                imageSize += imageSize / 3;
+            }
+
             auto mode = "w";
-            if (static_cast<uint64_t>(parameters.bytes_per_line) * static_cast<uint64_t>(parameters.lines) >=
-                4 * 1024 * 1024 * 1024UL)
+            if (imageSize >= 4 * 1024 * 1024 * 1024UL)
             {
                 mode = "w8";
             }
@@ -127,6 +227,9 @@ namespace Gorfector
                 return Error::CannotOpenFile;
             }
 
+            m_FilePath = path;
+            m_HasWriteFailed = false;
+
             if (deviceOptions != nullptr)
             {
                 TIFFSetField(m_File, TIFFTAG_MAKE, deviceOptions->GetDeviceVendor());
@@ -137,43 +240,57 @@ namespace Gorfector
 
             TIFFSetField(m_File, TIFFTAG_IMAGEWIDTH, parameters.pixels_per_line);
             TIFFSetField(m_File, TIFFTAG_IMAGELENGTH, parameters.lines);
-            TIFFSetField(m_File, TIFFTAG_SAMPLESPERPIXEL, parameters.format == SANE_FRAME_RGB ? 3 : 1);
-            TIFFSetField(m_File, TIFFTAG_BITSPERSAMPLE, parameters.depth);
-            TIFFSetField(m_File, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
-            TIFFSetField(m_File, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-            if (parameters.format == SANE_FRAME_RGB)
-            {
-                TIFFSetField(m_File, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
-            }
-            else if (parameters.format == SANE_FRAME_GRAY)
+            SetPixelFields(m_File, parameters);
+
+            auto rowsPerStrip = static_cast<uint32_t>(std::max(m_StateComponent->GetStripHeight(), 1));
+            if (tiledPyramid)
             {
-                if (parameters.depth == 1)
-                {
-                    TIFFSetField(m_File, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISWHITE);
-                }
-                else
+                TIFFSetField(m_File, TIFFTAG_TILEWIDTH, TiffPyramidEncoder::k_TileSize);
+                TIFFSetField(m_File, TIFFTAG_TILELENGTH, TiffPyramidEncoder::k_TileSize);
+
+                auto levelCount = TiffPyramidEncoder::ComputeReducedLevelCount(
+                        static_cast<uint32_t>(parameters.pixels_per_line), static_cast<uint32_t>(parameters.lines));
+                if (levelCount > 0)
                 {
-                    TIFFSetField(m_File, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+                    // The offsets are filled by libtiff when the sub-directories are written.
+                    std::vector<toff_t> subDirectoryOffsets(levelCount, 0);
+                    TIFFSetField(m_File, TIFFTAG_SUBIFD, levelCount, subDirectoryOffsets.data());
                 }
             }
-
-            TIFFSetField(m_File, TIFFTAG_COMPRESSION, m_StateComponent->GetTiffCompression());
-            if (m_StateComponent->GetTiffCompression() == COMPRESSION_JPEG)
+            else
             {
-                TIFFSetField(m_File, TIFFTAG_JPEGQUALITY, m_StateComponent->GetJpegQuality());
+                TIFFSetField(m_File, TIFFTAG_ROWSPERSTRIP, rowsPerStrip);
             }
-            else if (m_StateComponent->GetTiffCompression() == COMPRESSION_ADOBE_DEFLATE)
-            {
-                TIFFSetField(m_File, TIFFTAG_ZIPQUALITY, m_StateComponent->GetDeflateCompressionLevel());
-            }
-
-            TIFFSetField(m_File, TIFFTAG_ROWSPERSTRIP, 128);
             TIFFSetField(m_File, TIFFTAG_XRESOLUTION, xResolution);
             TIFFSetField(m_File, TIFFTAG_YRESOLUTION, yResolution);
             TIFFSetField(m_File, TIFFTAG_RESOLUTIONUNIT, RESUNIT_INCH);
 
             m_LineCounter = 0;
 
+            if (tiledPyramid)
+            {
+                m_PyramidEncoder = new TiffPyramidEncoder(
+                        m_File, parameters.pixels_per_line, parameters.lines,
+                        parameters.format == SANE_FRAME_RGB ? 3 : 1, parameters.depth,
+                        [this, parameters](TIFF *file) { SetPixelFields(file, parameters); });
+                if (!m_PyramidEncoder->IsValid())
+                {
+                    CancelFile();
+                    return Error::UnknownError;
+                }
+
+                return Error::None;
+            }
+
+            auto workerCount = m_StateComponent->GetWorkerCount();
+            if (workerCount > 1 && TiffStripEncoder::SupportsCompression(m_StateComponent->GetTiffCompression()))
+            {
+                m_StripEncoder = new TiffStripEncoder(
+                        m_File, m_StateComponent->GetTiffCompression(),
+                        m_StateComponent->GetDeflateCompressionLevel(), rowsPerStrip, parameters.bytes_per_line,
+                        workerCount);
+            }
+
             return Error::None;
         }
 
@@ -181,7 +298,8 @@ namespace Gorfector
          * @brief Appends image data to the TIFF file.
          *
          * This method writes a specified number of lines of image data to the TIFF file.
-         * It uses the libtiff library's `TIFFWriteScanline` function to write each line.
+         * It uses the libtiff library's `TIFFWriteScanline` function to write each line, or
+         * the strip or pyramid encoder when one is used.
          *
          * @param bytes Pointer to the image data to be written.
          * @param numberOfLines The number of lines to write to the TIFF file.
@@ -190,9 +308,24 @@ namespace Gorfector
          */
         size_t AppendBytes(SANE_Byte *bytes, uint32_t numberOfLines, const SANE_Parameters &parameters) override
         {
-            for (auto i = 0u; i < numberOfLines; i++)
+            if (m_PyramidEncoder != nullptr)
             {
-                TIFFWriteScanline(m_File, bytes + i * parameters.bytes_per_line, m_LineCounter++, 0);
+                m_PyramidEncoder->AppendLines(bytes, numberOfLines);
+                m_LineCounter += numberOfLines;
+                return numberOfLines * parameters.bytes_per_line;
+            }
+
+            if (m_StripEncoder != nullptr)
+            {
+                m_StripEncoder->AppendLines(bytes, numberOfLines);
+                m_LineCounter += numberOfLines;
+                return numberOfLines * parameters.bytes_per_line;
+            }
+
+            for (auto i = 0u; i < numberOfLines && !m_HasWriteFailed; i++)
+            {
+                auto *line = bytes + i * parameters.bytes_per_line;
+                m_HasWriteFailed = TIFFWriteScanline(m_File, line, m_LineCounter++, 0) < 0;
             }
 
             return numberOfLines * parameters.bytes_per_line;
@@ -201,12 +334,40 @@ namespace Gorfector
         /**
          * @brief Closes the currently open TIFF file.
          *
-         * This method ensures that the TIFF file is properly closed and releases
-         * the associated resources.
+         * This method writes the strips still being compressed, ensures that the TIFF
+         * file is properly closed and releases the associated resources.
+         *
+         * @return An error code indicating the result of the operation. On error, the incomplete file is removed.
          */
-        void CloseFile() override
+        Error CloseFile() override
         {
+            auto success = !m_HasWriteFailed;
+            if (m_StripEncoder != nullptr)
+            {
+                success = m_StripEncoder->Finish() && success;
+            }
+
+            if (m_PyramidEncoder != nullptr)
+            {
+                success = m_PyramidEncoder->Finish() && success;
+            }
+
+            // TIFFClose() does not report errors: write the directory and flush the file first.
+            if (m_File != nullptr)
+            {
+                success = TIFFFlush(m_File) == 1 && success;
+            }
+
             CancelFile();
+
+            if (!success)
+            {
+                std::error_code errorCode;
+                std::filesystem::remove(m_FilePath, errorCode);
+                return Error::CannotWriteFile;
+            }
+
+            return Error::None;
         }
 
         /**
@@ -217,6 +378,11 @@ namespace Gorfector
          */
         void CancelFile() override
         {
+            delete m_StripEncoder;
+            m_StripEncoder = nullptr;
+            delete m_PyramidEncoder;
+            m_PyramidEncoder = nullptr;
+
             if (m_File != nullptr)
             {
                 TIFFClose(m_File);
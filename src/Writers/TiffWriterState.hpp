@@ -30,6 +30,21 @@ namespace Gorfector
          */
         static constexpr const char *k_JpegQualityKey = "JpegQuality";
 
+        /**
+         * @brief Key for specifying the number of lines per strip in JSON.
+         */
+        static constexpr const char *k_StripHeightKey = "StripHeight";
+
+        /**
+         * @brief Key for specifying the number of encoder threads in JSON.
+         */
+        static constexpr const char *k_WorkerCountKey = "WorkerCount";
+
+        /**
+         * @brief Key for specifying whether to write a tiled image pyramid in JSON.
+         */
+        static constexpr const char *k_TiledPyramidKey = "TiledPyramid";
+
         /**
          * @enum Compression
          * @brief Enum representing supported compression algorithms.
@@ -56,6 +71,9 @@ namespace Gorfector
         Compression m_Compression{}; ///< Current compression algorithm.
         int m_DeflateCompressionLevel{}; ///< Compression level for Deflate algorithm.
         int m_JpegQuality{}; ///< Quality level for JPEG compression.
+        int m_StripHeight{}; ///< Number of lines per strip.
+        int m_WorkerCount{}; ///< Number of threads compressing strips; 1 lets libtiff compress the image.
+        bool m_TiledPyramid{}; ///< Whether to write a tiled image with reduced-resolution levels.
 
         friend void to_json(nlohmann::json &j, const TiffWriterState &p);
         friend void from_json(const nlohmann::json &j, TiffWriterState &p);
@@ -70,6 +88,9 @@ namespace Gorfector
             , m_Compression(Compression::Deflate)
             , m_DeflateCompressionLevel(1)
             , m_JpegQuality(75)
+            , m_StripHeight(128)
+            , m_WorkerCount(1)
+            , m_TiledPyramid(false)
         {
         }
 
@@ -149,6 +170,40 @@ namespace Gorfector
             return m_JpegQuality;
         }
 
+        /**
+         * @brief Retrieves the number of lines per strip.
+         * @return An integer representing the number of lines per strip.
+         */
+        [[nodiscard]] int GetStripHeight() const
+        {
+            return m_StripHeight;
+        }
+
+        /**
+         * @brief Retrieves the number of threads compressing strips.
+         *
+         * With more than one thread, strips are compressed in parallel outside libtiff, if the compression
+         * algorithm allows it (Deflate and Packbits).
+         *
+         * @return An integer representing the number of threads.
+         */
+        [[nodiscard]] int GetWorkerCount() const
+        {
+            return m_WorkerCount;
+        }
+
+        /**
+         * @brief Checks whether the image is written as tiles, with reduced-resolution levels in sub-directories.
+         *
+         * When true, the strip height and worker count are not used.
+         *
+         * @return True if a tiled image pyramid is written.
+         */
+        [[nodiscard]] bool IsTiledPyramid() const
+        {
+            return m_TiledPyramid;
+        }
+
         /**
          * @class Updater
          * @brief A helper class to update the state of `TiffWriterState`.
@@ -203,6 +258,33 @@ namespace Gorfector
             {
                 m_StateComponent->m_JpegQuality = quality;
             }
+
+            /**
+             * @brief Sets the number of lines per strip.
+             * @param stripHeight The number of lines per strip.
+             */
+            void SetStripHeight(int stripHeight) const
+            {
+                m_StateComponent->m_StripHeight = stripHeight;
+            }
+
+            /**
+             * @brief Sets the number of threads compressing strips.
+             * @param workerCount The number of threads.
+             */
+            void SetWorkerCount(int workerCount) const
+            {
+                m_StateComponent->m_WorkerCount = workerCount;
+            }
+
+            /**
+             * @brief Sets whether to write a tiled image pyramid.
+             * @param tiledPyramid True to write a tiled image with reduced-resolution levels.
+             */
+            void SetTiledPyramid(bool tiledPyramid) const
+            {
+                m_StateComponent->m_TiledPyramid = tiledPyramid;
+            }
         };
     };
 
@@ -216,7 +298,10 @@ namespace Gorfector
         j = nlohmann::json{
                 {TiffWriterState::k_CompressionKey, p.m_Compression},
                 {TiffWriterState::k_CompressionLevelKey, p.m_DeflateCompressionLevel},
-                {TiffWriterState::k_JpegQualityKey, p.m_JpegQuality}};
+                {TiffWriterState::k_JpegQualityKey, p.m_JpegQuality},
+                {TiffWriterState::k_StripHeightKey, p.m_StripHeight},
+                {TiffWriterState::k_WorkerCountKey, p.m_WorkerCount},
+                {TiffWriterState::k_TiledPyramidKey, p.m_TiledPyramid}};
     }
 
     /**
@@ -229,5 +314,19 @@ namespace Gorfector
         j.at(TiffWriterState::k_CompressionKey).get_to(p.m_Compression);
         j.at(TiffWriterState::k_CompressionLevelKey).get_to(p.m_DeflateCompressionLevel);
         j.at(TiffWriterState::k_JpegQualityKey).get_to(p.m_JpegQuality);
+
+        // Older preference files do not have these keys.
+        if (j.contains(TiffWriterState::k_StripHeightKey))
+        {
+            j.at(TiffWriterState::k_StripHeightKey).get_to(p.m_StripHeight);
+        }
+        if (j.contains(TiffWriterState::k_WorkerCountKey))
+        {
+            j.at(TiffWriterState::k_WorkerCountKey).get_to(p.m_WorkerCount);
+        }
+        if (j.contains(TiffWriterState::k_TiledPyramidKey))
+        {
+            j.at(TiffWriterState::k_TiledPyramidKey).get_to(p.m_TiledPyramid);
+        }
     }
 }
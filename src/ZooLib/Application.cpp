@@ -4,10 +4,20 @@
 #include "Application.hpp"
 #include "SignalSupport.hpp"
 
+static gboolean DispatchNotifyObserversSource(GSource *source, GSourceFunc callback, gpointer data)
+{
+    // Disarm the source before notifying the observers, so that changes they make schedule another notification.
+    g_source_set_ready_time(source, -1);
+    return callback(data);
+}
+
 ZooLib::Application::Application(const bool testMode)
     : m_GtkApp(nullptr)
     , m_TestMode(testMode)
 {
+    m_State.SetComponentChangedCallback(
+            [this](const StateComponent *stateComponent) { m_ObserverManager.MarkComponentChanged(stateComponent); });
+    m_ObserverManager.SetNotificationNeededCallback([this]() { ScheduleObserverNotification(); });
 }
 
 void ZooLib::Application::Initialize()
@@ -24,10 +34,13 @@ void ZooLib::Application::Initialize()
 
 ZooLib::Application::~Application()
 {
+    m_State.SetComponentChangedCallback(nullptr);
+    m_ObserverManager.SetNotificationNeededCallback(nullptr);
 
-    if (m_ExecuteTestActionCallbackId != 0)
+    if (m_NotifyObserversSource != nullptr)
     {
-        gtk_widget_remove_tick_callback(m_MainWindow, m_RunObserversCallbackId);
+        g_source_destroy(m_NotifyObserversSource);
+        m_NotifyObserversSource = nullptr;
     }
     if (m_ExecuteTestActionCallbackId != 0)
     {
@@ -75,15 +88,36 @@ void ZooLib::Application::OnActivate(GtkApplication *app)
     adw_toolbar_view_set_content(ADW_TOOLBAR_VIEW(mainView), content);
 
     gtk_window_present(GTK_WINDOW(m_MainWindow));
-    m_RunObserversCallbackId = gtk_widget_add_tick_callback(
-            m_MainWindow,
-            [](GtkWidget *widget, GdkFrameClock *frameClock, gpointer data) -> gboolean {
+    // Observers are notified only when a state component changes, instead of on every frame.
+    static GSourceFuncs s_NotifyObserversSourceFuncs = []() {
+        GSourceFuncs funcs{};
+        funcs.dispatch = DispatchNotifyObserversSource;
+        return funcs;
+    }();
+
+    m_NotifyObserversSource = g_source_new(&s_NotifyObserversSourceFuncs, sizeof(GSource));
+    g_source_set_name(m_NotifyObserversSource, "ZooLib observer notification");
+    // Above redraw priority: views are updated before the frame they change is drawn.
+    g_source_set_priority(m_NotifyObserversSource, G_PRIORITY_HIGH_IDLE + 10);
+    g_source_set_callback(
+            m_NotifyObserversSource,
+            [](gpointer data) -> gboolean {
                 auto *localApp = static_cast<Application *>(data);
                 localApp->m_ObserverManager.NotifyObservers();
                 localApp->PurgeChangesets();
+                if (!localApp->m_ObserverManager.HasPendingNotifications())
+                {
+                    // Changes made by the observers were handled in the same notification.
+                    g_source_set_ready_time(localApp->m_NotifyObserversSource, -1);
+                }
                 return G_SOURCE_CONTINUE;
             },
             this, nullptr);
+    g_source_attach(m_NotifyObserversSource, nullptr);
+    // The main context owns the source from now on.
+    g_source_unref(m_NotifyObserversSource);
+    // Notify all observers of the UI that was just built.
+    ScheduleObserverNotification();
 
     if (m_TestMode)
     {
@@ -27,9 +27,21 @@ namespace ZooLib
      */
     class Application
     {
-        guint m_RunObserversCallbackId{};
+        GSource *m_NotifyObserversSource{};
         guint m_ExecuteTestActionCallbackId{};
 
+        /**
+         * \brief Schedules a call to `NotifyObservers()` on the main loop. Several calls made before the call is
+         * dispatched result in a single call.
+         */
+        void ScheduleObserverNotification() const
+        {
+            if (m_NotifyObserversSource != nullptr)
+            {
+                g_source_set_ready_time(m_NotifyObserversSource, 0);
+            }
+        }
+
     protected:
         /**
          * \brief Command dispatcher for handling application commands.
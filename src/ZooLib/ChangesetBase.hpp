@@ -35,6 +35,17 @@ namespace ZooLib
             return m_StateInitialVersion;
         }
 
+        /**
+         * \brief Resets the changeset to an empty changeset starting at the given version.
+         * \param stateInitialVersion The initial version of the state.
+         * \note Derived class that store changes should implement a Reset method that also clears their changes, and
+         * call this method.
+         */
+        void Reset(uint64_t stateInitialVersion)
+        {
+            m_StateInitialVersion = stateInitialVersion;
+        }
+
         /**
          * \brief Aggregates another changeset into this one by updating the initial version.
          * \details The initial version is updated to the minimum of the current and the other changeset's initial
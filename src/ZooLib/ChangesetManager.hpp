@@ -98,33 +98,34 @@ namespace ZooLib
         }
 
         /**
-         * \brief Aggregates all changesets since a given version into a new changeset.
+         * \brief Aggregates all changesets since a given version into a caller-owned changeset.
+         *
+         * The accumulator is reset before aggregating, so the same accumulator can be reused on every update without
+         * allocating memory once it has grown to hold the largest changeset.
          *
          * \param sinceVersion The version from which to start aggregating changesets.
-         * \return A pointer to the aggregated changeset.
+         * \param accumulator Receives the aggregated changes.
          */
-        [[nodiscard]] TChangeset *GetAggregatedChangeset(uint64_t sinceVersion) const
+        void AggregateChangesets(uint64_t sinceVersion, TChangeset &accumulator) const
         {
             static_assert(
                     std::is_base_of_v<ChangesetBase, TChangeset>,
                     "The type parameter of ChangesetManager<T> must derive from ChangesetBase");
 
-            auto *aggregatedChangeset = new TChangeset(sinceVersion);
+            accumulator.Reset(sinceVersion);
 
             for (auto changeset: m_Changesets)
             {
                 if (changeset->GetStateInitialVersion() >= sinceVersion)
                 {
-                    aggregatedChangeset->Aggregate(*changeset);
+                    accumulator.Aggregate(*changeset);
                 }
             }
 
             if (m_CurrentChangeset != nullptr)
             {
-                aggregatedChangeset->Aggregate(*m_CurrentChangeset);
+                accumulator.Aggregate(*m_CurrentChangeset);
             }
-
-            return aggregatedChangeset;
         }
 
         /**
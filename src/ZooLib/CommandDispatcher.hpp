@@ -1,13 +1,45 @@
 #pragma once
 
-#include <functional>
-#include <typeindex>
-#include <unordered_map>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "Command.hpp"
 
 namespace ZooLib
 {
+    /**
+     * \class CommandTypeId
+     * \brief Assigns a dense integer identifier to each command type.
+     *
+     * Identifiers are allocated from 0, the first time `Get()` is called for a type, so that they can be used as
+     * indices in flat tables.
+     */
+    class CommandTypeId
+    {
+        static size_t Next()
+        {
+            static std::atomic<size_t> s_NextId{};
+            return s_NextId.fetch_add(1, std::memory_order_relaxed);
+        }
+
+    public:
+        /**
+         * \brief Gets the identifier of a command type.
+         * \tparam TCommand The command type.
+         * \return The identifier of the command type.
+         */
+        template<typename TCommand>
+        static size_t Get()
+        {
+            static const size_t s_Id = Next();
+            return s_Id;
+        }
+    };
+
     /**
      * \class CommandDispatcher
      * \brief Manages the dispatching of commands to their respective handlers.
@@ -15,64 +47,98 @@ namespace ZooLib
      * The `CommandDispatcher` class provides a mechanism to register, unregister, and dispatch commands
      * to their associated handler functions. It supports polymorphic command handling and allows for
      * hierarchical dispatching by delegating unhandled commands to a parent dispatcher.
+     *
+     * Handlers are stored in a flat table indexed by `CommandTypeId`, and are called through a function pointer
+     * instantiated for each command type, without allocations or virtual calls. The handler found for each command
+     * type, in the dispatcher or one of its parents, is cached until a handler is registered or unregistered in any
+     * dispatcher. Dispatchers must be used from the main thread.
      */
     class CommandDispatcher
     {
+        static constexpr size_t k_MaxStateArgs = 4;
+
         /**
-         * \class CommandHandlerFuncBase
-         * \brief Abstract base class for command handler functions.
-         *
-         * This class provides a polymorphic interface for invoking command handler functions.
-         * Derived classes must implement the `Invoke` method to handle specific command types.
+         * \brief A handler function with its state arguments.
          */
-        class CommandHandlerFuncBase
+        struct CommandHandler
         {
-        public:
-            virtual ~CommandHandlerFuncBase() = default;
-
-            /**
-             * \brief Invokes the handler function with the given command.
-             * \param command The command instance to handle.
-             */
-            virtual void Invoke(const Command &command) = 0;
+            /// Calls m_Handler, cast back to its type, with the command and the state arguments.
+            void (*m_Invoke)(const CommandHandler &handler, const Command &command){};
+            void (*m_Handler)(){}; ///< The handler function, with its type erased.
+            std::array<const void *, k_MaxStateArgs> m_StateArgs{}; ///< The state arguments passed to the handler.
         };
 
         /**
-         * \brief A wrapper for the handler function of a specific command type.
-         *
-         * This class encapsulates a handler function for a specific command type, allowing it
-         * to be invoked with the appropriate command instance. It inherits from the base
-         * `CommandHandlerFuncBase` to provide a polymorphic interface for invoking handlers.
-         *
-         * \tparam TCommand The type of the command this handler is associated with.
+         * \brief The result of looking up the handler of a command type in the dispatcher and its parents.
          */
-        template<typename TCommand>
-        class CommandHandlerFunc final : public CommandHandlerFuncBase
+        struct ResolvedHandler
+        {
+            const CommandHandler *m_Handler{}; ///< The handler, or `nullptr` if the command type is not handled.
+            bool m_IsResolved{}; ///< Whether the handler was looked up.
+        };
+
+        /// Incremented each time a handler is registered or unregistered, to invalidate the resolved handlers.
+        static inline uint64_t s_HandlersGeneration{};
+
+        CommandDispatcher *m_Parent{}; ///< Pointer to the parent dispatcher for hierarchical dispatching.
+        std::vector<CommandHandler> m_CommandHandlers{}; ///< Command handlers, indexed by command type ID.
+        std::vector<ResolvedHandler> m_ResolvedHandlers{}; ///< Cached handlers, indexed by command type ID.
+        uint64_t m_ResolvedHandlersGeneration{}; ///< The value of s_HandlersGeneration m_ResolvedHandlers is for.
+
+        /**
+         * \brief Calls a handler function with a command.
+         * \tparam TCommand The type of the command the handler is associated with.
+         * \tparam TStateArgs The types of the state arguments of the handler.
+         * \param handler The handler.
+         * \param command The command to pass to the handler.
+         */
+        template<typename TCommand, typename... TStateArgs>
+        static void Invoke(const CommandHandler &handler, const Command &command)
         {
-            std::function<void(const TCommand &)> m_Handler; ///< The handler function for the command.
-
-        public:
-            /**
-             * \brief Constructs a `CommandHandlerFunc` with the given handler function.
-             * \param handler A function to handle the command of type `TCommand`.
-             */
-            explicit CommandHandlerFunc(std::function<void(const TCommand &)> handler)
-                : m_Handler(handler)
+            auto handlerFunc = reinterpret_cast<void (*)(const TCommand &, TStateArgs *...)>(handler.m_Handler);
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                handlerFunc(
+                        static_cast<const TCommand &>(command),
+                        const_cast<TStateArgs *>(static_cast<const TStateArgs *>(handler.m_StateArgs[I]))...);
+            }(std::index_sequence_for<TStateArgs...>{});
+        }
+
+        /**
+         * \brief Finds the handler of a command type, in this dispatcher or its parents.
+         * \param commandTypeId The ID of the command type.
+         * \return The handler, or `nullptr` if no dispatcher handles the command type.
+         */
+        const CommandHandler *ResolveHandler(size_t commandTypeId) // NOLINT(misc-no-recursion)
+        {
+            if (m_ResolvedHandlersGeneration != s_HandlersGeneration)
             {
+                m_ResolvedHandlers.clear();
+                m_ResolvedHandlersGeneration = s_HandlersGeneration;
             }
 
-            /**
-             * \brief Invokes the handler function with the given command.
-             * \param command The command instance to pass to the handler.
-             */
-            void Invoke(const Command &command) override
+            if (commandTypeId < m_ResolvedHandlers.size() && m_ResolvedHandlers[commandTypeId].m_IsResolved)
             {
-                m_Handler(static_cast<const TCommand &>(command));
+                return m_ResolvedHandlers[commandTypeId].m_Handler;
             }
-        };
 
-        CommandDispatcher *m_Parent{}; ///< Pointer to the parent dispatcher for hierarchical dispatching.
-        std::unordered_map<size_t, CommandHandlerFuncBase *> m_CommandHandlers; ///< Map of command handlers by type.
+            const CommandHandler *handler = nullptr;
+            if (commandTypeId < m_CommandHandlers.size() && m_CommandHandlers[commandTypeId].m_Invoke != nullptr)
+            {
+                handler = &m_CommandHandlers[commandTypeId];
+            }
+            else if (m_Parent != nullptr && m_Parent != this)
+            {
+                handler = m_Parent->ResolveHandler(commandTypeId);
+            }
+
+            if (commandTypeId >= m_ResolvedHandlers.size())
+            {
+                m_ResolvedHandlers.resize(commandTypeId + 1);
+            }
+            m_ResolvedHandlers[commandTypeId] = {handler, true};
+
+            return handler;
+        }
 
     public:
         /**
@@ -84,6 +150,20 @@ namespace ZooLib
         {
         }
 
+        CommandDispatcher(const CommandDispatcher &) = delete;
+        CommandDispatcher &operator=(const CommandDispatcher &) = delete;
+
+        /**
+         * \brief Destroys the dispatcher. Dispatchers that cached one of its handlers look their handlers up again.
+         */
+        ~CommandDispatcher()
+        {
+            if (!m_CommandHandlers.empty())
+            {
+                ++s_HandlersGeneration;
+            }
+        }
+
         /**
          * \brief Dispatches a command to its registered handler.
          * \tparam TCommand The type of the command to dispatch.
@@ -93,20 +173,14 @@ namespace ZooLib
          * (if one exists).
          */
         template<typename TCommand>
-        void Dispatch(const TCommand &command) // NOLINT(misc-no-recursion)
+        void Dispatch(const TCommand &command)
         {
-            auto key = std::type_index(typeid(TCommand)).hash_code();
-            auto handler = m_CommandHandlers.find(key);
-            if (handler != m_CommandHandlers.end() && handler->second != nullptr)
-            {
-                handler->second->Invoke(command);
-            }
-            else
+            auto resolvedHandler = ResolveHandler(CommandTypeId::Get<TCommand>());
+            if (resolvedHandler != nullptr)
             {
-                if (m_Parent != nullptr && m_Parent != this)
-                {
-                    m_Parent->Dispatch(command);
-                }
+                // The handler may register or unregister handlers, so call a copy of it.
+                auto handler = *resolvedHandler;
+                handler.m_Invoke(handler, command);
             }
         }
 
@@ -115,7 +189,7 @@ namespace ZooLib
          * \tparam TCommand The type of the command to handle.
          * \tparam TStateArgs Variadic template for additional state arguments.
          * \param handler A function to handle the command.
-         * \param args Additional state arguments to bind to the handler.
+         * \param args Additional state arguments to pass to the handler.
          *
          * The handler function must accept a `const TCommand &` as its first parameter.
          */
@@ -125,24 +199,27 @@ namespace ZooLib
             static_assert(
                     std::is_base_of_v<Command, TCommand>,
                     "The TCommand type parameter of RegisterHandler<T> must derive from Command");
+            static_assert(sizeof...(TStateArgs) <= k_MaxStateArgs, "Too many state arguments for the handler");
 
-            auto key = std::type_index(typeid(TCommand)).hash_code();
-
-            auto handlerIt = m_CommandHandlers.find(key);
-            if (handlerIt != m_CommandHandlers.end())
+            auto commandTypeId = CommandTypeId::Get<TCommand>();
+            if (commandTypeId >= m_CommandHandlers.size())
             {
-                delete handlerIt->second;
+                m_CommandHandlers.resize(commandTypeId + 1);
             }
 
-            auto func = new CommandHandlerFunc<TCommand>(std::bind(handler, std::placeholders::_1, args...));
-            m_CommandHandlers[key] = func;
+            auto &commandHandler = m_CommandHandlers[commandTypeId];
+            commandHandler.m_Invoke = &Invoke<TCommand, TStateArgs...>;
+            commandHandler.m_Handler = reinterpret_cast<void (*)()>(handler);
+            commandHandler.m_StateArgs = {static_cast<const void *>(args)...};
+
+            ++s_HandlersGeneration;
         }
 
         /**
          * \brief Unregisters the handler function for a specific command type.
          * \tparam TCommand The type of the command to unregister.
          *
-         * If a handler is registered for the command type, it is deleted and removed from the map.
+         * If a handler is registered for the command type, it is removed from the table.
          */
         template<typename TCommand>
         void UnregisterHandler()
@@ -151,15 +228,12 @@ namespace ZooLib
                     std::is_base_of_v<Command, TCommand>,
                     "The TCommand type parameter of RegisterHandler<T> must derive from Command");
 
-            auto key = std::type_index(typeid(TCommand)).hash_code();
-
-            auto handlerIt = m_CommandHandlers.find(key);
-            if (handlerIt != m_CommandHandlers.end())
+            auto commandTypeId = CommandTypeId::Get<TCommand>();
+            if (commandTypeId < m_CommandHandlers.size())
             {
-                delete handlerIt->second;
+                m_CommandHandlers[commandTypeId] = {};
+                ++s_HandlersGeneration;
             }
-
-            m_CommandHandlers[key] = nullptr;
         }
     };
 }
@@ -3,6 +3,7 @@
 #include <gtk/gtk.h>
 #include <vector>
 
+#include "Profiler.hpp"
 #include "StateComponent.hpp"
 
 namespace ZooLib
@@ -18,6 +19,8 @@ namespace ZooLib
      */
     class Observer
     {
+        static inline const Profiler::Metric s_UpdateTime{"observer.update.time", Profiler::Unit::e_Nanoseconds};
+
     protected:
         /**
          * \brief The state components being observed for changes.
@@ -117,7 +120,10 @@ namespace ZooLib
                             version, observedComponent->GetVersion());
 #endif
 
-                    UpdateImplementation();
+                    {
+                        Profiler::ScopedTimer timer(s_UpdateTime);
+                        UpdateImplementation();
+                    }
 
 #if DEBUG_OBSERVERS
                     g_debug("Updated observer %s.", typeid(*this).name());
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
 #include "Observer.hpp"
@@ -14,13 +16,34 @@ namespace ZooLib
      *
      * The ObserverManager handles the addition, removal, and notification of observers. It ensures that
      * observers are executed in a topologically sorted order based on their dependencies.
+     *
+     * Only the observers of the components signaled by `MarkComponentChanged()` are notified, except after
+     * observers are added or removed, where all observers are notified once.
      */
     class ObserverManager
     {
         std::vector<Observer *> m_Observers{}; ///< List of all observers.
         bool m_NeedsSorting{}; ///< Flag indicating if the observers need to be sorted.
         std::vector<Observer *> m_SortedObservers{}; ///< List of observers sorted by dependency.
-        std::vector<Observer *> m_DeletedObservers{}; ///< List of observers marked for deletion.
+
+        /// Observers of each state component, one entry per occurrence in `GetObservedComponents()`.
+        std::unordered_map<const StateComponent *, std::vector<Observer *>> m_ObserversByComponent{};
+        /// Observers modifying each state component, one entry per occurrence in `GetModifiedComponents()`.
+        std::unordered_map<const StateComponent *, std::vector<Observer *>> m_ModifiersByComponent{};
+
+        /// Indices in m_SortedObservers of the observers of each state component.
+        std::unordered_map<const StateComponent *, std::vector<size_t>> m_SortedObserversByComponent{};
+        std::unordered_map<const Observer *, size_t> m_SortedObserverIndices{}; ///< Index of each sorted observer.
+
+        uint64_t m_SortGeneration{1}; ///< Incremented each time the observers are sorted.
+        /// For each observer of m_SortedObservers, the sort generation in which it was removed. Entries from older
+        /// generations are stale, so that the deletion set is cleared by incrementing m_SortGeneration.
+        std::vector<uint64_t> m_DeletionGenerations{};
+
+        std::vector<size_t> m_PendingObservers{}; ///< Min-heap of the indices of the observers to notify.
+        std::vector<bool> m_IsObserverPending{}; ///< Whether each observer of m_SortedObservers is pending.
+        bool m_NotifyAll{true}; ///< Flag indicating if all observers must be notified.
+        std::function<void()> m_NotificationNeededCallback{}; ///< Called when observers need to be notified.
 
         /**
          * \brief Removes an item from a vector by swapping it with the last element and popping it.
@@ -48,62 +71,209 @@ namespace ZooLib
             }
         }
 
+        /**
+         * \brief Removes one occurrence of an observer from the adjacency list of a state component.
+         * \param adjacency The adjacency lists.
+         * \param stateComponent The state component.
+         * \param observer The observer to remove.
+         */
+        void RemoveAdjacency(
+                std::unordered_map<const StateComponent *, std::vector<Observer *>> &adjacency,
+                const StateComponent *stateComponent, Observer *observer)
+        {
+            auto it = adjacency.find(stateComponent);
+            if (it == adjacency.end())
+            {
+                return;
+            }
+
+            SwapRemove(it->second, observer);
+            if (it->second.empty())
+            {
+                adjacency.erase(it);
+            }
+        }
+
         /**
          * \brief Sorts the observers in topological order based on their dependencies.
          *
-         * Observers form a directed graph based on their observed and modified state components.
-         * This method performs a topological sort to ensure the correct execution order.
+         * Observers form a directed graph based on their observed and modified state components: an observer
+         * depends on every observer that modifies one of its observed components. This method sorts the graph using
+         * Kahn's algorithm, in time linear in the number of observers and edges. Observers that do not depend on each
+         * other keep the order in which they were added.
          *
          * \throws std::runtime_error If the sorting fails due to cyclic dependencies.
          */
         void SortObservers()
         {
-            // See https://en.wikipedia.org/wiki/Topological_sorting.
+            // See https://en.wikipedia.org/wiki/Topological_sorting#Kahn's_algorithm.
+
+            std::unordered_map<const Observer *, size_t> observerIndices;
+            observerIndices.reserve(m_Observers.size());
+            for (auto index = 0UZ; index < m_Observers.size(); ++index)
+            {
+                observerIndices[m_Observers[index]] = index;
+            }
+
+            // The number of modifications of its observed components that each observer waits for.
+            std::vector<size_t> inDegrees(m_Observers.size(), 0);
+            for (auto index = 0UZ; index < m_Observers.size(); ++index)
+            {
+                for (const StateComponent *observedSC: m_Observers[index]->GetObservedComponents())
+                {
+                    auto it = m_ModifiersByComponent.find(observedSC);
+                    if (it != m_ModifiersByComponent.end())
+                    {
+                        inDegrees[index] += it->second.size();
+                    }
+                }
+            }
 
             m_SortedObservers.clear();
-            std::vector observersToSort(m_Observers);
-            std::vector<const StateComponent *> modifiedComponents;
-            for (const Observer *observer: observersToSort)
+            m_SortedObservers.reserve(m_Observers.size());
+            for (auto index = 0UZ; index < m_Observers.size(); ++index)
             {
-                for (auto modifiedSC: observer->GetModifiedComponents())
+                if (inDegrees[index] == 0)
                 {
-                    modifiedComponents.push_back(modifiedSC);
+                    m_SortedObservers.push_back(m_Observers[index]);
                 }
             }
 
-            bool nextObserverFound = true;
-            while (!observersToSort.empty() && nextObserverFound)
+            // m_SortedObservers doubles as the queue of observers whose dependencies are all sorted.
+            for (auto next = 0UZ; next < m_SortedObservers.size(); ++next)
             {
-                nextObserverFound = false;
-                for (Observer *observer: observersToSort)
+                for (const StateComponent *modifiedSC: m_SortedObservers[next]->GetModifiedComponents())
                 {
-                    if (std::ranges::all_of(
-                                observer->GetObservedComponents(),
-                                [&modifiedComponents](const StateComponent *observedSC) {
-                                    return std::ranges::find(modifiedComponents, observedSC) ==
-                                           modifiedComponents.end();
-                                }))
+                    auto it = m_ObserversByComponent.find(modifiedSC);
+                    if (it == m_ObserversByComponent.end())
                     {
-                        nextObserverFound = true;
+                        continue;
+                    }
 
-                        m_SortedObservers.push_back(observer);
-                        SwapRemove(observersToSort, observer);
-                        for (const StateComponent *modifiedSC: observer->GetModifiedComponents())
+                    for (Observer *dependent: it->second)
+                    {
+                        auto dependentIndex = observerIndices[dependent];
+                        if (--inDegrees[dependentIndex] == 0)
                         {
-                            SwapRemove(modifiedComponents, modifiedSC);
+                            m_SortedObservers.push_back(dependent);
                         }
-                        break;
                     }
                 }
             }
 
-            if (!nextObserverFound || !observersToSort.empty())
+            if (m_SortedObservers.size() != m_Observers.size())
             {
                 throw std::runtime_error("ObserverManager::SortObservers() failed to sort all observers.");
             }
         }
 
+        /**
+         * \brief Maps each state component to the indices of its observers in m_SortedObservers.
+         */
+        void IndexObservers()
+        {
+            m_SortedObserversByComponent.clear();
+            m_SortedObserverIndices.clear();
+            m_SortedObserverIndices.reserve(m_SortedObservers.size());
+            for (auto index = 0UZ; index < m_SortedObservers.size(); ++index)
+            {
+                m_SortedObserverIndices[m_SortedObservers[index]] = index;
+                for (const StateComponent *observedSC: m_SortedObservers[index]->GetObservedComponents())
+                {
+                    auto &indices = m_SortedObserversByComponent[observedSC];
+                    if (indices.empty() || indices.back() != index)
+                    {
+                        indices.push_back(index);
+                    }
+                }
+            }
+
+            ++m_SortGeneration;
+            m_DeletionGenerations.resize(m_SortedObservers.size());
+
+            m_PendingObservers.clear();
+            m_PendingObservers.reserve(m_SortedObservers.size());
+            m_IsObserverPending.assign(m_SortedObservers.size(), false);
+        }
+
+        /**
+         * \brief Adds an observer to the pending observers, unless it is already pending.
+         * \param index The index of the observer in m_SortedObservers.
+         * \return True if the observer was added.
+         */
+        bool PushPendingObserver(size_t index)
+        {
+            if (m_IsObserverPending[index])
+            {
+                return false;
+            }
+
+            m_IsObserverPending[index] = true;
+            m_PendingObservers.push_back(index);
+            std::ranges::push_heap(m_PendingObservers, std::greater{});
+            return true;
+        }
+
+        void RequestNotification() const
+        {
+            if (m_NotificationNeededCallback)
+            {
+                m_NotificationNeededCallback();
+            }
+        }
+
     public:
+        /**
+         * \brief Sets the function called when observers need to be notified, to schedule a call to
+         * `NotifyObservers()`. The function may be called several times before `NotifyObservers()` is called.
+         * \param callback The function to call.
+         */
+        void SetNotificationNeededCallback(std::function<void()> callback)
+        {
+            m_NotificationNeededCallback = std::move(callback);
+        }
+
+        /**
+         * \brief Checks if some observers need to be notified.
+         * \return True if `NotifyObservers()` has observers to notify.
+         */
+        [[nodiscard]] bool HasPendingNotifications() const
+        {
+            return m_NeedsSorting || m_NotifyAll || !m_PendingObservers.empty();
+        }
+
+        /**
+         * \brief Signals that a state component was modified, so that its observers are notified by the next call to
+         * `NotifyObservers()`.
+         * \param stateComponent The modified state component.
+         */
+        void MarkComponentChanged(const StateComponent *stateComponent)
+        {
+            if (m_NeedsSorting || m_NotifyAll)
+            {
+                // All observers will be notified.
+                RequestNotification();
+                return;
+            }
+
+            auto it = m_SortedObserversByComponent.find(stateComponent);
+            if (it == m_SortedObserversByComponent.end())
+            {
+                return;
+            }
+
+            bool addedObserver = false;
+            for (auto index: it->second)
+            {
+                addedObserver |= PushPendingObserver(index);
+            }
+
+            if (addedObserver)
+            {
+                RequestNotification();
+            }
+        }
+
         /**
          * \brief Adds an observer to the manager.
          * \param observer The observer to add.
@@ -111,7 +281,16 @@ namespace ZooLib
         void AddObserver(Observer *observer)
         {
             m_Observers.push_back(observer);
+            for (const StateComponent *observedSC: observer->GetObservedComponents())
+            {
+                m_ObserversByComponent[observedSC].push_back(observer);
+            }
+            for (const StateComponent *modifiedSC: observer->GetModifiedComponents())
+            {
+                m_ModifiersByComponent[modifiedSC].push_back(observer);
+            }
             m_NeedsSorting = true;
+            RequestNotification();
         }
 
         /**
@@ -120,9 +299,32 @@ namespace ZooLib
          */
         void RemoveObserver(Observer *observer)
         {
-            std::erase(m_Observers, observer);
-            m_DeletedObservers.push_back(observer);
+            auto it = std::ranges::find(m_Observers, observer);
+            if (it == m_Observers.end())
+            {
+                return;
+            }
+
+            m_Observers.erase(it);
+            for (const StateComponent *observedSC: observer->GetObservedComponents())
+            {
+                RemoveAdjacency(m_ObserversByComponent, observedSC, observer);
+            }
+            for (const StateComponent *modifiedSC: observer->GetModifiedComponents())
+            {
+                RemoveAdjacency(m_ModifiersByComponent, modifiedSC, observer);
+            }
+
+            // The observer may still be in the list of observers being notified.
+            auto sortedIt = m_SortedObserverIndices.find(observer);
+            if (sortedIt != m_SortedObserverIndices.end())
+            {
+                m_DeletionGenerations[sortedIt->second] = m_SortGeneration;
+                m_SortedObserverIndices.erase(sortedIt);
+            }
+
             m_NeedsSorting = true;
+            RequestNotification();
         }
 
         /**
@@ -132,39 +334,58 @@ namespace ZooLib
          */
         uint64_t GetMostRecentObservedVersion(const StateComponent *stateComponent) const
         {
+            auto it = m_ObserversByComponent.find(stateComponent);
+            if (it == m_ObserversByComponent.end())
+            {
+                return 0;
+            }
+
             uint64_t mostRecentVersion = 0;
-            for (const auto &observer: m_Observers)
+            for (const auto &observer: it->second)
             {
-                if (std::ranges::find(observer->GetObservedComponents(), stateComponent) !=
-                    observer->GetObservedComponents().end())
-                {
-                    mostRecentVersion = std::max(mostRecentVersion, observer->GetObservedVersion(stateComponent));
-                }
+                mostRecentVersion = std::max(mostRecentVersion, observer->GetObservedVersion(stateComponent));
             }
             return mostRecentVersion;
         }
 
         /**
-         * \brief Notifies all observers in the correct order.
+         * \brief Notifies the pending observers in the correct order.
          *
-         * If sorting is required, it sorts the observers first. Deleted observers are skipped.
+         * If sorting is required, it sorts the observers first and notifies all of them. Deleted observers are
+         * skipped. Observers of components modified by an observer are notified in the same call.
          */
         void NotifyObservers()
         {
             if (m_NeedsSorting)
             {
                 SortObservers();
-                m_DeletedObservers.clear();
                 m_NeedsSorting = false;
+                IndexObservers();
+                m_NotifyAll = true;
+            }
+
+            if (m_NotifyAll)
+            {
+                m_NotifyAll = false;
+                for (auto index = 0UZ; index < m_SortedObservers.size(); ++index)
+                {
+                    PushPendingObserver(index);
+                }
             }
 
 #if DEBUG_OBSERVER_MANAGER
-            g_debug("ObserverManager::NotifyObservers() notifying %zu observers", m_SortedObservers.size());
+            g_debug("ObserverManager::NotifyObservers() notifying %zu observers", m_PendingObservers.size());
 #endif
 
-            for (auto observer: m_SortedObservers)
+            while (!m_PendingObservers.empty())
             {
-                if (std::ranges::find(m_DeletedObservers, observer) != m_DeletedObservers.end())
+                std::ranges::pop_heap(m_PendingObservers, std::greater{});
+                auto index = m_PendingObservers.back();
+                m_PendingObservers.pop_back();
+                m_IsObserverPending[index] = false;
+
+                auto observer = m_SortedObservers[index];
+                if (m_DeletionGenerations[index] == m_SortGeneration)
                 {
                     continue;
                 }
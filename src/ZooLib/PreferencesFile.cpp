@@ -0,0 +1,201 @@
+#include "PreferencesFile.hpp"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <glib.h>
+#include <unistd.h>
+
+ZooLib::PreferencesFile::PreferencesFile(std::filesystem::path filePath)
+    : m_FilePath(std::move(filePath))
+{
+    m_WriterThread = std::thread(&PreferencesFile::RunWriter, this);
+}
+
+ZooLib::PreferencesFile::~PreferencesFile()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Condition.notify_all();
+
+    // The writer thread writes the pending modifications before returning.
+    m_WriterThread.join();
+}
+
+void ZooLib::PreferencesFile::LoadIfNeeded()
+{
+    if (m_IsLoaded)
+    {
+        return;
+    }
+
+    m_IsLoaded = true;
+
+    std::ifstream f(m_FilePath);
+    if (!f.good())
+    {
+        return;
+    }
+
+    try
+    {
+        m_Document = nlohmann::json::parse(f);
+    }
+    catch (const std::exception &)
+    {
+        m_Document = nlohmann::json{};
+    }
+
+    if (!m_Document.is_object())
+    {
+        m_Document = nlohmann::json::object();
+    }
+}
+
+bool ZooLib::PreferencesFile::Get(const std::string &key, nlohmann::json &value)
+{
+    std::lock_guard lock(m_Mutex);
+    LoadIfNeeded();
+
+    auto it = m_Document.find(key);
+    if (it == m_Document.end())
+    {
+        return false;
+    }
+
+    value = *it;
+    return true;
+}
+
+void ZooLib::PreferencesFile::Set(const std::string &key, nlohmann::json value)
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        LoadIfNeeded();
+
+        m_Document[key] = std::move(value);
+        m_IsDirty = true;
+        m_LastModificationTime = std::chrono::steady_clock::now();
+    }
+    m_Condition.notify_all();
+}
+
+void ZooLib::PreferencesFile::Flush()
+{
+    std::unique_lock lock(m_Mutex);
+    if (!m_IsDirty && !m_IsWriting)
+    {
+        return;
+    }
+
+    // A write in progress has all the modifications unless the document changed since it started; in that case, wait
+    // for the next write too.
+    auto writeAttemptCount = m_WriteAttemptCount + (m_IsWriting ? 1 : 0) + (m_IsDirty ? 1 : 0);
+    m_FlushRequested = true;
+    m_Condition.notify_all();
+    m_Condition.wait(lock, [this, writeAttemptCount]() { return m_WriteAttemptCount >= writeAttemptCount; });
+    m_FlushRequested = false;
+}
+
+void ZooLib::PreferencesFile::RunWriter()
+{
+    std::unique_lock lock(m_Mutex);
+    while (true)
+    {
+        m_Condition.wait(lock, [this]() { return m_Stopping || m_IsDirty; });
+        if (!m_IsDirty)
+        {
+            // Stopping, and nothing left to write.
+            return;
+        }
+
+        // Wait until the document stops changing, and after a failed write, for the retry delay, unless the file is
+        // needed now.
+        while (!m_Stopping && !m_FlushRequested)
+        {
+            auto writeTime = std::max(m_LastModificationTime + k_WriteDelay, m_RetryTime);
+            if (std::chrono::steady_clock::now() >= writeTime)
+            {
+                break;
+            }
+            m_Condition.wait_until(lock, writeTime);
+        }
+
+        // Copying the document is cheaper than serializing it, so serialize the copy without holding the lock.
+        auto document = m_Document;
+        m_IsDirty = false;
+        m_IsWriting = true;
+
+        lock.unlock();
+        auto written = Write(document);
+        lock.lock();
+
+        m_IsWriting = false;
+        ++m_WriteAttemptCount;
+        if (written)
+        {
+            ++m_WriteCount;
+        }
+        else
+        {
+            // Keep the modifications, to write them with the next ones or when the retry delay expires.
+            m_IsDirty = true;
+            m_RetryTime = std::chrono::steady_clock::now() + k_RetryDelay;
+            g_warning(
+                    "Failed to write the preferences file %s%s", m_FilePath.c_str(),
+                    m_Stopping ? "; the modifications are lost" : "");
+        }
+        m_Condition.notify_all();
+
+        if (!written && m_Stopping)
+        {
+            return;
+        }
+    }
+}
+
+bool ZooLib::PreferencesFile::Write(const nlohmann::json &document)
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_FilePath.parent_path(), error);
+
+    auto temporaryFilePath = m_FilePath;
+    temporaryFilePath += ".tmp";
+
+    auto *file = fopen(temporaryFilePath.c_str(), "w");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    // Flush the data to the disk before renaming: otherwise, after a crash, the file system may have the rename but
+    // not the data, leaving an empty file in place of the old one.
+    auto contents = document.dump(4);
+    auto written = fwrite(contents.data(), 1, contents.size(), file) == contents.size() && fflush(file) == 0 &&
+                   fsync(fileno(file)) == 0;
+    written = fclose(file) == 0 && written;
+    if (!written)
+    {
+        std::filesystem::remove(temporaryFilePath, error);
+        return false;
+    }
+
+    // Replace the file atomically, so that it is never left partially written.
+    std::filesystem::rename(temporaryFilePath, m_FilePath, error);
+    if (error)
+    {
+        std::filesystem::remove(temporaryFilePath, error);
+        return false;
+    }
+
+    // Make the rename itself durable.
+    if (auto directory = open(m_FilePath.parent_path().c_str(), O_RDONLY | O_DIRECTORY); directory >= 0)
+    {
+        fsync(directory);
+        close(directory);
+    }
+
+    return true;
+}
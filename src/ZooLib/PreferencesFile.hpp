@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+namespace ZooLib
+{
+    /**
+     * \class PreferencesFile
+     * \brief Keeps a JSON preferences file in memory and writes it back in the background.
+     *
+     * The file is parsed once, the first time a value is read or written. Writes update the in-memory document and
+     * are debounced: the document is written by a background thread once it has not been modified for
+     * `k_WriteDelay`, so that saving many components in a row writes the file once. The file is replaced atomically,
+     * by writing a temporary file next to it, flushing it to the disk and renaming it over the original. When the file
+     * cannot be written, the modifications stay pending and the write is retried after `k_RetryDelay`.
+     */
+    class PreferencesFile
+    {
+        static constexpr std::chrono::milliseconds k_WriteDelay{500};
+        static constexpr std::chrono::seconds k_RetryDelay{5};
+
+        std::filesystem::path m_FilePath{};
+
+        std::mutex m_Mutex{};
+        std::condition_variable m_Condition{};
+        nlohmann::json m_Document{};
+        bool m_IsLoaded{};
+        bool m_IsDirty{};
+        bool m_IsWriting{};
+        bool m_FlushRequested{};
+        bool m_Stopping{};
+        std::chrono::steady_clock::time_point m_LastModificationTime{};
+        std::chrono::steady_clock::time_point m_RetryTime{};
+        size_t m_WriteCount{};
+        size_t m_WriteAttemptCount{};
+
+        std::thread m_WriterThread{};
+
+        void LoadIfNeeded();
+        void RunWriter();
+        bool Write(const nlohmann::json &document);
+
+    public:
+        /**
+         * \brief Constructs a preferences file and starts its writer thread. The file is not read until needed.
+         * \param filePath The path of the preferences file.
+         */
+        explicit PreferencesFile(std::filesystem::path filePath);
+
+        PreferencesFile(const PreferencesFile &) = delete;
+        PreferencesFile &operator=(const PreferencesFile &) = delete;
+
+        /**
+         * \brief Writes the pending modifications and stops the writer thread.
+         */
+        ~PreferencesFile();
+
+        /**
+         * \brief Gets the path of the preferences file.
+         * \return The path of the preferences file.
+         */
+        [[nodiscard]] const std::filesystem::path &GetFilePath() const
+        {
+            return m_FilePath;
+        }
+
+        /**
+         * \brief Gets the value of a top level key of the document.
+         * \param key The key.
+         * \param value Receives a copy of the value, if the key exists.
+         * \return True if the key exists.
+         */
+        bool Get(const std::string &key, nlohmann::json &value);
+
+        /**
+         * \brief Sets the value of a top level key of the document, and schedules a write of the file.
+         * \param key The key.
+         * \param value The value.
+         */
+        void Set(const std::string &key, nlohmann::json value);
+
+        /**
+         * \brief Writes the pending modifications now, and waits until they are written. If the file cannot be written,
+         * returns after the failed attempt; the modifications stay pending.
+         */
+        void Flush();
+
+        /**
+         * \brief Gets the number of times the file was successfully written.
+         * \return The number of times the file was written.
+         */
+        [[nodiscard]] size_t GetWriteCount()
+        {
+            std::lock_guard lock(m_Mutex);
+            return m_WriteCount;
+        }
+    };
+}
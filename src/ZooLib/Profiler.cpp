@@ -0,0 +1,298 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <glib.h>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+
+std::atomic<bool> ZooLib::Profiler::s_Enabled{};
+
+namespace
+{
+    struct Histogram
+    {
+        std::atomic<uint64_t> Count{};
+        std::atomic<uint64_t> Sum{};
+        std::atomic<uint64_t> Max{};
+        std::array<std::atomic<uint64_t>, ZooLib::Profiler::k_BucketCount> Buckets{};
+    };
+
+    /**
+     * The histograms of a thread. Only the owning thread writes to them, so a write is a relaxed load followed by a
+     * relaxed store, and readers never see a torn value.
+     */
+    struct ThreadHistograms
+    {
+        std::array<Histogram, ZooLib::Profiler::k_MaxMetricCount> Histograms{};
+        std::atomic<bool> InUse{};
+    };
+
+    struct Registry
+    {
+        std::mutex Mutex{};
+        std::vector<const ZooLib::Profiler::Metric *> Metrics{};
+        std::vector<std::unique_ptr<ThreadHistograms>> Threads{};
+    };
+
+    Registry &GetRegistry()
+    {
+        // Never destroyed: threads may record values while the static variables are destroyed.
+        static auto *registry = new Registry();
+        return *registry;
+    }
+
+    /**
+     * Gives the histograms back when the thread exits, so that they can be reused by the next thread.
+     */
+    struct ThreadSlot
+    {
+        ThreadHistograms *Histograms{};
+
+        ~ThreadSlot()
+        {
+            if (Histograms != nullptr)
+            {
+                Histograms->InUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    ThreadHistograms *AcquireThreadHistograms()
+    {
+        auto &registry = GetRegistry();
+        std::lock_guard lock(registry.Mutex);
+
+        for (const auto &histograms: registry.Threads)
+        {
+            if (!histograms->InUse.load(std::memory_order_acquire))
+            {
+                histograms->InUse.store(true, std::memory_order_relaxed);
+                return histograms.get();
+            }
+        }
+
+        auto &histograms = registry.Threads.emplace_back(std::make_unique<ThreadHistograms>());
+        histograms->InUse.store(true, std::memory_order_relaxed);
+        return histograms.get();
+    }
+
+    ThreadHistograms *GetThreadHistograms()
+    {
+        thread_local ThreadSlot slot;
+        if (slot.Histograms == nullptr)
+        {
+            slot.Histograms = AcquireThreadHistograms();
+        }
+
+        return slot.Histograms;
+    }
+
+    void Increment(std::atomic<uint64_t> &counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    const char *GetUnitName(ZooLib::Profiler::Unit unit)
+    {
+        switch (unit)
+        {
+            case ZooLib::Profiler::Unit::e_Bytes:
+                return "bytes";
+            case ZooLib::Profiler::Unit::e_Nanoseconds:
+                return "ns";
+            default:
+                return "count";
+        }
+    }
+
+    std::string FormatValue(double value, ZooLib::Profiler::Unit unit)
+    {
+        switch (unit)
+        {
+            case ZooLib::Profiler::Unit::e_Bytes:
+                return std::format("{:.1f} KiB", value / 1024.0);
+            case ZooLib::Profiler::Unit::e_Nanoseconds:
+                return std::format("{:.3f} ms", value / 1e6);
+            default:
+                return std::format("{:.0f}", value);
+        }
+    }
+}
+
+ZooLib::Profiler::Metric::Metric(std::string name, Unit unit)
+    : m_Id(k_MaxMetricCount)
+    , m_Name(std::move(name))
+    , m_Unit(unit)
+{
+    auto &registry = GetRegistry();
+    std::lock_guard lock(registry.Mutex);
+
+    if (registry.Metrics.size() >= k_MaxMetricCount)
+    {
+        g_warning("Too many profiler metrics, %s will not be recorded.", m_Name.c_str());
+        return;
+    }
+
+    m_Id = static_cast<uint32_t>(registry.Metrics.size());
+    registry.Metrics.push_back(this);
+}
+
+void ZooLib::Profiler::Record(uint32_t metricId, uint64_t value)
+{
+    if (metricId >= k_MaxMetricCount)
+    {
+        return;
+    }
+
+    auto &histogram = GetThreadHistograms()->Histograms[metricId];
+    Increment(histogram.Count, 1);
+    Increment(histogram.Sum, value);
+    Increment(histogram.Buckets[GetBucketIndex(value)], 1);
+    if (value > histogram.Max.load(std::memory_order_relaxed))
+    {
+        histogram.Max.store(value, std::memory_order_relaxed);
+    }
+}
+
+uint64_t ZooLib::Profiler::Summary::GetPercentile(double fraction) const
+{
+    if (Count == 0)
+    {
+        return 0;
+    }
+
+    auto rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(Count)));
+    auto cumulativeCount = 0UL;
+    for (auto i = 0UZ; i < Buckets.size(); ++i)
+    {
+        cumulativeCount += Buckets[i];
+        if (cumulativeCount >= rank && cumulativeCount > 0)
+        {
+            auto upperBound = i == 0 ? 0 : i >= 64 ? Max : (1UL << i) - 1;
+            return std::min(upperBound, Max);
+        }
+    }
+
+    return Max;
+}
+
+std::vector<ZooLib::Profiler::Summary> ZooLib::Profiler::GetSummaries()
+{
+    auto &registry = GetRegistry();
+    std::lock_guard lock(registry.Mutex);
+
+    std::vector<Summary> summaries(registry.Metrics.size());
+    for (auto id = 0UZ; id < registry.Metrics.size(); ++id)
+    {
+        auto &summary = summaries[id];
+        summary.Name = registry.Metrics[id]->GetName();
+        summary.ValueUnit = registry.Metrics[id]->GetUnit();
+
+        for (const auto &threadHistograms: registry.Threads)
+        {
+            const auto &histogram = threadHistograms->Histograms[id];
+            summary.Count += histogram.Count.load(std::memory_order_relaxed);
+            summary.Sum += histogram.Sum.load(std::memory_order_relaxed);
+            summary.Max = std::max(summary.Max, histogram.Max.load(std::memory_order_relaxed));
+            for (auto i = 0UZ; i < k_BucketCount; ++i)
+            {
+                summary.Buckets[i] += histogram.Buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    return summaries;
+}
+
+void ZooLib::Profiler::Reset()
+{
+    auto &registry = GetRegistry();
+    std::lock_guard lock(registry.Mutex);
+
+    for (const auto &threadHistograms: registry.Threads)
+    {
+        for (auto &histogram: threadHistograms->Histograms)
+        {
+            histogram.Count.store(0, std::memory_order_relaxed);
+            histogram.Sum.store(0, std::memory_order_relaxed);
+            histogram.Max.store(0, std::memory_order_relaxed);
+            for (auto &bucket: histogram.Buckets)
+            {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+std::string ZooLib::Profiler::FormatSummaries(const std::vector<Summary> &summaries)
+{
+    auto text = std::format("{:<26} {:>8} {:>12} {:>12} {:>12}", "metric", "count", "mean", "p95", "max");
+    for (const auto &summary: summaries)
+    {
+        if (summary.Count == 0)
+        {
+            continue;
+        }
+
+        text += std::format(
+                "\n{:<26} {:>8} {:>12} {:>12} {:>12}", summary.Name, summary.Count,
+                FormatValue(summary.GetMean(), summary.ValueUnit),
+                FormatValue(static_cast<double>(summary.GetPercentile(0.95)), summary.ValueUnit),
+                FormatValue(static_cast<double>(summary.Max), summary.ValueUnit));
+    }
+
+    return text;
+}
+
+nlohmann::json ZooLib::Profiler::ToJson(const std::vector<Summary> &summaries)
+{
+    auto metrics = nlohmann::json::object();
+    for (const auto &summary: summaries)
+    {
+        // Only the buckets holding values, as [lower bound, upper bound, count].
+        auto histogram = nlohmann::json::array();
+        for (auto i = 0UZ; i < k_BucketCount; ++i)
+        {
+            if (summary.Buckets[i] != 0)
+            {
+                auto lowerBound = i == 0 ? 0UL : 1UL << (i - 1);
+                auto upperBound = i == 0 ? 0UL : i >= 64 ? UINT64_MAX : (1UL << i) - 1;
+                histogram.push_back(nlohmann::json::array({lowerBound, upperBound, summary.Buckets[i]}));
+            }
+        }
+
+        metrics[summary.Name] = nlohmann::json{
+                {"unit", GetUnitName(summary.ValueUnit)},
+                {"count", summary.Count},
+                {"sum", summary.Sum},
+                {"mean", summary.GetMean()},
+                {"p50", summary.GetPercentile(0.5)},
+                {"p90", summary.GetPercentile(0.9)},
+                {"p99", summary.GetPercentile(0.99)},
+                {"max", summary.Max},
+                {"histogram", histogram},
+        };
+    }
+
+    return metrics;
+}
+
+bool ZooLib::Profiler::WriteJsonFile(const std::filesystem::path &filePath)
+{
+    std::error_code error;
+    std::filesystem::create_directories(filePath.parent_path(), error);
+
+    std::ofstream f(filePath);
+    if (!f.good())
+    {
+        g_warning("Failed to write the profile to %s.", filePath.c_str());
+        return false;
+    }
+
+    f << ToJson(GetSummaries()).dump(4);
+    return f.good();
+}
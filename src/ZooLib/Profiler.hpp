@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <vector>
+
+namespace ZooLib
+{
+    /**
+     * \class Profiler
+     * \brief Collects timings and counters from hot paths into histograms.
+     *
+     * Each thread records into its own histograms, without locking: recording a value costs a few relaxed atomic
+     * stores. Readers sum the histograms of all threads. The histograms of a thread that exits are kept and reused by
+     * the next thread, so the totals include every value recorded since the profiler was enabled.
+     *
+     * Recording does nothing while the profiler is disabled, which is the default.
+     */
+    class Profiler
+    {
+    public:
+        enum class Unit
+        {
+            e_Count,
+            e_Bytes,
+            e_Nanoseconds,
+        };
+
+        static constexpr size_t k_MaxMetricCount = 32;
+        /// Bucket 0 holds the value 0, bucket i holds the values in [2^(i-1), 2^i).
+        static constexpr size_t k_BucketCount = 65;
+
+        /**
+         * \brief A named value recorded by the profiler. Metrics are meant to be static variables, created at startup.
+         */
+        class Metric
+        {
+            uint32_t m_Id;
+            std::string m_Name;
+            Unit m_Unit;
+
+        public:
+            Metric(std::string name, Unit unit);
+
+            Metric(const Metric &) = delete;
+            Metric &operator=(const Metric &) = delete;
+
+            [[nodiscard]] uint32_t GetId() const
+            {
+                return m_Id;
+            }
+
+            [[nodiscard]] const std::string &GetName() const
+            {
+                return m_Name;
+            }
+
+            [[nodiscard]] Unit GetUnit() const
+            {
+                return m_Unit;
+            }
+
+            /**
+             * \brief Records a value, if the profiler is enabled.
+             */
+            void Record(uint64_t value) const
+            {
+                if (IsEnabled())
+                {
+                    Profiler::Record(m_Id, value);
+                }
+            }
+        };
+
+        /**
+         * \brief Records the time elapsed between its construction and its destruction, in nanoseconds.
+         */
+        class ScopedTimer
+        {
+            const Metric &m_Metric;
+            std::chrono::steady_clock::time_point m_StartTime{};
+
+        public:
+            explicit ScopedTimer(const Metric &metric)
+                : m_Metric(metric)
+            {
+                if (IsEnabled())
+                {
+                    m_StartTime = std::chrono::steady_clock::now();
+                }
+            }
+
+            ~ScopedTimer()
+            {
+                if (IsEnabled() && m_StartTime != std::chrono::steady_clock::time_point{})
+                {
+                    auto duration = std::chrono::steady_clock::now() - m_StartTime;
+                    m_Metric.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+                }
+            }
+
+            ScopedTimer(const ScopedTimer &) = delete;
+            ScopedTimer &operator=(const ScopedTimer &) = delete;
+        };
+
+        /**
+         * \brief The values recorded for a metric by all threads.
+         */
+        struct Summary
+        {
+            std::string Name{};
+            Unit ValueUnit{};
+            uint64_t Count{};
+            uint64_t Sum{};
+            uint64_t Max{};
+            std::array<uint64_t, k_BucketCount> Buckets{};
+
+            [[nodiscard]] double GetMean() const
+            {
+                return Count == 0 ? 0 : static_cast<double>(Sum) / static_cast<double>(Count);
+            }
+
+            /**
+             * \brief Estimates a percentile from the histogram.
+             * \param fraction The percentile, between 0 and 1.
+             * \return The upper bound of the bucket holding the percentile, capped to the maximum value.
+             */
+            [[nodiscard]] uint64_t GetPercentile(double fraction) const;
+        };
+
+    private:
+        static std::atomic<bool> s_Enabled;
+
+        static void Record(uint32_t metricId, uint64_t value);
+
+    public:
+        [[nodiscard]] static bool IsEnabled()
+        {
+            return s_Enabled.load(std::memory_order_relaxed);
+        }
+
+        static void SetEnabled(bool enabled)
+        {
+            s_Enabled.store(enabled, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] static size_t GetBucketIndex(uint64_t value)
+        {
+            return std::bit_width(value);
+        }
+
+        /**
+         * \brief Gets the values recorded for each metric. Can be called from any thread, while values are recorded.
+         */
+        [[nodiscard]] static std::vector<Summary> GetSummaries();
+
+        /**
+         * \brief Clears the values recorded for each metric. Values recorded meanwhile by other threads may be lost.
+         */
+        static void Reset();
+
+        /**
+         * \brief Formats the summaries as a table, one metric per line.
+         */
+        [[nodiscard]] static std::string FormatSummaries(const std::vector<Summary> &summaries);
+
+        [[nodiscard]] static nlohmann::json ToJson(const std::vector<Summary> &summaries);
+
+        /**
+         * \brief Writes the summaries of all metrics to a JSON file.
+         * \return True if the file was written.
+         */
+        static bool WriteJsonFile(const std::filesystem::path &filePath);
+    };
+}
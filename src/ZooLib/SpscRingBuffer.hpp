@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <span>
+
+namespace ZooLib
+{
+    /**
+     * \class SpscRingBuffer
+     * \brief A bounded, lock-free ring buffer shared by exactly one producer thread and one consumer thread.
+     *
+     * The producer and the consumer work directly in the ring storage through spans: the producer asks for a
+     * writable span, fills it and commits the number of elements written; the consumer asks for a readable span,
+     * processes it in place and commits the number of elements consumed. The ring buffer never copies data.
+     *
+     * The head and tail indices are monotonically increasing counters. Each one lives on its own cache line, next to
+     * the owning thread's cached copy of the other index, so that the two threads do not invalidate each other's
+     * cache lines on every operation.
+     *
+     * \tparam T The type of the elements stored in the ring buffer.
+     */
+    template<typename T>
+    class SpscRingBuffer
+    {
+        static constexpr size_t k_CacheLineSize = 64;
+
+        /**
+         * \brief The ring storage. Read-only after construction.
+         */
+        T *m_Storage{};
+
+        /**
+         * \brief The number of elements in the ring storage. Read-only after construction.
+         */
+        size_t m_Capacity{};
+
+        /**
+         * \brief Total number of elements committed by the producer.
+         */
+        alignas(k_CacheLineSize) std::atomic<size_t> m_Head{};
+
+        /**
+         * \brief The producer's last seen value of `m_Tail`.
+         */
+        size_t m_CachedTail{};
+
+        /**
+         * \brief Total number of elements committed by the consumer.
+         */
+        alignas(k_CacheLineSize) std::atomic<size_t> m_Tail{};
+
+        /**
+         * \brief The consumer's last seen value of `m_Head`.
+         */
+        size_t m_CachedHead{};
+
+    public:
+        /**
+         * \brief Constructs a ring buffer.
+         * \param capacity The maximum number of elements the ring buffer can hold. Must be greater than 0.
+         */
+        explicit SpscRingBuffer(size_t capacity)
+            : m_Storage(new T[capacity])
+            , m_Capacity(capacity)
+        {
+        }
+
+        ~SpscRingBuffer()
+        {
+            delete[] m_Storage;
+        }
+
+        SpscRingBuffer(const SpscRingBuffer &) = delete;
+        SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+        /**
+         * \brief Retrieves the capacity of the ring buffer.
+         * \return The maximum number of elements the ring buffer can hold.
+         */
+        [[nodiscard]] size_t GetCapacity() const
+        {
+            return m_Capacity;
+        }
+
+        /**
+         * \brief Gets the largest contiguous writable region of the ring buffer. Producer only.
+         * \return A span of free elements; empty if the ring buffer is full.
+         */
+        [[nodiscard]] std::span<T> GetWriteSpan()
+        {
+            const auto head = m_Head.load(std::memory_order_relaxed);
+            const auto offset = head % m_Capacity;
+            const auto contiguous = m_Capacity - offset;
+
+            if (m_CachedTail + m_Capacity < head + contiguous)
+            {
+                // Not enough known free space: look at where the consumer actually is.
+                m_CachedTail = m_Tail.load(std::memory_order_acquire);
+            }
+
+            const auto free = m_CachedTail + m_Capacity - head;
+            return {m_Storage + offset, std::min(free, contiguous)};
+        }
+
+        /**
+         * \brief Publishes elements written in the span returned by `GetWriteSpan()`. Producer only.
+         * \param count The number of elements written, at most the size of the last write span.
+         */
+        void CommitWrite(size_t count)
+        {
+            m_Head.store(m_Head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+        /**
+         * \brief Gets the largest contiguous readable region of the ring buffer. Consumer only.
+         * \return A span of elements ready to be consumed; empty if the ring buffer is empty.
+         */
+        [[nodiscard]] std::span<T> GetReadSpan()
+        {
+            const auto tail = m_Tail.load(std::memory_order_relaxed);
+            const auto offset = tail % m_Capacity;
+            const auto contiguous = m_Capacity - offset;
+
+            if (m_CachedHead < tail + contiguous)
+            {
+                // Not enough known data: look at where the producer actually is.
+                m_CachedHead = m_Head.load(std::memory_order_acquire);
+            }
+
+            const auto available = m_CachedHead - tail;
+            return {m_Storage + offset, std::min(available, contiguous)};
+        }
+
+        /**
+         * \brief Releases elements of the span returned by `GetReadSpan()` back to the producer. Consumer only.
+         * \param count The number of elements consumed, at most the size of the last read span.
+         */
+        void CommitRead(size_t count)
+        {
+            m_Tail.store(m_Tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+        /**
+         * \brief Gets the number of elements currently stored in the ring buffer.
+         * \return The number of elements. The value is approximate if called while the other thread is active.
+         */
+        [[nodiscard]] size_t GetSize() const
+        {
+            // Load the tail first: the head can only move forward, so the difference is never negative.
+            const auto tail = m_Tail.load(std::memory_order_acquire);
+            return m_Head.load(std::memory_order_acquire) - tail;
+        }
+
+        /**
+         * \brief Discards all the elements, so that the ring buffer can be reused by another pair of threads. Neither
+         * the producer nor the consumer may use the ring buffer during the call.
+         */
+        void Reset()
+        {
+            m_Head.store(0, std::memory_order_relaxed);
+            m_Tail.store(0, std::memory_order_relaxed);
+            m_CachedHead = 0;
+            m_CachedTail = 0;
+        }
+    };
+}
@@ -9,4 +9,7 @@ ZooLib::State::~State()
     {
         delete stateComponent;
     }
+
+    // Components may save themselves when deleted; write them before the preferences file is destroyed.
+    m_PreferencesFile.reset();
 }
@@ -5,11 +5,14 @@
 #endif
 
 #include <filesystem>
-#include <fstream>
+#include <functional>
+#include <memory>
 #include <vector>
 
 #include <nlohmann/json.hpp>
 
+#include "PreferencesFile.hpp"
+
 namespace ZooLib
 {
     class StateComponent;
@@ -19,17 +22,44 @@ namespace ZooLib
      *
      * The `State` class provides functionality to manage a collection of state components,
      * serialize/deserialize their state to/from a preferences file, and retrieve components by type.
+     *
+     * The preferences file is parsed once and kept in memory. Saved components are written to disk in the background,
+     * and the pending writes are completed when the state is destroyed.
      */
     class State
     {
-        std::filesystem::path m_PreferencesFilePath{};
+        std::unique_ptr<PreferencesFile> m_PreferencesFile{};
+        bool m_IsPreferencesFileReadOnly{};
         std::vector<StateComponent *> m_StateComponents;
+        std::function<void(const StateComponent *)> m_ComponentChangedCallback{};
 
         TEST_FRIENDS;
 
     public:
         ~State();
 
+        /**
+         * \brief Sets the function called each time a state component is modified.
+         * \param callback The function to call, with the modified component. It is called on the thread that modified
+         * the component.
+         */
+        void SetComponentChangedCallback(std::function<void(const StateComponent *)> callback)
+        {
+            m_ComponentChangedCallback = std::move(callback);
+        }
+
+        /**
+         * \brief Signals that a state component was modified. Called when an updater is destroyed.
+         * \param stateComponent The modified component.
+         */
+        void NotifyComponentChanged(const StateComponent *stateComponent) const
+        {
+            if (m_ComponentChangedCallback)
+            {
+                m_ComponentChangedCallback(stateComponent);
+            }
+        }
+
         /**
          * \brief Adds a state component to the collection if it is not already present.
          * \param stateComponent A pointer to the state component to add.
@@ -89,7 +119,33 @@ namespace ZooLib
          */
         void SetPreferencesFilePath(const std::filesystem::path &filePath)
         {
-            m_PreferencesFilePath = filePath;
+            if (m_PreferencesFile != nullptr && m_PreferencesFile->GetFilePath() == filePath)
+            {
+                return;
+            }
+
+            m_PreferencesFile = filePath.empty() ? nullptr : std::make_unique<PreferencesFile>(filePath);
+        }
+
+        /**
+         * \brief Sets whether the components are only loaded from the preferences file. When read-only, saving a
+         * component does nothing, so that a process can use the user preferences without modifying them.
+         * \param readOnly True to never write the preferences file.
+         */
+        void SetPreferencesFileReadOnly(bool readOnly)
+        {
+            m_IsPreferencesFileReadOnly = readOnly;
+        }
+
+        /**
+         * \brief Writes the components saved so far to the preferences file, and waits until they are written.
+         */
+        void FlushPreferencesFile()
+        {
+            if (m_PreferencesFile != nullptr)
+            {
+                m_PreferencesFile->Flush();
+            }
         }
 
         /**
@@ -100,7 +156,7 @@ namespace ZooLib
         template<typename TStateComponent>
         void LoadFromPreferencesFile(TStateComponent *stateComponent)
         {
-            if (stateComponent == nullptr)
+            if (stateComponent == nullptr || m_PreferencesFile == nullptr)
             {
                 return;
             }
@@ -111,36 +167,28 @@ namespace ZooLib
                 return;
             }
 
-            std::ifstream f(m_PreferencesFilePath);
-            if (!f.good())
-            {
-                return;
-            }
-
             try
             {
-                if (auto jsonData = nlohmann::json::parse(f); jsonData.contains(key))
+                if (nlohmann::json componentJson; m_PreferencesFile->Get(key, componentJson))
                 {
                     auto updater = typename TStateComponent::Updater(stateComponent);
-                    updater.LoadFromJson(jsonData[key]);
+                    updater.LoadFromJson(componentJson);
                 }
             }
             catch (const std::exception &)
             {
             }
-
-            f.close();
         }
 
         /**
-         * \brief Saves the state of a component to the preferences file.
+         * \brief Saves the state of a component to the preferences file. The file is written in the background.
          * \tparam TStateComponent The type of the state component to save.
          * \param stateComponent A pointer to the state component to save.
          */
         template<typename TStateComponent>
         void SaveToFile(TStateComponent *stateComponent)
         {
-            if (stateComponent == nullptr || m_PreferencesFilePath.empty())
+            if (stateComponent == nullptr || m_PreferencesFile == nullptr || m_IsPreferencesFileReadOnly)
             {
                 return;
             }
@@ -151,31 +199,9 @@ namespace ZooLib
                 return;
             }
 
-            std::ifstream f(m_PreferencesFilePath);
-            nlohmann::json jsonData;
-            if (f.good())
-            {
-                try
-                {
-                    jsonData = nlohmann::json::parse(f);
-                }
-                catch (const std::exception &)
-                {
-                }
-
-                f.close();
-            }
-
             nlohmann::json componentJson;
             to_json(componentJson, *stateComponent);
-            jsonData[key] = componentJson;
-
-            auto dirs = m_PreferencesFilePath.parent_path();
-            create_directories(dirs);
-
-            std::ofstream outFile(m_PreferencesFilePath);
-            outFile << jsonData.dump(4);
-            outFile.close();
+            m_PreferencesFile->Set(key, std::move(componentJson));
         }
     };
 }
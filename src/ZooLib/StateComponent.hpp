@@ -109,11 +109,13 @@ namespace ZooLib
             }
 
             /**
-             * \brief Destructor that increments the version of the StateComponent.
+             * \brief Destructor that increments the version of the StateComponent and signals the change to the
+             * State, so that its observers get notified.
              */
             virtual ~Updater()
             {
                 ++m_StateComponent->m_StateVersion;
+                m_StateComponent->m_State->NotifyComponentChanged(m_StateComponent);
             }
 
             /**
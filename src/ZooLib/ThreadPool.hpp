@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ZooLib
+{
+    /**
+     * \class ThreadPool
+     * \brief A fixed set of worker threads executing tasks in submission order.
+     *
+     * Tasks are started in the order they are submitted, but they may complete in any order. The result of a task
+     * is obtained through the `std::future` returned by `Submit()`.
+     */
+    class ThreadPool
+    {
+        std::vector<std::thread> m_Threads{};
+
+        std::mutex m_Mutex{};
+        std::condition_variable m_TaskAvailable{};
+        std::deque<std::move_only_function<void()>> m_Tasks{};
+        bool m_Stopping{};
+
+        void Run()
+        {
+            while (true)
+            {
+                std::move_only_function<void()> task;
+
+                {
+                    std::unique_lock lock(m_Mutex);
+                    m_TaskAvailable.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+                    if (m_Tasks.empty())
+                    {
+                        // Stopping, and no more work to do.
+                        return;
+                    }
+
+                    task = std::move(m_Tasks.front());
+                    m_Tasks.pop_front();
+                }
+
+                task();
+            }
+        }
+
+    public:
+        /**
+         * \brief Constructs a thread pool and starts its worker threads.
+         * \param threadCount The number of worker threads. At least one thread is started.
+         */
+        explicit ThreadPool(size_t threadCount)
+        {
+            threadCount = std::max(threadCount, static_cast<size_t>(1));
+            m_Threads.reserve(threadCount);
+            for (auto i = 0UZ; i < threadCount; ++i)
+            {
+                m_Threads.emplace_back(&ThreadPool::Run, this);
+            }
+        }
+
+        /**
+         * \brief Destructor. Waits for all submitted tasks to complete, then stops the worker threads.
+         */
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard lock(m_Mutex);
+                m_Stopping = true;
+            }
+            m_TaskAvailable.notify_all();
+
+            for (auto &thread: m_Threads)
+            {
+                thread.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /**
+         * \brief Retrieves the number of worker threads.
+         * \return The number of worker threads.
+         */
+        [[nodiscard]] size_t GetThreadCount() const
+        {
+            return m_Threads.size();
+        }
+
+        /**
+         * \brief Queues a task for execution on one of the worker threads.
+         * \tparam TFunction A callable taking no arguments.
+         * \param function The task to execute.
+         * \return A future that receives the value returned by the task, or the exception it threw.
+         */
+        template<typename TFunction>
+        std::future<std::invoke_result_t<TFunction>> Submit(TFunction &&function)
+        {
+            std::packaged_task<std::invoke_result_t<TFunction>()> task(std::forward<TFunction>(function));
+            auto future = task.get_future();
+
+            {
+                std::lock_guard lock(m_Mutex);
+                m_Tasks.emplace_back(std::move(task));
+            }
+            m_TaskAvailable.notify_one();
+
+            return future;
+        }
+    };
+}
@@ -1,7 +1,10 @@
 
 #include <csignal>
+#include <cstring>
+#include <iostream>
 
 #include "App.hpp"
+#include "BatchScanner.hpp"
 #include "ZooLib/Gettext.hpp"
 #include "ZooLib/PathUtils.hpp"
 #include "config.h"
@@ -13,8 +16,42 @@ void SignalHandler(int signal)
     delete app;
 }
 
+/**
+ * Runs `gorfector --batch <scanlist.json|preset>`: scans without user interface and reports the progress on stdout, as
+ * JSON lines.
+ */
+static int RunBatch(const char *programName, const char *scanListOrPreset)
+{
+    if (scanListOrPreset == nullptr)
+    {
+        std::cerr << "Usage: " << programName << " --batch <scanlist.json|preset>" << std::endl;
+        return static_cast<int>(Gorfector::BatchScanner::ExitCode::e_InvalidArguments);
+    }
+
+    // Keep stdout for the progress events.
+    g_set_print_handler([](const gchar *message) { std::cerr << message; });
+
+    auto userConfigDirectoryPath = std::filesystem::path(g_get_user_config_dir()) / APP_ID;
+    Gorfector::BatchScanner batchScanner(userConfigDirectoryPath, std::cout);
+    return static_cast<int>(batchScanner.Run(scanListOrPreset));
+}
+
 int main(int argc, char **argv)
 {
+    setlocale(LC_ALL, "");
+    bind_textdomain_codeset(GETTEXT_PACKAGE, "UTF-8");
+    bindtextdomain(GETTEXT_PACKAGE, ZooLib::RelocatePath(GNOMELOCALEDIR).c_str());
+    textdomain(GETTEXT_PACKAGE);
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--batch") == 0)
+        {
+            // The batch mode handles SIGINT and SIGTERM itself, to cancel the scan.
+            return RunBatch(argv[0], i + 1 < argc ? argv[i + 1] : nullptr);
+        }
+    }
+
     signal(SIGINT, SignalHandler);
     signal(SIGILL, SignalHandler);
     signal(SIGABRT, SignalHandler);
@@ -22,11 +59,6 @@ int main(int argc, char **argv)
     signal(SIGTERM, SignalHandler);
     signal(SIGKILL, SignalHandler);
 
-    setlocale(LC_ALL, "");
-    bind_textdomain_codeset(GETTEXT_PACKAGE, "UTF-8");
-    bindtextdomain(GETTEXT_PACKAGE, ZooLib::RelocatePath(GNOMELOCALEDIR).c_str());
-    textdomain(GETTEXT_PACKAGE);
-
     app = Gorfector::App::Create(argc, argv);
     auto retVal = app->Run();
     delete app;